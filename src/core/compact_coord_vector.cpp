@@ -0,0 +1,131 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compact_coord_vector.h"
+
+#include <QtGlobal>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/** The number of low bits which carry the MapCoord flags. */
+constexpr int flag_bits = 6;
+constexpr quint64 flag_mask = (1u << flag_bits) - 1;
+
+constexpr quint64 zigzag(qint64 value) noexcept
+{
+	return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+constexpr qint64 unzigzag(quint64 value) noexcept
+{
+	return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+/** Appends a variable length integer, 7 bits per byte, low bits first. */
+void appendVarint(QByteArray& data, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		data.append(char(value | 0x80));
+		value >>= 7;
+	}
+	data.append(char(value));
+}
+
+quint64 readVarint(const char*& pos)
+{
+	quint64 value = 0;
+	for (int shift = 0; ; shift += 7)
+	{
+		auto const byte = quint8(*pos++);
+		value |= quint64(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+}
+
+}  // namespace
+
+
+
+CompactCoordVector::CompactCoordVector(const MapCoordVector& coords)
+{
+	encode(coords);
+}
+
+CompactCoordVector::~CompactCoordVector()
+{
+	// nothing, not inlined
+}
+
+
+void CompactCoordVector::encode(const MapCoordVector& coords)
+{
+	data.clear();
+	// Most deltas need no more than three bytes for x, and two bytes for y.
+	data.reserve(int(coords.size() * 5));
+
+	qint64 last_x = 0;
+	qint64 last_y = 0;
+	for (const auto& coord : coords)
+	{
+		Q_ASSERT((quint64(coord.flags()) & ~flag_mask) == 0);
+		auto const x = qint64(coord.nativeX());
+		auto const y = qint64(coord.nativeY());
+		appendVarint(data, (zigzag(x - last_x) << flag_bits) | (quint64(coord.flags()) & flag_mask));
+		appendVarint(data, zigzag(y - last_y));
+		last_x = x;
+		last_y = y;
+	}
+	data.squeeze();
+	count = coords.size();
+}
+
+
+void CompactCoordVector::decode(MapCoordVector& coords) const
+{
+	coords.clear();
+	coords.reserve(count);
+
+	qint64 x = 0;
+	qint64 y = 0;
+	const char* pos = data.constData();
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		auto const x_and_flags = readVarint(pos);
+		x += unzigzag(x_and_flags >> flag_bits);
+		y += unzigzag(readVarint(pos));
+		coords.emplace_back(MapCoord::fromNative(qint32(x), qint32(y)));
+		coords.back().setFlags(MapCoord::Flags::Int(x_and_flags & flag_mask));
+	}
+	Q_ASSERT(pos == data.constData() + data.size());
+}
+
+
+void CompactCoordVector::clear()
+{
+	data = {};
+	count = 0;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,91 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_COMPACT_COORD_VECTOR_H
+#define OPENORIENTEERING_COMPACT_COORD_VECTOR_H
+
+#include <cstddef>
+
+#include <QByteArray>
+
+#include "core/map_coord.h"
+
+namespace OpenOrienteering {
+
+
+/**
+ * A memory-saving, read-only encoding of a sequence of map coordinates.
+ *
+ * Each coordinate is stored as the difference to its predecessor. The x
+ * difference is zigzag encoded and combined with the coordinate's flags,
+ * the y difference is zigzag encoded. Both values are written as variable
+ * length integers with 7 bits per byte. For the typical distances between
+ * consecutive coordinates of a path, this needs about 5 bytes per coordinate
+ * instead of sizeof(MapCoord).
+ *
+ * The encoding is lossless: decoding restores the exact native coordinates
+ * and flags.
+ */
+class CompactCoordVector
+{
+public:
+	/** Constructs an empty vector. */
+	CompactCoordVector() noexcept = default;
+
+	/** Constructs an encoded copy of the given coordinates. */
+	explicit CompactCoordVector(const MapCoordVector& coords);
+
+	CompactCoordVector(const CompactCoordVector&) = default;
+	CompactCoordVector(CompactCoordVector&&) = default;
+
+	~CompactCoordVector();
+
+	CompactCoordVector& operator=(const CompactCoordVector&) = default;
+	CompactCoordVector& operator=(CompactCoordVector&&) = default;
+
+
+	/** Returns true if the vector holds no coordinates. */
+	bool empty() const noexcept { return count == 0; }
+
+	/** Returns the number of coordinates. */
+	std::size_t size() const noexcept { return count; }
+
+	/** Returns the number of bytes used by the encoded data. */
+	std::size_t byteSize() const noexcept { return std::size_t(data.size()); }
+
+
+	/** Replaces the contents by the encoded coordinates. */
+	void encode(const MapCoordVector& coords);
+
+	/** Replaces the contents of coords by the decoded coordinates. */
+	void decode(MapCoordVector& coords) const;
+
+	/** Releases the encoded data. */
+	void clear();
+
+
+private:
+	QByteArray data;
+	std::size_t count = 0;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
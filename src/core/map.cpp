@@ -26,6 +26,7 @@
 #include <exception>
 #include <iterator>
 #include <memory>
+#include <unordered_map>
 
 #include <Qt>
 #include <QtGlobal>
@@ -46,6 +47,7 @@
 #include <QSaveFile>
 #include <QStringList>
 #include <QTextDocument>
+#include <QTimer>
 #include <QTranslator>
 
 #include "core/georeferencing.h"
@@ -56,7 +58,9 @@
 #include "core/map_printer.h"
 #include "core/map_view.h"
 #include "core/objects/object.h"
+#include "core/objects/object_memory_budget.h"
 #include "core/objects/object_operations.h"
+#include "core/objects/object_update_scheduler.h"
 #include "core/renderables/renderable.h"
 #include "core/symbols/combined_symbol.h"
 #include "core/symbols/line_symbol.h"
@@ -226,6 +230,12 @@ MapColorMap Map::MapColorSet::importSet(const Map::MapColorSet& other, std::vect
 		
 		bool priorities_changed = false;
 		
+		// Candidate matches by hash, in order of priority
+		std::unordered_map<uint, std::vector<std::size_t>> buckets;
+		buckets.reserve(colors.size());
+		for (std::size_t k = 0, colors_size = colors.size(); k < colors_size; ++k)
+			buckets[colors[k]->structuralHash()].push_back(k);
+		
 		// Initialize merge_list
 		auto merge_list_item = merge_list.begin();
 		for (std::size_t i = 0; i < other.colors.size(); ++i)
@@ -234,17 +244,21 @@ MapColorMap Map::MapColorSet::importSet(const Map::MapColorSet& other, std::vect
 			
 			MapColor* src_color = other.colors[i];
 			merge_list_item->src_color = src_color;
-			for (std::size_t k = 0, colors_size = colors.size(); k < colors_size; ++k)
+			auto const bucket = buckets.find(src_color->structuralHash());
+			if (bucket != buckets.end())
 			{
-				if (colors[k]->equals(*src_color, false))
+				for (auto k : bucket->second)
 				{
-					merge_list_item->dest_color = colors[k];
-					merge_list_item->dest_index = k;
-					out_pointermap[src_color] = colors[k];
-					// Prefer a matching color at the same priority,
-					// so just abort early if priority matches
-					if (merge_list_item->dest_color->getPriority() == merge_list_item->src_color->getPriority())
-						break;
+					if (colors[k]->equals(*src_color, false))
+					{
+						merge_list_item->dest_color = colors[k];
+						merge_list_item->dest_index = k;
+						out_pointermap[src_color] = colors[k];
+						// Prefer a matching color at the same priority,
+						// so just abort early if priority matches
+						if (merge_list_item->dest_color->getPriority() == merge_list_item->src_color->getPriority())
+							break;
+					}
 				}
 			}
 			++merge_list_item;
@@ -439,6 +453,9 @@ Map::Map()
  , undo_manager(new UndoManager(this))
  , renderables(new MapRenderables(this))
  , selection_renderables(new MapRenderables(this))
+ , object_updates(new ObjectUpdateScheduler(*this))
+ , idle_compaction_timer(new QTimer())
+ , memory_budget(new ObjectMemoryBudget(*this))
  , renderable_options(Symbol::RenderNormal)
  , printer_config(nullptr)
 {
@@ -455,6 +472,13 @@ Map::Map()
 	connect(this, &Map::colorChanged, this, &Map::checkSpotColorPresence);
 	connect(this, &Map::colorDeleted, this, &Map::checkSpotColorPresence);
 	connect(undo_manager.data(), &UndoManager::cleanChanged, this, &Map::undoCleanChanged);
+	// These connections must be made before any other object connects to
+	// these signals, so that receivers find up-to-date statistics.
+	connect(this, &Map::selectedObjectEdited, this, &Map::updateSelectionStatistics);
+	connect(this, &Map::symbolChanged, this, &Map::updateSelectionStatistics);
+	
+	idle_compaction_timer->setInterval(idle_compaction_interval);
+	connect(idle_compaction_timer.data(), &QTimer::timeout, this, &Map::compactIdleObjects);
 }
 
 Map::~Map()
@@ -476,6 +500,7 @@ void Map::clear()
 	closed_templates.clear();
 	
 	object_selection.clear();
+	selection_statistics.clear();
 	first_selected_object = nullptr;
 	selection_renderables->clear();
 	
@@ -672,6 +697,8 @@ bool Map::exportTo(const QString& path, MapView* view, const FileFormat* format)
 		return false;
 	}
 	
+	finishObjectUpdates();
+	
 	QSaveFile file(path);
 	QScopedPointer<Exporter> exporter(format->createExporter(&file, this, view));
 	bool success = false;
@@ -999,6 +1026,8 @@ QHash<const Symbol*, Symbol*> Map::importMap(
 
 bool Map::exportToIODevice(QIODevice* stream)
 {
+	finishObjectUpdates();
+	
 	stream->open(QIODevice::WriteOnly);
 	Exporter* exporter = nullptr;
 	try {
@@ -1041,8 +1070,8 @@ bool Map::importFromIODevice(QIODevice* stream)
 
 void Map::draw(QPainter* painter, const RenderConfig& config)
 {
-	// Update the renderables of all objects marked as dirty
-	updateObjects();
+	// Update the renderables of the objects marked as dirty
+	updateObjects(config.bounding_box);
 	
 	// The actual drawing
 	renderables->draw(painter, config);
@@ -1050,8 +1079,8 @@ void Map::draw(QPainter* painter, const RenderConfig& config)
 
 void Map::drawOverprintingSimulation(QPainter* painter, const RenderConfig& config)
 {
-	// Update the renderables of all objects marked as dirty
-	updateObjects();
+	// Update the renderables of the objects marked as dirty
+	updateObjects(config.bounding_box);
 	
 	// The actual drawing
 	renderables->drawOverprintingSimulation(painter, config);
@@ -1059,8 +1088,8 @@ void Map::drawOverprintingSimulation(QPainter* painter, const RenderConfig& conf
 
 void Map::drawColorSeparation(QPainter* painter, const RenderConfig& config, const MapColor* spot_color, bool use_color)
 {
-	// Update the renderables of all objects marked as dirty
-	updateObjects();
+	// Update the renderables of the objects marked as dirty
+	updateObjects(config.bounding_box);
 	
 	// The actual drawing
 	renderables->drawColorSeparation(painter, config, spot_color, use_color);
@@ -1098,17 +1127,37 @@ void Map::drawTemplates(QPainter* painter, const QRectF& bounding_box, int first
 void Map::updateObjects()
 {
 	// TODO: It maybe would be better if the objects entered themselves into a separate list when they get dirty so not all objects have to be traversed here
-	applyOnAllObjects(&Object::update);
+	// Filtering by the dirty state avoids expanding compacted objects.
+	applyOnMatchingObjects(&Object::update, &Object::isOutputDirty);
+}
+
+void Map::updateObjects(const QRectF& bounding_box)
+{
+	auto const deferring = hasPendingObjectUpdates();
+	auto needs_update = [deferring, &bounding_box](const Object* object) {
+		if (object->hasEvictedRenderables())
+			return object->getExtent().intersects(bounding_box);
+		if (!object->isOutputDirty())
+			return false;
+		const auto& extent = object->getExtent();
+		return !deferring || !extent.isValid() || extent.intersects(bounding_box);
+	};
+	applyOnMatchingObjects([](Object* object) {
+		object->restoreRenderables();
+		object->update();
+	}, needs_update);
 }
 
 void Map::removeRenderablesOfObject(const Object* object, bool mark_area_as_dirty)
 {
+	++objects_revision;
 	renderables->removeRenderablesOfObject(object, mark_area_as_dirty);
 	if (isObjectSelected(object))
 		removeSelectionRenderables(object);
 }
 void Map::insertRenderablesOfObject(const Object* object)
 {
+	++objects_revision;
 	renderables->insertRenderablesOfObject(object);
 	if (isObjectSelected(object))
 		addSelectionRenderables(object);
@@ -1237,6 +1286,7 @@ void Map::addObjectToSelection(Object* object, bool emit_selection_changed)
 	Q_ASSERT(!isObjectSelected(object));
 	object_selection.insert(object);
 	addSelectionRenderables(object);
+	selection_statistics.add(object);
 	if (!first_selected_object)
 		first_selected_object = object;
 	if (emit_selection_changed)
@@ -1249,6 +1299,7 @@ void Map::removeObjectFromSelection(Object* object, bool emit_selection_changed)
 	Q_ASSERT(removed && "Map::removeObjectFromSelection: object was not selected!");
 	Q_UNUSED(removed);
 	removeSelectionRenderables(object);
+	selection_statistics.remove(object);
 	if (first_selected_object == object)
 		first_selected_object = object_selection.empty() ? nullptr : *object_selection.begin();
 	if (emit_selection_changed)
@@ -1269,6 +1320,7 @@ bool Map::removeSymbolFromSelection(const Symbol* symbol, bool emit_selection_ch
 		
 		removed_at_least_one_object = true;
 		removeSelectionRenderables(*it);
+		selection_statistics.remove(*it);
 		Object* removed_object = *it;
 		it = object_selection.erase(it);
 		if (first_selected_object == removed_object)
@@ -1302,12 +1354,25 @@ void Map::clearObjectSelection(bool emit_selection_changed)
 {
 	selection_renderables->clear();
 	object_selection.clear();
+	selection_statistics.clear();
 	first_selected_object = nullptr;
 	
 	if (emit_selection_changed)
 		emit objectSelectionChanged();
 }
 
+const SelectionStatistics& Map::selectionStatistics() const
+{
+	return selection_statistics;
+}
+
+void Map::updateSelectionStatistics()
+{
+	selection_statistics.clear();
+	for (const auto object : object_selection)
+		selection_statistics.add(object);
+}
+
 void Map::emitSelectionChanged()
 {
 	emit objectSelectionChanged();
@@ -1321,11 +1386,19 @@ void Map::emitSelectionEdited()
 void Map::addMapWidget(MapWidget* widget)
 {
 	widgets.push_back(widget);
+	if (!idle_compaction_timer->isActive())
+		idle_compaction_timer->start();
+	memory_budget->setActive(true);
 }
 
 void Map::removeMapWidget(MapWidget* widget)
 {
 	widgets.erase(std::remove(begin(widgets), end(widgets), widget), end(widgets));
+	if (widgets.empty())
+	{
+		idle_compaction_timer->stop();
+		memory_budget->setActive(false);
+	}
 }
 
 
@@ -1646,6 +1719,15 @@ QHash<const Symbol*, Symbol*> Map::importSymbols(
 {
 	QHash<const Symbol*, Symbol*> out_pointermap;
 	
+	// Candidate matches by hash, in the order of the existing symbols
+	std::unordered_map<uint, std::vector<Symbol*>> buckets;
+	if (merge_duplicates)
+	{
+		buckets.reserve(symbols.size());
+		for (auto symbol : symbols)
+			buckets[symbol->structuralHash()].push_back(symbol);
+	}
+	
 	std::vector<Symbol*> created_symbols;
 	created_symbols.reserve(other.symbols.size());
 	for (std::size_t i = 0, last = other.symbols.size(); i < last; ++i)
@@ -1656,14 +1738,18 @@ QHash<const Symbol*, Symbol*> Map::importSymbols(
 			if (merge_duplicates)
 			{
 				// Check if symbol is already present
-				auto match = std::find_if(begin(symbols), end(symbols), [symbol](auto s) {
-					return s->equals(symbol, Qt::CaseInsensitive, false);
-				});
-				if (match != end(symbols))
+				auto const bucket = buckets.find(symbol->structuralHash());
+				if (bucket != buckets.end())
 				{
-					// Symbol is already present
-					out_pointermap.insert(symbol, *match);
-					continue;
+					auto match = std::find_if(begin(bucket->second), end(bucket->second), [symbol](auto s) {
+						return s->equals(symbol, Qt::CaseInsensitive, false);
+					});
+					if (match != end(bucket->second))
+					{
+						// Symbol is already present
+						out_pointermap.insert(symbol, *match);
+						continue;
+					}
 				}
 			}
 			
@@ -1685,13 +1771,7 @@ QHash<const Symbol*, Symbol*> Map::importSymbols(
 	
 	// Notify the created symbols of the new context (mind combined symbols)
 	for (const auto symbol : created_symbols)
-	{
-		for (auto it = out_pointermap.constBegin(); it != out_pointermap.constEnd(); ++it)
-		{
-			// symbol is what was created by duplicate() above.
-			symbol->symbolChanged(it.key(), it.value());
-		}
-	}
+		symbol->symbolsChanged(out_pointermap);
 	
 	return out_pointermap;
 }
@@ -1700,6 +1780,7 @@ QHash<const Symbol*, Symbol*> Map::importSymbols(
 
 void Map::addSelectionRenderables(const Object* object)
 {
+	object->restoreRenderables();
 	object->update();
 	selection_renderables->insertRenderablesOfObject(object);
 }
@@ -2061,7 +2142,7 @@ void Map::setTemplateAreaDirty(Template* temp, const QRectF& area, int pixel_bor
 	{
 		const MapView* map_view = widget->getMapView();
 		if (map_view->isTemplateVisible(temp))
-			widget->markTemplateCacheDirty(map_view->calculateViewBoundingBox(area), pixel_border, front_cache);
+			widget->markTemplateCacheDirty(map_view->calculateViewBoundingBox(area), pixel_border, front_cache, temp);
 	}
 }
 
@@ -2499,12 +2580,54 @@ void Map::rotateAllObjects(double rotation, const MapCoord& center)
 
 void Map::updateAllObjects()
 {
-	applyOnAllObjects(&Object::forceUpdate);
+	scheduleObjectUpdates([](const Object*) { return true; });
 }
 
 void Map::updateAllObjectsWithSymbol(const Symbol* symbol)
 {
-	applyOnMatchingObjects(&Object::forceUpdate, ObjectOp::HasSymbol{symbol});
+	scheduleObjectUpdates(ObjectOp::HasSymbol{symbol});
+}
+
+void Map::scheduleObjectUpdates(const std::function<bool (const Object*)>& condition)
+{
+	if (widgets.empty())
+	{
+		// Nobody is waiting for a responsive display.
+		applyOnMatchingObjects(&Object::forceUpdate, condition);
+		return;
+	}
+	
+	object_updates->schedule(condition, visibleAreas());
+}
+
+std::vector<QRectF> Map::visibleAreas() const
+{
+	std::vector<QRectF> visible_areas;
+	visible_areas.reserve(widgets.size());
+	for (const auto* widget : widgets)
+	{
+		if (widget->isVisible())
+			visible_areas.push_back(widget->getMapView()->calculateViewedRect(widget->viewportToView(widget->rect())));
+	}
+	return visible_areas;
+}
+
+bool Map::hasPendingObjectUpdates() const
+{
+	return object_updates->isPending();
+}
+
+void Map::finishObjectUpdates()
+{
+	object_updates->finish();
+}
+
+int Map::compactIdleObjects()
+{
+	auto count = 0;
+	for (auto* part : parts)
+		count += part->compactIdleObjects();
+	return count;
 }
 
 void Map::changeSymbolForAllObjects(const Symbol* old_symbol, const Symbol* new_symbol)
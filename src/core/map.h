@@ -44,9 +44,11 @@
 #include "core/map_coord.h"
 #include "core/map_grid.h"
 #include "core/map_part.h"
+#include "core/selection_statistics.h"
 
 class QIODevice;
 class QPainter;
+class QTimer;
 class QTranslator;
 class QWidget;
 // IWYU pragma: no_forward_declare QRectF
@@ -64,6 +66,8 @@ class MapRenderables;
 class MapView;
 class MapWidget;
 class Object;
+class ObjectMemoryBudget;
+class ObjectUpdateScheduler;
 class PointSymbol;
 class RenderConfig;
 class Symbol;
@@ -316,10 +320,19 @@ public:
 	
 	/**
 	 * Updates the renderables and extent of all objects which have changed.
-	 * This is automatically called by draw(), you normally do not need to call it directly.
 	 */
 	void updateObjects();
 	
+	/**
+	 * Makes the objects in the given area ready for drawing.
+	 * 
+	 * This updates the objects which have changed, and restores evicted
+	 * renderables. While deferred object updates are pending, dirty objects
+	 * outside of the area are left to the background updates.
+	 * This is automatically called by draw(), you normally do not need to call it directly.
+	 */
+	void updateObjects(const QRectF& bounding_box);
+	
 	/** 
 	 * Calculates the extent of all map elements. 
 	 * 
@@ -961,12 +974,64 @@ public:
 	/** Rotates all objects by the given rotation angle (in radians). */
 	void rotateAllObjects(double rotation, const MapCoord& center);
 	
-	/** Forces an update of all objects, i.e. calls update(true) on each map object. */
+	/**
+	 * Forces an update of all objects.
+	 * 
+	 * When the map is shown in map widgets, only the visible objects and the
+	 * selected objects are updated immediately. All other objects keep their
+	 * current renderables until they are updated in the background.
+	 * 
+	 * @see finishObjectUpdates()
+	 */
 	void updateAllObjects();
 	
-	/** Forces an update of all objects with the given symbol. */
+	/**
+	 * Forces an update of all objects with the given symbol.
+	 * 
+	 * Like updateAllObjects(), this may defer the update of objects which
+	 * are not visible.
+	 */
 	void updateAllObjectsWithSymbol(const Symbol* symbol);
 	
+	/**
+	 * Returns true if there are objects waiting for a deferred update.
+	 */
+	bool hasPendingObjectUpdates() const;
+	
+	/**
+	 * Immediately completes all deferred object updates.
+	 * 
+	 * This must be called before the map's objects are used as a whole,
+	 * e.g. for saving, printing or exporting.
+	 */
+	void finishObjectUpdates();
+	
+	/**
+	 * Compacts the coordinates of objects which were not used since the
+	 * previous call, and returns the number of compacted objects.
+	 * 
+	 * Selected objects and objects waiting for an update are not compacted.
+	 * While the map is shown in map widgets, this function is called every
+	 * idle_compaction_interval milliseconds.
+	 * 
+	 * @see Object::compact()
+	 */
+	int compactIdleObjects();
+	
+	/** The interval (in ms) of the automatic compaction of idle objects. */
+	static constexpr int idle_compaction_interval = 60000;
+	
+	/**
+	 * Returns the areas (in map coordinates) shown in visible map widgets.
+	 */
+	std::vector<QRectF> visibleAreas() const;
+	
+	/**
+	 * Returns a counter which changes whenever objects' renderables are
+	 * inserted or removed, i.e. when objects are added, changed or deleted.
+	 */
+	quint64 objectsRevision() const { return objects_revision; }
+	
 	/** For all symbols with old_symbol, replaces the symbol by new_symbol. */
 	void changeSymbolForAllObjects(const Symbol* old_symbol, const Symbol* new_symbol);
 	
@@ -1108,6 +1173,14 @@ public:
 	/** Returns true if the given object is selected. */
 	bool isObjectSelected(const Object* object) const;
 	
+	/**
+	 * Returns aggregate information about the selected objects.
+	 * 
+	 * The statistics are maintained while the selection changes,
+	 * and rebuilt when selectedObjectEdited() is emitted.
+	 */
+	const SelectionStatistics& selectionStatistics() const;
+	
 	/**
 	 * Toggles the selection of the given object.
 	 * Returns true if the object was selected, false if deselected.
@@ -1499,6 +1572,17 @@ private:
 	);
 	
 	
+	/**
+	 * Forces an update of the objects matching the condition,
+	 * deferring the update of objects which are not visible.
+	 */
+	void scheduleObjectUpdates(const std::function<bool (const Object*)>& condition);
+	
+	/**
+	 * Rebuilds the selection statistics after changes to the selected objects.
+	 */
+	void updateSelectionStatistics();
+	
 	void addSelectionRenderables(const Object* object);
 	void updateSelectionRenderables(const Object* object);
 	void removeSelectionRenderables(const Object* object);
@@ -1515,12 +1599,17 @@ private:
 	int first_front_template = 0;		// index of the first template in templates which should be drawn in front of the map
 	PartVector parts;
 	ObjectSelection object_selection;
+	SelectionStatistics selection_statistics;
 	Object* first_selected_object = nullptr;
 	QScopedPointer<UndoManager> undo_manager;
 	std::size_t current_part_index = 0;
 	WidgetVector widgets;
 	QScopedPointer<MapRenderables> renderables;
 	QScopedPointer<MapRenderables> selection_renderables;
+	QScopedPointer<ObjectUpdateScheduler> object_updates;
+	QScopedPointer<QTimer> idle_compaction_timer;
+	QScopedPointer<ObjectMemoryBudget> memory_budget;
+	quint64 objects_revision = 0;
 	
 	QString map_notes;
 	
@@ -161,6 +161,17 @@ bool MapColor::equals(const MapColor& other, bool compare_priority) const
 	       (qAbs(opacity - other.opacity) < 1e-03);
 }
 
+uint MapColor::structuralHash() const
+{
+	// Only members which equals() compares exactly.
+	auto seed = qHash(name.toCaseFolded());
+	seed ^= uint(spot_color_method) << 1;
+	seed ^= uint(cmyk_color_method) << 5;
+	seed ^= uint(rgb_color_method) << 9;
+	seed ^= uint(quint8(flags)) << 13;
+	return seed;
+}
+
 
 void MapColor::setSpotColorName(const QString& spot_color_name) 
 { 
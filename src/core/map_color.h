@@ -384,6 +384,14 @@ public:
 	/** Compares this color and another. */
 	bool equals(const MapColor& other, bool compare_priority) const;
 	
+	/**
+	 * Returns a hash value which is consistent with equals().
+	 * 
+	 * The hash does not depend on the priority, so colors which are equal
+	 * with or without comparing the priority have the same hash value.
+	 */
+	uint structuralHash() const;
+	
 	/** Compares two colors given by pointers.
 	 *  Returns true if the colors are equal or if both pointers are nullptr. */
 	static bool equal(const MapColor* color, const MapColor* other);
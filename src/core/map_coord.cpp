@@ -25,6 +25,7 @@
 #include <stdexcept>
 #include <type_traits>
 
+#include <QByteArray>
 #include <QChar>
 #include <QLatin1Char>
 #include <QLatin1String>
@@ -32,6 +33,7 @@
 #include <QStringRef>
 
 #include "util/xml_stream_util.h"
+#include "util/xml_utf8_writer.h"
 
 
 namespace OpenOrienteering {
@@ -227,6 +229,18 @@ void MapCoord::save(QXmlStreamWriter& xml) const
 	}
 }
 
+void MapCoord::save(XmlUtf8Writer& xml) const
+{
+	xml.writeStartElement(XmlStreamLiteral::coord);
+	xml.writeAttribute(literal::x, xp);
+	xml.writeAttribute(literal::y, yp);
+	if (fp)
+	{
+		xml.writeAttribute(literal::flags, int(Flags::Int(fp)));
+	}
+	xml.writeEndElement();
+}
+
 MapCoord MapCoord::load(QXmlStreamReader& xml)
 {
 	XmlElementReader element(xml);
@@ -266,100 +280,87 @@ MapCoord::MapCoord(const LegacyMapCoord& coord) noexcept
 
 #endif
 
-QString MapCoord::toString() const
+namespace {
+
+/* The buffer size for the text representation must allow for
+ *  1x ';':   1
+ *  2x '-':   2
+ *  2x ' ':   2
+ *  2x the decimal digits for values up to 0..2^31:
+ *           20
+ *  1x the decimal digits for 0..2^8-1:
+ *            3
+ *  Total:   28 */
+constexpr std::size_t text_buffer_size = 1+2+2+20+3;
+
+/**
+ * Writes the decimal digits of value, and a sign, in front of pos.
+ * 
+ * Returns the new front position.
+ */
+char* prependNumber(char* pos, qint64 value)
 {
-	/* The buffer size must allow for
-	 *  1x ';':   1
-	 *  2x '-':   2
-	 *  2x ' ':   2
-	 *  2x the decimal digits for values up to 0..2^31:
-	 *           20
-	 *  1x the decimal digits for 0..2^8-1:
-	 *            3
-	 *  Total:   28 */
-	constexpr std::size_t buf_size = 1+2+2+20+3;
-	static const QChar encoded[10] = {
-	    QLatin1Char{'0'}, QLatin1Char{'1'},
-	    QLatin1Char{'2'}, QLatin1Char{'3'},
-	    QLatin1Char{'4'}, QLatin1Char{'5'},
-	    QLatin1Char{'6'}, QLatin1Char{'7'},
-	    QLatin1Char{'8'}, QLatin1Char{'9'}
-	};
-	QChar buffer[buf_size];
-	
-	// For efficiency, we construct the string from the back.
-	std::size_t j = buf_size - 1;
-	buffer[j] = QLatin1Char{';'};
-	--j;
-	
-	auto flags = Flags::Int(fp);
+	auto const negative = value < 0;
+	if (negative)
+		value = -value;
+	do
+	{
+		*--pos = char('0' + value % 10);
+		value = value / 10;
+	}
+	while (value != 0);
+	if (negative)
+		*--pos = '-';
+	return pos;
+}
+
+/**
+ * Writes the text representation of the coordinate in front of end.
+ * 
+ * For efficiency, the text is constructed from the back.
+ * Returns the front position.
+ */
+char* prependText(char* end, qint32 x, qint32 y, unsigned int flags)
+{
+	static_assert(sizeof(qint64) > sizeof(qint32),
+	              "qint64 must be large enough to hold"
+	              "-std::numeric_limits<qint32>::min()" );
+	auto pos = end;
+	*--pos = ';';
 	if (flags > 0)
 	{
 		do
 		{
-			buffer[j] = encoded[flags % 10];
+			*--pos = char('0' + flags % 10);
 			flags = flags / 10;
-			--j;
 		}
 		while (flags != 0);
-		
-		buffer[j] = QChar::Space;
-		--j;
-	}
-	
-	qint64 tmp = yp;
-	static_assert(sizeof(decltype(tmp)) > sizeof(decltype(MapCoord::yp)),
-	              "decltype(tmp) must be large enough to hold"
-	              "-std::numeric_limits<decltype(MapCoord::yp)>::min()" );
-	QChar sign { QChar::Null };
-	if (tmp < 0)
-	{
-		sign = QLatin1Char{'-'};
-		tmp = -tmp;
-	}
-	do
-	{
-		buffer[j] = encoded[tmp % 10];
-		tmp = tmp / 10;
-		--j;
-	}
-	while (tmp != 0);
-	if (!sign.isNull())
-	{
-		buffer[j] = sign;
-		--j;
-		sign = QChar::Null;
-	}
-	
-	buffer[j] = QChar::Space;
-	--j;
-	
-	static_assert(sizeof(decltype(tmp)) > sizeof(decltype(MapCoord::xp)),
-	              "decltype(tmp) must be large enough to hold"
-	              "-std::numeric_limits<decltype(MapCoord::xp)>::min()" );
-	tmp = xp;
-	if (tmp < 0)
-	{
-		sign = QLatin1Char{'-'};
-		tmp = -tmp;
-	}
-	do
-	{
-		buffer[j] = encoded[tmp % 10];
-		tmp = tmp / 10;
-		--j;
-	}
-	while (tmp != 0);
-	if (!sign.isNull())
-	{
-		buffer[j] = sign;
-		--j;
+		*--pos = ' ';
 	}
-	
-	++j;
-	Q_ASSERT(j < buf_size);
-	j = qMin(j, buf_size);
-	return QString(buffer+j, buf_size-j);
+	pos = prependNumber(pos, y);
+	*--pos = ' ';
+	pos = prependNumber(pos, x);
+	Q_ASSERT(end - pos <= std::ptrdiff_t(text_buffer_size));
+	return pos;
+}
+
+}  // namespace
+
+
+QString MapCoord::toString() const
+{
+	char buffer[text_buffer_size];
+	auto const end = buffer + text_buffer_size;
+	auto const start = prependText(end, xp, yp, Flags::Int(fp));
+	return QString::fromLatin1(start, int(end - start));
+}
+
+void MapCoord::appendText(QByteArray& data) const
+{
+	char buffer[text_buffer_size];
+	auto const end = buffer + text_buffer_size;
+	auto const start = prependText(end, xp, yp, Flags::Int(fp));
+	data.append(start, int(end - start));
 }
 
 MapCoord::MapCoord(QStringRef& text)
@@ -32,11 +32,14 @@
 #include <QPointF>
 #include <QString>
 
+class QByteArray;
 class QXmlStreamReader;
 class QXmlStreamWriter;
 
 namespace OpenOrienteering {
 
+class XmlUtf8Writer;
+
 #ifndef NO_NATIVE_FILE_FORMAT
 	
 /**
@@ -408,6 +411,13 @@ public:
 	 */
 	QString toString() const;
 	
+	/**
+	 * Appends the same text as toString() to the byte array.
+	 * 
+	 * The text is plain ASCII, i.e. valid UTF-8.
+	 */
+	void appendText(QByteArray& data) const;
+	
 	/**
 	 * Constructs the MapCoord from the beginning of text, and moves the 
 	 * reference to behind the this coordinates data.
@@ -426,6 +436,9 @@ public:
 	/** Saves the MapCoord in xml format to the stream. */
 	void save(QXmlStreamWriter& xml) const;
 	
+	/** Saves the MapCoord in xml format to the writer. */
+	void save(XmlUtf8Writer& xml) const;
+	
 	/** Loads the MapCoord in xml format from the stream.
 	 *
 	 * This will initialize the boundsOffset() if neccessary. Otherwise it will
@@ -0,0 +1,249 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_diff.h"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+
+#include <QHash>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+#include "core/map.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/symbols/symbol.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+std::vector<const Object*> collectObjects(const Map& map)
+{
+	std::vector<const Object*> objects;
+	objects.reserve(std::size_t(map.getNumObjects()));
+	for (int i = 0; i < map.getNumParts(); ++i)
+	{
+		const auto* part = map.getPart(std::size_t(i));
+		for (int j = 0; j < part->getNumObjects(); ++j)
+			objects.push_back(part->getObject(j));
+	}
+	return objects;
+}
+
+/** Returns true if both symbols have the same type and number. */
+bool sameSymbolNumber(const Symbol* lhs, const Symbol* rhs)
+{
+	if (!lhs || !rhs)
+		return lhs == rhs;
+	if (lhs->getType() != rhs->getType())
+		return false;
+	for (int i = 0; i < Symbol::number_components; ++i)
+	{
+		if (lhs->getNumberComponent(i) != rhs->getNumberComponent(i))
+			return false;
+	}
+	return true;
+}
+
+QPointF center(const Object* object)
+{
+	object->update();
+	return object->getExtent().center();
+}
+
+quint64 cellKey(qint64 x, qint64 y)
+{
+	return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+qint64 cellIndex(qreal value)
+{
+	return qint64(std::floor(value / MapDiff::cell_size));
+}
+
+}  // namespace
+
+
+
+MapDiff::MapDiff(const Map& old_map, const Map& new_map)
+{
+	compareSymbols(old_map, new_map);
+	compareObjects(old_map, new_map);
+}
+
+MapDiff::~MapDiff()
+{
+	// nothing, not inlined
+}
+
+
+bool MapDiff::isEmpty() const
+{
+	return added_symbols.empty()
+	       && removed_symbols.empty()
+	       && modified_symbols.empty()
+	       && added_objects.empty()
+	       && removed_objects.empty()
+	       && modified_objects.empty();
+}
+
+
+void MapDiff::compareSymbols(const Map& old_map, const Map& new_map)
+{
+	// Symbol numbers are expected to be unique, but this is not enforced.
+	// Duplicates are matched in map order.
+	QHash<QString, std::vector<int>> old_symbols;
+	for (int i = old_map.getNumSymbols() - 1; i >= 0; --i)
+		old_symbols[old_map.getSymbol(i)->getNumberAsString()].push_back(i);
+	
+	std::vector<bool> old_matched(std::size_t(old_map.getNumSymbols()), false);
+	for (int i = 0; i < new_map.getNumSymbols(); ++i)
+	{
+		const auto* new_symbol = new_map.getSymbol(i);
+		auto found = old_symbols.find(new_symbol->getNumberAsString());
+		if (found == old_symbols.end() || found->empty())
+		{
+			added_symbols.push_back(new_symbol);
+			continue;
+		}
+		
+		auto const old_index = found->back();
+		found->pop_back();
+		old_matched[std::size_t(old_index)] = true;
+		
+		const auto* old_symbol = old_map.getSymbol(old_index);
+		if (!old_symbol->equals(new_symbol))
+			modified_symbols.push_back({old_symbol, new_symbol});
+	}
+	
+	for (int i = 0; i < old_map.getNumSymbols(); ++i)
+	{
+		if (!old_matched[std::size_t(i)])
+			removed_symbols.push_back(old_map.getSymbol(i));
+	}
+}
+
+
+void MapDiff::compareObjects(const Map& old_map, const Map& new_map)
+{
+	auto const old_objects = collectObjects(old_map);
+	auto const new_objects = collectObjects(new_map);
+	std::vector<bool> old_matched(old_objects.size(), false);
+	std::vector<bool> new_matched(new_objects.size(), false);
+	
+	// Pass 1: identical objects
+	std::unordered_multimap<quint64, std::size_t> old_by_hash;
+	old_by_hash.reserve(old_objects.size());
+	for (std::size_t i = 0; i < old_objects.size(); ++i)
+		old_by_hash.emplace(old_objects[i]->contentHash(), i);
+	
+	for (std::size_t j = 0; j < new_objects.size(); ++j)
+	{
+		const auto* new_object = new_objects[j];
+		auto range = old_by_hash.equal_range(new_object->contentHash());
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			// The hash covers the symbol number, equals() covers hash collisions.
+			if (old_objects[it->second]->equals(new_object, false))
+			{
+				old_matched[it->second] = true;
+				new_matched[j] = true;
+				old_by_hash.erase(it);
+				break;
+			}
+		}
+	}
+	
+	// Pass 2: modified objects, matched by proximity
+	std::unordered_map<quint64, std::vector<std::size_t>> grid;
+	std::vector<QPointF> old_centers(old_objects.size());
+	for (std::size_t i = 0; i < old_objects.size(); ++i)
+	{
+		if (old_matched[i])
+			continue;
+		old_centers[i] = center(old_objects[i]);
+		grid[cellKey(cellIndex(old_centers[i].x()), cellIndex(old_centers[i].y()))].push_back(i);
+	}
+	
+	for (std::size_t j = 0; j < new_objects.size(); ++j)
+	{
+		if (new_matched[j])
+			continue;
+		
+		const auto* new_object = new_objects[j];
+		auto const new_center = center(new_object);
+		auto const cell_x = cellIndex(new_center.x());
+		auto const cell_y = cellIndex(new_center.y());
+		
+		auto best_index = old_objects.size();
+		auto best_distance = std::numeric_limits<qreal>::max();
+		for (auto x = cell_x - 1; x <= cell_x + 1; ++x)
+		{
+			for (auto y = cell_y - 1; y <= cell_y + 1; ++y)
+			{
+				auto cell = grid.find(cellKey(x, y));
+				if (cell == grid.end())
+					continue;
+				
+				for (auto i : cell->second)
+				{
+					const auto* old_object = old_objects[i];
+					if (old_matched[i]
+					    || old_object->getType() != new_object->getType()
+					    || !sameSymbolNumber(old_object->getSymbol(), new_object->getSymbol()))
+						continue;
+					
+					auto const delta = old_centers[i] - new_center;
+					auto const distance = QPointF::dotProduct(delta, delta);
+					if (distance < best_distance)
+					{
+						best_index = i;
+						best_distance = distance;
+					}
+				}
+			}
+		}
+		
+		if (best_index < old_objects.size())
+		{
+			old_matched[best_index] = true;
+			new_matched[j] = true;
+			modified_objects.push_back({old_objects[best_index], new_object});
+		}
+		else
+		{
+			added_objects.push_back(new_object);
+		}
+	}
+	
+	for (std::size_t i = 0; i < old_objects.size(); ++i)
+	{
+		if (!old_matched[i])
+			removed_objects.push_back(old_objects[i]);
+	}
+}
+
+
+}  // namespace OpenOrienteering
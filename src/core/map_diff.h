@@ -0,0 +1,129 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_MAP_DIFF_H
+#define OPENORIENTEERING_MAP_DIFF_H
+
+#include <vector>
+
+#include <QtGlobal>
+
+namespace OpenOrienteering {
+
+class Map;
+class Object;
+class Symbol;
+
+
+/**
+ * A structural comparison of two maps.
+ * 
+ * Symbols are matched by their number. Matched symbols which are not equal
+ * are reported as modified.
+ * 
+ * Objects are matched in two passes. The first pass pairs objects with
+ * identical content, by means of Object::contentHash(), regardless of their
+ * order in the map. The second pass pairs the remaining objects which have
+ * the same type and symbol number, and whose extents are close to each other.
+ * These pairs are reported as modified. All other objects are reported as
+ * removed or added.
+ * 
+ * Both passes use hash tables, so the comparison takes roughly linear time
+ * in the number of objects. This class does not depend on the GUI.
+ */
+class MapDiff
+{
+public:
+	/** A pair of matching symbols which are not equal. */
+	struct SymbolChange
+	{
+		const Symbol* old_symbol;
+		const Symbol* new_symbol;
+	};
+	
+	/** A pair of matching objects which are not equal. */
+	struct ObjectChange
+	{
+		const Object* old_object;
+		const Object* new_object;
+	};
+	
+	/**
+	 * Compares the given maps.
+	 * 
+	 * The maps must not be modified or destroyed while the result is in use.
+	 */
+	MapDiff(const Map& old_map, const Map& new_map);
+	
+	MapDiff(const MapDiff&) = default;
+	MapDiff(MapDiff&&) = default;
+	
+	~MapDiff();
+	
+	MapDiff& operator=(const MapDiff&) = default;
+	MapDiff& operator=(MapDiff&&) = default;
+	
+	
+	/** Returns true if no differences were found. */
+	bool isEmpty() const;
+	
+	/** Symbols which exist only in the new map. */
+	const std::vector<const Symbol*>& addedSymbols() const { return added_symbols; }
+	
+	/** Symbols which exist only in the old map. */
+	const std::vector<const Symbol*>& removedSymbols() const { return removed_symbols; }
+	
+	/** Symbols which exist in both maps, but with different properties. */
+	const std::vector<SymbolChange>& modifiedSymbols() const { return modified_symbols; }
+	
+	/** Objects which exist only in the new map, in map order. */
+	const std::vector<const Object*>& addedObjects() const { return added_objects; }
+	
+	/** Objects which exist only in the old map, in map order. */
+	const std::vector<const Object*>& removedObjects() const { return removed_objects; }
+	
+	/** Objects which were matched by proximity, in the order of the new map. */
+	const std::vector<ObjectChange>& modifiedObjects() const { return modified_objects; }
+	
+	
+	/**
+	 * The size (in mm) of the grid cells used for matching objects by proximity.
+	 * 
+	 * Objects are candidates for a match if the centers of their extents
+	 * are in the same or in adjacent cells.
+	 */
+	static constexpr qreal cell_size = 10.0;
+	
+private:
+	void compareSymbols(const Map& old_map, const Map& new_map);
+	
+	void compareObjects(const Map& old_map, const Map& new_map);
+	
+	std::vector<const Symbol*> added_symbols;
+	std::vector<const Symbol*> removed_symbols;
+	std::vector<SymbolChange>  modified_symbols;
+	std::vector<const Object*> added_objects;
+	std::vector<const Object*> removed_objects;
+	std::vector<ObjectChange>  modified_objects;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -0,0 +1,872 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "map_generalizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <QtGlobal>
+#include <QBuffer>
+#include <QIODevice>
+#include <QLatin1Char>
+#include <QPointF>
+#include <QRectF>
+#include <QRunnable>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/map_topology.h"
+#include "core/path_coord.h"
+#include "core/objects/boolean_tool.h"
+#include "core/objects/object.h"
+#include "core/symbols/symbol.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The maximum number of iterations for resolving point conflicts
+constexpr int max_displacement_iterations = 50;
+
+
+/**
+ * An object of the derived map which is subject to generalization.
+ *
+ * The generalization operates on the results, which initially hold a copy
+ * of the original object. If the results are changed, they replace the
+ * original object when the work is committed.
+ */
+struct Item
+{
+	int index;                                    ///< The index of the original in its part
+	const MapGeneralizer::SymbolRule* rule;
+	std::vector<std::unique_ptr<Object>> results;
+	bool changed;
+};
+
+
+/**
+ * The items of a partition cell.
+ */
+struct Cell
+{
+	const MapTopology* topology = nullptr;
+	std::vector<const PathObject*> originals;     ///< The originals of the items
+	std::vector<const PathObject*> context;       ///< Other paths, not to be modified
+	std::vector<Item> items;
+	MapGeneralizer::Report report;
+};
+
+
+/**
+ * A segment of a path, for checking simplifications.
+ */
+struct Segment
+{
+	MapCoordF first;
+	MapCoordF last;
+};
+
+
+double squaredDistanceToSegment(const MapCoordF& point, const MapCoordF& first, const MapCoordF& last)
+{
+	auto const segment = last - first;
+	auto const length_squared = segment.lengthSquared();
+	auto param = 0.0;
+	if (length_squared > 0)
+		param = qBound(0.0, MapCoordF::dotProduct(point - first, segment) / length_squared, 1.0);
+	return (point - (first + param * segment)).lengthSquared();
+}
+
+
+double cross(const MapCoordF& a, const MapCoordF& b)
+{
+	return a.x() * b.y() - a.y() * b.x();
+}
+
+
+/**
+ * Returns true if the segments cross each other in a single interior point.
+ */
+bool segmentsCross(const MapCoordF& a1, const MapCoordF& a2, const MapCoordF& b1, const MapCoordF& b2)
+{
+	auto const d1 = cross(a2 - a1, b1 - a1);
+	auto const d2 = cross(a2 - a1, b2 - a1);
+	auto const d3 = cross(b2 - b1, a1 - b1);
+	auto const d4 = cross(b2 - b1, a2 - b1);
+	return ((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0))
+	       && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0));
+}
+
+
+/**
+ * Returns the segments of the path's coordinates, including curve handles.
+ */
+std::vector<Segment> segmentsOf(const PathObject* path)
+{
+	std::vector<Segment> segments;
+	const auto& coords = path->getRawCoordinateVector();
+	for (const auto& part : path->parts())
+	{
+		for (auto i = part.first_index; i < part.last_index; ++i)
+			segments.push_back({ MapCoordF(coords[i]), MapCoordF(coords[i+1]) });
+	}
+	return segments;
+}
+
+
+/**
+ * Returns true if the areas are closer than the given distance.
+ */
+bool areasAreClose(const PathObject* a, const PathObject* b, double distance)
+{
+	auto const distance_squared = distance * distance;
+	auto const verticesAreClose = [distance_squared](const PathObject* vertices, const PathObject* edges) {
+		for (const auto& part : vertices->parts())
+		{
+			for (const auto& vertex : part.path_coords)
+			{
+				for (const auto& edge_part : edges->parts())
+				{
+					const auto& path_coords = edge_part.path_coords;
+					for (std::size_t i = 1; i < path_coords.size(); ++i)
+					{
+						if (squaredDistanceToSegment(vertex.pos, path_coords[i-1].pos, path_coords[i].pos) < distance_squared)
+							return true;
+					}
+				}
+			}
+		}
+		return false;
+	};
+
+	return verticesAreClose(a, b)
+	       || verticesAreClose(b, a)
+	       || b->isPointInsideArea(a->parts().front().path_coords.front().pos)
+	       || a->isPointInsideArea(b->parts().front().path_coords.front().pos);
+}
+
+
+double areaOf(const PathObject* path)
+{
+	// Holes are subtracted from the outer boundary.
+	const auto& parts = path->parts();
+	if (parts.empty())
+		return 0;
+	auto area = parts.front().calculateArea();
+	if (parts.size() > 1)
+	{
+		area *= 2;
+		for (const auto& part : parts)
+			area -= part.calculateArea();
+	}
+	return area;
+}
+
+
+
+/**
+ * Generalizes the items of a single partition cell.
+ */
+class CellGeneralizer : public QRunnable
+{
+public:
+	CellGeneralizer(const MapGeneralizer::Options& options, Cell& cell)
+	: options(options)
+	, cell(cell)
+	{}
+
+	void run() override
+	{
+		for (auto& item : cell.items)
+		{
+			for (auto& object : item.results)
+				object->update();
+		}
+		aggregate();
+		removeSmallObjects();
+		displacePoints();
+		simplifyPaths();
+	}
+
+private:
+	/**
+	 * Merges areas of the same symbol which are closer than the aggregation distance.
+	 */
+	void aggregate()
+	{
+		std::map<const Symbol*, std::vector<std::size_t>> groups;
+		for (std::size_t i = 0; i < cell.items.size(); ++i)
+		{
+			const auto& item = cell.items[i];
+			auto const object = item.results.front().get();
+			if (item.rule->aggregation_distance > 0
+			    && object->getType() == Object::Path
+			    && (object->getSymbol()->getContainedTypes() & Symbol::Area)
+			    && !object->asPath()->parts().empty())
+			{
+				groups[object->getSymbol()].push_back(i);
+			}
+		}
+
+		for (const auto& group : groups)
+		{
+			const auto& indices = group.second;
+			if (indices.size() < 2)
+				continue;
+
+			auto const distance = cell.items[indices.front()].rule->aggregation_distance;
+			std::vector<std::size_t> cluster_of(indices.size());
+			std::iota(begin(cluster_of), end(cluster_of), std::size_t(0));
+			auto const find = [&cluster_of](std::size_t i) {
+				while (cluster_of[i] != i)
+					i = cluster_of[i] = cluster_of[cluster_of[i]];
+				return i;
+			};
+
+			for (std::size_t i = 0; i < indices.size(); ++i)
+			{
+				auto const a = cell.items[indices[i]].results.front()->asPath();
+				auto const extent = a->getExtent().adjusted(-distance, -distance, distance, distance);
+				for (std::size_t j = i + 1; j < indices.size(); ++j)
+				{
+					auto const b = cell.items[indices[j]].results.front()->asPath();
+					if (find(i) != find(j)
+					    && extent.intersects(b->getExtent())
+					    && areasAreClose(a, b, distance))
+					{
+						cluster_of[find(j)] = find(i);
+					}
+				}
+			}
+
+			std::map<std::size_t, std::vector<std::size_t>> clusters;
+			for (std::size_t i = 0; i < indices.size(); ++i)
+				clusters[find(i)].push_back(indices[i]);
+			for (const auto& cluster : clusters)
+			{
+				const auto& members = cluster.second;
+				if (members.size() < 2)
+					continue;
+
+				BooleanTool::PathObjects in_objects;
+				for (auto index : members)
+					in_objects.push_back(cell.items[index].results.front()->asPath());
+				BooleanTool::PathObjects out_objects;
+				BooleanTool tool(BooleanTool::Union, nullptr);
+				if (!tool.executeForAggregation(in_objects, qint64(std::llround(distance * 1000)), out_objects))
+				{
+					for (auto object : out_objects)
+						delete object;
+					continue;
+				}
+
+				// The first member takes the results.
+				for (auto index : members)
+				{
+					cell.items[index].results.clear();
+					cell.items[index].changed = true;
+				}
+				auto& first = cell.items[members.front()];
+				for (auto object : out_objects)
+				{
+					object->update();
+					first.results.emplace_back(object);
+				}
+				cell.report.aggregated_objects += int(members.size());
+				cell.report.aggregates += int(out_objects.size());
+			}
+		}
+	}
+
+	/**
+	 * Removes areas and lines which are below the minimum size.
+	 */
+	void removeSmallObjects()
+	{
+		for (auto& item : cell.items)
+		{
+			auto const rule = item.rule;
+			if (rule->min_area <= 0 && rule->min_length <= 0)
+				continue;
+
+			auto const is_small = [this, rule](const std::unique_ptr<Object>& object) {
+				if (object->getType() != Object::Path)
+					return false;
+
+				auto const path = object->asPath();
+				auto const contained_types = path->getSymbol()->getContainedTypes();
+				if (contained_types & Symbol::Area)
+				{
+					if (areaOf(path) >= rule->min_area)
+						return false;
+					++cell.report.removed_areas;
+					return true;
+				}
+				if (contained_types & Symbol::Line)
+				{
+					auto length = 0.0;
+					for (const auto& part : path->parts())
+						length += part.length();
+					if (length >= rule->min_length)
+						return false;
+					++cell.report.removed_lines;
+					return true;
+				}
+				return false;
+			};
+
+			auto const size = item.results.size();
+			item.results.erase(std::remove_if(begin(item.results), end(item.results), is_small), end(item.results));
+			if (item.results.size() != size)
+				item.changed = true;
+		}
+	}
+
+	/**
+	 * Moves displaceable point objects apart which are closer than the minimum distance.
+	 */
+	void displacePoints()
+	{
+		auto const min_distance = options.min_point_distance;
+		if (min_distance <= 0)
+			return;
+
+		struct Point
+		{
+			Item* item;
+			PointObject* object;
+			MapCoordF origin;
+			MapCoordF pos;
+			bool movable;
+		};
+		std::vector<Point> points;
+		for (auto& item : cell.items)
+		{
+			for (auto& object : item.results)
+			{
+				if (object->getType() == Object::Point)
+				{
+					auto const point = object->asPoint();
+					points.push_back({ &item, point, point->getCoordF(), point->getCoordF(), item.rule->displaceable });
+				}
+			}
+		}
+		if (points.size() < 2)
+			return;
+
+		auto const limit = [this](Point& point) {
+			auto const offset = point.pos - point.origin;
+			auto const length = offset.length();
+			if (length > options.max_displacement)
+				point.pos = point.origin + offset * (options.max_displacement / length);
+		};
+
+		// Sweep along the x axis, so that only nearby pairs are compared.
+		std::vector<std::size_t> order(points.size());
+		std::iota(begin(order), end(order), std::size_t(0));
+		auto const sortByX = [&points, &order]() {
+			std::sort(begin(order), end(order), [&points](std::size_t a, std::size_t b) {
+				return points[a].pos.x() < points[b].pos.x();
+			});
+		};
+		auto const forEachClosePair = [&](auto operation) {
+			for (std::size_t a = 0; a < order.size(); ++a)
+			{
+				for (auto b = a + 1; b < order.size() && points[order[b]].pos.x() - points[order[a]].pos.x() < min_distance; ++b)
+				{
+					auto& first = points[order[a]];
+					auto& second = points[order[b]];
+					auto const distance = (second.pos - first.pos).length();
+					if (distance < min_distance)
+						operation(first, second, distance);
+				}
+			}
+		};
+
+		for (int iteration = 0; iteration < max_displacement_iterations; ++iteration)
+		{
+			sortByX();
+			auto moved = false;
+			forEachClosePair([&](Point& first, Point& second, double distance) {
+				if (!first.movable && !second.movable)
+					return;
+
+				auto direction = MapCoordF(1, 0);
+				if (distance > 0)
+					direction = (second.pos - first.pos) / distance;
+				auto const deficit = min_distance - distance;
+				auto const first_pos = first.pos;
+				auto const second_pos = second.pos;
+				if (first.movable && second.movable)
+				{
+					first.pos = first.pos - direction * (deficit / 2);
+					second.pos = second.pos + direction * (deficit / 2);
+				}
+				else if (first.movable)
+				{
+					first.pos = first.pos - direction * deficit;
+				}
+				else
+				{
+					second.pos = second.pos + direction * deficit;
+				}
+				limit(first);
+				limit(second);
+				if (first.pos != first_pos || second.pos != second_pos)
+					moved = true;
+			});
+			if (!moved)
+				break;
+		}
+
+		sortByX();
+		auto const tolerance = 0.001;  // 1 µm, the native map resolution
+		forEachClosePair([&](Point& /* first */, Point& /* second */, double distance) {
+			if (distance < min_distance - tolerance)
+				++cell.report.unresolved_conflicts;
+		});
+
+		for (auto& point : points)
+		{
+			if ((point.pos - point.origin).length() > tolerance)
+			{
+				point.object->setPosition(point.pos);
+				point.item->changed = true;
+				++cell.report.displaced_points;
+			}
+		}
+	}
+
+	/**
+	 * Simplifies paths within the tolerance of their rule.
+	 */
+	void simplifyPaths()
+	{
+		// The original geometry of all paths in the cell
+		struct Obstacle
+		{
+			std::size_t item;
+			std::size_t result;
+			QRectF extent;
+			std::vector<Segment> segments;
+		};
+		std::vector<Obstacle> obstacles;
+		for (std::size_t i = 0; i < cell.items.size(); ++i)
+		{
+			const auto& results = cell.items[i].results;
+			for (std::size_t j = 0; j < results.size(); ++j)
+			{
+				if (results[j]->getType() == Object::Path)
+					obstacles.push_back({ i, j, results[j]->getExtent(), segmentsOf(results[j]->asPath()) });
+			}
+		}
+		for (auto path : cell.context)
+			obstacles.push_back({ cell.items.size(), 0, path->getExtent(), segmentsOf(path) });
+
+		for (std::size_t i = 0; i < cell.items.size(); ++i)
+		{
+			auto& item = cell.items[i];
+			auto const tolerance = item.rule->simplification_tolerance;
+			if (tolerance <= 0)
+				continue;
+
+			for (std::size_t j = 0; j < item.results.size(); ++j)
+			{
+				auto& object = item.results[j];
+				if (object->getType() != Object::Path)
+					continue;
+
+				std::vector<Segment> neighbour_segments;
+				auto const extent = object->getExtent().adjusted(-tolerance, -tolerance, tolerance, tolerance);
+				for (const auto& obstacle : obstacles)
+				{
+					if ((obstacle.item != i || obstacle.result != j) && obstacle.extent.intersects(extent))
+						neighbour_segments.insert(end(neighbour_segments), begin(obstacle.segments), end(obstacle.segments));
+				}
+
+				auto simplified = simplify(object->asPath(), cell.originals[i], tolerance, neighbour_segments);
+				if (simplified)
+				{
+					cell.report.removed_coordinates += int(object->asPath()->getCoordinateCount() - simplified->getCoordinateCount());
+					++cell.report.simplified_objects;
+					object = std::move(simplified);
+					item.changed = true;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Returns a simplified copy of the path, or nullptr if nothing can be simplified.
+	 *
+	 * Straight segments between fixed nodes are simplified by the
+	 * Douglas-Peucker algorithm. A shortcut is not taken if it crosses
+	 * the original geometry.
+	 */
+	std::unique_ptr<PathObject> simplify(const PathObject* path, const PathObject* original, double tolerance, const std::vector<Segment>& neighbour_segments) const
+	{
+		const auto& coords = path->getRawCoordinateVector();
+		auto const own_segments = segmentsOf(path);
+		auto const tolerance_squared = tolerance * tolerance;
+
+		auto const isShared = [this, original](const MapCoord& coord) {
+			const auto& incidences = cell.topology->incidences(coord);
+			return std::any_of(begin(incidences), end(incidences), [original](const MapTopology::Incidence& incidence) {
+				return incidence.object != original;
+			});
+		};
+
+		auto const crossesGeometry = [&](std::size_t first, std::size_t last, std::size_t part_offset) {
+			auto const a = MapCoordF(coords[first]);
+			auto const b = MapCoordF(coords[last]);
+			auto const crosses = [&a, &b](const Segment& segment) {
+				return segmentsCross(a, b, segment.first, segment.last);
+			};
+			for (std::size_t i = 0; i < own_segments.size(); ++i)
+			{
+				// Skip the segments which are replaced by the shortcut.
+				if (i + part_offset >= first && i + part_offset < last)
+					continue;
+				if (crosses(own_segments[i]))
+					return true;
+			}
+			return std::any_of(begin(neighbour_segments), end(neighbour_segments), crosses);
+		};
+
+		std::vector<bool> keep(coords.size(), true);
+		auto changed = false;
+		auto segment_offset = std::size_t(0);  // own_segments index = coord index - part number
+		for (const auto& part : path->parts())
+		{
+			auto const first_index = part.first_index;
+			auto const last_index = part.last_index;
+			auto const part_offset = first_index - segment_offset;
+			segment_offset += last_index - first_index;
+
+			std::vector<bool> is_fixed(last_index - first_index + 1, false);
+			for (auto i = first_index; i <= last_index; ++i)
+			{
+				const auto& coord = coords[i];
+				if (i == first_index || i == last_index
+				    || coord.isDashPoint() || coord.isGapPoint() || isShared(coord))
+				{
+					is_fixed[i - first_index] = true;
+				}
+				if (coord.isCurveStart() && i + 3 <= last_index)
+				{
+					// Keep the curve start, the handles, and the curve end.
+					for (auto j = i; j <= i + 3; ++j)
+						is_fixed[j - first_index] = true;
+				}
+			}
+			std::vector<std::size_t> fixed;
+			for (auto i = first_index; i <= last_index; ++i)
+			{
+				if (is_fixed[i - first_index])
+					fixed.push_back(i);
+			}
+
+			if (part.isClosed() && fixed.size() == 2)
+			{
+				// Anchor a closed part at the node which is farthest from its start.
+				auto farthest = first_index;
+				for (auto i = first_index + 1; i < last_index; ++i)
+				{
+					if ((MapCoordF(coords[i]) - MapCoordF(coords[first_index])).lengthSquared()
+					    > (MapCoordF(coords[farthest]) - MapCoordF(coords[first_index])).lengthSquared())
+						farthest = i;
+				}
+				if (farthest != first_index)
+					fixed.insert(begin(fixed) + 1, farthest);
+			}
+
+			std::vector<bool> part_keep(keep.begin() + std::ptrdiff_t(first_index), keep.begin() + std::ptrdiff_t(last_index) + 1);
+			std::vector<std::pair<std::size_t, std::size_t>> runs;
+			for (std::size_t i = 1; i < fixed.size(); ++i)
+			{
+				if (fixed[i] - fixed[i-1] >= 2)
+					runs.emplace_back(fixed[i-1], fixed[i]);
+			}
+			while (!runs.empty())
+			{
+				auto const run = runs.back();
+				runs.pop_back();
+
+				auto max_distance = -1.0;
+				auto farthest = run.first + 1;
+				for (auto i = run.first + 1; i < run.second; ++i)
+				{
+					auto const distance = squaredDistanceToSegment(MapCoordF(coords[i]), MapCoordF(coords[run.first]), MapCoordF(coords[run.second]));
+					if (distance > max_distance)
+					{
+						max_distance = distance;
+						farthest = i;
+					}
+				}
+				if (max_distance <= tolerance_squared && !crossesGeometry(run.first, run.second, part_offset))
+				{
+					for (auto i = run.first + 1; i < run.second; ++i)
+						part_keep[i - first_index] = false;
+					continue;
+				}
+				if (farthest - run.first >= 2)
+					runs.emplace_back(run.first, farthest);
+				if (run.second - farthest >= 2)
+					runs.emplace_back(farthest, run.second);
+			}
+
+			// Don't let parts degenerate.
+			auto const kept = std::size_t(std::count(begin(part_keep), end(part_keep), true));
+			if (kept < (part.isClosed() ? 4u : 2u) || kept == part_keep.size())
+				continue;
+
+			std::copy(begin(part_keep), end(part_keep), keep.begin() + std::ptrdiff_t(first_index));
+			changed = true;
+		}
+
+		if (!changed)
+			return {};
+
+		MapCoordVector simplified_coords;
+		simplified_coords.reserve(coords.size());
+		for (std::size_t i = 0; i < coords.size(); ++i)
+		{
+			if (keep[i])
+				simplified_coords.push_back(coords[i]);
+		}
+
+		auto simplified = std::unique_ptr<PathObject>(new PathObject(path->getSymbol(), simplified_coords));
+		simplified->setTags(path->tags());
+		simplified->setPatternRotation(path->getPatternRotation());
+		simplified->setPatternOrigin(path->getPatternOrigin());
+		simplified->update();
+		return simplified;
+	}
+
+	const MapGeneralizer::Options& options;
+	Cell& cell;
+};
+
+
+void addReport(MapGeneralizer::Report& total, const MapGeneralizer::Report& report)
+{
+	total.aggregated_objects += report.aggregated_objects;
+	total.aggregates += report.aggregates;
+	total.removed_areas += report.removed_areas;
+	total.removed_lines += report.removed_lines;
+	total.displaced_points += report.displaced_points;
+	total.unresolved_conflicts += report.unresolved_conflicts;
+	total.simplified_objects += report.simplified_objects;
+	total.removed_coordinates += report.removed_coordinates;
+}
+
+
+}  // namespace
+
+
+
+MapGeneralizer::MapGeneralizer(Map& source, const Options& options)
+: source(source)
+, generalizer_options(options)
+{
+	// nothing else
+}
+
+MapGeneralizer::~MapGeneralizer()
+{
+	// nothing, not inlined
+}
+
+
+void MapGeneralizer::setRule(const Symbol* symbol, const SymbolRule& rule)
+{
+	rules.insert(symbol, rule);
+}
+
+const MapGeneralizer::SymbolRule& MapGeneralizer::rule(const Symbol* symbol) const
+{
+	auto found = rules.constFind(symbol);
+	return found == rules.constEnd() ? generalizer_options.default_rule : *found;
+}
+
+
+std::unique_ptr<Map> MapGeneralizer::generalize()
+{
+	last_report = {};
+	error_string.clear();
+
+	if (!(generalizer_options.partition_size > 0))
+	{
+		error_string = tr("Invalid partition size.");
+		return {};
+	}
+
+	// Copy the source map.
+	auto map = std::make_unique<Map>();
+	{
+		QBuffer buffer;
+		if (!source.exportToIODevice(&buffer)
+		    || !buffer.open(QIODevice::ReadOnly)
+		    || !map->importFromIODevice(&buffer))
+		{
+			error_string = tr("Cannot copy the map.");
+			return {};
+		}
+	}
+	last_report.input_objects = source.getNumObjects();
+
+	auto const scale_denominator = generalizer_options.scale_denominator;
+	if (scale_denominator > 0 && scale_denominator != map->getScaleDenominator())
+		map->changeScale(scale_denominator, MapCoord(0, 0), generalizer_options.scale_symbols, true, true, true);
+
+	// The copy has the same symbols in the same order.
+	QHash<const Symbol*, const SymbolRule*> symbol_rules;
+	for (int i = 0; i < source.getNumSymbols() && i < map->getNumSymbols(); ++i)
+		symbol_rules.insert(map->getSymbol(i), &rule(source.getSymbol(i)));
+	auto const ruleFor = [this, &symbol_rules](const Symbol* symbol) {
+		return symbol_rules.value(symbol, &rule(symbol));
+	};
+	auto const is_subject = [this](const Object* object, const SymbolRule* rule) {
+		switch (object->getType())
+		{
+		case Object::Path:
+			return rule->min_area > 0 || rule->min_length > 0
+			       || rule->aggregation_distance > 0 || rule->simplification_tolerance > 0;
+		case Object::Point:
+			return generalizer_options.min_point_distance > 0;
+		default:
+			return false;
+		}
+	};
+
+	// Distribute the objects over the partition cells.
+	auto const partition_size = generalizer_options.partition_size;
+	std::vector<std::unique_ptr<MapTopology>> topologies;
+	std::vector<std::pair<MapPart*, Cell>> cells;
+	for (int p = 0; p < map->getNumParts(); ++p)
+	{
+		auto part = map->getPart(std::size_t(p));
+		topologies.emplace_back(new MapTopology(*part));
+
+		std::map<std::pair<qint64, qint64>, Cell> part_cells;
+		for (int i = 0; i < part->getNumObjects(); ++i)
+		{
+			auto const object = part->getObject(i);
+			auto const rule = ruleFor(object->getSymbol());
+			auto const subject = is_subject(object, rule);
+			if (!subject && object->getType() != Object::Path)
+				continue;
+
+			object->update();
+			auto const center = object->getExtent().center();
+			auto const key = std::make_pair(qint64(std::floor(center.x() / partition_size)),
+			                                qint64(std::floor(center.y() / partition_size)));
+			auto& cell = part_cells[key];
+			cell.topology = topologies.back().get();
+			if (!subject)
+			{
+				// Other paths are obstacles for simplification.
+				cell.context.push_back(object->asPath());
+				continue;
+			}
+
+			cell.originals.push_back(object->getType() == Object::Path ? object->asPath() : nullptr);
+			cell.items.emplace_back();
+			auto& item = cell.items.back();
+			item.index = i;
+			item.rule = rule;
+			item.results.emplace_back(object->duplicate());
+			item.changed = false;
+		}
+
+		for (auto& cell : part_cells)
+		{
+			if (!cell.second.items.empty())
+				cells.emplace_back(part, std::move(cell.second));
+		}
+	}
+
+	{
+		QThreadPool pool;
+		for (auto& cell : cells)
+			pool.start(new CellGeneralizer(generalizer_options, cell.second));
+		pool.waitForDone();
+	}
+	topologies.clear();
+
+	// Replace the changed objects, from the back of each part.
+	std::map<MapPart*, std::vector<Item*>> changes;
+	for (auto& cell : cells)
+	{
+		addReport(last_report, cell.second.report);
+		for (auto& item : cell.second.items)
+		{
+			if (item.changed)
+				changes[cell.first].push_back(&item);
+		}
+	}
+	for (auto& change : changes)
+	{
+		auto part = change.first;
+		auto& items = change.second;
+		std::sort(begin(items), end(items), [](const Item* a, const Item* b) { return a->index > b->index; });
+		for (auto item : items)
+		{
+			part->deleteObject(item->index, false);
+			auto pos = item->index;
+			for (auto& object : item->results)
+				part->addObject(object.release(), pos++);
+		}
+	}
+
+	last_report.partition_cells = int(cells.size());
+	last_report.output_objects = map->getNumObjects();
+	return map;
+}
+
+
+QString MapGeneralizer::reportText() const
+{
+	const auto& r = last_report;
+	QStringList lines;
+	lines << tr("Objects: %1 in the source map, %2 in the derived map").arg(r.input_objects).arg(r.output_objects)
+	      << tr("Partition cells: %1").arg(r.partition_cells)
+	      << tr("Merged areas: %1, resulting in %2 areas").arg(r.aggregated_objects).arg(r.aggregates)
+	      << tr("Removed small areas: %1").arg(r.removed_areas)
+	      << tr("Removed short lines: %1").arg(r.removed_lines)
+	      << tr("Displaced points: %1, unresolved conflicts: %2").arg(r.displaced_points).arg(r.unresolved_conflicts)
+	      << tr("Simplified paths: %1, removed coordinates: %2").arg(r.simplified_objects).arg(r.removed_coordinates);
+	return lines.join(QLatin1Char('\n'));
+}
+
+
+}  // namespace OpenOrienteering
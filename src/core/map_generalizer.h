@@ -0,0 +1,151 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_MAP_GENERALIZER_H
+#define OPENORIENTEERING_MAP_GENERALIZER_H
+
+#include <memory>
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QString>
+
+namespace OpenOrienteering {
+
+class Map;
+class Symbol;
+
+
+/**
+ * Derives a generalized map, e.g. for a smaller scale.
+ *
+ * The source map is copied, optionally rescaled, and the objects of the copy
+ * are generalized according to rules per symbol. All thresholds are given in
+ * millimeters on the derived map. The operations are applied in this order:
+ *
+ * 1. Areas which are closer than the aggregation distance are merged.
+ * 2. Areas smaller than the minimum area, and lines shorter than the minimum
+ *    length, are removed.
+ * 3. Point objects which are closer than the minimum point distance are
+ *    displaced, up to a maximum displacement.
+ * 4. Paths are simplified within the given tolerance. The simplification
+ *    keeps curves, dash points, and nodes which are shared with other
+ *    objects, and it does not introduce intersections with the original
+ *    geometry of the object and its neighbours.
+ *
+ * The work is distributed over a grid of partition cells which are processed
+ * in parallel. Each object is assigned to the cell which contains the center
+ * of its extent. Aggregation and displacement only consider objects in the
+ * same cell.
+ *
+ * The source map is not modified.
+ */
+class MapGeneralizer
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::MapGeneralizer)
+
+public:
+	/** Generalization rules for the objects of a symbol. */
+	struct SymbolRule
+	{
+		double min_area = 0;                  ///< Smaller areas are removed, in mm².
+		double min_length = 0;                ///< Shorter lines are removed, in mm.
+		double aggregation_distance = 0;      ///< Closer areas are merged, in mm.
+		double simplification_tolerance = 0;  ///< The maximum deviation of simplified paths, in mm.
+		bool displaceable = false;            ///< Whether point objects may be moved.
+	};
+
+	/** General options. */
+	struct Options
+	{
+		unsigned int scale_denominator = 0;   ///< The scale of the derived map, or 0 to keep the scale.
+		bool scale_symbols = false;           ///< Whether to scale the symbols when changing the scale.
+		double min_point_distance = 0;        ///< The minimum distance between point objects, in mm.
+		double max_displacement = 1.0;        ///< The maximum displacement of a point object, in mm.
+		double partition_size = 100.0;        ///< The edge length of a partition cell, in mm.
+		SymbolRule default_rule;              ///< The rule for symbols without explicit rule.
+	};
+
+	/** Statistics of a generalization run. */
+	struct Report
+	{
+		int input_objects = 0;         ///< The number of objects in the source map.
+		int output_objects = 0;        ///< The number of objects in the derived map.
+		int partition_cells = 0;       ///< The number of processed partition cells.
+		int aggregated_objects = 0;    ///< The number of areas which were merged.
+		int aggregates = 0;            ///< The number of areas resulting from merging.
+		int removed_areas = 0;         ///< The number of areas removed for their size.
+		int removed_lines = 0;         ///< The number of lines removed for their length.
+		int displaced_points = 0;      ///< The number of displaced point objects.
+		int unresolved_conflicts = 0;  ///< The number of point pairs which remain too close.
+		int simplified_objects = 0;    ///< The number of simplified paths.
+		int removed_coordinates = 0;   ///< The number of coordinates removed by simplification.
+	};
+
+
+	/** Constructs a generalizer for the given source map. */
+	MapGeneralizer(Map& source, const Options& options);
+
+	MapGeneralizer(const MapGeneralizer&) = delete;
+	MapGeneralizer& operator=(const MapGeneralizer&) = delete;
+
+	/** Destructor. */
+	~MapGeneralizer();
+
+
+	/** Returns the options. */
+	const Options& options() const { return generalizer_options; }
+
+	/** Sets the rule for a symbol of the source map. */
+	void setRule(const Symbol* symbol, const SymbolRule& rule);
+
+	/** Returns the rule for a symbol of the source map. */
+	const SymbolRule& rule(const Symbol* symbol) const;
+
+
+	/**
+	 * Creates the generalized map.
+	 *
+	 * Returns nullptr on error.
+	 */
+	std::unique_ptr<Map> generalize();
+
+	/** Returns the statistics of the last call to generalize(). */
+	const Report& report() const { return last_report; }
+
+	/** Returns a human-readable summary of the report. */
+	QString reportText() const;
+
+	/** Returns a description of the last error. */
+	const QString& errorString() const { return error_string; }
+
+
+private:
+	Map& source;
+	Options generalizer_options;
+	QHash<const Symbol*, SymbolRule> rules;
+	Report last_report;
+	QString error_string;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -39,6 +39,7 @@
 #include "undo/object_undo.h"
 #include "util/util.h"
 #include "util/xml_stream_util.h"
+#include "util/xml_utf8_writer.h"
 
 
 namespace literal
@@ -69,6 +70,26 @@ MapPart::~MapPart()
 }
 
 
+Object* MapPart::getObject(int i)
+{
+	auto* object = objects[std::size_t(i)];
+	object->expand();
+	return object;
+}
+
+const Object* MapPart::getObject(int i) const
+{
+	const auto* object = objects[std::size_t(i)];
+	object->expand();
+	return object;
+}
+
+const Object* MapPart::getObjectUnexpanded(int i) const
+{
+	return objects[std::size_t(i)];
+}
+
+
 void MapPart::setName(const QString& new_name)
 {
 	name = new_name;
@@ -117,6 +138,22 @@ void MapPart::save(QXmlStreamWriter& xml) const
 	}
 }
 
+void MapPart::save(XmlUtf8Writer& xml) const
+{
+	xml.writeStartElement(literal::part);
+	xml.writeAttribute(literal::name, name);
+	xml.writeStartElement(literal::objects);
+	xml.writeAttribute(literal::count, objects.size());
+	for (const Object* object : objects)
+	{
+		xml.writeLineBreak();
+		object->save(xml);
+	}
+	xml.writeLineBreak();
+	xml.writeEndElement();
+	xml.writeEndElement();
+}
+
 MapPart* MapPart::load(QXmlStreamReader& xml, Map& map, SymbolDictionary& symbol_dict)
 {
 	Q_ASSERT(xml.name() == literal::part);
@@ -339,7 +376,10 @@ void MapPart::applyOnMatchingObjects(const std::function<void (Object*)>& operat
 {
 	std::for_each(objects.rbegin(), objects.rend(), [&operation, &condition](auto object) {
 		if (condition(object))
+		{
+			object->expand();
 			operation(object);
+		}
 	});
 }
 
@@ -351,14 +391,20 @@ void MapPart::applyOnMatchingObjects(const std::function<void (Object*, MapPart*
 		--i;
 		Object* const object = objects[i];
 		if (condition(object))
+		{
+			object->expand();
 			operation(object, this, int(i));
+		}
 	}
 }
 
 
 void MapPart::applyOnAllObjects(const std::function<void (Object*)>& operation)
 {
-	std::for_each(objects.rbegin(), objects.rend(), operation);
+	std::for_each(objects.rbegin(), objects.rend(), [&operation](auto object) {
+		object->expand();
+		operation(object);
+	});
 }
 
 
@@ -367,9 +413,30 @@ void MapPart::applyOnAllObjects(const std::function<void (Object*, MapPart*, int
 	for (auto i = objects.size(); i > 0; )
 	{
 		--i;
+		objects[i]->expand();
 		operation(objects[i], this, int(i));
 	}
 }
 
 
+void MapPart::applyOnAllObjectsUnexpanded(const std::function<void (Object*)>& operation)
+{
+	std::for_each(objects.rbegin(), objects.rend(), operation);
+}
+
+
+int MapPart::compactIdleObjects()
+{
+	int count = 0;
+	for (auto* object : objects)
+	{
+		if (object->isRecentlyUsed())
+			object->resetRecentlyUsed();
+		else if (!map->isObjectSelected(object) && object->compact())
+			++count;
+	}
+	return count;
+}
+
+
 }  // namespace OpenOrienteering
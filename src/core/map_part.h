@@ -43,6 +43,7 @@ class Map;
 class MapCoordF;
 class Object;
 class Symbol;
+class XmlUtf8Writer;
 using SymbolDictionary = QHash<QString, Symbol*>; // from symbol.h
 
 
@@ -93,6 +94,11 @@ public:
 	 */
 	void save(QXmlStreamWriter& xml) const;
 	
+	/**
+	 * Saves the map part in xml format to the given writer.
+	 */
+	void save(XmlUtf8Writer& xml) const;
+	
 	/**
 	 * Loads the map part in xml format from the given stream.
 	 * 
@@ -118,14 +124,28 @@ public:
 	
 	/**
 	 * Returns the i-th object from the part.
+	 * 
+	 * A compacted object is expanded before it is returned.
 	 */
 	const Object* getObject(int i) const;
 	
 	/**
 	 * Returns the i-th object from the part.
+	 * 
+	 * A compacted object is expanded before it is returned.
 	 */
 	Object* getObject(int i);
 	
+	/**
+	 * Returns the i-th object from the part, without expanding it.
+	 * 
+	 * This is meant for filtering objects by properties which do not need
+	 * the coordinates, such as the extent or the dirty state.
+	 * 
+	 * @see applyOnAllObjectsUnexpanded()
+	 */
+	const Object* getObjectUnexpanded(int i) const;
+	
 	/**
 	 * Returns the index of the object.
 	 * 
@@ -241,6 +261,22 @@ public:
 	void applyOnAllObjects(const std::function<void (Object*, MapPart*, int)>& operation);
 	
 	
+	/**
+	 * Applies an operation on all objects, without expanding compacted objects.
+	 * 
+	 * This is meant for memory management, and for filtering objects by
+	 * properties which do not need the coordinates. Unlike applyOnAllObjects(),
+	 * it does not force compacted objects back into their expanded form.
+	 */
+	void applyOnAllObjectsUnexpanded(const std::function<void (Object*)>& operation);
+	
+	/**
+	 * @copybrief   Map::compactIdleObjects()
+	 * @copydetails Map::compactIdleObjects()
+	 */
+	int compactIdleObjects();
+	
+	
 private:
 	typedef std::vector<Object*> ObjectList;
 
@@ -265,19 +301,6 @@ int MapPart::getNumObjects() const
 	return int(objects.size());
 }
 
-inline
-Object* MapPart::getObject(int i)
-{
-	return objects[std::size_t(i)];
-}
-
-inline
-const Object* MapPart::getObject(int i) const
-{
-	return objects[std::size_t(i)];
-}
-
-
 }  // namespace OpenOrienteering
 
 #endif
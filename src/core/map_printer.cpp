@@ -67,6 +67,7 @@ namespace literal
 	static const QLatin1String templates_visible("templates_visible");
 	static const QLatin1String grid_visible("grid_visible");
 	static const QLatin1String simulate_overprinting("simulate_overprinting");
+	static const QLatin1String text_as_outlines("text_as_outlines");
 	static const QLatin1String mode("mode");
 	static const QLatin1String vector("vector");
 	static const QLatin1String raster("raster");
@@ -158,7 +159,8 @@ MapPrinterOptions::MapPrinterOptions(unsigned int scale, int resolution, MapPrin
    color_mode(DefaultColorMode),
    show_templates(false),
    show_grid(false),
-   simulate_overprinting(false)
+   simulate_overprinting(false),
+   text_as_outlines(false)
 {
 	// nothing
 }
@@ -194,6 +196,7 @@ MapPrinterConfig::MapPrinterConfig(const Map& map, QXmlStreamReader& xml)
 	options.show_templates = printer_config_element.attribute<bool>(literal::templates_visible);
 	options.show_grid = printer_config_element.attribute<bool>(literal::grid_visible);
 	options.simulate_overprinting = printer_config_element.attribute<bool>(literal::simulate_overprinting);
+	options.text_as_outlines = printer_config_element.attribute<bool>(literal::text_as_outlines);
 	QStringRef mode = printer_config_element.attribute<QStringRef>(literal::mode);
 	if (!mode.isEmpty())
 	{
@@ -283,6 +286,7 @@ void MapPrinterConfig::save(QXmlStreamWriter& xml, const QLatin1String& element_
 	printer_config_element.writeAttribute(literal::templates_visible, options.show_templates);
 	printer_config_element.writeAttribute(literal::grid_visible, options.show_grid);
 	printer_config_element.writeAttribute(literal::simulate_overprinting, options.simulate_overprinting);
+	printer_config_element.writeAttribute(literal::text_as_outlines, options.text_as_outlines);
 	switch (options.mode)
 	{
 	case MapPrinterOptions::Vector:
@@ -715,6 +719,16 @@ void MapPrinter::setSimulateOverprinting(bool enabled)
 	}
 }
 
+// slot
+void MapPrinter::setTextAsOutlines(bool enabled)
+{
+	if (options.text_as_outlines != enabled)
+	{
+		options.text_as_outlines = enabled;
+		emit optionsChanged(options);
+	}
+}
+
 void MapPrinter::setColorMode(MapPrinterOptions::ColorMode color_mode)
 {
 	if (options.color_mode != color_mode)
@@ -830,6 +844,9 @@ void drawBuffer(QPainter* device_painter, const QImage* page_buffer, qreal pixel
 
 void MapPrinter::drawPage(QPainter* device_painter, float units_per_inch, const QRectF& page_extent, bool white_background, QImage* page_buffer) const
 {
+	// Deferred updates would leave outdated renderables in the output.
+	map.finishObjectUpdates();
+	
 	device_painter->save();
 	
 	device_painter->setRenderHint(QPainter::Antialiasing);
@@ -1018,7 +1035,8 @@ void MapPrinter::drawPage(QPainter* device_painter, float units_per_inch, const
 			map_painter->setTransform(painter->transform());
 		}
 		
-		RenderConfig config = { map, page_region_used, scale, RenderConfig::NoOptions, 1.0 };
+		auto text_options = options.text_as_outlines ? RenderConfig::NoOptions : RenderConfig::TextObjects;
+		RenderConfig config = { map, page_region_used, scale, text_options, 1.0 };
 		
 		if (rasterModeSelected() && options.simulate_overprinting)
 		{
@@ -1099,6 +1117,8 @@ void MapPrinter::drawSeparationPages(QPrinter* printer, QPainter* device_painter
 {
 	Q_ASSERT(printer->colorMode() == QPrinter::GrayScale);
 	
+	map.finishObjectUpdates();
+	
 	device_painter->save();
 	
 	device_painter->setRenderHint(QPainter::Antialiasing);
@@ -1130,7 +1150,8 @@ void MapPrinter::drawSeparationPages(QPrinter* printer, QPainter* device_painter
 				printer->newPage();
 			}
 			
-			RenderConfig config = { map, page_extent, scale, RenderConfig::NoOptions, 1.0 };
+			auto text_options = options.text_as_outlines ? RenderConfig::NoOptions : RenderConfig::TextObjects;
+			RenderConfig config = { map, page_extent, scale, text_options, 1.0 };
 			map.drawColorSeparation(device_painter, config, color);
 			need_new_page = true;
 		}
@@ -165,6 +165,13 @@ public:
 	 *  Only available in MapPrinterOptions::Raster mode.
 	 */
 	bool simulate_overprinting;
+	
+	/** Controls if text is output as glyph outlines instead of text objects.
+	 * 
+	 *  Only effective for PDF output. Text objects result in smaller,
+	 *  searchable files, but depend on the fonts being embeddable.
+	 */
+	bool text_as_outlines;
 };
 
 
@@ -344,6 +351,9 @@ public slots:
 	/** Controls whether to print in overprinting simulation mode. */
 	void setSimulateOverprinting(bool enabled);
 	
+	/** Controls whether to output text as glyph outlines. */
+	void setTextAsOutlines(bool enabled);
+	
 	/** Controls the color mode. */
 	void setColorMode(MapPrinterOptions::ColorMode color_mode);
 	
@@ -431,7 +441,8 @@ bool operator==(const MapPrinterOptions& lhs, const MapPrinterOptions& rhs)
 	        && lhs.scale                 == rhs.scale
 	        && lhs.show_templates        == rhs.show_templates
 	        && lhs.show_grid             == rhs.show_grid
-	        && lhs.simulate_overprinting == rhs.simulate_overprinting;
+	        && lhs.simulate_overprinting == rhs.simulate_overprinting
+	        && lhs.text_as_outlines      == rhs.text_as_outlines;
 }
 
 /** Returns true iff the MapPrinterOptions values are not equal. */
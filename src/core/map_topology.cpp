@@ -0,0 +1,330 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_topology.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "core/map_part.h"
+#include "core/objects/object.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/** Division rounding towards negative infinity. */
+qint64 floorDiv(qint64 value, qint64 divisor)
+{
+	return (value >= 0) ? (value / divisor) : ((value - divisor + 1) / divisor);
+}
+
+}  // namespace
+
+
+
+MapTopology::MapTopology() = default;
+
+MapTopology::MapTopology(MapPart& part, const QRectF& area)
+{
+	// Filtering by extent avoids expanding compacted objects which are
+	// not of interest.
+	part.applyOnAllObjectsUnexpanded([this, &area](Object* object) {
+		if (object->getType() == Object::Path
+		    && (!area.isValid() || area.intersects(object->getExtent())))
+		{
+			addObject(object->asPath());
+		}
+	});
+}
+
+MapTopology::~MapTopology()
+{
+	// nothing, not inlined
+}
+
+
+MapTopology::Key MapTopology::key(qint32 x, qint32 y)
+{
+	return (Key(quint32(x)) << 32) | quint32(y);
+}
+
+MapTopology::Key MapTopology::key(const MapCoord& coord)
+{
+	return key(coord.nativeX(), coord.nativeY());
+}
+
+
+void MapTopology::addObject(PathObject* object)
+{
+	removeObject(object);
+	
+	// Const access doesn't mark the object as dirty.
+	const auto& const_object = *object;
+	auto& keys = object_keys[object];
+	keys.reserve(const_object.getCoordinateCount());
+	for (const auto& part : const_object.parts())
+	{
+		auto const end_index = part.isClosed() ? part.last_index : part.last_index + 1;
+		for (auto i = part.first_index; i < end_index; ++i)
+		{
+			auto const k = key(const_object.getCoordinate(i));
+			nodes[k].push_back({object, i});
+			keys.push_back(k);
+		}
+	}
+}
+
+void MapTopology::removeObject(const PathObject* object)
+{
+	auto found = object_keys.find(object);
+	if (found == end(object_keys))
+		return;
+	
+	for (auto const k : found->second)
+	{
+		auto node = nodes.find(k);
+		if (node == end(nodes))
+			continue;  // already handled
+		
+		auto& list = node->second;
+		list.erase(std::remove_if(begin(list), end(list), [object](const Incidence& incidence) {
+			return incidence.object == object;
+		}), end(list));
+		if (list.empty())
+			nodes.erase(node);
+	}
+	object_keys.erase(found);
+}
+
+void MapTopology::updateObject(PathObject* object)
+{
+	addObject(object);
+}
+
+bool MapTopology::contains(const PathObject* object) const
+{
+	return object_keys.find(object) != end(object_keys);
+}
+
+
+const std::vector<MapTopology::Incidence>& MapTopology::incidences(const MapCoord& position) const
+{
+	static const std::vector<Incidence> none;
+	auto node = nodes.find(key(position));
+	return node == end(nodes) ? none : node->second;
+}
+
+std::size_t MapTopology::sharedNodeCount() const
+{
+	return std::size_t(std::count_if(begin(nodes), end(nodes), [](const auto& node) {
+		const auto& list = node.second;
+		return std::any_of(begin(list) + 1, end(list), [&list](const Incidence& incidence) {
+			return incidence.object != list.front().object;
+		});
+	}));
+}
+
+std::size_t MapTopology::duplicateCoordinateCount() const
+{
+	auto count = std::size_t(0);
+	for (const auto& node : nodes)
+	{
+		const auto& list = node.second;
+		auto const first_object = list.front().object;
+		if (std::any_of(begin(list) + 1, end(list), [first_object](const Incidence& incidence) {
+		        return incidence.object != first_object;
+		    }))
+		{
+			count += list.size() - 1;
+		}
+	}
+	return count;
+}
+
+
+bool MapTopology::areConsecutive(const PathObject* object, size_type index_a, size_type index_b)
+{
+	if (index_a > index_b)
+		std::swap(index_a, index_b);
+	
+	for (const auto& part : object->parts())
+	{
+		if (index_a < part.first_index || index_a > part.last_index)
+			continue;
+		if (index_b > part.last_index)
+			return false;
+		if (index_b == index_a + 1)
+			return true;
+		// The closing point is not indexed, the first point stands in for it.
+		return part.isClosed() && index_a == part.first_index && index_b + 1 == part.last_index;
+	}
+	return false;
+}
+
+const PathObject* MapTopology::segmentNeighbour(const PathObject* object, const MapCoord& a, const MapCoord& b, const PathObject* preferred) const
+{
+	const PathObject* result = nullptr;
+	const auto& at_b = incidences(b);
+	for (const auto& incidence_a : incidences(a))
+	{
+		auto const candidate = incidence_a.object;
+		if (candidate == object)
+			continue;
+		
+		for (const auto& incidence_b : at_b)
+		{
+			if (incidence_b.object == candidate
+			    && areConsecutive(candidate, incidence_a.index, incidence_b.index))
+			{
+				if (candidate == preferred)
+					return candidate;
+				if (!result)
+					result = candidate;
+			}
+		}
+	}
+	return result;
+}
+
+std::vector<MapTopology::Edge> MapTopology::sharedEdges(const PathObject* object) const
+{
+	std::vector<Edge> edges;
+	if (!contains(object))
+		return edges;
+	
+	const auto& coords = object->getRawCoordinateVector();
+	for (const auto& part : object->parts())
+	{
+		auto edge = Edge { object, 0, 0, nullptr };
+		for (auto i = part.first_index; i < part.last_index; ++i)
+		{
+			auto const neighbour = segmentNeighbour(object, coords[i], coords[i+1], edge.neighbour);
+			if (neighbour && neighbour == edge.neighbour && edge.last_index == i)
+			{
+				edge.last_index = i + 1;
+				continue;
+			}
+			
+			if (edge.neighbour)
+				edges.push_back(edge);
+			edge = { object, i, i + 1, neighbour };
+		}
+		if (edge.neighbour)
+			edges.push_back(edge);
+	}
+	return edges;
+}
+
+
+std::vector<PathObject*> MapTopology::moveNode(const MapCoord& position, const MapCoord& new_position)
+{
+	std::vector<PathObject*> modified;
+	
+	auto const old_key = key(position);
+	auto const new_key = key(new_position);
+	auto node = nodes.find(old_key);
+	if (old_key == new_key || node == end(nodes))
+		return modified;
+	
+	auto moved = std::move(node->second);
+	nodes.erase(node);
+	for (const auto& incidence : moved)
+	{
+		auto const object = incidence.object;
+		const auto& const_object = *object;
+		auto coord = MapCoord::fromNative(new_position.nativeX(), new_position.nativeY());
+		coord.setFlags(const_object.getCoordinate(incidence.index).flags());
+		object->setCoordinate(incidence.index, coord);
+		
+		auto& keys = object_keys[object];
+		std::replace(begin(keys), end(keys), old_key, new_key);
+		if (std::find(begin(modified), end(modified), object) == end(modified))
+			modified.push_back(object);
+	}
+	
+	auto& target = nodes[new_key];
+	target.insert(end(target), begin(moved), end(moved));
+	return modified;
+}
+
+
+std::vector<MapTopology::NearMiss> MapTopology::findNearMisses(qint32 tolerance) const
+{
+	std::vector<NearMiss> near_misses;
+	if (tolerance <= 0)
+		return near_misses;
+	
+	// A grid of cells of the tolerance's size
+	std::unordered_map<Key, std::vector<Key>> grid;
+	for (const auto& node : nodes)
+	{
+		auto const x = qint32(node.first >> 32);
+		auto const y = qint32(node.first);
+		grid[key(qint32(floorDiv(x, tolerance)), qint32(floorDiv(y, tolerance)))].push_back(node.first);
+	}
+	
+	auto const tolerance_sq = qint64(tolerance) * tolerance;
+	for (const auto& node : nodes)
+	{
+		auto const x = qint32(node.first >> 32);
+		auto const y = qint32(node.first);
+		auto const cell_x = floorDiv(x, tolerance);
+		auto const cell_y = floorDiv(y, tolerance);
+		for (auto cx = cell_x - 1; cx <= cell_x + 1; ++cx)
+		{
+			for (auto cy = cell_y - 1; cy <= cell_y + 1; ++cy)
+			{
+				auto cell = grid.find(key(qint32(cx), qint32(cy)));
+				if (cell == end(grid))
+					continue;
+				
+				for (auto const other_key : cell->second)
+				{
+					// Report each pair of positions once.
+					if (other_key <= node.first)
+						continue;
+					
+					auto const dx = qint64(qint32(other_key >> 32)) - x;
+					auto const dy = qint64(qint32(other_key)) - y;
+					if (dx * dx + dy * dy > tolerance_sq)
+						continue;
+					
+					const auto& others = nodes.at(other_key);
+					for (const auto& incidence : node.second)
+					{
+						auto other = std::find_if(begin(others), end(others), [&incidence](const Incidence& candidate) {
+							return candidate.object != incidence.object;
+						});
+						if (other != end(others))
+						{
+							near_misses.push_back({incidence, *other});
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+	return near_misses;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,177 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_MAP_TOPOLOGY_H
+#define OPENORIENTEERING_MAP_TOPOLOGY_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include <QtGlobal>
+#include <QRectF>
+
+#include "core/map_coord.h"
+
+namespace OpenOrienteering {
+
+class MapPart;
+class PathObject;
+
+
+/**
+ * An index of the nodes and edges which path objects share.
+ * 
+ * Adjacent areas, e.g. vegetation boundaries, are digitized with identical
+ * coordinates along their common border. This index finds the objects which
+ * share a node, i.e. a coordinate position, and the edges, i.e. runs of
+ * consecutive segments, which objects share with their neighbours. This
+ * allows to keep shared borders consistent while editing, and to find
+ * borders which were meant to be shared but are not exactly snapped.
+ * 
+ * The index is derived from the coordinates of the objects. The objects keep
+ * their own copy of the shared coordinates, so the file format and all code
+ * operating on objects are unaffected. Adding, removing, or updating an object
+ * in the index only touches the entries of this object.
+ * 
+ * Closing points are not indexed: they always follow the first point of
+ * their part.
+ */
+class MapTopology
+{
+public:
+	using size_type = MapCoordVector::size_type;
+	
+	/** A coordinate of an object at a node. */
+	struct Incidence
+	{
+		PathObject* object;
+		size_type index;
+	};
+	
+	/** A run of consecutive segments which an object shares with a neighbour. */
+	struct Edge
+	{
+		const PathObject* object;     ///< The object to which the indices refer.
+		size_type first_index;        ///< The index of the first coordinate of the edge.
+		size_type last_index;         ///< The index of the last coordinate of the edge.
+		const PathObject* neighbour;  ///< The object on the other side of the edge.
+	};
+	
+	/** Coordinates of different objects which almost, but not exactly, coincide. */
+	struct NearMiss
+	{
+		Incidence first;
+		Incidence second;
+	};
+	
+	
+	/** Constructs an empty index. */
+	MapTopology();
+	
+	/**
+	 * Constructs an index for the path objects of the given part.
+	 * 
+	 * If the area is valid, only objects with intersecting extent are indexed.
+	 */
+	explicit MapTopology(MapPart& part, const QRectF& area = {});
+	
+	MapTopology(const MapTopology&) = delete;
+	MapTopology(MapTopology&&) = default;
+	
+	~MapTopology();
+	
+	MapTopology& operator=(const MapTopology&) = delete;
+	MapTopology& operator=(MapTopology&&) = default;
+	
+	
+	/** Adds the object's coordinates to the index. */
+	void addObject(PathObject* object);
+	
+	/** Removes the object's coordinates from the index. */
+	void removeObject(const PathObject* object);
+	
+	/** Updates the index after the object's coordinates were changed. */
+	void updateObject(PathObject* object);
+	
+	/** Returns true if the object is indexed. */
+	bool contains(const PathObject* object) const;
+	
+	
+	/** Returns the object coordinates at the given position. */
+	const std::vector<Incidence>& incidences(const MapCoord& position) const;
+	
+	/** Returns the number of positions which are shared by at least two objects. */
+	std::size_t sharedNodeCount() const;
+	
+	/**
+	 * Returns the number of coordinates which duplicate the position of
+	 * another object's coordinate.
+	 */
+	std::size_t duplicateCoordinateCount() const;
+	
+	/**
+	 * Returns the edges which the object shares with other objects.
+	 * 
+	 * Edges do not extend across the start of closed parts.
+	 */
+	std::vector<Edge> sharedEdges(const PathObject* object) const;
+	
+	
+	/**
+	 * Moves all indexed object coordinates at position to new_position.
+	 * 
+	 * The flags of the coordinates are retained. Returns the modified objects.
+	 */
+	std::vector<PathObject*> moveNode(const MapCoord& position, const MapCoord& new_position);
+	
+	/**
+	 * Finds coordinates of different objects which are closer than the
+	 * tolerance (in native map units), but not identical.
+	 * 
+	 * Such coordinates indicate borders which are not properly snapped.
+	 */
+	std::vector<NearMiss> findNearMisses(qint32 tolerance) const;
+	
+	
+private:
+	using Key = quint64;
+	
+	static Key key(qint32 x, qint32 y);
+	
+	static Key key(const MapCoord& coord);
+	
+	/** Returns true if index_a and index_b refer to consecutive coordinates of the object. */
+	static bool areConsecutive(const PathObject* object, size_type index_a, size_type index_b);
+	
+	/**
+	 * Returns another object which has a segment from a to b or from b to a.
+	 * 
+	 * If there are several such objects, the preferred one is returned.
+	 */
+	const PathObject* segmentNeighbour(const PathObject* object, const MapCoord& a, const MapCoord& b, const PathObject* preferred) const;
+	
+	std::unordered_map<Key, std::vector<Incidence>> nodes;
+	std::unordered_map<const PathObject*, std::vector<Key>> object_keys;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -0,0 +1,861 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "map_validator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#include <QtGlobal>
+#include <QLatin1String>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include "core/map.h"
+#include "core/map_part.h"
+#include "core/path_coord.h"
+#include "core/objects/object.h"
+#include "core/symbols/symbol.h"
+#include "util/util.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The cell size of the index of area extents, in mm
+constexpr double extent_cell_size = 10.0;
+
+/// The minimum cell size of the index of path segments, in mm
+constexpr double min_segment_cell_size = 0.5;
+
+/// The number of objects which are measured together on a worker thread
+constexpr std::size_t objects_per_chunk = 1000;
+
+
+/**
+ * A uniform grid of buckets, for finding items near a given rect.
+ *
+ * Items are stored in every cell which their rect touches, so a query may
+ * return the same item more than once.
+ */
+template <class T>
+class GridIndex
+{
+public:
+	explicit GridIndex(double cell_size) : cell_size(cell_size) {}
+
+	void insert(const QRectF& rect, const T& item)
+	{
+		auto const r = range(rect);
+		for (auto y = r.top; y <= r.bottom; ++y)
+		{
+			for (auto x = r.left; x <= r.right; ++x)
+				cells[key(x, y)].push_back(item);
+		}
+	}
+
+	template <class Function>
+	void query(const QRectF& rect, Function function) const
+	{
+		auto const r = range(rect);
+		for (auto y = r.top; y <= r.bottom; ++y)
+		{
+			for (auto x = r.left; x <= r.right; ++x)
+			{
+				auto const found = cells.find(key(x, y));
+				if (found == cells.end())
+					continue;
+				for (const auto& item : found->second)
+					function(item);
+			}
+		}
+	}
+
+private:
+	struct Range
+	{
+		qint64 left, top, right, bottom;
+	};
+
+	Range range(const QRectF& rect) const
+	{
+		return { qint64(std::floor(rect.left() / cell_size)), qint64(std::floor(rect.top() / cell_size)),
+		         qint64(std::floor(rect.right() / cell_size)), qint64(std::floor(rect.bottom() / cell_size)) };
+	}
+
+	static quint64 key(qint64 x, qint64 y)
+	{
+		return (quint64(quint32(x)) << 32) | quint32(y);
+	}
+
+	double cell_size;
+	std::unordered_map<quint64, std::vector<T>> cells;
+};
+
+
+/**
+ * A piece of a path segment in the index.
+ */
+struct Segment
+{
+	MapCoordF first;
+	MapCoordF last;
+	int feature;
+};
+
+
+/**
+ * An object which takes part in the pairwise checks.
+ *
+ * The geometry is copied from the object, so that the checks can run
+ * concurrently without accessing the objects.
+ */
+struct Feature
+{
+	Object* object;
+	const Symbol* symbol;
+	const MapValidator::SymbolRule* rule;
+	QRectF extent;
+	MapCoordF position;                          ///< The point position, or the first path coord
+	std::vector<std::vector<MapCoordF>> rings;   ///< The path coords of each part
+	bool is_area;
+	bool is_point;
+};
+
+
+/**
+ * An object which is to be checked, with its rule.
+ */
+struct Candidate
+{
+	Object* object;
+	const Symbol* symbol;
+	const MapValidator::SymbolRule* rule;
+};
+
+
+/**
+ * The spatial indexes of the paths of a symbol.
+ */
+struct SymbolIndex
+{
+	explicit SymbolIndex(double segment_cell_size)
+	: segment_cell_size(segment_cell_size)
+	, segments(segment_cell_size)
+	, extents(extent_cell_size)
+	{}
+
+	double segment_cell_size;
+	GridIndex<Segment> segments;
+	GridIndex<int> extents;      ///< Areas only
+};
+
+
+/**
+ * The data for the pairwise checks in a map part.
+ *
+ * The data is read-only while the tiles are processed.
+ */
+struct PartData
+{
+	int part = 0;
+	std::vector<Feature> features;
+	std::unordered_map<const Symbol*, SymbolIndex> symbol_indexes;
+	GridIndex<int> points { 1.0 };
+	double max_point_distance = 0;
+};
+
+
+using Issue = MapValidator::Issue;
+
+
+double cross(const MapCoordF& a, const MapCoordF& b)
+{
+	return a.x() * b.y() - a.y() * b.x();
+}
+
+
+/**
+ * Returns true if the segments cross each other in a single interior point.
+ */
+bool segmentsCross(const MapCoordF& a1, const MapCoordF& a2, const MapCoordF& b1, const MapCoordF& b2)
+{
+	auto const d1 = cross(a2 - a1, b1 - a1);
+	auto const d2 = cross(a2 - a1, b2 - a1);
+	auto const d3 = cross(b2 - b1, a1 - b1);
+	auto const d4 = cross(b2 - b1, a2 - b1);
+	return ((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0))
+	       && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0));
+}
+
+
+MapCoordF closestPointOnSegment(const MapCoordF& point, const MapCoordF& first, const MapCoordF& last)
+{
+	auto const segment = last - first;
+	auto const length_squared = segment.lengthSquared();
+	auto param = 0.0;
+	if (length_squared > 0)
+		param = qBound(0.0, MapCoordF::dotProduct(point - first, segment) / length_squared, 1.0);
+	return first + segment * param;
+}
+
+
+/**
+ * Returns the squared distance of two segments which do not cross,
+ * and the closest points.
+ */
+double squaredDistance(const MapCoordF& a1, const MapCoordF& a2, const MapCoordF& b1, const MapCoordF& b2,
+                       MapCoordF& on_a, MapCoordF& on_b)
+{
+	const std::pair<MapCoordF, MapCoordF> candidates[] = {
+	    { a1, closestPointOnSegment(a1, b1, b2) },
+	    { a2, closestPointOnSegment(a2, b1, b2) },
+	    { closestPointOnSegment(b1, a1, a2), b1 },
+	    { closestPointOnSegment(b2, a1, a2), b2 },
+	};
+	auto result = -1.0;
+	for (const auto& candidate : candidates)
+	{
+		auto const distance_squared = (candidate.second - candidate.first).lengthSquared();
+		if (result < 0 || distance_squared < result)
+		{
+			result = distance_squared;
+			on_a = candidate.first;
+			on_b = candidate.second;
+		}
+	}
+	return result;
+}
+
+
+/**
+ * Calls the function for the pieces of the segments of the ring,
+ * where the pieces are not longer than the given length.
+ */
+template <class Function>
+void forEachPiece(const std::vector<MapCoordF>& ring, double piece_length, Function function)
+{
+	for (std::size_t i = 1; i < ring.size(); ++i)
+	{
+		auto const first = ring[i-1];
+		auto const segment = ring[i] - first;
+		auto const n = std::max(1, int(std::ceil(segment.length() / piece_length)));
+		auto previous = first;
+		for (int k = 1; k <= n; ++k)
+		{
+			auto const next = (k == n) ? ring[i] : MapCoordF(first + segment * (double(k) / n));
+			function(previous, next);
+			previous = next;
+		}
+	}
+}
+
+
+/**
+ * Returns true if the point is inside the rings, by the even-odd rule.
+ */
+bool isInside(const std::vector<std::vector<MapCoordF>>& rings, const MapCoordF& point)
+{
+	auto inside = false;
+	for (const auto& ring : rings)
+	{
+		for (std::size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+		{
+			const auto& a = ring[i];
+			const auto& b = ring[j];
+			if ((a.y() > point.y()) != (b.y() > point.y())
+			    && point.x() < (b.x() - a.x()) * (point.y() - a.y()) / (b.y() - a.y()) + a.x())
+				inside = !inside;
+		}
+	}
+	return inside;
+}
+
+
+double areaOf(const PathObject* path)
+{
+	// Holes are subtracted from the outer boundary.
+	const auto& parts = path->parts();
+	if (parts.empty())
+		return 0;
+	auto area = parts.front().calculateArea();
+	if (parts.size() > 1)
+	{
+		area *= 2;
+		for (const auto& part : parts)
+			area -= part.calculateArea();
+	}
+	return area;
+}
+
+
+Issue makeIssue(MapValidator::IssueType type, int part, const Feature& feature, const Feature* other)
+{
+	Issue issue;
+	issue.type = type;
+	issue.part = part;
+	issue.object = feature.object;
+	issue.other = other ? other->object : nullptr;
+	issue.position = MapCoordF(feature.extent.center());
+	issue.extent = other ? feature.extent.united(other->extent) : feature.extent;
+	issue.value = 0;
+	issue.limit = 0;
+	issue.fix = MapValidator::NoFix;
+	issue.fix_offset = MapCoordF(0, 0);
+	return issue;
+}
+
+
+
+/**
+ * Measures a chunk of objects, and collects the data for the pairwise checks.
+ *
+ * The objects must have been expanded and updated on the map's thread.
+ * Only const member functions are used here.
+ */
+class FeatureCollector : public QRunnable
+{
+public:
+	FeatureCollector(const Candidate* first, const Candidate* last, int part,
+	                 std::vector<Feature>& features, std::vector<Issue>& issues)
+	: first(first)
+	, last(last)
+	, part(part)
+	, features(features)
+	, issues(issues)
+	{}
+
+	void run() override
+	{
+		for (auto candidate = first; candidate != last; ++candidate)
+			collect(*candidate);
+	}
+
+	void collect(const Candidate& candidate)
+	{
+		const Object* object = candidate.object;
+		const auto& rule = *candidate.rule;
+
+		// The extent is taken from the geometry, not from the renderables.
+		Feature feature = { candidate.object, candidate.symbol, candidate.rule, {}, {}, {}, false, false };
+		if (object->getType() == Object::Point)
+		{
+			feature.position = object->asPoint()->getCoordF();
+			feature.extent = QRectF(feature.position.x(), feature.position.y(), 0.0001, 0.0001);
+			feature.is_point = true;
+			features.push_back(std::move(feature));
+			return;
+		}
+
+		auto const path = object->asPath();
+		if (path->parts().empty())
+			return;
+		for (const auto& path_part : path->parts())
+			rectIncludeSafe(feature.extent, path_part.calculateExtent());
+		auto const contained_types = candidate.symbol->getContainedTypes();
+		feature.is_area = (contained_types & Symbol::Area) != 0;
+		if (feature.is_area && rule.min_area > 0)
+		{
+			auto const area = areaOf(path);
+			if (area < rule.min_area)
+			{
+				auto issue = makeIssue(MapValidator::AreaTooSmall, part, feature, nullptr);
+				issue.value = area;
+				issue.limit = rule.min_area;
+				issue.fix = MapValidator::DeleteObject;
+				issues.push_back(issue);
+			}
+		}
+		else if (!feature.is_area && (contained_types & Symbol::Line) && rule.min_length > 0)
+		{
+			auto length = 0.0;
+			for (const auto& path_part : path->parts())
+				length += path_part.length();
+			if (length < rule.min_length)
+			{
+				auto issue = makeIssue(MapValidator::LineTooShort, part, feature, nullptr);
+				issue.value = length;
+				issue.limit = rule.min_length;
+				issue.fix = MapValidator::DeleteObject;
+				issues.push_back(issue);
+			}
+		}
+
+		if (!(rule.min_gap > 0) && !(feature.is_area && rule.check_overlap))
+			return;
+
+		for (const auto& path_part : path->parts())
+		{
+			feature.rings.emplace_back();
+			auto& ring = feature.rings.back();
+			ring.reserve(path_part.path_coords.size());
+			for (const auto& path_coord : path_part.path_coords)
+				ring.push_back(path_coord.pos);
+		}
+		feature.position = feature.rings.front().front();
+		features.push_back(std::move(feature));
+	}
+
+private:
+	const Candidate* first;
+	const Candidate* last;
+	int part;
+	std::vector<Feature>& features;
+	std::vector<Issue>& issues;
+};
+
+
+
+/**
+ * Builds the spatial index of the paths of a single symbol.
+ */
+class SymbolIndexBuilder : public QRunnable
+{
+public:
+	SymbolIndexBuilder(const std::vector<Feature>& features, const Symbol* symbol, SymbolIndex& index)
+	: features(features)
+	, symbol(symbol)
+	, index(index)
+	{}
+
+	void run() override
+	{
+		for (std::size_t f = 0; f < features.size(); ++f)
+		{
+			const auto& feature = features[f];
+			if (feature.is_point || feature.symbol != symbol)
+				continue;
+			for (const auto& ring : feature.rings)
+			{
+				forEachPiece(ring, index.segment_cell_size, [this, f](const MapCoordF& first, const MapCoordF& last) {
+					index.segments.insert(QRectF(first, last).normalized(), { first, last, int(f) });
+				});
+			}
+			if (feature.is_area && feature.rule->check_overlap)
+				index.extents.insert(feature.extent, int(f));
+		}
+	}
+
+private:
+	const std::vector<Feature>& features;
+	const Symbol* symbol;
+	SymbolIndex& index;
+};
+
+
+
+/**
+ * Builds the spatial index of the point positions.
+ */
+class PointIndexBuilder : public QRunnable
+{
+public:
+	PointIndexBuilder(const std::vector<Feature>& features, GridIndex<int>& index)
+	: features(features)
+	, index(index)
+	{}
+
+	void run() override
+	{
+		for (std::size_t f = 0; f < features.size(); ++f)
+		{
+			const auto& feature = features[f];
+			if (feature.is_point)
+				index.insert(QRectF(feature.position, feature.position), int(f));
+		}
+	}
+
+private:
+	const std::vector<Feature>& features;
+	GridIndex<int>& index;
+};
+
+
+
+/**
+ * Runs the pairwise checks for the objects of a single tile.
+ */
+class TileValidator : public QRunnable
+{
+public:
+	TileValidator(const PartData& data, const std::vector<int>& features, std::vector<Issue>& issues)
+	: data(data)
+	, features(features)
+	, issues(issues)
+	{}
+
+	void run() override
+	{
+		for (auto f : features)
+		{
+			const auto& feature = data.features[std::size_t(f)];
+			if (feature.is_point)
+			{
+				checkPointDistances(f);
+				continue;
+			}
+			checkGaps(f);
+			if (feature.is_area && feature.rule->check_overlap)
+				checkContainment(f);
+		}
+	}
+
+	/**
+	 * Finds points which are closer than the larger of their minimum distances.
+	 */
+	void checkPointDistances(int a)
+	{
+		const auto& feature = data.features[std::size_t(a)];
+		auto const radius = data.max_point_distance;
+		QRectF const rect(feature.position.x() - radius, feature.position.y() - radius, 2 * radius, 2 * radius);
+		data.points.query(rect, [this, a, &feature](int b) {
+			if (b <= a)
+				return;
+			const auto& other = data.features[std::size_t(b)];
+			auto const limit = std::max(feature.rule->min_point_distance, other.rule->min_point_distance);
+			auto const offset = feature.position - other.position;
+			auto const distance = offset.length();
+			if (!(limit > 0) || distance >= limit)
+				return;
+
+			auto issue = makeIssue(MapValidator::PointsTooClose, data.part, feature, &other);
+			issue.position = MapCoordF((feature.position + other.position) / 2);
+			issue.value = distance;
+			issue.limit = limit;
+			issue.fix = MapValidator::MoveObject;
+			auto const direction = distance > 0 ? MapCoordF(offset / distance) : MapCoordF(1, 0);
+			issue.fix_offset = MapCoordF(direction * (limit - distance));
+			issues.push_back(issue);
+		});
+	}
+
+	/**
+	 * Finds paths of the same symbol which are closer than the minimum gap,
+	 * and areas whose boundaries cross.
+	 */
+	void checkGaps(int a)
+	{
+		struct Contact
+		{
+			double distance_squared;
+			MapCoordF position;
+			bool crossing;
+		};
+
+		const auto& feature = data.features[std::size_t(a)];
+		const auto& index = data.symbol_indexes.at(feature.symbol);
+		auto const gap = feature.rule->min_gap;
+		std::map<int, Contact> contacts;
+		for (const auto& ring : feature.rings)
+		{
+			forEachPiece(ring, index.segment_cell_size, [&](const MapCoordF& a1, const MapCoordF& a2) {
+				auto const rect = QRectF(a1, a2).normalized().adjusted(-gap, -gap, gap, gap);
+				index.segments.query(rect, [&](const Segment& segment) {
+					if (segment.feature <= a)
+						return;
+					auto& contact = contacts.emplace(segment.feature, Contact{ -1, {}, false }).first->second;
+					if (contact.crossing)
+						return;
+					if (segmentsCross(a1, a2, segment.first, segment.last))
+					{
+						auto const t = cross(segment.first - a1, segment.last - segment.first)
+						               / cross(a2 - a1, segment.last - segment.first);
+						contact = { 0, MapCoordF(a1 + (a2 - a1) * t), true };
+						return;
+					}
+					MapCoordF on_a, on_b;
+					auto const distance_squared = squaredDistance(a1, a2, segment.first, segment.last, on_a, on_b);
+					if (contact.distance_squared < 0 || distance_squared < contact.distance_squared)
+						contact = { distance_squared, MapCoordF((on_a + on_b) / 2), false };
+				});
+			});
+		}
+
+		for (const auto& entry : contacts)
+		{
+			const auto& other = data.features[std::size_t(entry.first)];
+			const auto& contact = entry.second;
+			if (contact.crossing)
+			{
+				if (!feature.is_area || !feature.rule->check_overlap)
+					continue;
+				auto issue = makeIssue(MapValidator::Overlap, data.part, feature, &other);
+				issue.position = contact.position;
+				issue.fix = MapValidator::MergeObjects;
+				issues.push_back(issue);
+			}
+			else if (contact.distance_squared > 0 && contact.distance_squared < gap * gap)
+			{
+				auto issue = makeIssue(MapValidator::GapTooSmall, data.part, feature, &other);
+				issue.position = contact.position;
+				issue.value = std::sqrt(contact.distance_squared);
+				issue.limit = gap;
+				if (feature.is_area)
+					issue.fix = MapValidator::MergeObjects;
+				issues.push_back(issue);
+			}
+		}
+	}
+
+	/**
+	 * Finds areas of the same symbol which contain the given area.
+	 */
+	void checkContainment(int a)
+	{
+		const auto& feature = data.features[std::size_t(a)];
+		const auto& index = data.symbol_indexes.at(feature.symbol);
+		std::set<int> visited;
+		index.extents.query(QRectF(feature.position, feature.position), [&](int b) {
+			if (b == a || !visited.insert(b).second)
+				return;
+			const auto& other = data.features[std::size_t(b)];
+			if (!other.extent.contains(feature.extent) || !isInside(other.rings, feature.position))
+				return;
+			auto issue = makeIssue(MapValidator::Overlap, data.part, feature, &other);
+			issue.position = feature.position;
+			issue.fix = MapValidator::MergeObjects;
+			issues.push_back(issue);
+		});
+	}
+
+private:
+	const PartData& data;
+	const std::vector<int>& features;
+	std::vector<Issue>& issues;
+};
+
+
+/**
+ * Removes duplicate overlaps, and gaps between overlapping areas.
+ */
+void removeRedundantIssues(std::vector<Issue>& issues)
+{
+	auto const pairOf = [](const Issue& issue) {
+		auto const a = static_cast<const Object*>(issue.object);
+		auto const b = static_cast<const Object*>(issue.other);
+		return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+	};
+
+	std::set<std::pair<const Object*, const Object*>> overlaps;
+	auto const is_redundant = [&overlaps, &pairOf](const Issue& issue) {
+		return issue.type == MapValidator::Overlap && !overlaps.insert(pairOf(issue)).second;
+	};
+	issues.erase(std::remove_if(begin(issues), end(issues), is_redundant), end(issues));
+
+	auto const is_overlapping_gap = [&overlaps, &pairOf](const Issue& issue) {
+		return issue.type == MapValidator::GapTooSmall && overlaps.count(pairOf(issue)) > 0;
+	};
+	issues.erase(std::remove_if(begin(issues), end(issues), is_overlapping_gap), end(issues));
+}
+
+
+}  // namespace
+
+
+
+MapValidator::MapValidator(Map& map, const Options& options)
+: map(map)
+, validator_options(options)
+{
+	// nothing else
+}
+
+MapValidator::~MapValidator()
+{
+	// nothing, not inlined
+}
+
+
+void MapValidator::setRule(const Symbol* symbol, const SymbolRule& rule)
+{
+	rules.insert(symbol, rule);
+}
+
+const MapValidator::SymbolRule& MapValidator::rule(const Symbol* symbol) const
+{
+	auto found = rules.constFind(symbol);
+	return found == rules.constEnd() ? validator_options.default_rule : *found;
+}
+
+
+bool MapValidator::validate()
+{
+	issue_list.clear();
+	error_string.clear();
+
+	auto const tile_size = validator_options.tile_size;
+	if (!(tile_size > 0))
+	{
+		error_string = tr("Invalid tile size.");
+		return false;
+	}
+
+	auto max_point_distance = validator_options.default_rule.min_point_distance;
+	for (const auto& rule : rules)
+		max_point_distance = std::max(max_point_distance, rule.min_point_distance);
+
+	for (int p = 0; p < map.getNumParts(); ++p)
+	{
+		auto const part = map.getPart(std::size_t(p));
+
+		// Expand and update the objects on the map's thread.
+		std::vector<Candidate> candidates;
+		candidates.reserve(std::size_t(part->getNumObjects()));
+		for (int i = 0; i < part->getNumObjects(); ++i)
+		{
+			auto const object = part->getObject(i);
+			auto const symbol = object->getSymbol();
+			if (!symbol || symbol->isHelperSymbol())
+				continue;
+			auto const type = object->getType();
+			if (type != Object::Path && (type != Object::Point || !(max_point_distance > 0)))
+				continue;
+
+			object->expand();
+			object->update();
+			candidates.push_back({ object, symbol, &this->rule(symbol) });
+		}
+
+		// Measure the objects, and collect the data for the pairwise checks,
+		// in chunks which are processed in parallel.
+		auto const num_chunks = (candidates.size() + objects_per_chunk - 1) / objects_per_chunk;
+		std::vector<std::vector<Feature>> chunk_features(num_chunks);
+		std::vector<std::vector<Issue>> chunk_issues(num_chunks);
+		{
+			QThreadPool pool;
+			for (std::size_t c = 0; c < num_chunks; ++c)
+			{
+				auto const first = candidates.data() + c * objects_per_chunk;
+				auto const last = candidates.data() + std::min(candidates.size(), (c + 1) * objects_per_chunk);
+				pool.start(new FeatureCollector(first, last, p, chunk_features[c], chunk_issues[c]));
+			}
+			pool.waitForDone();
+		}
+
+		PartData data;
+		data.part = p;
+		data.max_point_distance = max_point_distance;
+		data.points = GridIndex<int>(std::max(max_point_distance, min_segment_cell_size));
+		data.features.reserve(candidates.size());
+		for (std::size_t c = 0; c < num_chunks; ++c)
+		{
+			std::move(begin(chunk_features[c]), end(chunk_features[c]), std::back_inserter(data.features));
+			issue_list.insert(end(issue_list), begin(chunk_issues[c]), end(chunk_issues[c]));
+		}
+
+		// Build the spatial indexes in parallel, one task per index.
+		for (const auto& feature : data.features)
+		{
+			if (!feature.is_point && data.symbol_indexes.find(feature.symbol) == data.symbol_indexes.end())
+			{
+				auto const cell_size = std::max(4 * feature.rule->min_gap, min_segment_cell_size);
+				data.symbol_indexes.emplace(feature.symbol, SymbolIndex(cell_size));
+			}
+		}
+		{
+			QThreadPool pool;
+			pool.start(new PointIndexBuilder(data.features, data.points));
+			for (auto& entry : data.symbol_indexes)
+				pool.start(new SymbolIndexBuilder(data.features, entry.first, entry.second));
+			pool.waitForDone();
+		}
+
+		// Distribute the features over the tiles.
+		std::map<std::pair<qint64, qint64>, std::vector<int>> tiles;
+		for (std::size_t f = 0; f < data.features.size(); ++f)
+		{
+			auto const center = data.features[f].extent.center();
+			auto const key = std::make_pair(qint64(std::floor(center.x() / tile_size)),
+			                                qint64(std::floor(center.y() / tile_size)));
+			tiles[key].push_back(int(f));
+		}
+
+		std::vector<std::vector<Issue>> tile_issues(tiles.size());
+		{
+			QThreadPool pool;
+			auto tile_issue = begin(tile_issues);
+			for (const auto& tile : tiles)
+				pool.start(new TileValidator(data, tile.second, *tile_issue++));
+			pool.waitForDone();
+		}
+		for (const auto& issues : tile_issues)
+			issue_list.insert(end(issue_list), begin(issues), end(issues));
+	}
+
+	removeRedundantIssues(issue_list);
+	std::stable_sort(begin(issue_list), end(issue_list), [](const Issue& a, const Issue& b) {
+		if (a.part != b.part)
+			return a.part < b.part;
+		if (a.position.y() != b.position.y())
+			return a.position.y() < b.position.y();
+		return a.position.x() < b.position.x();
+	});
+	return true;
+}
+
+
+QString MapValidator::description(const Issue& issue)
+{
+	QString text;
+	switch (issue.type)
+	{
+	case AreaTooSmall:
+		text = tr("Area too small: %1 mm², minimum %2 mm²").arg(issue.value, 0, 'f', 3).arg(issue.limit);
+		break;
+	case LineTooShort:
+		text = tr("Line too short: %1 mm, minimum %2 mm").arg(issue.value, 0, 'f', 2).arg(issue.limit);
+		break;
+	case GapTooSmall:
+		text = tr("Gap too small: %1 mm, minimum %2 mm").arg(issue.value, 0, 'f', 2).arg(issue.limit);
+		break;
+	case Overlap:
+		text = tr("Overlapping areas");
+		break;
+	case PointsTooClose:
+		text = tr("Point objects too close: %1 mm, minimum %2 mm").arg(issue.value, 0, 'f', 2).arg(issue.limit);
+		break;
+	}
+
+	switch (issue.fix)
+	{
+	case NoFix:
+		break;
+	case DeleteObject:
+		text += QLatin1String(" - ") + tr("Suggestion: Delete the object.");
+		break;
+	case MergeObjects:
+		text += QLatin1String(" - ") + tr("Suggestion: Merge the objects.");
+		break;
+	case MoveObject:
+		text += QLatin1String(" - ") + tr("Suggestion: Move the object by %1 mm.").arg(issue.fix_offset.length(), 0, 'f', 2);
+		break;
+	}
+	return text;
+}
+
+
+}  // namespace OpenOrienteering
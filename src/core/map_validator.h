@@ -0,0 +1,174 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_MAP_VALIDATOR_H
+#define OPENORIENTEERING_MAP_VALIDATOR_H
+
+#include <vector>
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QRectF>
+#include <QString>
+
+#include "core/map_coord.h"
+
+namespace OpenOrienteering {
+
+class Map;
+class Object;
+class Symbol;
+
+
+/**
+ * Checks a map against cartographic rules, e.g. before printing.
+ *
+ * The rules are given per symbol. All thresholds are given in millimeters
+ * on the map. The validator reports:
+ *
+ * - areas which are smaller than the minimum area,
+ * - lines which are shorter than the minimum length,
+ * - objects of the same symbol which are closer than the minimum gap,
+ * - areas of the same symbol which overlap each other,
+ * - point objects which are closer than the minimum point distance.
+ *
+ * The objects are measured in chunks on worker threads, and the spatial
+ * indexes are built concurrently, one per symbol. Gaps and point distances
+ * are found via spatial indexes of the path segments and point positions.
+ * These pairwise checks are distributed over
+ * a grid of tiles which are processed in parallel. Each object is assigned
+ * to the tile which contains the center of its extent, but it is compared
+ * with nearby objects from all tiles. Only objects in the same map part are
+ * compared.
+ *
+ * Objects with helper symbols are ignored. The map is not modified.
+ */
+class MapValidator
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::MapValidator)
+
+public:
+	/** Validation rules for the objects of a symbol. */
+	struct SymbolRule
+	{
+		double min_area = 0;            ///< Smaller areas are reported, in mm².
+		double min_length = 0;          ///< Shorter lines are reported, in mm.
+		double min_gap = 0;             ///< Closer objects of the same symbol are reported, in mm.
+		double min_point_distance = 0;  ///< Closer point objects of any symbol are reported, in mm.
+		bool check_overlap = false;     ///< Whether overlapping areas of the same symbol are reported.
+	};
+
+	/** General options. */
+	struct Options
+	{
+		double tile_size = 50.0;        ///< The edge length of a tile, in mm.
+		SymbolRule default_rule;        ///< The rule for symbols without explicit rule.
+	};
+
+	/** The kinds of issues. */
+	enum IssueType
+	{
+		AreaTooSmall,
+		LineTooShort,
+		GapTooSmall,
+		Overlap,
+		PointsTooClose
+	};
+
+	/** The kinds of suggested fixes. */
+	enum Fix
+	{
+		NoFix,
+		DeleteObject,   ///< Delete the object.
+		MergeObjects,   ///< Merge the object with the other object.
+		MoveObject      ///< Move the object by the fix offset.
+	};
+
+	/** A violation of a rule. */
+	struct Issue
+	{
+		IssueType type;
+		int part;               ///< The index of the map part.
+		Object* object;
+		Object* other;          ///< The other object of a pair, or nullptr.
+		MapCoordF position;     ///< The location of the issue.
+		QRectF extent;          ///< The area to be shown for the issue.
+		double value;           ///< The measured area, length or distance.
+		double limit;           ///< The limit from the rule.
+		Fix fix;                ///< The suggested fix.
+		MapCoordF fix_offset;   ///< The suggested displacement for MoveObject.
+	};
+
+
+	/** Constructs a validator for the given map. */
+	MapValidator(Map& map, const Options& options);
+
+	MapValidator(const MapValidator&) = delete;
+	MapValidator& operator=(const MapValidator&) = delete;
+
+	/** Destructor. */
+	~MapValidator();
+
+
+	/** Returns the options. */
+	const Options& options() const { return validator_options; }
+
+	/** Sets the rule for a symbol. */
+	void setRule(const Symbol* symbol, const SymbolRule& rule);
+
+	/** Returns the rule for a symbol. */
+	const SymbolRule& rule(const Symbol* symbol) const;
+
+
+	/**
+	 * Checks the map.
+	 *
+	 * This must be called on the map's thread which expands and updates the
+	 * objects before the worker threads read them. Returns false on error.
+	 */
+	bool validate();
+
+	/**
+	 * Returns the issues found by the last call to validate().
+	 *
+	 * The issues are ordered by map part, and by position from top to
+	 * bottom, for stepping through the map.
+	 */
+	const std::vector<Issue>& issues() const { return issue_list; }
+
+	/** Returns a human-readable description of an issue and its fix. */
+	static QString description(const Issue& issue);
+
+	/** Returns a description of the last error. */
+	const QString& errorString() const { return error_string; }
+
+
+private:
+	Map& map;
+	Options validator_options;
+	QHash<const Symbol*, SymbolRule> rules;
+	std::vector<Issue> issue_list;
+	QString error_string;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
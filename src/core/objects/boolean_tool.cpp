@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014, 2015 Kai Pastor
+ *    Copyright 2014, 2015, 2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -24,9 +24,11 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 
 #include <QtGlobal>
 #include <QDebug>
@@ -109,156 +111,20 @@ BooleanTool::BooleanTool(Operation op, Map* map)
 
 bool BooleanTool::execute()
 {
-	// Check basic prerequisite
-	Object* const primary_object = map->getFirstSelectedObject();
-	if (primary_object->getType() != Object::Path)
-	{
-		qWarning("The first selected object must be a path.");
-		return false; // in release build
-	}
-
-	// Filter selected objects into in_objects
-	PathObjects in_objects;
-	in_objects.reserve(map->getNumSelectedObjects());
-	for (Object* object : map->selectedObjects())
-	{
-		if (object->getType() == Object::Path)
-		{
-			PathObject* const path = object->asPath();
-			if (op != MergeHoles || (object->getSymbol()->getContainedTypes() & Symbol::Area && path->parts().size() > 1 ))
-			{
-				in_objects.push_back(path);
-			}
-		}
-	}
-	
-	// Perform the core operation
-	QScopedPointer<CombinedUndoStep> undo_step(new CombinedUndoStep(map));
-	PathObjects out_objects;
-	if (!executeForObjects(primary_object->asPath(), in_objects, out_objects, *undo_step))
-	{
-		Q_ASSERT(out_objects.size() == 0);
-		return false; // in release build
-	}
-	
-	map->push(undo_step.take());
-	map->setObjectsDirty();
-	map->emitSelectionChanged();
-	map->emitSelectionEdited();
-	return true;
+	BooleanTask task(op, map, BooleanTask::SelectedObjects);
+	return task.runSynchronously();
 }
 
 bool BooleanTool::executePerSymbol()
 {
-	PathObjects backlog;
-	backlog.reserve(map->getNumSelectedObjects());
-	
-	// Filter area objects into initial backlog
-	for (Object* object : map->selectedObjects())
-	{
-		if (object->getSymbol()->getContainedTypes() & Symbol::Area)
-			backlog.push_back(object->asPath());
-	}
-	
-	QScopedPointer<CombinedUndoStep> undo_step(new CombinedUndoStep(map));
-	PathObjects new_backlog;
-	new_backlog.reserve(backlog.size()/2);
-	PathObjects in_objects;
-	in_objects.reserve(backlog.size()/2);
-	PathObjects out_objects;
-	while (!backlog.empty())
-	{
-		PathObject* const primary_object = backlog.front();
-		const Symbol* const symbol = primary_object->getSymbol();
-		
-		// Filter objects by symbol into in_objects or new_backlog, respectively
-		new_backlog.clear();
-		in_objects.clear();
-		for (PathObject* object : backlog)
-		{
-			if (object->getSymbol() == symbol)
-			{
-				if (op != MergeHoles || (object->getSymbol()->getContainedTypes() & Symbol::Area && object->parts().size() > 1 ))
-				{
-					in_objects.push_back(object);
-				}
-			}
-			else
-			{
-				new_backlog.push_back(object);
-			}
-		}
-		backlog.swap(new_backlog);
-		
-		// Short cut for single object of given symbol
-		if (in_objects.size() == 1)
-			continue;
-		
-		// Perform the core operation
-		out_objects.clear();
-		executeForObjects(primary_object, in_objects, out_objects, *undo_step);
-	}
-	
-	bool const have_changes = undo_step->getNumSubSteps() > 0;
-	if (have_changes)
-	{
-		map->push(undo_step.take());
-		map->setObjectsDirty();
-		map->emitSelectionChanged();
-		map->emitSelectionEdited();
-	}
-	return have_changes;
+	BooleanTask task(op, map, BooleanTask::PerSymbol);
+	return task.runSynchronously() && task.hasChanges();
 }
 
-bool BooleanTool::executeForObjects(PathObject* subject, PathObjects& in_objects, PathObjects& out_objects, CombinedUndoStep& undo_step)
+bool BooleanTool::executeForObjects(PathObject* subject, PathObjects& in_objects, PathObjects& out_objects, const BackgroundTask* task)
 {
-	if (!executeForObjects(subject, in_objects, out_objects))
-	{
-		Q_ASSERT(out_objects.size() == 0);
-		return false; // in release build
-	}
-	
-	// Add original objects to undo step, and remove them from map.
-	QScopedPointer<AddObjectsUndoStep> add_step(new AddObjectsUndoStep(map));
-	for (PathObject* object : in_objects)
-	{
-		if (op != Difference || object == subject)
-		{
-			add_step->addObject(object, object);
-		}
-	}
-	// Keep as separate loop to get the correct index in the previous loop
-	for (PathObject* object : in_objects)
-	{
-		if (op != Difference || object == subject)
-		{
-			map->removeObjectFromSelection(object, false);
-			map->getCurrentPart()->deleteObject(object, true);
-			object->setMap(map); // necessary so objects are saved correctly
-		}
-	}
+	auto const is_canceled = [task]() { return task && task->isCanceled(); };
 	
-	// Add resulting objects to map, and create delete step for them
-	QScopedPointer<DeleteObjectsUndoStep> delete_step(new DeleteObjectsUndoStep(map));
-	MapPart* part = map->getCurrentPart();
-	for (PathObject* object : out_objects)
-	{
-		map->addObject(object);
-		map->addObjectToSelection(object, false);
-	}
-	// Keep as separate loop to get the correct index in the previous loop
-	for (PathObject* object : out_objects)
-	{
-		delete_step->addObject(part->findObjectIndex(object));
-	}
-	
-	undo_step.push(add_step.take());
-	undo_step.push(delete_step.take());
-	return true;
-}
-
-bool BooleanTool::executeForObjects(PathObject* subject, PathObjects& in_objects, PathObjects& out_objects)
-{
 	// Convert the objects to Clipper polygons and
 	// create a hash map, mapping point positions to the PathCoords.
 	// These paths are to be regarded as closed.
@@ -270,6 +136,9 @@ bool BooleanTool::executeForObjects(PathObject* subject, PathObjects& in_objects
 	ClipperLib::Paths clip_polygons;
 	for (PathObject* object : in_objects)
 	{
+		if (is_canceled())
+			return false;
+		
 		if (object != subject)
 		{
 			pathObjectToPolygons(object, clip_polygons, polymap);
@@ -300,17 +169,61 @@ bool BooleanTool::executeForObjects(PathObject* subject, PathObjects& in_objects
 	                    return false;
 	}
 
+	if (is_canceled())
+		return false;
+	
 	ClipperLib::PolyTree solution;
 	bool success = clipper.Execute(clip_type, solution, fill_type, fill_type);
 	if (success)
 	{
 		// Try to convert the solution polygons to objects again
-		polyTreeToPathObjects(solution, out_objects, subject, polymap);
+		auto const num_existing = out_objects.size();
+		for (int i = 0, count = solution.ChildCount(); i < count; ++i)
+		{
+			if (is_canceled())
+			{
+				for (auto object = begin(out_objects) + num_existing; object != end(out_objects); ++object)
+					delete *object;
+				out_objects.resize(num_existing);
+				return false;
+			}
+			outerPolyNodeToPathObjects(*solution.Childs[i], out_objects, subject, polymap);
+		}
 	}
 	
 	return success;
 }
 
+bool BooleanTool::executeForAggregation(const PathObjects& in_objects, qint64 gap, PathObjects& out_objects)
+{
+	if (in_objects.empty() || gap <= 0)
+		return false;
+	
+	PolyMap polymap;
+	ClipperLib::Paths polygons;
+	for (const PathObject* object : in_objects)
+		pathObjectToPolygons(object, polygons, polymap);
+	
+	// Round joins, with a resolution which is adequate for the gap width.
+	auto const delta = gap / 2.0;
+	auto const arc_tolerance = std::max(5.0, delta / 50);
+	
+	ClipperLib::ClipperOffset grow;
+	grow.ArcTolerance = arc_tolerance;
+	grow.AddPaths(polygons, ClipperLib::jtRound, ClipperLib::etClosedPolygon);
+	ClipperLib::Paths grown;
+	grow.Execute(grown, delta);
+	
+	ClipperLib::ClipperOffset shrink;
+	shrink.ArcTolerance = arc_tolerance;
+	shrink.AddPaths(grown, ClipperLib::jtRound, ClipperLib::etClosedPolygon);
+	ClipperLib::PolyTree solution;
+	shrink.Execute(solution, -delta);
+	
+	polyTreeToPathObjects(solution, out_objects, in_objects.front(), polymap);
+	return !out_objects.empty();
+}
+
 void BooleanTool::polyTreeToPathObjects(const ClipperLib::PolyTree& tree, PathObjects& out_objects, const PathObject* proto, const PolyMap& polymap)
 {
 	for (int i = 0, count = tree.ChildCount(); i < count; ++i)
@@ -1082,4 +995,200 @@ bool BooleanTool::checkSegmentMatch(
 }
 
 
+
+
+//### BooleanTask ###
+
+BooleanTask::BooleanTask(BooleanTool::Operation op, Map* map, Mode mode)
+: tool(op, map)
+, op(op)
+, mode(mode)
+, map(map)
+{
+	using Operation = BooleanTool::Operation;
+	auto const is_input = [op](const PathObject* path) {
+		return op != Operation::MergeHoles
+		       || (path->getSymbol()->getContainedTypes() & Symbol::Area && path->parts().size() > 1);
+	};
+	
+	switch (mode)
+	{
+	case SelectedObjects:
+		{
+			// Check basic prerequisite
+			Object* const primary_object = map->getFirstSelectedObject();
+			if (!primary_object || primary_object->getType() != Object::Path)
+			{
+				qWarning("The first selected object must be a path.");
+				return; // in release build
+			}
+			
+			// Filter selected objects into in_objects
+			BooleanTool::PathObjects in_objects;
+			in_objects.reserve(map->getNumSelectedObjects());
+			for (Object* object : map->selectedObjects())
+			{
+				if (object->getType() == Object::Path && is_input(object->asPath()))
+					in_objects.push_back(object->asPath());
+			}
+			addGroup(primary_object->asPath(), in_objects);
+		}
+		break;
+		
+	case PerSymbol:
+		{
+			BooleanTool::PathObjects backlog;
+			backlog.reserve(map->getNumSelectedObjects());
+			
+			// Filter area objects into initial backlog
+			for (Object* object : map->selectedObjects())
+			{
+				if (object->getSymbol()->getContainedTypes() & Symbol::Area)
+					backlog.push_back(object->asPath());
+			}
+			
+			BooleanTool::PathObjects new_backlog;
+			new_backlog.reserve(backlog.size()/2);
+			BooleanTool::PathObjects in_objects;
+			in_objects.reserve(backlog.size()/2);
+			while (!backlog.empty())
+			{
+				PathObject* const primary_object = backlog.front();
+				const Symbol* const symbol = primary_object->getSymbol();
+				
+				// Filter objects by symbol into in_objects or new_backlog, respectively
+				new_backlog.clear();
+				in_objects.clear();
+				for (PathObject* object : backlog)
+				{
+					if (object->getSymbol() == symbol)
+					{
+						if (is_input(object))
+							in_objects.push_back(object);
+					}
+					else
+					{
+						new_backlog.push_back(object);
+					}
+				}
+				backlog.swap(new_backlog);
+				
+				// Short cut for single object of given symbol
+				if (in_objects.size() == 1)
+					continue;
+				
+				addGroup(primary_object, in_objects);
+			}
+		}
+		break;
+	}
+}
+
+BooleanTask::~BooleanTask()
+{
+	abort();
+	for (auto& group : groups)
+	{
+		for (auto object : group.results)
+			delete object;
+	}
+}
+
+void BooleanTask::addGroup(PathObject* subject, const BooleanTool::PathObjects& objects)
+{
+	Group group = { objects, subject, {}, {}, false };
+	group.copies.reserve(objects.size() + 1);
+	for (auto object : objects)
+		group.copies.emplace_back(object->duplicate());
+	if (std::find(begin(objects), end(objects), subject) == end(objects))
+		group.copies.emplace_back(subject->duplicate());
+	groups.push_back(std::move(group));
+}
+
+bool BooleanTask::run()
+{
+	auto const num_groups = groups.size();
+	for (std::size_t i = 0; i < num_groups; ++i)
+	{
+		if (isCanceled())
+			return false;
+		
+		auto& group = groups[i];
+		BooleanTool::PathObjects in_objects;
+		in_objects.reserve(group.objects.size());
+		for (std::size_t j = 0; j < group.objects.size(); ++j)
+			in_objects.push_back(group.copies[j].get());
+		
+		auto const subject_index = std::size_t(std::find(begin(group.objects), end(group.objects), group.subject) - begin(group.objects));
+		auto* subject = group.copies[subject_index].get();
+		group.success = tool.executeForObjects(subject, in_objects, group.results, this);
+		if (!group.success)
+		{
+			Q_ASSERT(group.results.empty());
+			if (mode == SelectedObjects || isCanceled())
+				return false;
+		}
+		setProgress(int(100 * (i + 1) / num_groups));
+	}
+	return mode == PerSymbol || !groups.empty();
+}
+
+void BooleanTask::commit()
+{
+	QScopedPointer<CombinedUndoStep> undo_step(new CombinedUndoStep(map));
+	MapPart* part = map->getCurrentPart();
+	for (auto& group : groups)
+	{
+		if (!group.success)
+			continue;
+		
+		// Add original objects to undo step, and remove them from map.
+		QScopedPointer<AddObjectsUndoStep> add_step(new AddObjectsUndoStep(map));
+		for (PathObject* object : group.objects)
+		{
+			if (op != BooleanTool::Difference || object == group.subject)
+			{
+				add_step->addObject(object, object);
+			}
+		}
+		// Keep as separate loop to get the correct index in the previous loop
+		for (PathObject* object : group.objects)
+		{
+			if (op != BooleanTool::Difference || object == group.subject)
+			{
+				map->removeObjectFromSelection(object, false);
+				part->deleteObject(object, true);
+				object->setMap(map); // necessary so objects are saved correctly
+			}
+		}
+		
+		// Add resulting objects to map, and create delete step for them
+		QScopedPointer<DeleteObjectsUndoStep> delete_step(new DeleteObjectsUndoStep(map));
+		for (PathObject* object : group.results)
+		{
+			map->addObject(object);
+			map->addObjectToSelection(object, false);
+		}
+		// Keep as separate loop to get the correct index in the previous loop
+		for (PathObject* object : group.results)
+		{
+			delete_step->addObject(part->findObjectIndex(object));
+		}
+		group.results.clear();
+		
+		undo_step->push(add_step.take());
+		undo_step->push(delete_step.take());
+	}
+	
+	has_changes = undo_step->getNumSubSteps() > 0;
+	if (has_changes)
+	{
+		map->push(undo_step.take());
+		map->setObjectsDirty();
+		map->emitSelectionChanged();
+		map->emitSelectionEdited();
+	}
+}
+
+
 }  // namespace OpenOrienteering
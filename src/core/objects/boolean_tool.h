@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014, 2015 Kai Pastor
+ *    Copyright 2014, 2015, 2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,16 +22,20 @@
 #ifndef OPENORIENTEERING_BOOLEAN_TOOL_H
 #define OPENORIENTEERING_BOOLEAN_TOOL_H
 
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include <QtGlobal>
 #include <QHash>
+#include <QObject>
 
 #include <clipper.hpp>
 
+#include "util/background_task.h"
+
 namespace OpenOrienteering {
 
-class CombinedUndoStep;
 class Map;
 class PathCoord;
 class PathObject;
@@ -81,6 +85,8 @@ public:
 	 * 
 	 * The first selected object is treated special and must be a path.
 	 * 
+	 * This is the synchronous variant of BooleanTask::SelectedObjects.
+	 * 
 	 * @return True on success, false on error
 	 */
 	bool execute();
@@ -96,6 +102,8 @@ public:
 	 * operation failed for remain unchanged. The operation continues for other
 	 * groups of objects.
 	 * 
+	 * This is the synchronous variant of BooleanTask::PerSymbol.
+	 * 
 	 * @return True if the map was changed, false otherwise.
 	 */
 	bool executePerSymbol();
@@ -104,16 +112,22 @@ public:
 	 * Executes the operation on particular objects.
 	 * 
 	 * This function does not (actively) change the collection of objects in the map
-	 * or the selection.
+	 * or the selection. It may be used on a worker thread if the objects do
+	 * not belong to a map.
+	 * 
+	 * When a task is given, the operation stops and fails as soon as the task
+	 * is canceled.
 	 * 
 	 * @param subject               The primary affected object.
 	 * @param in_objects            All objects to operate on. Must contain subject.
 	 * @param out_objects           The resulting collection of objects.
+	 * @param task                  The task executing this operation, or nullptr.
 	 */
 	bool executeForObjects(
 	        PathObject* subject,
 	        PathObjects& in_objects,
-	        PathObjects& out_objects );
+	        PathObjects& out_objects,
+	        const BackgroundTask* task = nullptr );
 	
 	/**
 	 * Executes the Intersection and Difference operation on the given line object.
@@ -127,26 +141,29 @@ public:
 	        const PathObject* line,
 	        PathObjects& out_objects );
 	
-private:
-	typedef std::pair< const PathPart*, const PathCoord* > PathCoordInfo;
-	
-	typedef QHash< ClipperLib::IntPoint, PathCoordInfo > PolyMap;
-	
 	/**
-	 * Executes the operation on particular objects, and provides undo steps.
+	 * Merges areas which are separated by gaps narrower than the given width.
 	 * 
-	 * This function changes the collection of objects in the map and the selection.
+	 * This is a morphological closing: The union of the areas, grown by half
+	 * the gap width, is shrunk by the same amount. Apart from the bridges over
+	 * the gaps, the result follows the original boundaries. Like
+	 * executeForObjects(), this may be used on a worker thread if the objects
+	 * do not belong to a map. The first object serves as prototype for the
+	 * results.
 	 * 
-	 * @param subject               The primary affected object.
-	 * @param in_objects            All objects to operate on. Must contain subject.
+	 * @param in_objects            The areas to operate on.
+	 * @param gap                   The width of the gaps to close, in native map units.
 	 * @param out_objects           The resulting collection of objects.
-	 * @param undo_step             A combined undo step which will be filled with sub steps.
 	 */
-	bool executeForObjects(
-	        PathObject* subject,
-	        PathObjects& in_objects,
-	        PathObjects& out_objects,
-	        CombinedUndoStep& undo_step );
+	bool executeForAggregation(
+	        const PathObjects& in_objects,
+	        qint64 gap,
+	        PathObjects& out_objects );
+	
+private:
+	typedef std::pair< const PathPart*, const PathCoord* > PathCoordInfo;
+	
+	typedef QHash< ClipperLib::IntPoint, PathCoordInfo > PolyMap;
 	
 	/**
 	 * Converts a ClipperLib::PolyTree to PathObjects.
@@ -268,6 +285,85 @@ private:
 };
 
 
+
+/**
+ * A background task for boolean operations on the selected objects.
+ * 
+ * The constructor takes copies of the selected path objects. The operation
+ * is executed on these copies in run(). commit() replaces the original
+ * objects with the results, selects the results, and pushes an undo step.
+ */
+class BooleanTask : public BackgroundTask
+{
+Q_OBJECT
+public:
+	/**
+	 * The ways of grouping the selected objects.
+	 */
+	enum Mode
+	{
+		SelectedObjects,  ///< Operate on all selected objects, cf. BooleanTool::execute()
+		PerSymbol         ///< Operate per symbol, cf. BooleanTool::executePerSymbol()
+	};
+	
+	/**
+	 * Prepares the operation on the current selection of the given map.
+	 */
+	BooleanTask(BooleanTool::Operation op, Map* map, Mode mode);
+	
+	/**
+	 * Destructor.
+	 * 
+	 * Discards results which were not committed.
+	 */
+	~BooleanTask() override;
+	
+	/**
+	 * Returns true if the committed results changed the map.
+	 */
+	bool hasChanges() const { return has_changes; }
+	
+protected:
+	/**
+	 * Executes the operation on the copies.
+	 * 
+	 * In SelectedObjects mode, this fails when the operation fails.
+	 * In PerSymbol mode, groups which fail remain unchanged.
+	 */
+	bool run() override;
+	
+	/**
+	 * Replaces the original objects with the results.
+	 */
+	void commit() override;
+	
+private:
+	/**
+	 * A set of objects which is processed by a single operation.
+	 */
+	struct Group
+	{
+		BooleanTool::PathObjects objects;   ///< The original objects
+		PathObject* subject;                ///< The original primary object
+		std::vector<std::unique_ptr<PathObject>> copies;  ///< Copies of objects, and of the subject
+		BooleanTool::PathObjects results;
+		bool success;
+	};
+	
+	/**
+	 * Adds a group, taking the copies.
+	 */
+	void addGroup(PathObject* subject, const BooleanTool::PathObjects& objects);
+	
+	BooleanTool tool;
+	const BooleanTool::Operation op;
+	const Mode mode;
+	Map* const map;
+	std::vector<Group> groups;
+	bool has_changes = false;
+};
+
+
 }  // namespace OpenOrienteering
 
 #endif
@@ -22,16 +22,19 @@
 #include "object.h"
 
 #include <cmath>
+#include <cstring>
 
 #include <QtMath>
 #include <QtNumeric>
 #include <QIODevice>
+#include <QThread>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 
 #include <private/qbezier_p.h>
 
 #include "settings.h"
+#include "core/compact_coord_vector.h"
 #include "core/map.h"
 #include "core/objects/text_object.h"
 #include "core/renderables/renderable.h"
@@ -43,6 +46,7 @@
 #include "fileformats/file_import_export.h"
 #include "util/util.h"
 #include "util/xml_stream_util.h"
+#include "util/xml_utf8_writer.h"
 
 
 // ### A namespace which collects various string constants of type QLatin1String. ###
@@ -66,6 +70,74 @@ namespace literal
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * A 64-bit FNV-1a hash which is independent of the platform's byte order.
+ */
+class ContentHasher
+{
+public:
+	explicit ContentHasher(quint64 seed = 14695981039346656037ull) noexcept
+	: value(seed)
+	{}
+	
+	void add(quint32 data) noexcept
+	{
+		for (int i = 0; i < 4; ++i, data >>= 8)
+		{
+			value ^= data & 0xff;
+			value *= 1099511628211ull;
+		}
+	}
+	
+	void add(qint32 data) noexcept
+	{
+		add(quint32(data));
+	}
+	
+	void add(quint64 data) noexcept
+	{
+		add(quint32(data));
+		add(quint32(data >> 32));
+	}
+	
+	void add(float data) noexcept
+	{
+		if (data == 0)
+			data = 0;  // no negative zero
+		quint32 bits;
+		std::memcpy(&bits, &data, sizeof(bits));
+		add(bits);
+	}
+	
+	void add(MapCoord coord) noexcept
+	{
+		add(coord.nativeX());
+		add(coord.nativeY());
+		add(quint32(coord.flags()));
+	}
+	
+	void add(const QString& string) noexcept
+	{
+		add(quint32(string.size()));
+		for (auto c : string)
+			add(quint32(c.unicode()));
+	}
+	
+	quint64 result() const noexcept
+	{
+		return value;
+	}
+	
+private:
+	quint64 value;
+};
+
+}  // namespace
+
+
+
 // ### Object implementation ###
 
 Object::Object(Object::Type type, const Symbol* symbol)
@@ -74,7 +146,10 @@ Object::Object(Object::Type type, const Symbol* symbol)
   map(nullptr),
   output_dirty(true),
   extent(),
-  output(*this)
+  output(*this),
+  recently_used(true),
+  renderables_evicted(false),
+  content_hash(0)
 {
 	// nothing
 }
@@ -86,7 +161,10 @@ Object::Object(Object::Type type, const Symbol* symbol, const MapCoordVector& co
    map(map),
    output_dirty(true),
    extent(),
-   output(*this)
+   output(*this),
+   recently_used(true),
+   renderables_evicted(false),
+   content_hash(0)
 {
 	// nothing
 }
@@ -94,12 +172,15 @@ Object::Object(Object::Type type, const Symbol* symbol, const MapCoordVector& co
 Object::Object(const Object& proto)
  : type(proto.type)
  , symbol(proto.symbol)
- , coords(proto.coords)
+ , coords(proto.getRawCoordinateVector())
  , map(nullptr)
  , object_tags(proto.object_tags)
  , output_dirty(true)
  , extent(proto.extent)
  , output(*this)
+ , recently_used(true)
+ , renderables_evicted(false)
+ , content_hash(proto.content_hash)
 {
 	// nothing
 }
@@ -118,10 +199,12 @@ void Object::copyFrom(const Object& other)
 		throw std::invalid_argument(Q_FUNC_INFO);
 	
 	symbol = other.symbol;
-	coords = other.coords;
+	compact_coords.reset();
+	coords = other.getRawCoordinateVector();
 	// map unchanged!
 	object_tags = other.object_tags;
 	output_dirty = true;
+	content_hash = 0;
 	extent = other.extent;
 }
 
@@ -137,6 +220,8 @@ bool Object::equals(const Object* other, bool compare_symbol) const
 			return false;
 	}
 	
+	expand();
+	other->expand();
 	if (coords.size() != other->coords.size())
 		return false;
 	for (size_t i = 0, end = coords.size(); i < end; ++i)
@@ -212,6 +297,66 @@ bool Object::equals(const Object* other, bool compare_symbol) const
 
 
 
+quint64 Object::contentHash() const
+{
+	if (content_hash == 0)
+		content_hash = calculateContentHash();
+	
+	// The symbol number identifies the symbol across maps. It is not cached
+	// because symbols may be renumbered without touching the objects.
+	ContentHasher hasher(content_hash);
+	if (symbol)
+	{
+		hasher.add(qint32(symbol->getType()));
+		for (int i = 0; i < Symbol::number_components; ++i)
+			hasher.add(qint32(symbol->getNumberComponent(i)));
+	}
+	return hasher.result();
+}
+
+quint64 Object::calculateContentHash() const
+{
+	expand();
+	
+	ContentHasher hasher;
+	hasher.add(qint32(type));
+	hasher.add(quint32(coords.size()));
+	for (const auto& coord : coords)
+		hasher.add(coord);
+	
+	// QHash iteration order is arbitrary.
+	auto keys = object_tags.keys();
+	std::sort(begin(keys), end(keys));
+	for (const auto& key : keys)
+	{
+		hasher.add(key);
+		hasher.add(object_tags.value(key));
+	}
+	
+	switch (type)
+	{
+	case Point:
+		hasher.add(static_cast<const PointObject*>(this)->getRotation());
+		break;
+	case Path:
+		hasher.add(static_cast<const PathObject*>(this)->getPatternRotation());
+		hasher.add(static_cast<const PathObject*>(this)->getPatternOrigin());
+		break;
+	case Text:
+		{
+			auto text_object = static_cast<const TextObject*>(this);
+			hasher.add(text_object->getText());
+			hasher.add(qint32(text_object->getHorizontalAlignment()));
+			hasher.add(qint32(text_object->getVerticalAlignment()));
+			hasher.add(text_object->getRotation());
+		}
+		break;
+	}
+	
+	// 0 is reserved for "not calculated".
+	return std::max(hasher.result(), quint64(1));
+}
+
 bool Object::validate() const
 {
 	return true;
@@ -380,7 +525,8 @@ void Object::save(QXmlStreamWriter& xml) const
 	{
 		// Scope of coords XML element
 		XmlElementWriter coords_element(xml, literal::coords);
-		coords_element.write(coords);
+		MapCoordVector buffer;
+		coords_element.write(peekCoordinates(buffer));
 	}
 	
 	if (type == Path)
@@ -397,6 +543,60 @@ void Object::save(QXmlStreamWriter& xml) const
 	}
 }
 
+void Object::save(XmlUtf8Writer& xml) const
+{
+	xml.writeStartElement(literal::object);
+	xml.writeAttribute(literal::type, int(type));
+	int symbol_index = -1;
+	if (map)
+		symbol_index = map->findSymbolIndex(symbol);
+	if (symbol_index != -1)
+		xml.writeAttribute(literal::symbol, symbol_index);
+	
+	if (type == Point)
+	{
+		const PointObject* point = reinterpret_cast<const PointObject*>(this);
+		const PointSymbol* point_symbol = reinterpret_cast<const PointSymbol*>(point->getSymbol());
+		if (point_symbol->isRotatable())
+			xml.writeAttribute(literal::rotation, point->getRotation());
+	}
+	else if (type == Text)
+	{
+		const TextObject* text = reinterpret_cast<const TextObject*>(this);
+		xml.writeAttribute(literal::rotation, text->getRotation());
+		xml.writeAttribute(literal::h_align, int(text->getHorizontalAlignment()));
+		xml.writeAttribute(literal::v_align, int(text->getVerticalAlignment()));
+	}
+	
+	if (!object_tags.empty())
+	{
+		xml.writeStartElement(literal::tags);
+		xml.write(object_tags);
+		xml.writeEndElement();
+	}
+	
+	xml.writeStartElement(literal::coords);
+	MapCoordVector buffer;
+	xml.write(peekCoordinates(buffer));
+	xml.writeEndElement();
+	
+	if (type == Path)
+	{
+		const PathObject* path = reinterpret_cast<const PathObject*>(this);
+		xml.writeStartElement(literal::pattern);
+		xml.writeAttribute(literal::rotation, path->getPatternRotation());
+		path->getPatternOrigin().save(xml);
+		xml.writeEndElement();
+	}
+	else if (type == Text)
+	{
+		const TextObject* text = reinterpret_cast<const TextObject*>(this);
+		xml.writeTextElement(literal::text, text->getText());
+	}
+	
+	xml.writeEndElement();
+}
+
 Object* Object::load(QXmlStreamReader& xml, Map* map, const SymbolDictionary& symbol_dict, const Symbol* symbol)
 {
 	Q_ASSERT(xml.name() == literal::object);
@@ -541,6 +741,8 @@ bool Object::update() const
 	if (!output_dirty)
 		return false;
 	
+	expand();
+	
 	Symbol::RenderableOptions options = Symbol::RenderNormal;
 	if (map)
 	{
@@ -550,6 +752,7 @@ bool Object::update() const
 	}
 	
 	output.deleteRenderables();
+	renderables_evicted = false;
 	
 	extent = QRectF();
 	
@@ -575,6 +778,87 @@ void Object::updateEvent() const
 	// nothing here
 }
 
+void Object::compactEvent()
+{
+	// nothing here
+}
+
+void Object::expandEvent() const
+{
+	// nothing here
+}
+
+bool Object::compact()
+{
+	Q_ASSERT(!map || map->thread() == QThread::currentThread());
+	
+	if (compact_coords
+	    || output_dirty
+	    || type != Path
+	    || coords.size() < min_compact_size)
+	{
+		return false;
+	}
+	
+	compact_coords.reset(new CompactCoordVector(coords));
+	MapCoordVector().swap(coords);
+	compactEvent();
+	return true;
+}
+
+bool Object::evictRenderables()
+{
+	if (renderables_evicted || output_dirty || !map)
+		return false;
+	
+	map->removeRenderablesOfObject(this, false);
+	output.deleteRenderables();
+	renderables_evicted = true;
+	compact();
+	return true;
+}
+
+void Object::restoreRenderables() const
+{
+	if (renderables_evicted)
+		forceUpdate();
+}
+
+std::size_t Object::memoryUsage() const
+{
+	// Renderables vary in size, with painter paths being the largest part.
+	constexpr auto renderable_size = std::size_t(256);
+	auto usage = coords.capacity() * sizeof(MapCoord)
+	             + output.renderableCount() * renderable_size;
+	if (compact_coords)
+		usage += compact_coords->byteSize();
+	return usage;
+}
+
+void Object::expandCompacted() const
+{
+	Q_ASSERT(!map || map->thread() == QThread::currentThread());
+	
+	// The coordinates are logically unchanged, only their representation is.
+	compact_coords->decode(const_cast<MapCoordVector&>(coords));
+	compact_coords.reset();
+	expandEvent();
+}
+
+void Object::discardCompactedCoordinates()
+{
+	compact_coords.reset();
+}
+
+const MapCoordVector& Object::peekCoordinates(MapCoordVector& buffer) const
+{
+	if (!compact_coords)
+		return coords;
+	
+	compact_coords->decode(buffer);
+	return buffer;
+}
+
 void Object::createRenderables(ObjectRenderables& output, Symbol::RenderableOptions options) const
 {
 	symbol->createRenderables(this, VirtualCoordVector(coords), output, options);
@@ -582,6 +866,7 @@ void Object::createRenderables(ObjectRenderables& output, Symbol::RenderableOpti
 
 void Object::move(qint32 dx, qint32 dy)
 {
+	expand();
 	if (type == Text && coords.size() == 2)
 	{
 		MapCoord& coord = coords.front();
@@ -599,6 +884,7 @@ void Object::move(qint32 dx, qint32 dy)
 
 void Object::move(MapCoord offset)
 {
+	expand();
 	if (type == Text && coords.size() == 2)
 	{
 		coords.front() += offset;
@@ -613,6 +899,7 @@ void Object::move(MapCoord offset)
 
 void Object::scale(MapCoordF center, double factor)
 {
+	expand();
 	if (type == Text && coords.size() == 2)
 	{
 		coords[0].setX(center.x() + (coords[0].x() - center.x()) * factor);
@@ -631,6 +918,7 @@ void Object::scale(MapCoordF center, double factor)
 
 void Object::scale(double factor_x, double factor_y)
 {
+	expand();
 	for (MapCoord& coord : coords)
 	{
 		coord.setX(coord.x() * factor_x);
@@ -642,6 +930,7 @@ void Object::scale(double factor_x, double factor_y)
 
 void Object::rotateAround(MapCoordF center, double angle)
 {
+	expand();
 	double sin_angle = sin(angle);
 	double cos_angle = cos(angle);
 	
@@ -672,6 +961,7 @@ void Object::rotateAround(MapCoordF center, double angle)
 
 void Object::rotate(double angle)
 {
+	expand();
 	double sin_angle = sin(angle);
 	double cos_angle = cos(angle);
 	
@@ -705,6 +995,7 @@ void Object::transform(const QTransform& t)
 	if (t.isIdentity())
 		return;
 	
+	expand();
 	for (auto& coord : coords)
 	{
 		const auto p = t.map(MapCoordF{coord});
@@ -735,6 +1026,7 @@ int Object::isPointOnObject(MapCoordF coord, float tolerance, bool treat_areas_a
 	if (coord.x() > extent.right() + extent_extension) return Symbol::NoSymbol;
 	if (coord.y() > extent.bottom() + extent_extension) return Symbol::NoSymbol;
 	
+	expand();
 	if (type == Symbol::Text)
 	{
 		// Texts
@@ -793,6 +1085,7 @@ void Object::setTags(const Object::Tags& tags)
 	if (object_tags != tags)
 	{
 		object_tags = tags;
+		content_hash = 0;
 		if (map)
 		{
 			map->setObjectsDirty();
@@ -807,6 +1100,7 @@ void Object::setTag(const QString& key, const QString& value)
 	if (!object_tags.contains(key) || object_tags.value(key) != value)
 	{
 		object_tags.insert(key, value);
+		content_hash = 0;
 		if (map)
 		{
 			map->setObjectsDirty();
@@ -821,6 +1115,7 @@ void Object::removeTag(const QString& key)
 	if (object_tags.contains(key))
 	{
 		object_tags.remove(key);
+		content_hash = 0;
 		if (map)
 			map->setObjectsDirty();
 	}
@@ -999,6 +1294,7 @@ PathObject::PathObject(const Symbol* symbol, const PathObject& proto, MapCoordVe
  , pattern_rotation { 0.0f }
  , pattern_origin { 0, 0 }
 {
+	proto.expand();
 	auto begin = proto.coords.begin() + piece;
 	auto part  = proto.findPartForIndex(piece);
 	if (piece == part->last_index)
@@ -1082,6 +1378,7 @@ bool PathObject::validate() const
 
 void PathObject::normalize()
 {
+	expand();
 	for (MapCoordVector::size_type i = 0; i < coords.size(); ++i)
 	{
 		if (coords[i].isCurveStart())
@@ -1116,6 +1413,7 @@ void PathObject::normalize()
 
 bool PathObject::intersectsBox(const QRectF& box) const
 {
+	expand();
 	// Check path parts for an intersection with box
 	if (std::any_of(begin(path_parts), end(path_parts), [&box](const PathPart& part) { return part.intersectsBox(box); }))
 	{
@@ -1133,17 +1431,20 @@ bool PathObject::intersectsBox(const QRectF& box) const
 
 PathPartVector::const_iterator PathObject::findPartForIndex(MapCoordVector::size_type coords_index) const
 {
+	expand();
 	return std::lower_bound(begin(path_parts), end(path_parts), coords_index, PathPartVector::compareEndIndex);
 }
 
 PathPartVector::iterator PathObject::findPartForIndex(MapCoordVector::size_type coords_index)
 {
+	expand();
 	setOutputDirty();
 	return std::lower_bound(begin(path_parts), end(path_parts), coords_index, PathPartVector::compareEndIndex);
 }
 
 PathPartVector::size_type PathObject::findPartIndexForIndex(MapCoordVector::size_type coords_index) const
 {
+	expand();
 	for (PathPartVector::size_type i = 0; i < path_parts.size(); ++i)
 	{
 		if (path_parts[i].first_index <= coords_index && path_parts[i].last_index >= coords_index)
@@ -1165,6 +1466,7 @@ PathCoord PathObject::findPathCoordForIndex(MapCoordVector::size_type index) con
 
 bool PathObject::isCurveHandle(MapCoordVector::size_type index) const
 {
+	expand();
 	return ( index < coords.size() &&
 	         !coords[index].isCurveStart() &&
 	         (
@@ -1176,6 +1478,7 @@ bool PathObject::isCurveHandle(MapCoordVector::size_type index) const
 
 void PathObject::deletePart(PathPartVector::size_type part_index)
 {
+	expand();
 	setOutputDirty();
 	
 	auto part = begin(path_parts) + part_index;
@@ -1219,6 +1522,7 @@ void PathObject::calcClosestPointOnPath(
         MapCoordVector::size_type start_index,
         MapCoordVector::size_type end_index) const
 {
+	expand();
 	update();
 	
 	auto bound = std::numeric_limits<float>::max();
@@ -1272,6 +1576,7 @@ MapCoordVector::size_type PathObject::subdivide(const PathCoord& path_coord)
 
 MapCoordVector::size_type PathObject::subdivide(MapCoordVector::size_type index, float param)
 {
+	expand();
 	Q_ASSERT(index < coords.size());
 	
 	if (coords[index].isCurveStart())
@@ -1300,6 +1605,8 @@ MapCoordVector::size_type PathObject::subdivide(MapCoordVector::size_type index,
 
 bool PathObject::canBeConnected(const PathObject* other, double connect_threshold_sq) const
 {
+	expand();
+	other->expand();
 	for (const auto& part : path_parts)
 	{
 		if (part.isClosed())
@@ -1326,6 +1633,7 @@ bool PathObject::canBeConnected(const PathObject* other, double connect_threshol
 
 bool PathObject::connectIfClose(PathObject* other, double connect_threshold_sq)
 {
+	other->expand();
 	bool did_connect_path = false;
 	
 	auto num_parts = parts().size();
@@ -1386,6 +1694,8 @@ bool PathObject::connectIfClose(PathObject* other, double connect_threshold_sq)
 
 void PathObject::connectPathParts(PathPartVector::size_type part_index, const PathObject* other, PathPartVector::size_type other_part_index, bool prepend, bool merge_ends)
 {
+	expand();
+	other->expand();
 	Q_ASSERT(part_index < path_parts.size());
 	PathPart& part = path_parts[part_index];
 	PathPart& other_part = other->path_parts[other_part_index];
@@ -1449,6 +1759,7 @@ void PathObject::connectPathParts(PathPartVector::size_type part_index, const Pa
 
 std::vector<PathObject*> PathObject::removeFromLine(PathPartVector::size_type part_index, qreal begin, qreal end_index) const
 {
+	expand();
 	Q_ASSERT(path_parts.size() == 1); // TODO
 	Q_ASSERT(symbol->getContainedTypes() == Symbol::Line);
 	
@@ -1487,6 +1798,7 @@ std::vector<PathObject*> PathObject::removeFromLine(PathPartVector::size_type pa
 
 std::vector<PathObject*> PathObject::splitLineAt(const PathCoord& split_pos) const
 {
+	expand();
 	Q_ASSERT(path_parts.size() == 1);
 	Q_ASSERT((symbol->getContainedTypes() & ~Symbol::Combined) == Symbol::Line);
 	
@@ -1530,6 +1842,7 @@ void PathObject::changePathBounds(
         PathCoord::length_type start_len,
         PathCoord::length_type end_len)
 {
+	expand();
 	update();
 	
 	PathPart& part = path_parts[part_index];
@@ -2074,6 +2387,8 @@ void PathObject::calcBezierPointDeletionRetainingShapeOptimization(MapCoord p0,
 
 void PathObject::appendPath(const PathObject* other)
 {
+	expand();
+	other->expand();
 	coords.reserve(coords.size() + other->coords.size());
 	coords.insert(coords.end(), other->coords.begin(), other->coords.end());
 	
@@ -2093,6 +2408,7 @@ void PathObject::appendPathPart(const PathPart &part)
 
 void PathObject::reverse()
 {
+	expand();
 	for (auto& part : path_parts)
 		part.reverse();
 		
@@ -2101,12 +2417,14 @@ void PathObject::reverse()
 
 void PathObject::closeAllParts()
 {
+	expand();
 	for (auto& part : path_parts)
 		part.setClosed(true, true);
 }
 
 bool PathObject::convertToCurves(PathObject** undo_duplicate)
 {
+	expand();
 	bool converted_a_range = false;
 	for (const auto& part : path_parts)
 	{
@@ -2136,6 +2454,7 @@ bool PathObject::convertToCurves(PathObject** undo_duplicate)
 
 int PathObject::convertRangeToCurves(const PathPart& part, MapCoordVector::size_type start_index, MapCoordVector::size_type end_index)
 {
+	expand();
 	Q_ASSERT(end_index > start_index);
 	
 	Q_ASSERT(!coords[start_index].isCurveStart());
@@ -2235,6 +2554,8 @@ int PathObject::convertRangeToCurves(const PathPart& part, MapCoordVector::size_
 
 bool PathObject::simplify(PathObject** undo_duplicate, double threshold)
 {
+	expand();
+	
 	// A copy for reference and undo while this is modified.
 	QScopedPointer<PathObject> original(new PathObject(*this));
 	
@@ -2522,6 +2843,8 @@ double PathObject::calcMaximumDistanceTo(
         MapCoordVector::size_type other_start_index,
         MapCoordVector::size_type other_end_index) const
 {
+	expand();
+	other->expand();
 	update();
 	
 	Q_ASSERT(other_start_index == 0);
@@ -2599,6 +2922,8 @@ void PathObject::Intersections::normalize()
 
 void PathObject::calcAllIntersectionsWith(const PathObject* other, PathObject::Intersections& out) const
 {
+	expand();
+	other->expand();
 	update();
 	other->update();
 	
@@ -2866,6 +3191,7 @@ void PathObject::calcAllIntersectionsWith(const PathObject* other, PathObject::I
 
 void PathObject::setCoordinate(MapCoordVector::size_type pos, MapCoord c)
 {
+	expand();
 	Q_ASSERT(pos < getCoordinateCount());
 	
 	const PathPart& part = *findPartForIndex(pos);
@@ -2880,6 +3206,7 @@ void PathObject::setCoordinate(MapCoordVector::size_type pos, MapCoord c)
 
 void PathObject::addCoordinate(MapCoordVector::size_type pos, MapCoord c)
 {
+	expand();
 	Q_ASSERT(pos <= coords.size());
 	
 	if (coords.empty())
@@ -2912,6 +3239,7 @@ void PathObject::addCoordinate(MapCoordVector::size_type pos, MapCoord c)
 
 void PathObject::addCoordinate(MapCoord c, bool start_new_part)
 {
+	expand();
 	if (coords.empty())
 	{
 		addCoordinate(0, c);
@@ -2931,6 +3259,7 @@ void PathObject::addCoordinate(MapCoord c, bool start_new_part)
 
 void PathObject::deleteCoordinate(MapCoordVector::size_type pos, bool adjust_other_coords, int delete_bezier_point_action)
 {
+	expand();
 	const auto part = findPartForIndex(pos);
 	const auto coords_begin = begin(coords);
 	
@@ -3070,6 +3399,7 @@ void PathObject::prepareDeleteBezierPoint(MapCoordVector::size_type pos, int del
 
 void PathObject::clearCoordinates()
 {
+	discardCompactedCoordinates();
 	coords.clear();
 	path_parts.clear();
 	setOutputDirty();
@@ -3077,11 +3407,13 @@ void PathObject::clearCoordinates()
 
 void PathObject::assignCoordinates(const PathObject& proto, MapCoordVector::size_type first, MapCoordVector::size_type last)
 {
+	proto.expand();
 	Q_ASSERT(last < proto.coords.size());
 	
 	auto part = proto.findPartForIndex(first);
 	Q_ASSERT(part == proto.findPartForIndex(last));
 	
+	discardCompactedCoordinates();
 	coords.clear();
 	if (last >= first)
 		coords.reserve(last - first + 1);
@@ -3130,8 +3462,13 @@ void PathObject::updatePathCoords() const
 
 void PathObject::recalculateParts()
 {
+	expand();
 	setOutputDirty();
-	
+	calculateParts();
+}
+
+void PathObject::calculateParts() const
+{
 	path_parts.clear();
 	if (!coords.empty())
 	{
@@ -3142,7 +3479,7 @@ void PathObject::recalculateParts()
 		{
 			if (coords[i].isHolePoint())
 			{
-				path_parts.emplace_back(*this, start_index, i);
+				path_parts.emplace_back(const_cast<PathObject&>(*this), start_index, i);
 				start_index = i+1;
 			}
 			else if (coords[i].isCurveStart())
@@ -3152,7 +3489,7 @@ void PathObject::recalculateParts()
 		}
 		
 		if (start_index <= last_index)
-			path_parts.emplace_back(*this, start_index, last_index);
+			path_parts.emplace_back(const_cast<PathObject&>(*this), start_index, last_index);
 	}
 }
 
@@ -3174,6 +3511,26 @@ void PathObject::createRenderables(ObjectRenderables& output, Symbol::Renderable
 	symbol->createRenderables(this, path_parts, output, options);
 }
 
+std::size_t PathObject::memoryUsage() const
+{
+	auto usage = Object::memoryUsage();
+	for (const auto& part : path_parts)
+		usage += part.path_coords.capacity() * sizeof(PathCoord);
+	return usage;
+}
+
+void PathObject::compactEvent()
+{
+	path_parts.clear();
+	path_parts.shrink_to_fit();
+}
+
+void PathObject::expandEvent() const
+{
+	calculateParts();
+	updatePathCoords();
+}
+
 
 // ### PointObject ###
 
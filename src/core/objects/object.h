@@ -23,7 +23,10 @@
 #define OPENORIENTEERING_OBJECT_H
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <limits>
+#include <memory>
 #include <vector>
 
 #include <QtGlobal>
@@ -46,11 +49,13 @@ class QXmlStreamWriter;
 
 namespace OpenOrienteering {
 
+class CompactCoordVector;
 class Map;
 class PointObject;
 class PathObject;
 class TextObject;
 class VirtualCoordVector;
+class XmlUtf8Writer;
 
 
 /**
@@ -130,6 +135,17 @@ public:
 	
 	virtual bool validate() const;
 	
+	/**
+	 * Returns a 64-bit hash of the object's content.
+	 * 
+	 * The hash covers the object type, the symbol number, the coordinates
+	 * with their flags, the tags, and the type-specific properties such as
+	 * rotation and text. It does not depend on memory addresses, so it can be
+	 * used to match objects from different maps. Except for the symbol
+	 * number, the hash is cached until the object is modified.
+	 */
+	quint64 contentHash() const;
+	
 	/** Returns the object type determined by the subclass */
 	inline Type getType() const;
 	
@@ -151,6 +167,15 @@ public:
 	
 	/** Saves the object in xml format to the given stream. */
 	void save(QXmlStreamWriter& xml) const;
+	
+	/**
+	 * Saves the object in xml format to the given writer.
+	 * 
+	 * The output is the same as for a QXmlStreamWriter without
+	 * auto-formatting, for file format version 6 or later.
+	 */
+	void save(XmlUtf8Writer& xml) const;
+	
 	/**
 	 * Loads the object in xml format from the given stream.
 	 * @param xml The stream to load the object from, must be at the correct tag.
@@ -247,6 +272,82 @@ public:
 	/** Returns if the object's output must be regenerated. */
 	bool isOutputDirty() const;
 	
+	/**
+	 * Replaces the coordinates by a compact encoding, in order to save memory.
+	 * 
+	 * Only path objects with a valid output and with a substantial number of
+	 * coordinates are compacted. Derived data such as path coords is dropped.
+	 * Returns true if the object was compacted.
+	 * 
+	 * The coordinates are restored transparently by expand(). This happens
+	 * implicitly in getRawCoordinateVector(), in update() for dirty objects,
+	 * in the PathObject accessors, and when the object is retrieved via
+	 * MapPart::getObject() or by MapPart's object iteration functions.
+	 * Saving does not expand compacted objects.
+	 * 
+	 * For objects in a map, compacting and expanding must happen on the
+	 * map's thread, i.e. normally on the GUI thread. Worker threads must
+	 * operate on copies, which are never compacted, or on data which was
+	 * extracted before the work was started.
+	 */
+	bool compact();
+	
+	/** Returns true if the coordinates are currently held in compact form. */
+	bool isCompacted() const;
+	
+	/**
+	 * Restores the coordinates and derived data of a compacted object,
+	 * and marks the object as recently used.
+	 * 
+	 * Although this function is const, it modifies a compacted object, which
+	 * is not thread-safe, cf. compact(). For other objects, it only sets the
+	 * recently-used mark, which is safe for concurrent readers.
+	 * 
+	 * All PathObject member functions which access the coordinates or the
+	 * path parts call this function first.
+	 */
+	void expand() const;
+	
+	/**
+	 * Returns true if the object was used since the last call to
+	 * resetRecentlyUsed(), i.e. if expand() was called.
+	 */
+	bool isRecentlyUsed() const;
+	
+	/** Clears the recently-used mark. */
+	void resetRecentlyUsed() const;
+	
+	/** The minimum number of coordinates for compacting an object. */
+	static constexpr MapCoordVector::size_type min_compact_size = 16;
+	
+	/**
+	 * Drops the renderables and the derived path coordinates, in order to save memory.
+	 * 
+	 * The object keeps its extent, so that it can still be found by spatial
+	 * queries. Only objects in a map and with an up-to-date output are
+	 * evicted. Returns true if the renderables were evicted.
+	 * 
+	 * @see restoreRenderables()
+	 */
+	bool evictRenderables();
+	
+	/** Returns true if the renderables were dropped by evictRenderables(). */
+	bool hasEvictedRenderables() const;
+	
+	/**
+	 * Regenerates the renderables if they were evicted.
+	 * 
+	 * Map::draw() and similar functions call this for the evicted objects
+	 * which intersect the area to be drawn.
+	 */
+	void restoreRenderables() const;
+	
+	/**
+	 * Returns an estimate of the memory (in bytes) which is occupied by
+	 * the coordinates and the output of this object.
+	 */
+	virtual std::size_t memoryUsage() const;
+	
 	/**
 	 * Changes the object's symbol, returns if successful.
 	 * 
@@ -304,6 +405,19 @@ protected:
 	
 	virtual void createRenderables(ObjectRenderables& output, Symbol::RenderableOptions options) const;
 	
+	/** Called by compact() after the coordinates were encoded and cleared. */
+	virtual void compactEvent();
+	
+	/** Called by expand() after the coordinates were decoded. */
+	virtual void expandEvent() const;
+	
+	/**
+	 * Drops the compact encoding without decoding it.
+	 * 
+	 * This is for functions which replace all coordinates.
+	 */
+	void discardCompactedCoordinates();
+	
 	Type type;
 	const Symbol* symbol;
 	MapCoordVector coords;
@@ -314,6 +428,21 @@ private:
 	mutable bool output_dirty;        // does the output have to be re-generated because of changes?
 	mutable QRectF extent;            // only valid after calling update()
 	mutable ObjectRenderables output; // only valid after calling update()
+	mutable std::unique_ptr<CompactCoordVector> compact_coords; // only set when compacted
+	mutable std::atomic<bool> recently_used;  // may be set by concurrent readers
+	mutable bool renderables_evicted;
+	mutable quint64 content_hash;     // 0 if not yet calculated
+	
+	void expandCompacted() const;
+	
+	/**
+	 * Returns the coordinates without expanding a compacted object.
+	 * 
+	 * For a compacted object, the coordinates are decoded into the buffer.
+	 */
+	const MapCoordVector& peekCoordinates(MapCoordVector& buffer) const;
+	
+	quint64 calculateContentHash() const;
 };
 
 
@@ -502,6 +631,8 @@ public:
 	
 	bool intersectsBox(const QRectF& box) const override;
 	
+	std::size_t memoryUsage() const override;
+	
 	
 	// Coordinate access methods
 	
@@ -901,7 +1032,14 @@ protected:
 	
 	void createRenderables(ObjectRenderables& output, Symbol::RenderableOptions options) const override;
 	
+	void compactEvent() override;
+	
+	void expandEvent() const override;
+	
 private:
+	/** Builds the path parts from the coordinates' hole points. */
+	void calculateParts() const;
+	
 	/**
 	 * Rotation angle of the object pattern. Only used if the object
 	 * has a symbol which interprets this value.
@@ -1076,6 +1214,7 @@ const ObjectRenderables& Object::renderables() const
 inline
 const MapCoordVector& Object::getRawCoordinateVector() const
 {
+	expand();
 	return coords;
 }
 
@@ -1083,6 +1222,8 @@ inline
 void Object::setOutputDirty(bool dirty)
 {
 	output_dirty = dirty;
+	if (dirty)
+		content_hash = 0;
 }
 
 inline
@@ -1091,6 +1232,40 @@ bool Object::isOutputDirty() const
 	return output_dirty;
 }
 
+inline
+bool Object::isCompacted() const
+{
+	return bool(compact_coords);
+}
+
+inline
+void Object::expand() const
+{
+	// Const accessors may be used from worker threads.
+	if (!recently_used.load(std::memory_order_relaxed))
+		recently_used.store(true, std::memory_order_relaxed);
+	if (Q_UNLIKELY(compact_coords))
+		expandCompacted();
+}
+
+inline
+bool Object::isRecentlyUsed() const
+{
+	return recently_used.load(std::memory_order_relaxed);
+}
+
+inline
+void Object::resetRecentlyUsed() const
+{
+	recently_used.store(false, std::memory_order_relaxed);
+}
+
+inline
+bool Object::hasEvictedRenderables() const
+{
+	return renderables_evicted;
+}
+
 inline
 const Symbol* Object::getSymbol() const
 {
@@ -1169,12 +1344,14 @@ PathPart& PathPart::operator=(const PathPart& rhs)
 inline
 MapCoordVector::size_type PathObject::getCoordinateCount() const
 {
+	expand();
 	return coords.size();
 }
 
 inline
 const MapCoord& PathObject::getCoordinate(MapCoordVector::size_type pos) const
 {
+	expand();
 	Q_ASSERT(pos < coords.size());
 	return coords[pos];
 }
@@ -1182,6 +1359,7 @@ const MapCoord& PathObject::getCoordinate(MapCoordVector::size_type pos) const
 inline
 MapCoord& PathObject::getCoordinate(MapCoordVector::size_type pos)
 {
+	expand();
 	Q_ASSERT(pos < coords.size());
 	setOutputDirty();
 	return coords[pos];
@@ -1190,12 +1368,14 @@ MapCoord& PathObject::getCoordinate(MapCoordVector::size_type pos)
 inline
 const PathPartVector& PathObject::parts() const
 {
+	expand();
 	return path_parts;
 }
 
 inline
 PathPartVector& PathObject::parts()
 {
+	expand();
 	setOutputDirty();
 	return path_parts;
 }
@@ -0,0 +1,176 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "object_memory_budget.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <QVariant>
+
+#include "settings.h"
+#include "core/map.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+
+
+namespace OpenOrienteering {
+
+ObjectMemoryBudget::ObjectMemoryBudget(Map& map)
+: map(map)
+{
+	check_timer.setInterval(check_interval);
+	connect(&check_timer, &QTimer::timeout, this, &ObjectMemoryBudget::check);
+	connect(&Settings::getInstance(), &Settings::settingsChanged, this, &ObjectMemoryBudget::settingsChanged);
+	settingsChanged();
+}
+
+ObjectMemoryBudget::~ObjectMemoryBudget()
+{
+	// nothing, not inlined
+}
+
+
+void ObjectMemoryBudget::settingsChanged()
+{
+	auto const mebibytes = Settings::getInstance().getSetting(Settings::General_ObjectMemoryBudget).toInt();
+	setBudget(std::size_t(std::max(0, mebibytes)) << 20);
+}
+
+
+void ObjectMemoryBudget::setBudget(std::size_t bytes)
+{
+	budget_bytes = bytes;
+	updateTimer();
+}
+
+
+void ObjectMemoryBudget::setActive(bool active)
+{
+	this->active = active;
+	updateTimer();
+}
+
+
+void ObjectMemoryBudget::updateTimer()
+{
+	if (!active || budget_bytes == 0)
+	{
+		check_timer.stop();
+		last_visible.clear();
+		checked_areas.clear();
+	}
+	else if (!check_timer.isActive())
+	{
+		check_timer.start();
+	}
+}
+
+
+void ObjectMemoryBudget::check()
+{
+	auto const visible_areas = map.visibleAreas();
+	// Without views, there is nothing to tell near from far objects.
+	if (visible_areas.empty())
+		return;
+	
+	// Without changes, another scan would not find anything new.
+	if (map.objectsRevision() == checked_revision && visible_areas == checked_areas)
+		return;
+	
+	enforce(visible_areas);
+	checked_revision = map.objectsRevision();
+	checked_areas = visible_areas;
+}
+
+
+int ObjectMemoryBudget::enforce(const std::vector<QRectF>& visible_areas)
+{
+	if (budget_bytes == 0)
+		return 0;
+	
+	++generation;
+	
+	// Objects next to the visible areas are likely to be shown soon.
+	std::vector<QRectF> near_areas;
+	near_areas.reserve(visible_areas.size());
+	for (const auto& area : visible_areas)
+	{
+		auto const margin = std::max(area.width(), area.height());
+		near_areas.push_back(area.adjusted(-margin, -margin, margin, margin));
+	}
+	auto is_near = [&near_areas](const QRectF& extent) {
+		return std::any_of(begin(near_areas), end(near_areas), [&extent](const QRectF& area) {
+			return area.intersects(extent);
+		});
+	};
+	
+	// Collect usage, visibility, and the candidates for eviction.
+	auto usage = std::size_t(0);
+	std::vector<std::pair<quint64, Object*>> candidates;
+	std::unordered_map<const Object*, quint64> stamps;
+	stamps.reserve(last_visible.size());
+	for (int i = 0; i < map.getNumParts(); ++i)
+	{
+		map.getPart(i)->applyOnAllObjectsUnexpanded([&](Object* object) {
+			usage += object->memoryUsage();
+			
+			auto stamp = generation;
+			const auto& extent = object->getExtent();
+			if (extent.isValid() && !is_near(extent) && !map.isObjectSelected(object))
+			{
+				auto found = last_visible.find(object);
+				stamp = (found == last_visible.end()) ? 0 : found->second;
+				if (!object->hasEvictedRenderables() && !object->isOutputDirty())
+					candidates.emplace_back(stamp, object);
+			}
+			stamps.emplace(object, stamp);
+		});
+	}
+	// Dropping the old table also drops the entries of deleted objects.
+	last_visible.swap(stamps);
+	
+	if (usage <= budget_bytes)
+		return 0;
+	
+	// Least recently visible first
+	std::stable_sort(begin(candidates), end(candidates), [](const auto& lhs, const auto& rhs) {
+		return lhs.first < rhs.first;
+	});
+	
+	auto count = 0;
+	for (const auto& candidate : candidates)
+	{
+		if (usage <= budget_bytes)
+			break;
+		
+		auto* object = candidate.second;
+		auto const object_usage = object->memoryUsage();
+		if (object->evictRenderables())
+		{
+			usage = usage - object_usage + object->memoryUsage();
+			++count;
+		}
+	}
+	return count;
+}
+
+
+}  // namespace OpenOrienteering
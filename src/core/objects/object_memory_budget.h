@@ -0,0 +1,118 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_OBJECT_MEMORY_BUDGET_H
+#define OPENORIENTEERING_OBJECT_MEMORY_BUDGET_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include <QtGlobal>
+#include <QObject>
+#include <QRectF>
+#include <QTimer>
+
+namespace OpenOrienteering {
+
+class Map;
+class Object;
+
+
+/**
+ * Limits the memory which is used for the output of map objects.
+ * 
+ * Every object keeps its renderables and its path coords once they were
+ * generated. For very large maps, this may consume more memory than the
+ * objects themselves. This class periodically checks the estimated memory
+ * usage of all objects against a budget. When the budget is exceeded, it
+ * evicts the renderables of objects which are far outside of all visible
+ * areas, least recently visible objects first.
+ * 
+ * Evicted objects are regenerated lazily when they are drawn or printed.
+ * 
+ * The periodic check runs only while the map is shown in map widgets, i.e.
+ * while it is open in an editor. It is skipped while neither the objects
+ * nor the visible areas changed since the previous check.
+ * 
+ * The budget is taken from Settings::General_ObjectMemoryBudget.
+ */
+class ObjectMemoryBudget : public QObject
+{
+Q_OBJECT
+public:
+	/** Creates a memory budget for the given map. */
+	explicit ObjectMemoryBudget(Map& map);
+	
+	~ObjectMemoryBudget() override;
+	
+	/** Returns the budget in bytes, or 0 for no limit. */
+	std::size_t budget() const { return budget_bytes; }
+	
+	/** Sets the budget in bytes. 0 removes the limit. */
+	void setBudget(std::size_t bytes);
+	
+	/** Returns true if the periodic check is enabled. */
+	bool isActive() const { return active; }
+	
+	/**
+	 * Enables or disables the periodic check.
+	 * 
+	 * The map enables the check while it is shown in map widgets.
+	 */
+	void setActive(bool active);
+	
+	/**
+	 * Checks the budget, and evicts the renderables of least recently
+	 * visible objects when the budget is exceeded.
+	 * 
+	 * Objects within a margin around the visible areas (in map coordinates),
+	 * selected objects, and objects waiting for an update, are not evicted.
+	 * Returns the number of evicted objects.
+	 */
+	int enforce(const std::vector<QRectF>& visible_areas);
+	
+	/** The interval (in ms) of the periodic budget check. */
+	static constexpr int check_interval = 10000;
+	
+private:
+	/** Runs enforce() for the areas shown in the map's widgets. */
+	void check();
+	
+	void settingsChanged();
+	
+	/** Starts or stops the timer, depending on the state and on the budget. */
+	void updateTimer();
+	
+	Q_DISABLE_COPY(ObjectMemoryBudget)
+	
+	Map& map;
+	QTimer check_timer;
+	std::unordered_map<const Object*, quint64> last_visible;
+	quint64 generation = 0;
+	std::size_t budget_bytes = 0;
+	std::vector<QRectF> checked_areas;
+	quint64 checked_revision = 0;
+	bool active = false;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
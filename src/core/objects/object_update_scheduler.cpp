@@ -0,0 +1,124 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "object_update_scheduler.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+
+#include "core/map.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+
+
+namespace OpenOrienteering {
+
+ObjectUpdateScheduler::ObjectUpdateScheduler(Map& map)
+: map(map)
+{
+	batch_timer.setInterval(0);
+	connect(&batch_timer, &QTimer::timeout, this, &ObjectUpdateScheduler::processBatch);
+}
+
+ObjectUpdateScheduler::~ObjectUpdateScheduler()
+{
+	// nothing, not inlined
+}
+
+
+void ObjectUpdateScheduler::schedule(const Condition& condition, const std::vector<QRectF>& priority_areas)
+{
+	auto is_priority = [this, &priority_areas](const Object* object) {
+		const auto& extent = object->getExtent();
+		return !extent.isValid()
+		       || map.isObjectSelected(object)
+		       || std::any_of(begin(priority_areas), end(priority_areas), [&extent](const QRectF& area) {
+		              return area.intersects(extent);
+		          });
+	};
+
+	// Marking an object as dirty does not need its coordinates. Only the
+	// objects which are updated immediately are expanded, by forceUpdate().
+	for (int i = 0; i < map.getNumParts(); ++i)
+	{
+		map.getPart(i)->applyOnAllObjectsUnexpanded([&condition, &is_priority](Object* object) {
+			if (!condition(object))
+				return;
+			if (is_priority(object))
+				object->forceUpdate();
+			else
+				object->setOutputDirty();
+		});
+	}
+
+	// Restart from the beginning: The new dirty objects may be located
+	// before the current position.
+	part_index = 0;
+	object_index = 0;
+	pending = true;
+	batch_timer.start();
+}
+
+
+void ObjectUpdateScheduler::finish()
+{
+	if (!pending)
+		return;
+
+	batch_timer.stop();
+	pending = false;
+	// Filtering by the dirty state avoids expanding compacted objects.
+	map.applyOnMatchingObjects([](Object* object) { object->update(); },
+	                           [](const Object* object) { return object->isOutputDirty(); });
+}
+
+
+void ObjectUpdateScheduler::processBatch()
+{
+	QElapsedTimer elapsed;
+	elapsed.start();
+
+	auto const num_parts = std::size_t(map.getNumParts());
+	for (; part_index < num_parts; ++part_index, object_index = 0)
+	{
+		// Clean objects are skipped without expanding them.
+		// update() expands only the dirty ones.
+		const auto* part = map.getPart(part_index);
+		auto const num_objects = std::size_t(part->getNumObjects());
+		for (; object_index < num_objects; ++object_index)
+		{
+			auto const* object = part->getObjectUnexpanded(int(object_index));
+			if (!object->isOutputDirty())
+				continue;
+			if (object->update() && elapsed.elapsed() >= batch_duration)
+			{
+				++object_index;
+				return;
+			}
+		}
+	}
+
+	// Objects may have been added or removed while waiting for the
+	// next batch. Catch any dirty object which was skipped that way.
+	finish();
+}
+
+
+}  // namespace OpenOrienteering
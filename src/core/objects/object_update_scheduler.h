@@ -0,0 +1,101 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_OBJECT_UPDATE_SCHEDULER_H
+#define OPENORIENTEERING_OBJECT_UPDATE_SCHEDULER_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <QObject>
+#include <QRectF>
+#include <QTimer>
+
+namespace OpenOrienteering {
+
+class Map;
+class Object;
+
+
+/**
+ * Regenerates the renderables of many map objects without blocking the GUI.
+ *
+ * Changing a symbol or a color may require the regeneration of every object
+ * in the map. For large maps, doing this in a single run freezes the user
+ * interface for a long time. This scheduler splits the work:
+ *
+ * - Objects which intersect one of the given priority areas (normally the
+ *   areas shown in the map widgets), and selected objects, are updated
+ *   immediately.
+ * - All other objects are only marked as dirty. They keep their old
+ *   renderables until they are updated in small batches from the event loop.
+ *
+ * The batches run on the GUI thread because the map's renderables are not
+ * thread-safe. finish() must be called before the map's objects are
+ * consumed as a whole, e.g. for saving, printing, or exporting.
+ */
+class ObjectUpdateScheduler : public QObject
+{
+Q_OBJECT
+public:
+	/** A condition which selects objects for an update. */
+	using Condition = std::function<bool (const Object*)>;
+
+	/** Creates a scheduler for the given map. */
+	explicit ObjectUpdateScheduler(Map& map);
+
+	~ObjectUpdateScheduler() override;
+
+	/**
+	 * Marks all objects matching the condition for an update.
+	 *
+	 * Objects intersecting one of the priority areas (in map coordinates)
+	 * are updated before this function returns.
+	 */
+	void schedule(const Condition& condition, const std::vector<QRectF>& priority_areas);
+
+	/** Returns true if there are objects waiting for an update. */
+	bool isPending() const { return pending; }
+
+	/** Synchronously updates all objects which are still waiting. */
+	void finish();
+
+	/**
+	 * The time in milliseconds which a single batch may spend on updating objects.
+	 */
+	static constexpr int batch_duration = 15;
+
+private:
+	/** Updates the next batch of objects. */
+	void processBatch();
+
+	Q_DISABLE_COPY(ObjectUpdateScheduler)
+
+	Map& map;
+	QTimer batch_timer;
+	std::size_t part_index   = 0;
+	std::size_t object_index = 0;
+	bool pending = false;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
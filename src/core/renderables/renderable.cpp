@@ -88,6 +88,16 @@ namespace OpenOrienteering {
 
 Renderable::~Renderable() = default;
 
+QPainterPath Renderable::shape() const
+{
+	return {};
+}
+
+std::size_t Renderable::elementCount() const
+{
+	return 1;
+}
+
 
 
 // ### SharedRenderables ###
@@ -134,6 +144,12 @@ ObjectRenderables::ObjectRenderables(Object& object)
 	// nothing else
 }
 
+ObjectRenderables::ObjectRenderables(QRectF& extent)
+: extent(extent)
+{
+	// nothing else
+}
+
 ObjectRenderables::~ObjectRenderables() = default;
 
 void ObjectRenderables::draw(int map_color, const QColor& color, QPainter* painter, const RenderConfig& config) const
@@ -211,6 +227,21 @@ void ObjectRenderables::takeRenderables()
 	}
 }
 
+void ObjectRenderables::releaseGroups(const std::function<void (const PainterConfig&, RenderableVector&&)>& receiver)
+{
+	for (auto& color : *this)
+	{
+		for (auto& renderables : *color.second)
+		{
+			if (renderables.second.empty())
+				continue;
+			
+			receiver(renderables.first, std::move(renderables.second));
+			renderables.second.clear();
+		}
+	}
+}
+
 void ObjectRenderables::deleteRenderables()
 {
 	for (auto& color : *this)
@@ -219,6 +250,20 @@ void ObjectRenderables::deleteRenderables()
 	}
 }
 
+std::size_t ObjectRenderables::renderableCount() const
+{
+	auto count = std::size_t(0);
+	for (const auto& color : *this)
+	{
+		for (const auto& renderables : *color.second)
+		{
+			for (const auto renderable : renderables.second)
+				count += renderable->elementCount();
+		}
+	}
+	return count;
+}
+
 
 
 // ### MapRenderables ###
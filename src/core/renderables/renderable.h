@@ -21,6 +21,8 @@
 #ifndef OPENORIENTEERING_RENDERABLE_H
 #define OPENORIENTEERING_RENDERABLE_H
 
+#include <cstddef>
+#include <functional>
 #include <map>
 #include <vector>
 
@@ -72,6 +74,12 @@ public:
 		HelperSymbols       = 1<<3, ///< Activates display of symbols with the "helper symbol" flag.
 		Highlighted         = 1<<4, ///< Makes the color appear highlighted.
 		RequireSpotColor    = 1<<5, ///< Skips colors which do not have a spot color definition.
+		Preview             = 1<<6, ///< Skips text and tiny point details for the benefit of speed.
+		                            ///  Used for the screen during continuous interaction.
+		StrokeOutlines      = 1<<7, ///< Fills cached outlines instead of stroking thick lines.
+		                            ///  Saves time on redraws, at the cost of memory.
+		TextObjects         = 1<<8, ///< Draws text as text with embedded fonts where supported
+		                            ///  (PDF), instead of drawing the glyph outlines.
 		Tool                = Screen | ForceMinSize | HelperSymbols, ///< The recommended flags for tools.
 		NoOptions           = 0     ///< No option activated.
 	};
@@ -104,6 +112,11 @@ public:
 	 * \see QFlags::testFlag()
 	 */
 	bool testFlag(const Option flag) const;
+	
+	/**
+	 * The minimum size (in pixels) of point details which are drawn in Preview mode.
+	 */
+	static constexpr qreal preview_min_pixels = 2.0;
 };
 
 
@@ -120,6 +133,9 @@ protected:
 	/** The constructor for new renderables. */
 	explicit Renderable(const MapColor* color);
 	
+	/** The constructor for renderables which represent a given color priority. */
+	explicit Renderable(int color_priority);
+	
 public:
 	Renderable(const Renderable&) = delete;
 	Renderable(Renderable&&) = delete;
@@ -154,6 +170,22 @@ public:
 	 */
 	virtual void render(QPainter& painter, const RenderConfig& config) const = 0;
 	
+	/**
+	 * Returns the area which is covered when rendering this renderable.
+	 * 
+	 * The shape is meant to be filled, even for renderables which are drawn
+	 * with a pen. The default implementation returns an empty path, meaning
+	 * that the shape is not available.
+	 */
+	virtual QPainterPath shape() const;
+	
+	/**
+	 * Returns the number of elementary renderables represented by this one.
+	 * 
+	 * The default implementation returns 1.
+	 */
+	virtual std::size_t elementCount() const;
+	
 protected:
 	/** The color priority is a major attribute and cannot be modified. */
 	const int color_priority;
@@ -260,6 +292,9 @@ class ObjectRenderables : protected std::map<int, SharedRenderables::Pointer>
 friend class MapRenderables;
 public:
 	ObjectRenderables(Object& object);
+	
+	/** Constructs a container which is not bound to an object. */
+	explicit ObjectRenderables(QRectF& extent);
 	ObjectRenderables(const ObjectRenderables&) = delete;
 	ObjectRenderables& operator=(const ObjectRenderables&) = delete;
 	~ObjectRenderables();
@@ -271,6 +306,15 @@ public:
 	void deleteRenderables();
 	void takeRenderables();
 	
+	/**
+	 * Hands over the renderables to the given function, group by group.
+	 * 
+	 * The function is called for each group of renderables with common render
+	 * attributes. It takes the ownership of the renderables. Afterwards, this
+	 * container is empty.
+	 */
+	void releaseGroups(const std::function<void (const PainterConfig&, RenderableVector&&)>& receiver);
+	
 	/**
 	 * Draws all renderables matching the given map color with the given color.
 	 * 
@@ -285,6 +329,9 @@ public:
 	
 	const QRectF& getExtent() const;
 	
+	/** Returns the number of renderables. */
+	std::size_t renderableCount() const;
+	
 private:
 	QRectF& extent;
 	const QPainterPath* clip_path = nullptr; // no memory management here!
@@ -393,6 +440,13 @@ Renderable::Renderable(const MapColor* color)
 	; // nothing
 }
 
+inline
+Renderable::Renderable(int color_priority)
+ : color_priority(color_priority)
+{
+	; // nothing
+}
+
 inline
 const QRectF&Renderable::getExtent() const
 {
@@ -20,9 +20,11 @@
 
 #include "renderable_implementation.h"
 
+#include <cmath>
 #include <cstddef>
 #include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <QtMath>
@@ -31,8 +33,10 @@
 #include <QFontMetricsF>
 #include <QPaintEngine>
 #include <QPainter>
+#include <QPainterPathStroker>
 #include <QPen>
 #include <QPoint>
+#include <QPolygonF>
 #include <QTransform>
 // IWYU pragma: no_include <QVariant>
 
@@ -53,6 +57,8 @@
 #  include "advanced_pdf_printer.h"
 #endif
 
+#include <clipper.hpp>
+
 // IWYU pragma: no_forward_declare QFontMetricsF
 
 
@@ -85,12 +91,136 @@ inline void fixPenForPdf(QPen& pen, const QPainter& painter)
 #endif
 }
 
+/**
+ * The number of Clipper integer units per map unit (millimeter).
+ * 
+ * This matches the resolution of native map coordinates.
+ */
+constexpr qreal clipper_scale = 1000;
+
+/**
+ * Converts a painter path to Clipper paths.
+ * 
+ * Curves are flattened in Clipper coordinates. Doing this in map units
+ * would result in a too coarse approximation.
+ */
+ClipperLib::Paths toClipperPaths(const QPainterPath& path)
+{
+	const auto polygons = path.toSubpathPolygons(QTransform::fromScale(clipper_scale, clipper_scale));
+	ClipperLib::Paths paths;
+	paths.reserve(std::size_t(polygons.size()));
+	for (const auto& polygon : polygons)
+	{
+		ClipperLib::Path clipper_path;
+		clipper_path.reserve(std::size_t(polygon.size()));
+		for (const auto& point : polygon)
+			clipper_path.push_back(ClipperLib::IntPoint(qRound64(point.x()), qRound64(point.y())));
+		paths.push_back(std::move(clipper_path));
+	}
+	return paths;
+}
+
+/**
+ * Converts Clipper paths back to a painter path.
+ */
+QPainterPath toPainterPath(const ClipperLib::Paths& paths, bool closed)
+{
+	QPainterPath result;
+	for (const auto& clipper_path : paths)
+	{
+		if (clipper_path.size() < 2)
+			continue;
+		
+		auto point = begin(clipper_path);
+		result.moveTo(point->X / clipper_scale, point->Y / clipper_scale);
+		for (++point; point != end(clipper_path); ++point)
+			result.lineTo(point->X / clipper_scale, point->Y / clipper_scale);
+		if (closed)
+			result.closeSubpath();
+	}
+	return result;
+}
+
 }  // namespace
 
 
 
 namespace OpenOrienteering {
 
+// ### ClippedPathCache ###
+
+const QPainterPath& ClippedPathCache::clippedPath(const QPainterPath& path, PathType type, const QRectF& bounding_box, qreal scaling, qreal padding)
+{
+	if (path.elementCount() < min_element_count || scaling <= 0 || !bounding_box.isValid())
+		return path;
+	
+	auto const level = qCeil(std::log2(tile_pixels / scaling));
+	auto const tile_size = std::ldexp(1.0, level);
+	auto const range = QRect { QPoint { qFloor(bounding_box.left() / tile_size), qFloor(bounding_box.top() / tile_size) },
+	                           QPoint { qFloor(bounding_box.right() / tile_size), qFloor(bounding_box.bottom() / tile_size) } };
+	if (valid && level == tile_level && range == tile_range)
+		return clipped_path;
+	
+	// Some pixels of extra padding hide the clipped edges of highlighted areas.
+	padding += 8 / scaling;
+	auto const region = QRectF { range.left() * tile_size, range.top() * tile_size,
+	                             range.width() * tile_size, range.height() * tile_size }
+	                    .adjusted(-padding, -padding, padding, padding);
+	if (region.contains(path.controlPointRect()))
+		return path;
+	
+	ClipperLib::Path clip_polygon;
+	clip_polygon.reserve(4);
+	for (const auto& corner : { region.topLeft(), region.topRight(), region.bottomRight(), region.bottomLeft() })
+		clip_polygon.push_back(ClipperLib::IntPoint(qRound64(corner.x() * clipper_scale), qRound64(corner.y() * clipper_scale)));
+	
+	ClipperLib::Clipper clipper;
+	clipper.AddPaths(toClipperPaths(path), ClipperLib::ptSubject, type == Polygons);
+	clipper.AddPath(clip_polygon, ClipperLib::ptClip, true);
+	
+	ClipperLib::Paths result;
+	if (type == Polygons)
+	{
+		auto const fill_type = path.fillRule() == Qt::WindingFill ? ClipperLib::pftNonZero : ClipperLib::pftEvenOdd;
+		clipper.Execute(ClipperLib::ctIntersection, result, fill_type, ClipperLib::pftNonZero);
+	}
+	else
+	{
+		ClipperLib::PolyTree tree;
+		clipper.Execute(ClipperLib::ctIntersection, tree, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+		ClipperLib::OpenPathsFromPolyTree(tree, result);
+	}
+	
+	// Clipper returns outer polygons and holes with opposite orientation,
+	// so the default fill rule works for both input fill rules.
+	clipped_path = toPainterPath(result, type == Polygons);
+	tile_range = range;
+	tile_level = level;
+	valid = true;
+	return clipped_path;
+}
+
+
+
+// ### StrokeOutlineCache ###
+
+const QPainterPath& StrokeOutlineCache::outline(const QPainterPath& path, const QPen& pen, qreal scaling)
+{
+	auto const bucket = qCeil(std::log2(scaling));
+	if (valid && bucket == zoom_bucket)
+		return outline_path;
+	
+	QPainterPathStroker stroker(pen);
+	// A quarter pixel at the largest scaling of the bucket
+	stroker.setCurveThreshold(std::ldexp(0.25, -bucket));
+	outline_path = stroker.createStroke(path);
+	zoom_bucket = bucket;
+	valid = true;
+	return outline_path;
+}
+
+
+
 // ### DotRenderable ###
 
 DotRenderable::DotRenderable(const PointSymbol* symbol, MapCoordF coord)
@@ -107,8 +237,18 @@ PainterConfig DotRenderable::getPainterConfig(const QPainterPath* clip_path) con
 	return { color_priority, PainterConfig::BrushOnly, 0, clip_path };
 }
 
+QPainterPath DotRenderable::shape() const
+{
+	QPainterPath path;
+	path.addEllipse(extent);
+	return path;
+}
+
 void DotRenderable::render(QPainter &painter, const RenderConfig &config) const
 {
+	if (config.testFlag(RenderConfig::Preview) && extent.width() * config.scaling < RenderConfig::preview_min_pixels)
+		return;
+	
 	if (config.options.testFlag(RenderConfig::ForceMinSize) && extent.width() * config.scaling < 1.5)
 		painter.drawEllipse(extent.center(), 0.5 / config.scaling, 0.5 * config.scaling);
 	else
@@ -135,8 +275,20 @@ PainterConfig CircleRenderable::getPainterConfig(const QPainterPath* clip_path)
 	return { color_priority, PainterConfig::PenOnly, line_width, clip_path };
 }
 
+QPainterPath CircleRenderable::shape() const
+{
+	QPainterPath path;
+	path.addEllipse(rect);
+	QPainterPathStroker stroker;
+	stroker.setWidth(line_width);
+	return stroker.createStroke(path);
+}
+
 void CircleRenderable::render(QPainter &painter, const RenderConfig &config) const
 {
+	if (config.testFlag(RenderConfig::Preview) && extent.width() * config.scaling < RenderConfig::preview_min_pixels)
+		return;
+	
 	if (config.options.testFlag(RenderConfig::ForceMinSize) && rect.width() * config.scaling < 1.5)
 		painter.drawEllipse(rect.center(), 0.5 / config.scaling, 0.5 / config.scaling);
 	else
@@ -431,6 +583,17 @@ PainterConfig LineRenderable::getPainterConfig(const QPainterPath* clip_path) co
 	return { color_priority, PainterConfig::PenOnly, line_width, clip_path };
 }
 
+QPainterPath LineRenderable::shape() const
+{
+	QPainterPathStroker stroker;
+	stroker.setWidth(line_width);
+	stroker.setCapStyle(cap_style);
+	stroker.setJoinStyle(join_style);
+	if (join_style == Qt::MiterJoin)
+		stroker.setMiterLimit(LineSymbol::miterLimit());
+	return stroker.createStroke(path);
+}
+
 void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
 {
 	QPen pen(painter.pen());
@@ -443,14 +606,34 @@ void LineRenderable::render(QPainter &painter, const RenderConfig &config) const
 	}
 	painter.setPen(pen);
 	
+	const int count = path.elementCount();
+	if (config.testFlag(RenderConfig::StrokeOutlines)
+	    && count > 2
+	    && count <= StrokeOutlineCache::max_element_count
+	    && pen.style() == Qt::SolidLine
+	    && pen.widthF() * config.scaling >= StrokeOutlineCache::min_pixels)
+	{
+		// Thick line: fill the cached outline instead of stroking again
+		if (!outline_cache)
+			outline_cache.reset(new StrokeOutlineCache());
+		painter.fillPath(outline_cache->outline(path, pen, config.scaling), pen.brush());
+		return;
+	}
+	
 	// One-time adjustment for line width
 	QRectF bounding_box = config.bounding_box.adjusted(-line_width, -line_width, line_width, line_width);
-	const int count = path.elementCount();
 	if (count <= 2 || bounding_box.contains(path.controlPointRect()))
 	{
 		// path fully contained
 		painter.drawPath(path);
 	}
+	else if (count >= ClippedPathCache::min_element_count && config.testFlag(RenderConfig::Screen))
+	{
+		// Huge path, e.g. a long boundary: clip once per tile region
+		if (!clip_cache)
+			clip_cache.reset(new ClippedPathCache());
+		painter.drawPath(clip_cache->clippedPath(path, ClippedPathCache::Polylines, config.bounding_box, config.scaling, line_width));
+	}
 	else
 	{
 		// Manually clip the path with bounding_box, this seems to be faster.
@@ -654,9 +837,24 @@ PainterConfig AreaRenderable::getPainterConfig(const QPainterPath* clip_path) co
 	return { color_priority, PainterConfig::BrushOnly, 0, clip_path };
 }
 
-void AreaRenderable::render(QPainter &painter, const RenderConfig &/*config*/) const
+QPainterPath AreaRenderable::shape() const
 {
-	painter.drawPath(path);
+	return path;
+}
+
+void AreaRenderable::render(QPainter &painter, const RenderConfig &config) const
+{
+	if (path.elementCount() >= ClippedPathCache::min_element_count
+	    && config.testFlag(RenderConfig::Screen))
+	{
+		if (!clip_cache)
+			clip_cache.reset(new ClippedPathCache());
+		painter.drawPath(clip_cache->clippedPath(path, ClippedPathCache::Polygons, config.bounding_box, config.scaling, 0));
+	}
+	else
+	{
+		painter.drawPath(path);
+	}
 	
 	// DEBUG: show all control points
 	/*QPen pen(painter.pen());
@@ -675,10 +873,94 @@ void AreaRenderable::render(QPainter &painter, const RenderConfig &/*config*/) c
 
 
 
+// ### PatternRenderable ###
+
+PatternCells::PatternCells(Builder builder)
+ : builder(std::move(builder))
+{
+	// nothing else
+}
+
+PatternCells::~PatternCells()
+{
+	// nothing, not inlined
+}
+
+const QPainterPath& PatternCells::cell(const PainterConfig& config) const
+{
+	if (builder)
+	{
+		builder(cells);
+		builder = nullptr;
+	}
+	
+	static const QPainterPath no_cell;
+	auto found = cells.find(config);
+	return found != cells.end() ? found->second : no_cell;
+}
+
+
+
+PatternRenderable::PatternRenderable(const PainterConfig& config, RenderableVector&& elements, const QPainterPath* outline, std::shared_ptr<const PatternCells> cells, const QTransform& cell_matrix)
+ : Renderable(config.color_priority)
+ , elements(std::move(elements))
+ , outline(outline)
+ , cells(std::move(cells))
+ , cell_matrix(cell_matrix)
+ , mode(config.mode)
+ , pen_width(config.pen_width)
+{
+	Q_ASSERT(!this->elements.empty());
+	extent = this->elements.front()->getExtent();
+	for (const auto element : this->elements)
+		rectInclude(extent, element->getExtent());
+}
+
+PatternRenderable::~PatternRenderable()
+{
+	for (const auto element : elements)
+		delete element;
+}
+
+PainterConfig PatternRenderable::getPainterConfig(const QPainterPath* clip_path) const
+{
+	return { color_priority, mode, pen_width, clip_path };
+}
+
+std::size_t PatternRenderable::elementCount() const
+{
+	return elements.size();
+}
+
+void PatternRenderable::render(QPainter& painter, const RenderConfig& config) const
+{
+#ifdef QT_PRINTSUPPORT_LIB
+	auto const engine = painter.paintEngine();
+	if (cells && engine && engine->type() == AdvancedPdfPrinter::paintEngineType())
+	{
+		// The cells are built only here, on first use.
+		const auto& cell = cells->cell(getPainterConfig(outline));
+		// The painter is configured with the color of this renderable.
+		const auto& color = (mode == PainterConfig::PenOnly) ? painter.pen().color() : painter.brush().color();
+		if (!cell.isEmpty() && AdvancedPdfPrinter::fillTilingPattern(painter, *outline, cell, cell_matrix, color))
+			return;
+	}
+#endif
+	
+	for (const auto element : elements)
+	{
+		if (element->intersects(config.bounding_box))
+			element->render(painter, config);
+	}
+}
+
+
+
 // ### TextRenderable ###
 
 TextRenderable::TextRenderable(const TextSymbol* symbol, const TextObject* text_object, const MapColor* color, double anchor_x, double anchor_y)
 : Renderable { color }
+, font       { symbol->getQFont() }
 , anchor_x   { anchor_x }
 , anchor_y   { anchor_y }
 , rotation   { 0.0 }
@@ -686,7 +968,6 @@ TextRenderable::TextRenderable(const TextSymbol* symbol, const TextObject* text_
 {
 	path.setFillRule(Qt::WindingFill);	// Otherwise, when text and an underline intersect, holes appear
 	
-	const QFont& font(symbol->getQFont());
 	const QFontMetricsF& metrics(symbol->getFontMetrics());
 	
 	int num_lines = text_object->getNumLines();
@@ -710,17 +991,19 @@ TextRenderable::TextRenderable(const TextSymbol* symbol, const TextObject* text_
 				{
 					// draw underline for gap between parts as rectangle
 					// TODO: watch out for inconsistency between text and gap underline
-					path.moveTo(underline_x0, underline_y0);
-					path.lineTo(part.part_x,  underline_y0);
-					path.lineTo(part.part_x,  underline_y1);
-					path.lineTo(underline_x0, underline_y1);
-					path.closeSubpath();
+					gap_underlines.moveTo(underline_x0, underline_y0);
+					gap_underlines.lineTo(part.part_x,  underline_y0);
+					gap_underlines.lineTo(part.part_x,  underline_y1);
+					gap_underlines.lineTo(underline_x0, underline_y1);
+					gap_underlines.closeSubpath();
 				}
 				underline_x0 = part.part_x;
 			}
 			path.addText(part.part_x, line_y, font, part.part_text);
+			parts.push_back({ QPointF(part.part_x, line_y), part.part_text });
 		}
 	}
+	path.addPath(gap_underlines);
 	
 	QTransform t { 1.0, 0.0, 0.0, 1.0, anchor_x, anchor_y };
 	t.scale(scale_factor, scale_factor);
@@ -742,12 +1025,15 @@ PainterConfig TextRenderable::getPainterConfig(const QPainterPath* clip_path) co
 
 void TextRenderable::render(QPainter &painter, const RenderConfig &config) const
 {
+	if (config.testFlag(RenderConfig::Preview))
+		return;
+	
 	painter.save();
-	renderCommon(painter, config);
+	renderCommon(painter, config, false);
 	painter.restore();
 }
 
-void TextRenderable::renderCommon(QPainter& painter, const RenderConfig& config) const
+void TextRenderable::renderCommon(QPainter& painter, const RenderConfig& config, bool stroke) const
 {
 	bool disable_antialiasing = config.options.testFlag(RenderConfig::Screen) && !(Settings::getInstance().getSettingCached(Settings::MapDisplay_TextAntialiasing).toBool());
 	if (disable_antialiasing)
@@ -760,9 +1046,38 @@ void TextRenderable::renderCommon(QPainter& painter, const RenderConfig& config)
 	if (rotation != 0.0)
 		painter.rotate(rotation);
 	painter.scale(scale_factor, scale_factor);
+	if (config.options.testFlag(RenderConfig::TextObjects) && renderTextObjects(painter, stroke))
+		return;
+	
 	painter.drawPath(path);
 }
 
+bool TextRenderable::renderTextObjects(QPainter& painter, bool stroke) const
+{
+#ifdef QT_PRINTSUPPORT_LIB
+	if (painter.paintEngine()->type() != AdvancedPdfPrinter::paintEngineType())
+		return false;
+	
+	if (!gap_underlines.isEmpty())
+		painter.drawPath(gap_underlines);
+	
+	if (!stroke)
+	{
+		// Text is drawn with the pen, but the painter is configured for the brush.
+		painter.setPen(QPen(painter.brush().color()));
+		painter.setBrush(Qt::NoBrush);
+	}
+	painter.setFont(font);
+	for (const auto& part : parts)
+		AdvancedPdfPrinter::drawText(painter, part.position, part.text, stroke);
+	return true;
+#else
+	Q_UNUSED(painter)
+	Q_UNUSED(stroke)
+	return false;
+#endif
+}
+
 
 
 // ### TextRenderable ###
@@ -782,13 +1097,16 @@ PainterConfig TextFramingRenderable::getPainterConfig(const QPainterPath* clip_p
 
 void TextFramingRenderable::render(QPainter& painter, const RenderConfig& config) const
 {
+	if (config.testFlag(RenderConfig::Preview))
+		return;
+	
 	painter.save();
 	QPen pen(painter.pen());
 	pen.setJoinStyle(Qt::MiterJoin);
 	pen.setMiterLimit(0.5);
 	fixPenForPdf(pen, painter);
 	painter.setPen(pen);
-	TextRenderable::renderCommon(painter, config);
+	TextRenderable::renderCommon(painter, config, true);
 	painter.restore();
 }
 
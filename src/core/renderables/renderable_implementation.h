@@ -22,15 +22,26 @@
 #ifndef OPENORIENTEERING_RENDERABLE_IMPLENTATION_H
 #define OPENORIENTEERING_RENDERABLE_IMPLENTATION_H
 
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
 #include <Qt>
 #include <QtGlobal>
+#include <QFont>
 #include <QPainterPath>
 #include <QPointF>
+#include <QRect>
 #include <QRectF>
+#include <QString>
+#include <QTransform>
 
 #include "renderable.h"
 
 class QPainter;
+class QPen;
 class QPointF;
 
 namespace OpenOrienteering {
@@ -53,6 +64,7 @@ public:
 	DotRenderable(const PointSymbol* symbol, MapCoordF coord);
 	void render(QPainter& painter, const RenderConfig& config) const override;
 	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	QPainterPath shape() const override;
 };
 
 /** Renderable for displaying a circle. */
@@ -62,12 +74,92 @@ public:
 	CircleRenderable(const PointSymbol* symbol, MapCoordF coord);
 	void render(QPainter& painter, const RenderConfig& config) const override;
 	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	QPainterPath shape() const override;
 	
 protected:
 	const qreal line_width;
 	QRectF rect;
 };
 
+/**
+ * A cache for the visible part of a huge painter path.
+ * 
+ * Even when only a small part of a path is visible, the raster engine
+ * processes the whole path on each redraw. This cache clips the path to a
+ * padded region of aligned tiles which covers the bounding box to be drawn,
+ * and keeps the result. Redraws at the same zoom level which fall into the
+ * same tile region reuse the clipped path.
+ * 
+ * The tiles are about tile_pixels wide. Their size in map units is a power
+ * of two, so that small zoom steps still hit the cache.
+ */
+class ClippedPathCache
+{
+public:
+	/** The type of geometry represented by the path. */
+	enum PathType
+	{
+		Polygons,   ///< Closed subpaths, rendered with a brush.
+		Polylines   ///< Open subpaths, rendered with a pen.
+	};
+	
+	/** Paths with less elements are rendered without clipping. */
+	static constexpr int min_element_count = 1000;
+	
+	/** The approximate size of a tile in pixels. */
+	static constexpr qreal tile_pixels = 512;
+	
+	/**
+	 * Returns the part of the path which is needed for drawing the bounding box.
+	 * 
+	 * The scaling is given in pixels per map unit. The padding (in map units)
+	 * extends the clip region in order to hide effects of clipping, e.g. for
+	 * pen widths. Returns the original path when clipping isn't useful.
+	 * The returned reference is valid until the next call.
+	 */
+	const QPainterPath& clippedPath(const QPainterPath& path, PathType type, const QRectF& bounding_box, qreal scaling, qreal padding);
+	
+private:
+	QPainterPath clipped_path;
+	QRect tile_range;
+	int tile_level = 0;
+	bool valid     = false;
+};
+
+
+/**
+ * A cache for the filled outline of a line drawn with a wide pen.
+ * 
+ * The raster engine runs its stroker on each redraw of a path with a wide
+ * pen. Filling a precalculated outline avoids this work. The outline depends
+ * on the zoom level only via the flattening of curves, round joins and round
+ * caps, so it is kept for a zoom bucket, i.e. for a power-of-two range of the
+ * scaling.
+ */
+class StrokeOutlineCache
+{
+public:
+	/** Paths with more elements are stroked directly. */
+	static constexpr int max_element_count = ClippedPathCache::min_element_count;
+	
+	/** Lines which are thinner (in pixels) are stroked directly. */
+	static constexpr qreal min_pixels = 3;
+	
+	/**
+	 * Returns the outline of the path when stroked with the given pen.
+	 * 
+	 * The scaling is given in pixels per map unit.
+	 * The returned reference is valid until the next call.
+	 */
+	const QPainterPath& outline(const QPainterPath& path, const QPen& pen, qreal scaling);
+	
+private:
+	QPainterPath outline_path;
+	int zoom_bucket = 0;
+	bool valid      = false;
+};
+
+
 /** Renderable for displaying a line. */
 class LineRenderable : public Renderable
 {
@@ -76,6 +168,7 @@ public:
 	LineRenderable(const LineSymbol* symbol, QPointF first, QPointF second);
 	void render(QPainter& painter, const RenderConfig& config) const override;
 	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	QPainterPath shape() const override;
 	
 protected:
 	void extentIncludeCap(quint32 i, qreal half_line_width, bool end_cap, const LineSymbol* symbol, const VirtualPath& path);
@@ -86,6 +179,8 @@ protected:
 	QPainterPath path;
 	Qt::PenCapStyle cap_style;
 	Qt::PenJoinStyle join_style;
+	mutable std::unique_ptr<ClippedPathCache> clip_cache;
+	mutable std::unique_ptr<StrokeOutlineCache> outline_cache;
 };
 
 /** Renderable for displaying an area. */
@@ -96,6 +191,7 @@ public:
 	AreaRenderable(const AreaSymbol* symbol, const VirtualPath& path);
 	void render(QPainter& painter, const RenderConfig& config) const override;
 	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	QPainterPath shape() const override;
 	
 	inline const QPainterPath* painterPath() const;
 	
@@ -103,6 +199,79 @@ protected:
 	void addSubpath(const VirtualPath& virtual_path);
 	
 	QPainterPath path;
+	mutable std::unique_ptr<ClippedPathCache> clip_cache;
+};
+
+/**
+ * The cells of the tiling patterns for the renderables of a fill pattern.
+ * 
+ * Building the cells is expensive, and they are needed only for PDF output.
+ * So they are built by the given function when they are requested for the
+ * first time. A single instance is shared by the PatternRenderables of an
+ * area object.
+ */
+class PatternCells
+{
+public:
+	using Cells = std::map<PainterConfig, QPainterPath>;
+	using Builder = std::function<void (Cells&)>;
+	
+	explicit PatternCells(Builder builder);
+	PatternCells(const PatternCells&) = delete;
+	PatternCells(PatternCells&&) = delete;
+	~PatternCells();
+	PatternCells& operator=(const PatternCells&) = delete;
+	PatternCells& operator=(PatternCells&&) = delete;
+	
+	/** Returns true if the cells were built. */
+	bool isBuilt() const { return !builder; }
+	
+	/**
+	 * Returns the cell for the given render attributes.
+	 * 
+	 * The cell is empty if there is no cell for these attributes.
+	 */
+	const QPainterPath& cell(const PainterConfig& config) const;
+	
+private:
+	mutable Builder builder;
+	mutable Cells cells;
+};
+
+/**
+ * Renderable for a fill pattern which is clipped to an area outline.
+ * 
+ * This renderable owns the elementary renderables of a pattern which share
+ * the same render attributes, and normally renders these elements. But when
+ * painting on the advanced PDF engine, it fills the outline with a native
+ * tiling pattern instead. Then the PDF contains a single cell definition
+ * instead of thousands of elements.
+ * 
+ * The cell is given in pattern space, where the pattern repeats with a step
+ * of 1 in both directions. The cell matrix maps pattern space to map
+ * coordinates. If there is no cell, the elements are always rendered.
+ */
+class PatternRenderable : public Renderable
+{
+public:
+	PatternRenderable(const PainterConfig& config, RenderableVector&& elements, const QPainterPath* outline, std::shared_ptr<const PatternCells> cells, const QTransform& cell_matrix);
+	PatternRenderable(const PatternRenderable&) = delete;
+	PatternRenderable(PatternRenderable&&) = delete;
+	~PatternRenderable() override;
+	PatternRenderable& operator=(const PatternRenderable&) = delete;
+	PatternRenderable& operator=(PatternRenderable&&) = delete;
+	
+	void render(QPainter& painter, const RenderConfig& config) const override;
+	PainterConfig getPainterConfig(const QPainterPath* clip_path = nullptr) const override;
+	std::size_t elementCount() const override;
+	
+protected:
+	RenderableVector elements;
+	const QPainterPath* outline;  ///< Owned by the area's AreaRenderable.
+	std::shared_ptr<const PatternCells> cells;
+	QTransform cell_matrix;
+	PainterConfig::PainterMode mode;
+	qreal pen_width;
 };
 
 /** Renderable for displaying text. */
@@ -114,9 +283,33 @@ public:
 	void render(QPainter& painter, const RenderConfig& config) const override;
 	
 protected:
-	void renderCommon(QPainter& painter, const RenderConfig& config) const;
+	/**
+	 * Draws the text in the painter's current configuration.
+	 * 
+	 * With RenderConfig::TextObjects, text is drawn as text objects with
+	 * embedded fonts when the painter supports it (advanced PDF engine).
+	 * Otherwise, the glyph outlines are drawn.
+	 */
+	void renderCommon(QPainter& painter, const RenderConfig& config, bool stroke) const;
+	
+	/**
+	 * Draws the text parts as text objects.
+	 * 
+	 * Returns false if the painter does not support this.
+	 */
+	bool renderTextObjects(QPainter& painter, bool stroke) const;
+	
+	/** A piece of text, positioned at its baseline in text coordinates. */
+	struct TextPart
+	{
+		QPointF position;
+		QString text;
+	};
 	
 	QPainterPath path;
+	QPainterPath gap_underlines;
+	QFont font;
+	std::vector<TextPart> parts;
 	qreal anchor_x;
 	qreal anchor_y;
 	qreal rotation;
@@ -0,0 +1,151 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "selection_statistics.h"
+
+#include "core/virtual_path.h"
+#include "core/objects/object.h"
+#include "core/symbols/area_symbol.h"
+#include "core/symbols/point_symbol.h"
+#include "core/symbols/symbol.h"
+
+
+namespace OpenOrienteering {
+
+void SelectionStatistics::add(const Object* object)
+{
+	Q_ASSERT(!items.contains(object));
+	auto item = makeItem(object);
+	items.insert(object, item);
+	apply(item, +1);
+}
+
+void SelectionStatistics::remove(const Object* object)
+{
+	auto it = items.find(object);
+	Q_ASSERT(it != items.end());
+	if (it != items.end())
+	{
+		apply(*it, -1);
+		items.erase(it);
+	}
+}
+
+void SelectionStatistics::clear()
+{
+	items.clear();
+	symbol_counts.clear();
+	feature_counts.fill(0);
+	total_length = 0;
+	total_area = 0;
+}
+
+
+int SelectionStatistics::count(Feature feature) const
+{
+	for (std::size_t i = 0; i < num_features; ++i)
+	{
+		if (feature == (1 << i))
+			return feature_counts[i];
+	}
+	Q_UNREACHABLE();
+}
+
+const Symbol* SelectionStatistics::uniformSymbol() const
+{
+	return symbol_counts.size() == 1 ? symbol_counts.begin().key() : nullptr;
+}
+
+
+// static
+SelectionStatistics::Item SelectionStatistics::makeItem(const Object* object)
+{
+	auto item = Item { object->getSymbol(), 0, 0, 0 };
+	auto const symbol = item.symbol;
+	if (!symbol)
+		return item;
+	
+	if (symbol->getType() == Symbol::Point)
+	{
+		if (symbol->asPoint()->isRotatable())
+			item.features |= RotatablePoint;
+	}
+	else if (Symbol::areTypesCompatible(symbol->getType(), Symbol::Area))
+	{
+		item.features |= Path;
+		if (symbol->getType() == Symbol::Area && symbol->asArea()->hasRotatableFillPattern())
+			item.features |= RotatablePattern;
+		
+		auto const contained_types = symbol->getContainedTypes();
+		if (contained_types & Symbol::Line)
+			item.features |= Line;
+		
+		if (object->getType() == Object::Path)
+		{
+			object->update();
+			const auto& parts = object->asPath()->parts();
+			for (const auto& part : parts)
+				item.length += part.length();
+			
+			if (contained_types & Symbol::Area)
+			{
+				item.features |= Area;
+				if (parts.size() > 1)
+					item.features |= AreaWithHoles;
+				
+				if (!parts.empty())
+				{
+					// Holes are subtracted from the outer boundary.
+					item.area = parts.front().calculateArea();
+					if (parts.size() > 1)
+					{
+						item.area *= 2;
+						for (const auto& part : parts)
+							item.area -= part.calculateArea();
+					}
+				}
+			}
+		}
+	}
+	return item;
+}
+
+
+void SelectionStatistics::apply(const Item& item, int sign)
+{
+	if (item.symbol)
+	{
+		auto& symbol_count = symbol_counts[item.symbol];
+		symbol_count += sign;
+		if (symbol_count <= 0)
+			symbol_counts.remove(item.symbol);
+	}
+	
+	for (std::size_t i = 0; i < num_features; ++i)
+	{
+		if (item.features & (1 << i))
+			feature_counts[i] += sign;
+	}
+	
+	total_length += sign * item.length;
+	total_area   += sign * item.area;
+}
+
+
+}  // namespace OpenOrienteering
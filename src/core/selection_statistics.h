@@ -0,0 +1,153 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_SELECTION_STATISTICS_H
+#define OPENORIENTEERING_SELECTION_STATISTICS_H
+
+#include <array>
+#include <cstddef>
+
+#include <QtGlobal>
+#include <QHash>
+
+namespace OpenOrienteering {
+
+class Object;
+class Symbol;
+
+
+/**
+ * Aggregate information about a set of selected objects.
+ * 
+ * The statistics are updated incrementally when objects are added or
+ * removed, so that queries run in constant time (or in the number of
+ * distinct symbols) instead of iterating over the selection.
+ * 
+ * The contribution of each object is recorded when it is added. If selected
+ * objects are modified, the statistics must be rebuilt by clear() and add().
+ */
+class SelectionStatistics
+{
+public:
+	/**
+	 * Features of selected objects.
+	 */
+	enum Feature
+	{
+		Path             = 0x01, ///< Objects with a line, area or combined symbol
+		Line             = 0x02, ///< Paths with a symbol containing line symbols
+		Area             = 0x04, ///< Paths with a symbol containing area symbols
+		AreaWithHoles    = 0x08, ///< Area paths which have more than one part
+		RotatablePattern = 0x10, ///< Objects with an area symbol with a rotatable fill pattern
+		RotatablePoint   = 0x20, ///< Objects with a rotatable point symbol
+	};
+	
+	/** Adds an object to the statistics. */
+	void add(const Object* object);
+	
+	/** Removes an object from the statistics. */
+	void remove(const Object* object);
+	
+	/** Resets the statistics to an empty selection. */
+	void clear();
+	
+	
+	/** Returns the number of objects in the statistics. */
+	int size() const;
+	
+	/** Returns the number of objects which have the given feature. */
+	int count(Feature feature) const;
+	
+	/** Returns true if at least one object has the given feature. */
+	bool contains(Feature feature) const;
+	
+	/** Returns the number of objects per symbol. */
+	const QHash<const Symbol*, int>& symbolCounts() const;
+	
+	/** Returns the common symbol of all objects, or nullptr if there is none. */
+	const Symbol* uniformSymbol() const;
+	
+	/** Returns the total length of all path parts (in mm on paper). */
+	double totalLength() const;
+	
+	/** Returns the total area of all area objects (in mm² on paper). */
+	double totalArea() const;
+	
+	
+private:
+	/** The recorded contribution of a single object. */
+	struct Item
+	{
+		const Symbol* symbol;
+		double length;
+		double area;
+		int features;
+	};
+	
+	static Item makeItem(const Object* object);
+	
+	void apply(const Item& item, int sign);
+	
+	static constexpr std::size_t num_features = 6;
+	
+	QHash<const Object*, Item> items;
+	QHash<const Symbol*, int> symbol_counts;
+	std::array<int, num_features> feature_counts = {};
+	double total_length = 0;
+	double total_area = 0;
+};
+
+
+
+// ### SelectionStatistics inline code ###
+
+inline
+int SelectionStatistics::size() const
+{
+	return items.size();
+}
+
+inline
+bool SelectionStatistics::contains(Feature feature) const
+{
+	return count(feature) > 0;
+}
+
+inline
+const QHash<const Symbol*, int>& SelectionStatistics::symbolCounts() const
+{
+	return symbol_counts;
+}
+
+inline
+double SelectionStatistics::totalLength() const
+{
+	return total_length;
+}
+
+inline
+double SelectionStatistics::totalArea() const
+{
+	return total_area;
+}
+
+
+}  // namespace OpenOrienteering
+
+#endif
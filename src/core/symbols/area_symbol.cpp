@@ -29,7 +29,9 @@
 #include <QtMath>
 #include <QIODevice>
 #include <QLatin1String>
+#include <QPainterPath>
 #include <QStringRef>
+#include <QTransform>
 #include <QXmlStreamReader> // IWYU pragma: keep
 
 #include "core/map.h"
@@ -483,6 +485,81 @@ void AreaSymbol::FillPattern::createRenderables(const AreaRenderable& outline, f
 		rotation = M_PI + rotation;
 	Q_ASSERT(rotation >= 0 && rotation <= M_PI);
 	
+	if (flags & Option::AlternativeToClipping)
+	{
+		// Not clipped to the outline, so not suitable for a tiling pattern
+		createElements(outline, delta_rotation, pattern_origin, rotation, output);
+		return;
+	}
+	
+	const auto* clip_path = outline.painterPath();
+	QRectF elements_extent;
+	ObjectRenderables elements(elements_extent);
+	elements.setClipPath(clip_path);
+	createElements(outline, delta_rotation, pattern_origin, rotation, elements);
+	
+	// The cell shapes, by render attributes, in pattern cell space.
+	// They are built only when the PDF engine asks for them. The point
+	// symbol still exists then, because printing and exporting finish all
+	// pending object updates first.
+	const auto cell_matrix = cellMatrix(pattern_origin, rotation);
+	const auto to_cell = QTransform(cell_matrix.m11(), cell_matrix.m12(), cell_matrix.m21(), cell_matrix.m22(), 0, 0).inverted();
+	std::shared_ptr<const PatternCells> cells;
+	switch (type)
+	{
+	case LinePattern:
+		{
+			auto half_width = 0.5 * line_width / line_spacing;
+			auto config = PainterConfig{ line_color ? line_color->getPriority() : MapColor::Reserved,
+			                             PainterConfig::PenOnly, 0.001 * line_width, clip_path };
+			cells = std::make_shared<PatternCells>([config, half_width](PatternCells::Cells& cells) {
+				QPainterPath cell;
+				cell.addRect(0, -half_width, 1, 2 * half_width);
+				cells.emplace(config, cell);
+			});
+		}
+		break;
+	case PointPattern:
+		if (point && point_distance > 0)
+		{
+			const auto* point_symbol = point;
+			cells = std::make_shared<PatternCells>([point_symbol, delta_rotation, to_cell, clip_path](PatternCells::Cells& cells) {
+				QRectF point_extent;
+				ObjectRenderables point_renderables(point_extent);
+				point_renderables.setClipPath(clip_path);
+				point_symbol->createRenderablesScaled(MapCoordF(0, 0), -delta_rotation, point_renderables);
+				point_renderables.releaseGroups([&cells, &to_cell](const PainterConfig& config, RenderableVector&& group) {
+					QPainterPath cell;
+					bool supported = true;
+					for (const auto renderable : group)
+					{
+						auto shape = renderable->shape();
+						if (shape.isEmpty())
+							supported = false;  // e.g. text
+						else if (supported)
+							cell = cell.isEmpty() ? to_cell.map(shape) : cell.united(to_cell.map(shape));
+						delete renderable;
+					}
+					cells.emplace(config, supported ? cell : QPainterPath());
+				});
+			});
+		}
+		break;
+	}
+	
+	const auto old_clip_path = output.getClipPath();
+	output.setClipPath(clip_path);
+	elements.releaseGroups([&](const PainterConfig& config, RenderableVector&& group) {
+		// Without a cell, the PatternRenderable renders the elements.
+		auto renderable = new PatternRenderable(config, std::move(group), clip_path, cells, cell_matrix);
+		output.insertRenderable(renderable, config);
+	});
+	output.setClipPath(old_clip_path);
+}
+
+
+void AreaSymbol::FillPattern::createElements(const AreaRenderable& outline, float delta_rotation, const MapCoord& pattern_origin, qreal rotation, ObjectRenderables& output) const
+{
 	// Handle clipping
 	const auto old_clip_path = output.getClipPath();
 	if (!(flags & Option::AlternativeToClipping))
@@ -521,6 +598,36 @@ void AreaSymbol::FillPattern::createRenderables(const AreaRenderable& outline, f
 }
 
 
+QTransform AreaSymbol::FillPattern::cellMatrix(const MapCoord& pattern_origin, qreal rotation) const
+{
+	// Cf. createRenderables<T>() for the placement of lines and points
+	const auto normal = MapCoordF(std::sin(rotation), std::cos(rotation));
+	const auto tangent = MapCoordF(std::cos(rotation), -std::sin(rotation));
+	
+	auto line_offset_f = 0.001 * line_offset;
+	auto along_line_offset_f = 0.0;
+	auto step_along_line = 0.001 * line_spacing;
+	if (type == PointPattern && point_distance > 0)
+	{
+		// The lines of points run in opposite direction in some cases.
+		auto const reversed = qAbs(rotation - M_PI/2) < 0.0001
+		                      || (rotation >= 0.0001 && rotation < M_PI/2);
+		along_line_offset_f = (reversed ? -0.001 : 0.001) * offset_along_line;
+		step_along_line = 0.001 * point_distance;
+	}
+	if (rotatable())
+	{
+		line_offset_f += MapCoordF::dotProduct(normal, MapCoordF(pattern_origin));
+		along_line_offset_f += MapCoordF::dotProduct(tangent, MapCoordF(pattern_origin));
+	}
+	
+	const auto origin = tangent * along_line_offset_f + normal * line_offset_f;
+	const auto x_step = tangent * step_along_line;
+	const auto y_step = normal * (0.001 * line_spacing);
+	return { x_step.x(), x_step.y(), y_step.x(), y_step.y(), origin.x(), origin.y() };
+}
+
+
 void AreaSymbol::FillPattern::createPointPatternLine(
         MapCoordF first, MapCoordF second,
         qreal delta_offset,
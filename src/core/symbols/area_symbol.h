@@ -35,6 +35,7 @@
 
 class QIODevice;
 class QRectF;
+class QTransform;
 class QXmlStreamReader;
 class QXmlStreamWriter;
 
@@ -182,6 +183,10 @@ public:
 		
 		/**
 		 * Creates renderables for this pattern to fill the area surrounded by the outline.
+		 * 
+		 * When the pattern is clipped to the outline, the elements are wrapped
+		 * in PatternRenderables which can be output as native PDF patterns.
+		 * 
 		 * @param outline A renderable giving the extent and outline.
 		 * @param delta_rotation Rotation offest which is added to the pattern angle.
 		 * @param pattern_origin Origin point for line / point placement.
@@ -194,6 +199,26 @@ public:
 			ObjectRenderables& output
 		) const;
 		
+		/** Creates the individual renderables of the pattern, called by createRenderables(). */
+		void createElements(
+			const AreaRenderable& outline,
+			float delta_rotation,
+			const MapCoord& pattern_origin,
+			qreal rotation,
+			ObjectRenderables& output
+		) const;
+		
+		/**
+		 * Returns the transformation from pattern cell space to map coordinates.
+		 * 
+		 * In pattern cell space, the lines run along the x axis at integer y
+		 * values, and the points of a PointPattern are at integer x values.
+		 * 
+		 * @param pattern_origin Origin point for line / point placement.
+		 * @param rotation The unique rotation of the lines, in [0, pi].
+		 */
+		QTransform cellMatrix(const MapCoord& pattern_origin, qreal rotation) const;
+		
 		/** Does the heavy-lifting in loops over lines. */
 		template <int type>
 		void createRenderables(
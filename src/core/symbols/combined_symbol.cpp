@@ -181,6 +181,25 @@ bool CombinedSymbol::symbolChanged(const Symbol* old_symbol, const Symbol* new_s
 	return have_symbol;
 }
 
+bool CombinedSymbol::symbolsChanged(const QHash<const Symbol*, Symbol*>& symbol_map)
+{
+	bool have_symbol = false;
+	for (auto& subsymbol : parts)
+	{
+		auto match = symbol_map.constFind(subsymbol);
+		if (match != symbol_map.constEnd())
+		{
+			have_symbol = true;
+			subsymbol = match.value();
+		}
+	}
+	
+	// always invalidate the icon, since the parts might have changed.
+	resetIcon();
+	
+	return have_symbol;
+}
+
 bool CombinedSymbol::containsSymbol(const Symbol* symbol) const
 {
 	for (auto subsymbol : parts)
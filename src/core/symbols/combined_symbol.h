@@ -83,6 +83,7 @@ public:
 	bool containsColor(const MapColor* color) const override;
 	const MapColor* guessDominantColor() const override;
 	bool symbolChanged(const Symbol* old_symbol, const Symbol* new_symbol) override;
+	bool symbolsChanged(const QHash<const Symbol*, Symbol*>& symbol_map) override;
 	bool containsSymbol(const Symbol* symbol) const override;
 	void scale(double factor) override;
 	Type getContainedTypes() const override;
@@ -105,6 +105,25 @@ bool Symbol::equals(const Symbol* other, Qt::CaseSensitivity case_sensitivity, b
 	return equalsImpl(other, case_sensitivity);
 }
 
+uint Symbol::structuralHash() const
+{
+	auto combine = [](uint seed, uint value) {
+		return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+	};
+	
+	auto seed = qHash(int(type));
+	// Same sequence of components as compared in equals()
+	for (int i = 0; i < number_components; ++i)
+	{
+		seed = combine(seed, qHash(number[i]));
+		if (number[i] == -1)
+			break;
+	}
+	seed = combine(seed, qHash(is_helper_symbol));
+	// Case folding makes the hash independent of the case sensitivity.
+	return combine(seed, qHash(name.toCaseFolded()));
+}
+
 const PointSymbol* Symbol::asPoint() const
 {
 	Q_ASSERT(type == Point);
@@ -350,6 +369,12 @@ bool Symbol::symbolChanged(const Symbol* old_symbol, const Symbol* new_symbol)
 	return false;
 }
 
+bool Symbol::symbolsChanged(const QHash<const Symbol*, Symbol*>& symbol_map)
+{
+	Q_UNUSED(symbol_map);
+	return false;
+}
+
 bool Symbol::containsSymbol(const Symbol* symbol) const
 {
 	Q_UNUSED(symbol);
@@ -124,6 +124,16 @@ public:
 	 */
 	bool equals(const Symbol* other, Qt::CaseSensitivity case_sensitivity = Qt::CaseSensitive, bool compare_state = false) const;
 	
+	/**
+	 * Returns a hash value which is consistent with equals().
+	 * 
+	 * Symbols which are equal, regardless of the case sensitivity and of the
+	 * state comparison, have the same hash value. The hash covers the type,
+	 * the number, the helper symbol flag, and the name. It can be used to find
+	 * candidates for equals() without comparing each pair of symbols.
+	 */
+	uint structuralHash() const;
+	
 	
 	/** Returns the type of the symbol */
 	inline Type getType() const {return type;}
@@ -259,6 +269,16 @@ public:
 	 */
 	virtual bool symbolChanged(const Symbol* old_symbol, const Symbol* new_symbol);
 	
+	/**
+	 * Called by the map after importing symbols, to replace all references
+	 * to the keys of the given map by the corresponding values.
+	 * 
+	 * This is equivalent to calling symbolChanged() for each entry of the map,
+	 * but it needs only a single pass over the references.
+	 * Returns true if this symbol contained any of the replaced symbols.
+	 */
+	virtual bool symbolsChanged(const QHash<const Symbol*, Symbol*>& symbol_map);
+	
 	/**
 	 * Must return if the given symbol is referenced by this symbol.
 	 * Should NOT return true if the argument is itself.
@@ -0,0 +1,197 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "transform_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+double distance(const QPointF& a, const QPointF& b)
+{
+	return std::hypot(a.x() - b.x(), a.y() - b.y());
+}
+
+}  // namespace
+
+
+
+TransformGrid::TransformGrid(Transform transform, const QRectF& extent, double max_error, int max_depth)
+: transform(std::move(transform))
+, grid_extent(extent.normalized())
+, max_error(max_error)
+, max_depth(max_depth)
+{
+	// A degenerated extent is not worth a grid.
+	if (!(grid_extent.width() > 0 && grid_extent.height() > 0) || !(max_error > 0))
+		return;
+	
+	Cell root;
+	root.rect = grid_extent;
+	std::array<bool, 4> corners_ok;
+	corners_ok[0] = sample(grid_extent.topLeft(), root.corners[0]);
+	corners_ok[1] = sample(grid_extent.topRight(), root.corners[1]);
+	corners_ok[2] = sample(grid_extent.bottomLeft(), root.corners[2]);
+	corners_ok[3] = sample(grid_extent.bottomRight(), root.corners[3]);
+	cells.push_back(root);
+	build(0, corners_ok, 0);
+}
+
+TransformGrid::~TransformGrid()
+{
+	// nothing, not inlined
+}
+
+
+std::size_t TransformGrid::cellCount() const
+{
+	return std::size_t(std::count_if(begin(cells), end(cells), [](const Cell& cell) {
+		return cell.valid;
+	}));
+}
+
+
+bool TransformGrid::sample(const QPointF& source, QPointF& target)
+{
+	++samples;
+	return transform(source, target);
+}
+
+
+void TransformGrid::build(std::size_t index, const std::array<bool, 4>& corners_ok, int depth)
+{
+	// The samples of the 3x3 grid of the cell, row by row
+	auto const rect = cells[index].rect;
+	auto const center = rect.center();
+	std::array<QPointF, 9> sources = {{
+	    rect.topLeft(),           { center.x(), rect.top() },    rect.topRight(),
+	    { rect.left(), center.y() }, center,                     { rect.right(), center.y() },
+	    rect.bottomLeft(),        { center.x(), rect.bottom() }, rect.bottomRight(),
+	}};
+	std::array<QPointF, 9> targets;
+	std::array<bool, 9> ok;
+	targets[0] = cells[index].corners[0];
+	targets[2] = cells[index].corners[1];
+	targets[6] = cells[index].corners[2];
+	targets[8] = cells[index].corners[3];
+	ok[0] = corners_ok[0];
+	ok[2] = corners_ok[1];
+	ok[6] = corners_ok[2];
+	ok[8] = corners_ok[3];
+	auto all_ok = ok[0] && ok[2] && ok[6] && ok[8];
+	for (auto i : { 1, 3, 4, 5, 7 })
+	{
+		ok[std::size_t(i)] = sample(sources[std::size_t(i)], targets[std::size_t(i)]);
+		all_ok = all_ok && ok[std::size_t(i)];
+	}
+	
+	if (all_ok)
+	{
+		auto error = 0.0;
+		for (auto i : { 1, 3, 4, 5, 7 })
+			error = std::max(error, distance(interpolate(cells[index], sources[std::size_t(i)]), targets[std::size_t(i)]));
+		if (error <= max_error / 2)
+		{
+			cells[index].valid = true;
+			return;
+		}
+	}
+	
+	// Subdivision is futile where the transformation fails everywhere.
+	if (depth >= max_depth || std::none_of(begin(ok), end(ok), [](bool value) { return value; }))
+		return;
+	
+	// Subdivide, reusing the samples for the corners of the children.
+	auto const first_child = cells.size();
+	cells[index].first_child = int(first_child);
+	static const std::array<std::array<std::size_t, 4>, 4> child_corners = {{
+	    {{ 0, 1, 3, 4 }}, {{ 1, 2, 4, 5 }},
+	    {{ 3, 4, 6, 7 }}, {{ 4, 5, 7, 8 }},
+	}};
+	for (const auto& corners : child_corners)
+	{
+		Cell child;
+		child.rect = QRectF(sources[corners[0]], sources[corners[3]]);
+		for (std::size_t i = 0; i < 4; ++i)
+			child.corners[i] = targets[corners[i]];
+		cells.push_back(child);
+	}
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		const auto& corners = child_corners[i];
+		build(first_child + i, { ok[corners[0]], ok[corners[1]], ok[corners[2]], ok[corners[3]] }, depth + 1);
+	}
+}
+
+
+const TransformGrid::Cell* TransformGrid::findCell(const QPointF& source) const
+{
+	if (cells.empty() || !grid_extent.contains(source))
+		return nullptr;
+	
+	auto cell = &cells.front();
+	while (cell->first_child >= 0)
+	{
+		auto const center = cell->rect.center();
+		auto const quadrant = (source.x() < center.x() ? 0 : 1) + (source.y() < center.y() ? 0 : 2);
+		cell = &cells[std::size_t(cell->first_child + quadrant)];
+	}
+	return cell->valid ? cell : nullptr;
+}
+
+
+QPointF TransformGrid::interpolate(const Cell& cell, const QPointF& source)
+{
+	auto const u = (source.x() - cell.rect.left()) / cell.rect.width();
+	auto const v = (source.y() - cell.rect.top()) / cell.rect.height();
+	return (1 - v) * ((1 - u) * cell.corners[0] + u * cell.corners[1])
+	       + v * ((1 - u) * cell.corners[2] + u * cell.corners[3]);
+}
+
+
+bool TransformGrid::isInterpolated(const QPointF& source) const
+{
+	return findCell(source) != nullptr;
+}
+
+
+QPointF TransformGrid::map(const QPointF& source, bool* ok) const
+{
+	if (auto const cell = findCell(source))
+	{
+		if (ok)
+			*ok = true;
+		return interpolate(*cell, source);
+	}
+	
+	QPointF target;
+	auto const result = transform(source, target);
+	if (ok)
+		*ok = result;
+	return target;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,173 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_TRANSFORM_GRID_H
+#define OPENORIENTEERING_TRANSFORM_GRID_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <QPointF>
+#include <QRectF>
+
+namespace OpenOrienteering {
+
+
+/**
+ * An accelerator for transforming many points with an expensive transformation,
+ * e.g. from geographic coordinates to map coordinates.
+ *
+ * The exact transformation is sampled on an adaptive grid over a given extent.
+ * A grid cell is subdivided until the bilinear interpolation of the samples
+ * at its corners meets the error bound. The error is estimated from exact
+ * samples at the center and at the middle of the edges of the cell, and it
+ * must not exceed half of the error bound.
+ *
+ * Points outside the extent, and points in cells where the error bound is not
+ * met at the maximum subdivision depth or where the exact transformation
+ * fails, are transformed exactly.
+ */
+class TransformGrid
+{
+public:
+	/**
+	 * The exact transformation.
+	 *
+	 * Returns false if the point cannot be transformed.
+	 */
+	using Transform = std::function<bool (const QPointF& source, QPointF& target)>;
+
+	/**
+	 * Builds the grid for the given transformation.
+	 *
+	 * @param transform  The exact transformation.
+	 * @param extent     The area of the source coordinates which is covered by the grid.
+	 * @param max_error  The maximum distance of interpolated points from the exact result,
+	 *                   in target coordinates.
+	 * @param max_depth  The maximum number of subdivisions of the extent.
+	 */
+	TransformGrid(Transform transform, const QRectF& extent, double max_error, int max_depth = 8);
+
+	TransformGrid(const TransformGrid&) = delete;
+	TransformGrid(TransformGrid&&) = default;
+
+	/** Destructor. */
+	~TransformGrid();
+
+	TransformGrid& operator=(const TransformGrid&) = delete;
+	TransformGrid& operator=(TransformGrid&&) = default;
+
+
+	/** Returns the area covered by the grid. */
+	const QRectF& extent() const { return grid_extent; }
+
+	/** Returns the error bound. */
+	double maxError() const { return max_error; }
+
+	/** Returns the number of cells which are used for interpolation. */
+	std::size_t cellCount() const;
+
+	/** Returns the number of exact transformations made when building the grid. */
+	std::size_t sampleCount() const { return samples; }
+
+	/** Returns true if the given point is transformed by interpolation. */
+	bool isInterpolated(const QPointF& source) const;
+
+	/**
+	 * Transforms a point.
+	 *
+	 * The result is interpolated if possible, and calculated by the exact
+	 * transformation otherwise.
+	 */
+	QPointF map(const QPointF& source, bool* ok = nullptr) const;
+
+
+	/**
+	 * Returns the bounding box of the given points, for use as an extent.
+	 *
+	 * The getter returns the source coordinates of an element.
+	 */
+	template <class Container, class Getter>
+	static QRectF boundingBox(const Container& container, Getter getter);
+
+private:
+	struct Cell
+	{
+		QRectF rect;
+		std::array<QPointF, 4> corners;  ///< top left, top right, bottom left, bottom right
+		int first_child = -1;            ///< The four children are stored in sequence.
+		bool valid = false;              ///< Whether the cell may be used for interpolation.
+	};
+
+	/** Evaluates the exact transformation, and counts the samples. */
+	bool sample(const QPointF& source, QPointF& target);
+
+	/** Tests and subdivides the given cell. */
+	void build(std::size_t index, const std::array<bool, 4>& corners_ok, int depth);
+
+	/** Returns the leaf cell containing the point, or nullptr. */
+	const Cell* findCell(const QPointF& source) const;
+
+	/** Interpolates the transformation of a point in a cell. */
+	static QPointF interpolate(const Cell& cell, const QPointF& source);
+
+
+	Transform transform;
+	QRectF grid_extent;
+	double max_error;
+	int max_depth;
+	std::size_t samples = 0;
+	std::vector<Cell> cells;
+};
+
+
+
+// ### TransformGrid inline and template code ###
+
+template <class Container, class Getter>
+QRectF TransformGrid::boundingBox(const Container& container, Getter getter)
+{
+	auto first = true;
+	auto left = 0.0, top = 0.0, right = 0.0, bottom = 0.0;
+	for (const auto& element : container)
+	{
+		QPointF const point = getter(element);
+		if (first)
+		{
+			left = right = point.x();
+			top = bottom = point.y();
+			first = false;
+			continue;
+		}
+		left = std::min(left, point.x());
+		right = std::max(right, point.x());
+		top = std::min(top, point.y());
+		bottom = std::max(bottom, point.y());
+	}
+	return { QPointF{ left, top }, QPointF{ right, bottom } };
+}
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2016 Kai Pastor
+ *    Copyright 2016, 2018 Kai Pastor
  *
  *    Some parts taken from file_format_oc*d8{.h,_p.h,cpp} which are
  *    Copyright 2012 Pete Curtis
@@ -22,13 +22,333 @@
 
 #include "ocd_file_export.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include <QtMath>
+#include <QFontMetricsF>
+#include <QIODevice>
+#include <QLatin1Char>
+#include <QLatin1String>
+#include <QPointF>
+#include <QRectF>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTransform>
+
+#include "core/georeferencing.h"
+#include "core/map.h"
+#include "core/map_color.h"
+#include "core/map_grid.h"
+#include "core/map_part.h"
+#include "core/map_view.h"
+#include "core/objects/object.h"
+#include "core/objects/text_object.h"
+#include "core/symbols/area_symbol.h"
+#include "core/symbols/combined_symbol.h"
+#include "core/symbols/line_symbol.h"
+#include "core/symbols/point_symbol.h"
+#include "core/symbols/symbol.h"
+#include "core/symbols/text_symbol.h"
+#include "fileformats/file_format.h"
 #include "fileformats/ocad8_file_format_p.h"
+#include "fileformats/ocd_types_v11.h"
+#include "fileformats/ocd_types_v12.h"
+#include "templates/template.h"
+#include "util/util.h"
 
 
 namespace OpenOrienteering {
 
-OcdFileExport::OcdFileExport(QIODevice* stream, Map* map, MapView* view)
+namespace {
+
+/** The number of objects which are encoded by a single task. */
+constexpr int object_chunk_size = 1000;
+
+/** The largest absolute value of an OCD coordinate, in 0.01 mm. */
+constexpr qint32 max_ocd_coord = 0x7fffff;
+
+
+/**
+ * Converts a Mapper length (0.001 mm) to an OCD length (0.01 mm).
+ */
+constexpr qint32 convertSize(qint32 size)
+{
+	return (size + 5) / 10;
+}
+
+/**
+ * Converts an angle in radians to an OCD angle (tenths of a degree).
+ */
+qint16 convertRotation(double angle)
+{
+	return qint16(qRound(10 * qRadiansToDegrees(angle)));
+}
+
+/**
+ * Converts a native Mapper coordinate value to an OCD coordinate value,
+ * rounding half up, and shifts it into the upper 24 bits.
+ */
+qint32 convertPointMember(qint32 value)
+{
+	auto ocd_value = (value >= 0) ? (value + 5) / 10 : -((-value + 4) / 10);
+	ocd_value = qBound(-max_ocd_coord, ocd_value, max_ocd_coord);
+	return qint32(quint32(ocd_value) << 8);
+}
+
+Ocd::OcdPoint32 convertPoint(const MapCoord& coord)
+{
+	return { convertPointMember(coord.nativeX()), convertPointMember(-coord.nativeY()) };
+}
+
+Ocd::OcdPoint32 convertPoint(const QPointF& point)
+{
+	return convertPoint(MapCoord(point));
+}
+
+
+/**
+ * Appends OCD coordinates (with flags) for the given Mapper coordinates.
+ *
+ * This function does not access any shared state. It may be called from
+ * worker threads.
+ */
+void appendCoordinates(std::vector<Ocd::OcdPoint32>& ocd_coords, const MapCoordVector& coords, const Symbol* symbol, const MapCoord& offset)
+{
+	// The importer puts hole points of area objects onto the last point of
+	// the previous part, and the hole points of other objects on the point
+	// itself.
+	auto const is_area = symbol && symbol->getType() == Symbol::Area;
+	auto dash_flag = qint32(Ocd::OcdPoint32::FlagCorner);
+	if (symbol && symbol->getType() == Symbol::Line)
+	{
+		auto line_symbol = static_cast<const LineSymbol*>(symbol);
+		if ((!line_symbol->getDashSymbol() || line_symbol->getDashSymbol()->isEmpty()) && line_symbol->isDashed())
+			dash_flag = Ocd::OcdPoint32::FlagDash;
+	}
+
+	ocd_coords.reserve(ocd_coords.size() + coords.size());
+	bool curve_start = false;
+	bool hole_point = false;
+	bool curve_continue = false;
+	for (const auto& coord : coords)
+	{
+		auto ocd_point = convertPoint(MapCoord::fromNative(coord.nativeX() - offset.nativeX(), coord.nativeY() - offset.nativeY()));
+		if (coord.isDashPoint())
+			ocd_point.y |= dash_flag;
+		if (curve_start)
+			ocd_point.x |= Ocd::OcdPoint32::FlagCtl1;
+		else if (curve_continue)
+			ocd_point.x |= Ocd::OcdPoint32::FlagCtl2;
+		if (is_area ? hole_point : coord.isHolePoint())
+			ocd_point.y |= Ocd::OcdPoint32::FlagHole;
+
+		curve_continue = curve_start;
+		curve_start = coord.isCurveStart();
+		hole_point = coord.isHolePoint();
+		ocd_coords.push_back(ocd_point);
+	}
+}
+
+
+/**
+ * Writes a string to a fixed-size OCD string field.
+ */
+template< std::size_t N >
+void setOcdString(Ocd::Utf16PascalString<N>& ocd_string, const QString& string)
+{
+	auto const length = std::min(std::size_t(string.length()), N - 1);
+	std::copy(string.constData(), string.constData() + length, ocd_string.data);
+	std::fill(ocd_string.data + length, ocd_string.data + N, QChar{});
+}
+
+template< std::size_t N >
+void setOcdString(Ocd::Utf8PascalString<N>& ocd_string, const QString& string)
+{
+	auto utf8 = string.toUtf8();
+	auto length = std::min(utf8.size(), int(N));
+	// Don't cut multi-byte sequences.
+	while (length > 0 && length < utf8.size() && (quint8(utf8[length]) & 0xc0) == 0x80)
+		--length;
+	ocd_string.length = quint8(length);
+	std::memcpy(ocd_string.data, utf8.constData(), std::size_t(length));
+}
+
+
+/**
+ * Appends the given number of linked, empty index blocks.
+ *
+ * Returns the file position of the first block, or 0 if num_entries is 0.
+ */
+template< class E >
+quint32 appendIndexBlocks(QByteArray& byte_array, std::size_t num_entries)
+{
+	using IndexBlock = Ocd::IndexBlock<E>;
+	constexpr auto block_size = int(sizeof(IndexBlock));
+
+	if (num_entries == 0)
+		return 0;
+
+	auto const first_block = quint32(byte_array.size());
+	auto const num_blocks = int((num_entries + 255) / 256);
+	byte_array.append(QByteArray(num_blocks * block_size, 0));
+	for (int i = 0; i < num_blocks - 1; ++i)
+	{
+		auto block = reinterpret_cast<IndexBlock*>(byte_array.data() + first_block + i * block_size);
+		block->next_block = first_block + quint32((i + 1) * block_size);
+	}
+	return first_block;
+}
+
+/**
+ * Returns a reference to an entry in the index blocks created by appendIndexBlocks().
+ *
+ * The reference is invalidated when the byte array is modified.
+ */
+template< class E >
+E& indexEntry(QByteArray& byte_array, quint32 first_block, std::size_t index)
+{
+	using IndexBlock = Ocd::IndexBlock<E>;
+	auto block = reinterpret_cast<IndexBlock*>(byte_array.data() + first_block + (index / 256) * sizeof(IndexBlock));
+	return block->entries[index % 256];
+}
+
+
+/**
+ * Returns the bytes of a symbol record with a variable number of elements.
+ */
+template< class S >
+QByteArray symbolRecord(S& ocd_symbol, const QByteArray& elements)
+{
+	auto const header_size = int(sizeof(S) - sizeof(typename S::Element));
+	ocd_symbol.base.size = quint32(header_size + elements.size());
+	QByteArray record(reinterpret_cast<const char*>(&ocd_symbol), header_size);
+	record.append(elements);
+	return record;
+}
+
+
+/**
+ * The input for encoding a single object.
+ *
+ * Everything is prepared on the calling thread, so that the encoders do not
+ * need to touch the objects: Even const object accessors may modify an
+ * object's state when it is compacted.
+ */
+struct ObjectSource
+{
+	const MapCoordVector* coords;
+	const Symbol* symbol;
+	quint32 symbol_number;
+	quint8  type;
+	qint16  angle;
+	std::vector<Ocd::OcdPoint32> text_coords;
+	QString text;
+};
+
+/**
+ * The result of encoding a chunk of objects.
+ *
+ * The positions in the index entries are relative to the start of the data.
+ */
+struct EncodedChunk
+{
+	QByteArray data;
+	std::vector<Ocd::ObjectIndexEntryV9> entries;
+};
+
+
+/**
+ * Encodes a range of objects into a chunk.
+ */
+template< class Format >
+class ObjectEncoder : public QRunnable
+{
+public:
+	using OcdObject = typename Format::Object;
+	using SourceIterator = std::vector<ObjectSource>::const_iterator;
+
+	ObjectEncoder(SourceIterator first, SourceIterator last, const MapCoord& offset, EncodedChunk& chunk)
+	: first(first)
+	, last(last)
+	, offset(offset)
+	, chunk(chunk)
+	{}
+
+	void run() override
+	{
+		chunk.entries.reserve(std::size_t(std::distance(first, last)));
+		std::vector<Ocd::OcdPoint32> coords;
+		for (auto source = first; source != last; ++source)
+		{
+			coords.clear();
+			if (source->type >= 4)
+				coords = source->text_coords;
+			else
+				appendCoordinates(coords, *source->coords, source->symbol, offset);
+
+			// UTF-16 with terminating zero, padded to multiples of 8 bytes
+			auto text = QByteArray(reinterpret_cast<const char*>(source->text.utf16()), 2 * source->text.length());
+			if (!text.isEmpty())
+				text.append(QByteArray(8 - text.size() % 8, 0));
+
+			OcdObject ocd_object = {};
+			ocd_object.symbol = source->symbol_number;
+			ocd_object.type = source->type;
+			ocd_object.angle = source->angle;
+			ocd_object.num_items = quint32(coords.size());
+			ocd_object.num_text = quint16(text.size() / 8);
+
+			auto const pos = chunk.data.size();
+			chunk.data.append(reinterpret_cast<const char*>(&ocd_object), int(sizeof(OcdObject) - sizeof(Ocd::OcdPoint32)));
+			chunk.data.append(reinterpret_cast<const char*>(coords.data()), int(coords.size() * sizeof(Ocd::OcdPoint32)));
+			chunk.data.append(text);
+
+			Ocd::ObjectIndexEntryV9 entry = {};
+			if (!coords.empty())
+			{
+				auto const value_mask = qint32(~0xff);
+				entry.bottom_left_bound = { std::numeric_limits<qint32>::max() & value_mask, std::numeric_limits<qint32>::max() & value_mask };
+				entry.top_right_bound = { std::numeric_limits<qint32>::min(), std::numeric_limits<qint32>::min() };
+				for (const auto& point : coords)
+				{
+					entry.bottom_left_bound.x = std::min(entry.bottom_left_bound.x, point.x & value_mask);
+					entry.bottom_left_bound.y = std::min(entry.bottom_left_bound.y, point.y & value_mask);
+					entry.top_right_bound.x = std::max(entry.top_right_bound.x, point.x & value_mask);
+					entry.top_right_bound.y = std::max(entry.top_right_bound.y, point.y & value_mask);
+				}
+			}
+			entry.pos = quint32(pos);
+			entry.size = quint32(chunk.data.size() - pos);
+			entry.symbol = qint32(source->symbol_number);
+			entry.type = source->type;
+			entry.status = Ocd::ObjectNormal;
+			chunk.entries.push_back(entry);
+		}
+	}
+
+private:
+	const SourceIterator first;
+	const SourceIterator last;
+	const MapCoord offset;
+	EncodedChunk& chunk;
+};
+
+
+}  // namespace
+
+
+
+// ### OcdFileExport ###
+
+OcdFileExport::OcdFileExport(QIODevice* stream, Map* map, MapView* view, quint16 version)
 : Exporter { stream, map, view }
+, ocd_version { version }
 {
 	// nothing else
 }
@@ -38,6 +358,22 @@ OcdFileExport::~OcdFileExport() = default;
 
 
 void OcdFileExport::doExport()
+{
+	switch (ocd_version)
+	{
+	case 11:
+		exportImplementation<Ocd::FormatV11>();
+		break;
+	case 12:
+		exportImplementation<Ocd::FormatV12>();
+		break;
+	default:
+		exportImplementationLegacy();
+	}
+}
+
+
+void OcdFileExport::exportImplementationLegacy()
 {
 	OCAD8FileExport delegate { stream, map, view };
 	delegate.doExport();
@@ -48,4 +384,933 @@ void OcdFileExport::doExport()
 }
 
 
+template< class Format >
+void OcdFileExport::exportImplementation()
+{
+	uses_registration_color = map->isColorUsedByASymbol(map->getRegistrationColor());
+	if (uses_registration_color)
+		addWarning(tr("Registration black is exported as a regular color."));
+
+	area_offset = calculateAreaOffset();
+
+	auto byte_array = QByteArray(int(sizeof(typename Format::FileHeader)), 0);
+
+	typename Format::FileHeader header = {};
+	header.vendor_mark = 0x0cad;
+	header.file_type = 0;  // normal map
+	header.version = ocd_version;
+	header.first_symbol_block = exportSymbols<Format>(byte_array);
+	header.first_object_block = exportObjects<Format>(byte_array);
+	header.first_string_block = exportParameterStrings<Format>(byte_array);
+	std::memcpy(byte_array.data(), &header, sizeof(header));
+
+	if (stream->write(byte_array) != byte_array.size())
+		throw FileFormatException(stream->errorString());
+}
+
+
+MapCoord OcdFileExport::calculateAreaOffset()
+{
+	auto area_offset = QPointF{};
+
+	constexpr auto limit = qreal(max_ocd_coord) / 100;  // mm
+	auto const ocd_bounds = QRectF{QPointF{-limit, -limit}, QPointF{limit, limit}};
+	auto const objects_extent = map->calculateExtent();
+	if (!ocd_bounds.contains(objects_extent))
+	{
+		addWarning(tr("Coordinates are adjusted to fit into the OCD drawing area."));
+		area_offset = objects_extent.center();
+		if (objects_extent.width() >= ocd_bounds.width() || objects_extent.height() >= ocd_bounds.height())
+		{
+			addWarning(tr("Some coordinates remain outside of the OCD drawing area."
+			              " They might be unreachable in OCAD."));
+		}
+
+		// Round offset to 100 m in projected coordinates, to avoid crude grid offset.
+		constexpr auto unit = 100;
+		auto projected_offset = map->getGeoreferencing().toProjectedCoords(MapCoordF(area_offset));
+		projected_offset.rx() = qreal(qRound(projected_offset.x()/unit)) * unit;
+		projected_offset.ry() = qreal(qRound(projected_offset.y()/unit)) * unit;
+		area_offset = map->getGeoreferencing().toMapCoordF(projected_offset);
+	}
+
+	return MapCoord{area_offset};
+}
+
+
+quint32 OcdFileExport::makeSymbolNumber(const Symbol* symbol)
+{
+	auto found = symbol_numbers.constFind(symbol);
+	if (found != symbol_numbers.constEnd())
+		return *found;
+
+	auto number = quint32(std::max(0, symbol->getNumberComponent(0))) * Ocd::BaseSymbolV11::symbol_number_factor;
+	if (symbol->getNumberComponent(1) >= 0)
+		number += quint32(symbol->getNumberComponent(1)) % Ocd::BaseSymbolV11::symbol_number_factor;
+	// Symbol number 0.0 is not valid
+	if (number == 0)
+		number = 1;
+	// Ensure uniqueness of the symbol number
+	while (used_symbol_numbers.contains(number))
+		++number;
+	used_symbol_numbers.insert(number);
+	symbol_numbers.insert(symbol, number);
+	return number;
+}
+
+
+template< class Format >
+quint32 OcdFileExport::exportSymbols(QByteArray& byte_array)
+{
+	// Text objects carry the alignment in OCD text symbols.
+	map->applyOnAllObjects([this](const Object* object) {
+		if (object->getType() != Object::Text)
+			return;
+
+		auto text_object = static_cast<const TextObject*>(object);
+		auto text_symbol = static_cast<const TextSymbol*>(object->getSymbol());
+		quint16 alignment = 0;
+		switch (text_object->getHorizontalAlignment())
+		{
+		case TextObject::AlignLeft:    alignment = Ocd::HAlignLeft; break;
+		case TextObject::AlignHCenter: alignment = Ocd::HAlignCenter; break;
+		case TextObject::AlignRight:   alignment = Ocd::HAlignRight; break;
+		}
+		switch (text_object->getVerticalAlignment())
+		{
+		case TextObject::AlignTop:      alignment |= Ocd::VAlignTop; break;
+		case TextObject::AlignVCenter:  alignment |= Ocd::VAlignMiddle; break;
+		case TextObject::AlignBaseline:
+		case TextObject::AlignBottom:   alignment |= Ocd::VAlignBottom; break;
+		}
+
+		auto found = text_alignments.constFind(text_symbol);
+		if (found == text_alignments.constEnd())
+			text_alignments.insert(text_symbol, alignment);
+		else if (*found != alignment && text_object->hasSingleAnchor())
+			addWarning(tr("In text symbol %1: text objects with different alignments are exported with the alignment of the first object.")
+			           .arg(text_symbol->getPlainTextName()));
+	});
+
+	std::vector<QByteArray> records;
+	records.reserve(std::size_t(map->getNumSymbols()));
+
+	auto export_symbol = [this, &records](const Symbol* symbol, const Symbol* base) {
+		switch (symbol->getType())
+		{
+		case Symbol::Point:
+			records.push_back(exportPointSymbol<Format>(symbol->asPoint(), base));
+			symbol_types.insert(base, Ocd::SymbolTypePoint);
+			break;
+		case Symbol::Line:
+			records.push_back(exportLineSymbol<Format>(symbol->asLine(), base));
+			symbol_types.insert(base, Ocd::SymbolTypeLine);
+			break;
+		case Symbol::Area:
+			records.push_back(exportAreaSymbol<Format>(symbol->asArea(), base, 0));
+			symbol_types.insert(base, Ocd::SymbolTypeArea);
+			break;
+		case Symbol::Text:
+			records.push_back(exportTextSymbol<Format>(symbol->asText(), base));
+			symbol_types.insert(base, Ocd::SymbolTypeText);
+			break;
+		default:
+			return false;
+		}
+		return true;
+	};
+
+	for (int i = 0; i < map->getNumSymbols(); ++i)
+	{
+		auto symbol = map->getSymbol(i);
+		if (symbol->getType() != Symbol::Combined)
+			export_symbol(symbol, symbol);
+	}
+
+	// Combined symbols may refer to other symbols, so they are handled last.
+	for (int i = 0; i < map->getNumSymbols(); ++i)
+	{
+		auto symbol = map->getSymbol(i);
+		if (symbol->getType() != Symbol::Combined)
+			continue;
+
+		auto combined = symbol->asCombined();
+		if (combined->getNumParts() == 2
+		    && combined->getPart(0) && combined->getPart(0)->getType() == Symbol::Area
+		    && combined->getPart(1) && combined->getPart(1)->getType() == Symbol::Line)
+		{
+			// An area symbol with a border line
+			auto border = combined->getPart(1);
+			if (!symbol_numbers.contains(border))
+				export_symbol(border, border);
+			records.push_back(exportAreaSymbol<Format>(combined->getPart(0)->asArea(), combined, symbol_numbers.value(border)));
+			symbol_types.insert(combined, Ocd::SymbolTypeArea);
+			continue;
+		}
+
+		auto part_index = 0;
+		while (part_index < combined->getNumParts()
+		       && !(combined->getPart(part_index)
+		            && (combined->getPart(part_index)->getType() == Symbol::Line
+		                || combined->getPart(part_index)->getType() == Symbol::Area)))
+		{
+			++part_index;
+		}
+		if (part_index < combined->getNumParts())
+		{
+			addWarning(tr("In combined symbol %1: Only the first line or area part is exported.")
+			           .arg(combined->getPlainTextName()));
+			export_symbol(combined->getPart(part_index), combined);
+		}
+		else
+		{
+			addWarning(tr("Unable to export combined symbol %1.").arg(combined->getPlainTextName()));
+		}
+	}
+
+	auto const first_block = appendIndexBlocks<quint32>(byte_array, records.size());
+	for (std::size_t i = 0; i < records.size(); ++i)
+	{
+		indexEntry<quint32>(byte_array, first_block, i) = quint32(byte_array.size());
+		byte_array.append(records[i]);
+	}
+	return first_block;
+}
+
+
+template< class OcdBaseSymbol >
+void OcdFileExport::setupBaseSymbol(OcdBaseSymbol& ocd_base_symbol, const Symbol* symbol, const Symbol* base)
+{
+	ocd_base_symbol.number = makeSymbolNumber(base);
+	setOcdString(ocd_base_symbol.description, base->getPlainTextName());
+	if (base->isProtected())
+		ocd_base_symbol.status |= Ocd::SymbolProtected;
+	if (base->isHidden())
+		ocd_base_symbol.status |= Ocd::SymbolHidden;
+
+	auto colors = symbolColors(symbol);
+	auto const num_colors = std::min(colors.size(), sizeof(ocd_base_symbol.colors) / sizeof(ocd_base_symbol.colors[0]));
+	ocd_base_symbol.num_colors = quint16(num_colors);
+	std::copy(begin(colors), begin(colors) + num_colors, ocd_base_symbol.colors);
+}
+
+
+template< class Format >
+QByteArray OcdFileExport::exportPointSymbol(const PointSymbol* point_symbol, const Symbol* base)
+{
+	typename Format::PointSymbol ocd_symbol = {};
+	setupBaseSymbol(ocd_symbol.base, point_symbol, base);
+	ocd_symbol.base.type = Ocd::SymbolTypePoint;
+	if (point_symbol->isRotatable())
+		ocd_symbol.base.flags |= 1;
+
+	QByteArray elements;
+	ocd_symbol.data_size = exportPattern(elements, point_symbol);
+
+	// The extent is the largest distance of any coordinate from the origin.
+	qint32 extent = 0;
+	auto const* point = reinterpret_cast<const Ocd::OcdPoint32*>(elements.constData());
+	for (auto i = 0; i < ocd_symbol.data_size; )
+	{
+		auto const* element = reinterpret_cast<const Ocd::PointSymbolElementV8*>(point + i);
+		i += 2;
+		for (auto j = 0; j < element->num_coords; ++j, ++i)
+		{
+			extent = std::max(extent, std::abs(point[i].x >> 8) + std::max(element->diameter, element->line_width) / 2);
+			extent = std::max(extent, std::abs(point[i].y >> 8) + std::max(element->diameter, element->line_width) / 2);
+		}
+	}
+	ocd_symbol.base.extent = extent > 0 ? extent : 100;
+
+	return symbolRecord(ocd_symbol, elements);
+}
+
+
+template< class Format >
+QByteArray OcdFileExport::exportLineSymbol(const LineSymbol* line_symbol, const Symbol* base)
+{
+	typename Format::LineSymbol ocd_symbol = {};
+	setupBaseSymbol(ocd_symbol.base, line_symbol, base);
+	ocd_symbol.base.type = Ocd::SymbolTypeLine;
+
+	auto& common = ocd_symbol.common;
+	using LineStyle = Ocd::LineSymbolCommonV8;
+
+	auto extent = convertSize(line_symbol->getLineWidth() / 2);
+	if (line_symbol->hasBorder())
+		extent = std::max(extent, convertSize(line_symbol->getLineWidth() / 2 + line_symbol->getBorder().shift + line_symbol->getBorder().width / 2));
+
+	common.line_color = convertColor(line_symbol->getColor());
+	if (line_symbol->getColor())
+		common.line_width = quint16(convertSize(line_symbol->getLineWidth()));
+
+	// Cap and join
+	auto const cap_style = line_symbol->getCapStyle();
+	auto const join_style = line_symbol->getJoinStyle();
+	if (cap_style == LineSymbol::FlatCap && join_style == LineSymbol::BevelJoin)
+		common.line_style = LineStyle::BevelJoin_FlatCap;
+	else if (cap_style == LineSymbol::RoundCap && join_style == LineSymbol::RoundJoin)
+		common.line_style = LineStyle::RoundJoin_RoundCap;
+	else if (cap_style == LineSymbol::PointedCap && join_style == LineSymbol::BevelJoin)
+		common.line_style = LineStyle::BevelJoin_PointedCap;
+	else if (cap_style == LineSymbol::PointedCap && join_style == LineSymbol::RoundJoin)
+		common.line_style = LineStyle::RoundJoin_PointedCap;
+	else if (cap_style == LineSymbol::FlatCap && join_style == LineSymbol::MiterJoin)
+		common.line_style = LineStyle::MiterJoin_FlatCap;
+	else if (cap_style == LineSymbol::PointedCap && join_style == LineSymbol::MiterJoin)
+		common.line_style = LineStyle::MiterJoin_PointedCap;
+	else
+	{
+		addWarning(tr("In line symbol \"%1\", cannot represent cap/join combination.").arg(line_symbol->getPlainTextName()));
+		// Decide based on the caps
+		if (cap_style == LineSymbol::RoundCap)
+			common.line_style = LineStyle::RoundJoin_RoundCap;
+		else if (cap_style == LineSymbol::PointedCap)
+			common.line_style = LineStyle::RoundJoin_PointedCap;
+		else
+			common.line_style = LineStyle::BevelJoin_FlatCap;
+	}
+
+	if (cap_style == LineSymbol::PointedCap)
+	{
+		common.dist_from_start = qint16(convertSize(line_symbol->getPointedCapLength()));
+		common.dist_from_end = common.dist_from_start;
+	}
+
+	// Dash pattern
+	if (line_symbol->isDashed())
+	{
+		if (line_symbol->getMidSymbol() && !line_symbol->getMidSymbol()->isEmpty())
+		{
+			if (line_symbol->getDashesInGroup() > 1)
+				addWarning(tr("In line symbol \"%1\", neglecting the dash grouping.").arg(line_symbol->getPlainTextName()));
+
+			common.main_length = qint16(convertSize(line_symbol->getDashLength() + line_symbol->getBreakLength()));
+			common.end_length = common.main_length / 2;
+			common.sec_gap = qint16(convertSize(line_symbol->getBreakLength()));
+		}
+		else if (line_symbol->getDashesInGroup() > 1)
+		{
+			if (line_symbol->getDashesInGroup() > 2)
+				addWarning(tr("In line symbol \"%1\", the number of dashes in a group has been reduced to 2.").arg(line_symbol->getPlainTextName()));
+
+			common.main_length = qint16(convertSize(2 * line_symbol->getDashLength() + line_symbol->getInGroupBreakLength()));
+			common.end_length = common.main_length;
+			common.main_gap = qint16(convertSize(line_symbol->getBreakLength()));
+			common.sec_gap = qint16(convertSize(line_symbol->getInGroupBreakLength()));
+			common.end_gap = common.sec_gap;
+		}
+		else
+		{
+			common.main_length = qint16(convertSize(line_symbol->getDashLength()));
+			common.end_length = common.main_length / (line_symbol->getHalfOuterDashes() ? 2 : 1);
+			common.main_gap = qint16(convertSize(line_symbol->getBreakLength()));
+		}
+	}
+	else
+	{
+		common.main_length = qint16(convertSize(line_symbol->getSegmentLength()));
+		common.end_length = qint16(convertSize(line_symbol->getEndLength()));
+	}
+
+	common.min_sym = line_symbol->getShowAtLeastOneSymbol() ? 0 : -1;
+
+	// Double line
+	if (line_symbol->hasBorder() && (line_symbol->getBorder().isVisible() || line_symbol->getRightBorder().isVisible()))
+	{
+		const auto& border = line_symbol->getBorder();
+		const auto& right_border = line_symbol->getRightBorder();
+
+		common.double_width = qint16(convertSize(line_symbol->getLineWidth() - border.width + 2 * border.shift));
+		if (border.dashed && !right_border.dashed)
+			common.double_mode = 2;
+		else
+			common.double_mode = border.dashed ? 3 : 1;
+
+		common.double_left_width = qint16(convertSize(border.width));
+		common.double_right_width = qint16(convertSize(right_border.width));
+		common.double_left_color = convertColor(border.color);
+		common.double_right_color = convertColor(right_border.color);
+
+		if (border.dashed)
+		{
+			common.double_length = qint16(convertSize(border.dash_length));
+			common.double_gap = qint16(convertSize(border.break_length));
+		}
+		else if (right_border.dashed)
+		{
+			common.double_length = qint16(convertSize(right_border.dash_length));
+			common.double_gap = qint16(convertSize(right_border.break_length));
+		}
+
+		if ((border.dashed && right_border.dashed
+		     && (border.dash_length != right_border.dash_length || border.break_length != right_border.break_length))
+		    || (!border.dashed && right_border.dashed))
+		{
+			addWarning(tr("In line symbol \"%1\", cannot export the borders correctly.").arg(line_symbol->getPlainTextName()));
+		}
+	}
+
+	// Point symbols along the line: mid (primary), dash (corner), start, end
+	QByteArray elements;
+	common.primary_data_size = exportPattern(elements, line_symbol->getMidSymbol());
+	common.num_prim_sym = qint16(line_symbol->getMidSymbolsPerSpot());
+	common.prim_sym_dist = qint16(convertSize(line_symbol->getMidSymbolDistance()));
+	common.corner_data_size = exportPattern(elements, line_symbol->getDashSymbol());
+	common.start_data_size = exportPattern(elements, line_symbol->getStartSymbol());
+	common.end_data_size = exportPattern(elements, line_symbol->getEndSymbol());
+
+	for (auto point_symbol : { line_symbol->getMidSymbol(), line_symbol->getDashSymbol(), line_symbol->getStartSymbol(), line_symbol->getEndSymbol() })
+	{
+		if (point_symbol)
+			extent = std::max(extent, convertSize(qRound(1000 * point_symbol->dimensionForIcon())) / 2);
+	}
+	ocd_symbol.base.extent = extent;
+
+	return symbolRecord(ocd_symbol, elements);
+}
+
+
+template< class Format >
+QByteArray OcdFileExport::exportAreaSymbol(const AreaSymbol* area_symbol, const Symbol* base, quint32 border_symbol)
+{
+	typename Format::AreaSymbol ocd_symbol = {};
+	setupBaseSymbol(ocd_symbol.base, area_symbol, base);
+	ocd_symbol.base.type = Ocd::SymbolTypeArea;
+
+	auto& common = ocd_symbol.common;
+	if (area_symbol->getColor())
+	{
+		common.fill_on_V9 = 1;
+		common.fill_color = convertColor(area_symbol->getColor());
+	}
+	if (border_symbol)
+	{
+		common.border_on_V9 = 1;
+		ocd_symbol.border_symbol = border_symbol;
+	}
+
+	// Hatch
+	common.hatch_mode = Ocd::HatchNone;
+	const PointSymbol* point_pattern = nullptr;
+	for (int i = 0, end = area_symbol->getNumFillPatterns(); i < end; ++i)
+	{
+		const auto& pattern = area_symbol->getFillPattern(i);
+		if (pattern.rotatable())
+			ocd_symbol.base.flags |= 1;
+
+		if (pattern.type == AreaSymbol::FillPattern::LinePattern)
+		{
+			if ((common.hatch_mode == Ocd::HatchSingle && common.hatch_color != convertColor(pattern.line_color))
+			    || common.hatch_mode == Ocd::HatchCross)
+			{
+				addWarning(tr("In area symbol \"%1\", skipping a fill pattern.").arg(area_symbol->getPlainTextName()));
+				continue;
+			}
+
+			if (common.hatch_mode == Ocd::HatchNone)
+			{
+				common.hatch_mode = Ocd::HatchSingle;
+				common.hatch_color = convertColor(pattern.line_color);
+				common.hatch_line_width = quint16(convertSize(pattern.line_width));
+				common.hatch_dist = quint16(convertSize(pattern.line_spacing));
+				common.hatch_angle_1 = convertRotation(pattern.angle);
+			}
+			else
+			{
+				common.hatch_mode = Ocd::HatchCross;
+				common.hatch_line_width = (common.hatch_line_width + quint16(convertSize(pattern.line_width))) / 2;
+				common.hatch_dist = (common.hatch_dist + quint16(convertSize(pattern.line_spacing))) / 2;
+				common.hatch_angle_2 = convertRotation(pattern.angle);
+			}
+		}
+		else if (pattern.type == AreaSymbol::FillPattern::PointPattern)
+		{
+			if (common.structure_mode == Ocd::StructureNone)
+			{
+				common.structure_mode = Ocd::StructureAlignedRows;
+				common.structure_width = quint16(convertSize(pattern.point_distance));
+				common.structure_height = quint16(convertSize(pattern.line_spacing));
+				common.structure_angle = convertRotation(pattern.angle);
+				point_pattern = pattern.point;
+			}
+			else if (common.structure_mode == Ocd::StructureAlignedRows)
+			{
+				// NOTE: This is only a heuristic which works for the orienteering symbol sets,
+				// and for the patterns created by the OCD importer.
+				common.structure_mode = Ocd::StructureShiftedRows;
+				if (pattern.line_offset != 0)
+					common.structure_height /= 2;
+				else
+					common.structure_width /= 2;
+			}
+			else
+			{
+				addWarning(tr("In area symbol \"%1\", skipping a fill pattern.").arg(area_symbol->getPlainTextName()));
+			}
+		}
+	}
+
+	QByteArray elements;
+	ocd_symbol.data_size = exportPattern(elements, point_pattern);
+
+	return symbolRecord(ocd_symbol, elements);
+}
+
+
+template< class Format >
+QByteArray OcdFileExport::exportTextSymbol(const TextSymbol* text_symbol, const Symbol* base)
+{
+	typename Format::TextSymbol ocd_symbol = {};
+	setupBaseSymbol(ocd_symbol.base, text_symbol, base);
+	ocd_symbol.base.type = Ocd::SymbolTypeText;
+	ocd_symbol.base.size = sizeof(ocd_symbol);
+
+	setOcdString(ocd_symbol.font_name, text_symbol->getFontFamily());
+
+	auto& basic = ocd_symbol.basic;
+	basic.color = convertColor(text_symbol->getColor());
+	basic.font_size = quint16(qRound(10 * text_symbol->getFontSize() / 25.4 * 72.0));
+	basic.font_weight = text_symbol->isBold() ? 700 : 400;
+	basic.font_italic = text_symbol->isItalic() ? 1 : 0;
+	basic.char_spacing = quint16(qRound(100000 * text_symbol->getCharacterSpacing()));
+	basic.word_spacing = 100;
+	basic.alignment = text_alignments.value(text_symbol, Ocd::HAlignLeft | Ocd::VAlignBottom);
+	if (text_symbol->isUnderlined())
+		addWarning(tr("In text symbol %1: ignoring underlining").arg(text_symbol->getPlainTextName()));
+	if (text_symbol->usesKerning())
+		addWarning(tr("In text symbol %1: ignoring kerning").arg(text_symbol->getPlainTextName()));
+
+	auto& special = ocd_symbol.special;
+	auto const absolute_line_spacing = text_symbol->getLineSpacing() * (text_symbol->getFontMetrics().lineSpacing() / text_symbol->calculateInternalScaling());
+	special.line_spacing = quint16(qRound(absolute_line_spacing / (text_symbol->getFontSize() * 0.01)));
+	special.para_spacing = qint16(convertSize(qRound(1000 * text_symbol->getParagraphSpacing())));
+	special.line_below_on = text_symbol->hasLineBelow() ? 1 : 0;
+	special.line_below_color = convertColor(text_symbol->getLineBelowColor());
+	special.line_below_width = quint16(convertSize(qRound(1000 * text_symbol->getLineBelowWidth())));
+	special.line_below_offset = quint16(convertSize(qRound(1000 * text_symbol->getLineBelowDistance())));
+	special.num_tabs = quint16(std::min(text_symbol->getNumCustomTabs(), int(sizeof(special.tab_pos) / sizeof(special.tab_pos[0]))));
+	for (int i = 0; i < special.num_tabs; ++i)
+		special.tab_pos[i] = quint32(convertSize(text_symbol->getCustomTab(i)));
+
+	auto& framing = ocd_symbol.framing;
+	if (text_symbol->usesFraming() && text_symbol->getFramingColor())
+	{
+		framing.color = convertColor(text_symbol->getFramingColor());
+		if (text_symbol->getFramingMode() == TextSymbol::ShadowFraming)
+		{
+			framing.mode = Ocd::FramingShadow;
+			framing.offset_x = quint16(convertSize(text_symbol->getFramingShadowXOffset()));
+			framing.offset_y = quint16(-convertSize(text_symbol->getFramingShadowYOffset()));
+		}
+		else if (text_symbol->getFramingMode() == TextSymbol::LineFraming)
+		{
+			framing.mode = Ocd::FramingLine;
+			framing.line_width = quint16(convertSize(text_symbol->getFramingLineHalfWidth()));
+		}
+	}
+
+	return QByteArray(reinterpret_cast<const char*>(&ocd_symbol), int(sizeof(ocd_symbol)));
+}
+
+
+quint16 OcdFileExport::exportPattern(QByteArray& data, const PointSymbol* point_symbol)
+{
+	if (!point_symbol)
+		return 0;
+
+	auto const start = data.size();
+	std::vector<Ocd::OcdPoint32> ocd_coords;
+	auto append_element = [&data, &ocd_coords](Ocd::PointSymbolElementV8& element) {
+		element.num_coords = quint16(ocd_coords.size());
+		data.append(reinterpret_cast<const char*>(&element), int(sizeof(element)));
+		data.append(reinterpret_cast<const char*>(ocd_coords.data()), int(ocd_coords.size() * sizeof(Ocd::OcdPoint32)));
+	};
+
+	auto export_element = [this, &ocd_coords, &append_element](const Symbol* symbol, const MapCoordVector& coords) {
+		Ocd::PointSymbolElementV8 element = {};
+		ocd_coords.clear();
+		switch (symbol->getType())
+		{
+		case Symbol::Point:
+			{
+				auto point = static_cast<const PointSymbol*>(symbol);
+				appendCoordinates(ocd_coords, coords, symbol, {});
+				if (point->getInnerRadius() > 0 && point->getInnerColor())
+				{
+					element.type = Ocd::PointSymbolElementV8::TypeDot;
+					element.color = convertColor(point->getInnerColor());
+					element.diameter = qint16(convertSize(2 * point->getInnerRadius()));
+					append_element(element);
+				}
+				if (point->getOuterWidth() > 0 && point->getOuterColor())
+				{
+					element = {};
+					element.type = Ocd::PointSymbolElementV8::TypeCircle;
+					element.color = convertColor(point->getOuterColor());
+					element.line_width = qint16(convertSize(point->getOuterWidth()));
+					element.diameter = qint16(convertSize(2 * point->getInnerRadius() + point->getOuterWidth()));
+					append_element(element);
+				}
+			}
+			break;
+		case Symbol::Line:
+			{
+				auto line = static_cast<const LineSymbol*>(symbol);
+				if (!line->getColor())
+					break;
+				element.type = Ocd::PointSymbolElementV8::TypeLine;
+				if (line->getCapStyle() == LineSymbol::RoundCap)
+					element.flags |= 1;
+				else if (line->getJoinStyle() == LineSymbol::MiterJoin)
+					element.flags |= 4;
+				element.color = convertColor(line->getColor());
+				element.line_width = qint16(convertSize(line->getLineWidth()));
+				appendCoordinates(ocd_coords, coords, symbol, {});
+				append_element(element);
+			}
+			break;
+		case Symbol::Area:
+			{
+				auto area = static_cast<const AreaSymbol*>(symbol);
+				if (!area->getColor())
+					break;
+				element.type = Ocd::PointSymbolElementV8::TypeArea;
+				element.color = convertColor(area->getColor());
+				appendCoordinates(ocd_coords, coords, symbol, {});
+				append_element(element);
+			}
+			break;
+		default:
+			; // nothing
+		}
+	};
+
+	export_element(point_symbol, { MapCoord{} });
+	for (int i = 0; i < point_symbol->getNumElements(); ++i)
+	{
+		export_element(point_symbol->getElementSymbol(i), point_symbol->getElementObject(i)->getRawCoordinateVector());
+	}
+
+	return quint16((data.size() - start) / int(sizeof(Ocd::OcdPoint32)));
+}
+
+
+template< class Format >
+quint32 OcdFileExport::exportObjects(QByteArray& byte_array)
+{
+	// Collect the input on this thread. Getting the objects expands
+	// compacted objects, and text objects need their layout.
+	std::vector<ObjectSource> sources;
+	sources.reserve(std::size_t(map->getNumObjects()));
+	std::size_t skipped = 0;
+	for (int p = 0; p < map->getNumParts(); ++p)
+	{
+		auto part = map->getPart(p);
+		for (int o = 0; o < part->getNumObjects(); ++o)
+		{
+			auto object = part->getObject(o);
+			auto symbol = object->getSymbol();
+			auto symbol_type = symbol_types.value(symbol, 0);
+			if (!symbol_type)
+			{
+				++skipped;
+				continue;
+			}
+
+			ObjectSource source = { &object->getRawCoordinateVector(), symbol, symbol_numbers.value(symbol), symbol_type, 0, {}, {} };
+			switch (object->getType())
+			{
+			case Object::Point:
+				source.angle = convertRotation(static_cast<const PointObject*>(object)->getRotation());
+				break;
+			case Object::Path:
+				source.angle = convertRotation(static_cast<const PathObject*>(object)->getPatternRotation());
+				break;
+			case Object::Text:
+				{
+					auto text_object = static_cast<TextObject*>(object);
+					text_object->update();
+					source.type = text_object->hasSingleAnchor() ? 4 : 5;
+					source.angle = convertRotation(text_object->getRotation());
+					source.text_coords = exportTextCoordinates(text_object);
+					// OCD uses "\r\n" for line breaks, and drops a leading line break.
+					source.text = text_object->getText();
+					if (source.text.startsWith(QLatin1Char('\n')))
+						source.text.prepend(QLatin1Char('\n'));
+					source.text.replace(QLatin1Char('\n'), QLatin1String("\r\n"));
+				}
+				break;
+			}
+			sources.push_back(std::move(source));
+		}
+	}
+
+	if (skipped)
+		addWarning(tr("Unable to export %n object(s) with unsupported symbols.", nullptr, int(skipped)));
+
+	// Encode the objects in chunks. The encoders only read from the sources.
+	auto const num_chunks = (sources.size() + object_chunk_size - 1) / object_chunk_size;
+	std::vector<EncodedChunk> chunks(num_chunks);
+	{
+		QThreadPool pool;
+		for (std::size_t i = 0; i < num_chunks; ++i)
+		{
+			auto first = begin(sources) + std::ptrdiff_t(i * object_chunk_size);
+			auto last = (i + 1 == num_chunks) ? end(sources) : first + object_chunk_size;
+			pool.start(new ObjectEncoder<Format>(first, last, area_offset, chunks[i]));
+		}
+		pool.waitForDone();
+	}
+
+	// Concatenate the chunks.
+	using IndexEntry = typename Format::Object::IndexEntryType;
+	auto const first_block = appendIndexBlocks<IndexEntry>(byte_array, sources.size());
+	std::size_t index = 0;
+	for (auto& chunk : chunks)
+	{
+		auto const chunk_pos = quint32(byte_array.size());
+		byte_array.append(chunk.data);
+		chunk.data.clear();
+		for (auto entry : chunk.entries)
+		{
+			entry.pos += chunk_pos;
+			indexEntry<IndexEntry>(byte_array, first_block, index) = entry;
+			++index;
+		}
+	}
+	return first_block;
+}
+
+
+std::vector<Ocd::OcdPoint32> OcdFileExport::exportTextCoordinates(const TextObject* object) const
+{
+	std::vector<Ocd::OcdPoint32> ocd_coords;
+	if (object->getNumLines() == 0)
+		return ocd_coords;
+
+	auto const offset = MapCoordF(area_offset);
+	auto convert = [&offset](const QPointF& point) { return convertPoint(point - offset); };
+
+	auto const text_to_map = object->calcTextToMapTransform();
+	if (object->hasSingleAnchor())
+	{
+		// 5 coordinates: baseline anchor point, bottom left, bottom right, top right, top left
+		auto const map_to_text = object->calcMapToTextTransform();
+		auto const anchor_text = map_to_text.map(QPointF(object->getAnchorCoordF()));
+		auto const* line0 = object->getLineInfo(0);
+
+		QRectF bounding_box_text;
+		for (int i = 0; i < object->getNumLines(); ++i)
+		{
+			auto const* info = object->getLineInfo(i);
+			rectIncludeSafe(bounding_box_text, QPointF(info->line_x, info->line_y - info->ascent));
+			rectIncludeSafe(bounding_box_text, QPointF(info->line_x + info->width, info->line_y + info->descent));
+		}
+
+		ocd_coords.reserve(5);
+		ocd_coords.push_back(convert(text_to_map.map(QPointF(anchor_text.x(), line0->line_y))));
+		ocd_coords.push_back(convert(text_to_map.map(bounding_box_text.bottomLeft())));
+		ocd_coords.push_back(convert(text_to_map.map(bounding_box_text.bottomRight())));
+		ocd_coords.push_back(convert(text_to_map.map(bounding_box_text.topRight())));
+		ocd_coords.push_back(convert(text_to_map.map(bounding_box_text.topLeft())));
+	}
+	else
+	{
+		// 4 coordinates: bottom left, bottom right, top right, top left.
+		// OCD adds an extra internal leading which the importer removes.
+		auto const* text_symbol = static_cast<const TextSymbol*>(object->getSymbol());
+		auto const metrics = text_symbol->getFontMetrics();
+		auto const top_adjust = -text_symbol->getFontSize() + (metrics.ascent() + metrics.descent() + 0.5) / text_symbol->calculateInternalScaling();
+		auto const top = -object->getBoxHeight() / 2 - top_adjust;
+		auto const bottom = object->getBoxHeight() / 2;
+		auto const left = -object->getBoxWidth() / 2;
+		auto const right = object->getBoxWidth() / 2;
+
+		QTransform transform;
+		transform.rotate(-qRadiansToDegrees(object->getRotation()));
+		auto const anchor = QPointF(object->getAnchorCoordF());
+		ocd_coords.reserve(4);
+		ocd_coords.push_back(convert(transform.map(QPointF(left, bottom)) + anchor));
+		ocd_coords.push_back(convert(transform.map(QPointF(right, bottom)) + anchor));
+		ocd_coords.push_back(convert(transform.map(QPointF(right, top)) + anchor));
+		ocd_coords.push_back(convert(transform.map(QPointF(left, top)) + anchor));
+	}
+	return ocd_coords;
+}
+
+
+template< class Format >
+quint32 OcdFileExport::exportParameterStrings(QByteArray& byte_array)
+{
+	std::vector<std::pair<qint32, QString>> strings;
+
+	if (uses_registration_color)
+		strings.emplace_back(9, exportColor(map->getRegistrationColor(), 0));
+	for (int i = 0; i < map->getNumColors(); ++i)
+	{
+		auto color = map->getColor(i);
+		strings.emplace_back(9, exportColor(color, convertColor(color)));
+	}
+
+	strings.emplace_back(1039, exportGeoreferencing());
+
+	if (!map->getMapNotes().isEmpty())
+		strings.emplace_back(1061, map->getMapNotes());
+
+	if (view)
+		strings.emplace_back(1030, exportView());
+
+	for (auto& string : exportTemplates())
+		strings.emplace_back(8, std::move(string));
+
+	auto const first_block = appendIndexBlocks<Ocd::ParameterStringIndexEntry>(byte_array, strings.size());
+	for (std::size_t i = 0; i < strings.size(); ++i)
+	{
+		// Format::Encoding is UTF-8 for all natively exported versions.
+		auto data = strings[i].second.toUtf8();
+		data.append('\0');
+		auto& entry = indexEntry<Ocd::ParameterStringIndexEntry>(byte_array, first_block, i);
+		entry.pos = quint32(byte_array.size());
+		entry.size = quint32(data.size());
+		entry.type = strings[i].first;
+		byte_array.append(data);
+	}
+	return first_block;
+}
+
+
+QString OcdFileExport::exportGeoreferencing() const
+{
+	const auto& georef = map->getGeoreferencing();
+	auto const ref_point = georef.toProjectedCoords(area_offset);
+	auto string = QString::fromLatin1("\tm%1\ta%2\tx%3\ty%4")
+	              .arg(georef.getScaleDenominator())
+	              .arg(georef.getGrivation(), 0, 'f', 8)
+	              .arg(ref_point.x(), 0, 'f', 4)
+	              .arg(ref_point.y(), 0, 'f', 4);
+
+	const auto& grid = map->getGrid();
+	if (grid.getUnit() == MapGrid::MetersInTerrain)
+		string.append(QString::fromLatin1("\td%1").arg(grid.getHorizontalSpacing()));
+
+	// Grid and zone, as understood by OcdFileImport::applyGridAndZone()
+	QString combined_grid_zone;
+	auto const crs_id = georef.getProjectedCRSId();
+	const auto& parameters = georef.getProjectedCRSParameters();
+	if (georef.isLocal())
+	{
+		combined_grid_zone = QString::fromLatin1("1000");
+	}
+	else if (crs_id == QLatin1String("UTM") && parameters.size() == 1)
+	{
+		// Only northern zones
+		auto const zone = parameters.front().split(QLatin1Char(' '));
+		if (zone.size() == 1 || zone.at(1) == QLatin1String("N"))
+			combined_grid_zone = QLatin1String("20") + zone.front();
+	}
+	else if (crs_id == QLatin1String("Gauss-Krueger, datum: Potsdam") && parameters.size() == 1)
+	{
+		combined_grid_zone = QLatin1String("80") + parameters.front();
+	}
+	else if (crs_id == QLatin1String("EPSG") && parameters.size() == 1)
+	{
+		if (parameters.front() == QLatin1String("3067"))
+			combined_grid_zone = QString::fromLatin1("6005");
+		else if (parameters.front() == QLatin1String("21781"))
+			combined_grid_zone = QString::fromLatin1("14001");
+	}
+	if (!combined_grid_zone.isEmpty())
+		string.append(QLatin1String("\ti") + combined_grid_zone);
+
+	return string;
+}
+
+
+QString OcdFileExport::exportColor(const MapColor* color, int number) const
+{
+	const auto& cmyk = color->getCmyk();
+	return color->getName()
+	       + QString::fromLatin1("\tn%1\tc%2\tm%3\ty%4\tk%5\to%6\tt%7")
+	        .arg(number)
+	        .arg(100 * cmyk.c, 0, 'f', 1)
+	        .arg(100 * cmyk.m, 0, 'f', 1)
+	        .arg(100 * cmyk.y, 0, 'f', 1)
+	        .arg(100 * cmyk.k, 0, 'f', 1)
+	        .arg(color->getKnockout() ? 0 : 1)
+	        .arg(100 * color->getOpacity(), 0, 'f', 1);
+}
+
+
+QString OcdFileExport::exportView() const
+{
+	auto const center = MapCoordF(view->center()) - MapCoordF(area_offset);
+	return QString::fromLatin1("\tx%1\ty%2\tz%3")
+	        .arg(center.x(), 0, 'f', 2)
+	        .arg(-center.y(), 0, 'f', 2)
+	        .arg(view->getZoom());
+}
+
+
+std::vector<QString> OcdFileExport::exportTemplates() const
+{
+	std::vector<QString> strings;
+	auto const num_templates = map->getNumTemplates();
+	strings.reserve(std::size_t(num_templates));
+	// The importer inserts each template at the front.
+	for (int i = num_templates - 1; i >= 0; --i)
+	{
+		auto temp = map->getTemplate(i);
+		auto const rotation = qRadiansToDegrees(temp->getTemplateRotation());
+		auto dimming = 0;
+		auto visible = true;
+		if (view)
+		{
+			auto const visibility = view->getTemplateVisibility(temp);
+			dimming = qRound(100 * (1 - visibility.opacity));
+			visible = visibility.visible;
+		}
+		// The path is prepended after formatting: it may contain '%'.
+		strings.push_back(temp->getTemplatePath()
+		                  + QString::fromLatin1("\tx%1\ty%2\ta%3\tb%3\tu%4\tv%5\td%6\ts%7")
+		                  .arg(0.001 * (temp->getTemplateX() - area_offset.nativeX()), 0, 'f', 3)
+		                  .arg(-0.001 * (temp->getTemplateY() - area_offset.nativeY()), 0, 'f', 3)
+		                  .arg(rotation, 0, 'f', 8)
+		                  .arg(temp->getTemplateScaleX(), 0, 'g', 12)
+		                  .arg(temp->getTemplateScaleY(), 0, 'g', 12)
+		                  .arg(dimming)
+		                  .arg(visible ? 1 : 0));
+	}
+	return strings;
+}
+
+
+quint16 OcdFileExport::convertColor(const MapColor* color) const
+{
+	if (color == map->getRegistrationColor())
+		return 0;
+
+	auto const index = map->findColorIndex(color);
+	if (index < 0)
+		return 0;
+
+	return quint16(uses_registration_color ? (index + 1) : index);
+}
+
+
+std::vector<quint16> OcdFileExport::symbolColors(const Symbol* symbol) const
+{
+	std::vector<quint16> colors;
+	if (uses_registration_color && symbol->containsColor(map->getRegistrationColor()))
+		colors.push_back(0);
+	for (int i = 0; i < map->getNumColors(); ++i)
+	{
+		auto color = map->getColor(i);
+		if (symbol->containsColor(color))
+			colors.push_back(convertColor(color));
+	}
+	return colors;
+}
+
+
 }  // namespace OpenOrienteering
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2016 Kai Pastor
+ *    Copyright 2016, 2018 Kai Pastor
  *
  *    Some parts taken from file_format_oc*d8{.h,_p.h,cpp} which are
  *    Copyright 2012 Pete Curtis
@@ -23,37 +23,173 @@
 #ifndef OPENORIENTEERING_OCD_FILE_EXPORT_H
 #define OPENORIENTEERING_OCD_FILE_EXPORT_H
 
+#include <vector>
+
+#include <QtGlobal>
+#include <QByteArray>
 #include <QCoreApplication>
+#include <QHash>
+#include <QSet>
+#include <QString>
 
+#include "core/map_coord.h"
 #include "fileformats/file_import_export.h"
+#include "fileformats/ocd_types.h"
 
 class QIODevice;
 
 namespace OpenOrienteering {
 
+class AreaSymbol;
+class LineSymbol;
 class Map;
+class MapColor;
 class MapView;
+class Object;
+class PointSymbol;
+class Symbol;
+class TextObject;
+class TextSymbol;
 
 
 /**
  * An exporter for OCD files.
+ * 
+ * Version 11 and 12 files are written natively, using the type definitions
+ * from ocd_types_v11.h and ocd_types_v12.h. Other versions are delegated to
+ * the legacy OCAD8FileExport.
+ * 
+ * The native export writes the file in one pass into a byte array. The
+ * objects are encoded in chunks on a private thread pool. The map is not
+ * modified, and it is only accessed from the calling thread.
  */
 class OcdFileExport : public Exporter
 {
 	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::OcdFileExport)
 	
 public:
-	OcdFileExport(QIODevice* stream, Map *map, MapView *view);
+	/**
+	 * Constructs a new exporter.
+	 * 
+	 * The version selects the file format version. 11 and 12 are written
+	 * natively, any other value selects the legacy version 8 export.
+	 */
+	OcdFileExport(QIODevice* stream, Map *map, MapView *view, quint16 version = 8);
 	
 	~OcdFileExport() override;
 	
 	/**
 	 * Exports an OCD file.
-	 * 
-	 * For now, this simply uses the OCAD8FileExport class.
 	 */
 	void doExport() override;
 	
+protected:
+	/**
+	 * Exports a version 8 file via the OCAD8FileExport class.
+	 */
+	void exportImplementationLegacy();
+	
+	/**
+	 * Exports a file of the given format natively.
+	 */
+	template< class Format >
+	void exportImplementation();
+	
+	
+	/**
+	 * Determines an offset which moves the objects into the OCD drawing area.
+	 * 
+	 * Returns a null coordinate if no offset is needed.
+	 */
+	MapCoord calculateAreaOffset();
+	
+	/**
+	 * Returns the OCD symbol number for the given symbol, making it unique.
+	 */
+	quint32 makeSymbolNumber(const Symbol* symbol);
+	
+	
+	/**
+	 * Appends the symbol index and the symbols.
+	 * 
+	 * Returns the file position of the first symbol index block.
+	 */
+	template< class Format >
+	quint32 exportSymbols(QByteArray& byte_array);
+	
+	template< class Format >
+	QByteArray exportPointSymbol(const PointSymbol* point_symbol, const Symbol* base);
+	
+	template< class Format >
+	QByteArray exportLineSymbol(const LineSymbol* line_symbol, const Symbol* base);
+	
+	template< class Format >
+	QByteArray exportAreaSymbol(const AreaSymbol* area_symbol, const Symbol* base, quint32 border_symbol);
+	
+	template< class Format >
+	QByteArray exportTextSymbol(const TextSymbol* text_symbol, const Symbol* base);
+	
+	template< class OcdBaseSymbol >
+	void setupBaseSymbol(OcdBaseSymbol& ocd_base_symbol, const Symbol* symbol, const Symbol* base);
+	
+	/**
+	 * Appends the point symbol elements for a pattern.
+	 * 
+	 * Returns the size of the appended data in units of Ocd::OcdPoint32.
+	 */
+	quint16 exportPattern(QByteArray& data, const PointSymbol* point_symbol);
+	
+	
+	/**
+	 * Appends the object index and the objects.
+	 * 
+	 * Returns the file position of the first object index block.
+	 */
+	template< class Format >
+	quint32 exportObjects(QByteArray& byte_array);
+	
+	/**
+	 * Calculates the OCD coordinates of a text object's box or anchor.
+	 */
+	std::vector<Ocd::OcdPoint32> exportTextCoordinates(const TextObject* object) const;
+	
+	
+	/**
+	 * Appends the parameter string index and the parameter strings.
+	 * 
+	 * Returns the file position of the first string index block.
+	 */
+	template< class Format >
+	quint32 exportParameterStrings(QByteArray& byte_array);
+	
+	QString exportGeoreferencing() const;
+	
+	QString exportColor(const MapColor* color, int number) const;
+	
+	QString exportView() const;
+	
+	std::vector<QString> exportTemplates() const;
+	
+	
+	/**
+	 * Returns the OCD color number for the given color.
+	 */
+	quint16 convertColor(const MapColor* color) const;
+	
+	/**
+	 * Returns the list of the OCD color numbers used by a symbol.
+	 */
+	std::vector<quint16> symbolColors(const Symbol* symbol) const;
+	
+private:
+	QHash<const Symbol*, quint32> symbol_numbers;
+	QHash<const Symbol*, quint8> symbol_types;
+	QSet<quint32> used_symbol_numbers;
+	QHash<const TextSymbol*, quint16> text_alignments;
+	MapCoord area_offset;
+	quint16 ocd_version;
+	bool uses_registration_color = false;
+	
 };
 
 
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2013-2016 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    Some parts taken from file_format_oc*d8{.h,_p.h,cpp} which are
  *    Copyright 2012 Pete Curtis
@@ -39,6 +39,15 @@ namespace OpenOrienteering {
 OcdFileFormat::OcdFileFormat()
 : FileFormat { MapFile, "OCD", ::OpenOrienteering::ImportExport::tr("OCAD"), QString::fromLatin1("ocd"),
                ImportSupported | ExportSupported | ExportLossy }
+, version { 8 }
+{
+	// Nothing
+}
+
+OcdFileFormat::OcdFileFormat(const char* id, const QString& description, quint16 version)
+: FileFormat { MapFile, id, description, QString::fromLatin1("ocd"),
+               ExportSupported | ExportLossy }
+, version { version }
 {
 	// Nothing
 }
@@ -58,7 +67,7 @@ Importer* OcdFileFormat::createImporter(QIODevice* stream, Map *map, MapView *vi
 
 Exporter* OcdFileFormat::createExporter(QIODevice* stream, Map* map, MapView* view) const
 {
-	return new OcdFileExport(stream, map, view);
+	return new OcdFileExport(stream, map, view, version);
 }
 
 
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2013, 2016 Kai Pastor
+ *    Copyright 2013, 2016, 2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,6 +22,9 @@
 
 #include <cstddef>
 
+#include <QtGlobal>
+#include <QString>
+
 #include "fileformats/file_format.h"
 
 class QIODevice;
@@ -42,9 +45,19 @@ class OcdFileFormat : public FileFormat
 public:
 	/**
 	 * Constructs a new OcdFileFormat.
+	 * 
+	 * This format imports all supported OCD versions, and it exports
+	 * version 8 files.
 	 */
 	OcdFileFormat();
 	
+	/**
+	 * Constructs an export-only OcdFileFormat for a particular version.
+	 * 
+	 * Import is left to the default OcdFileFormat which handles all versions.
+	 */
+	OcdFileFormat(const char* id, const QString& description, quint16 version);
+	
 	/**
 	 * Detects whether the buffer may be the start of a valid OCD file.
 	 * 
@@ -58,6 +71,9 @@ public:
 	
 	/// \copydoc FileFormat::createExporter()
 	Exporter* createExporter(QIODevice* stream, Map* map, MapView* view) const override;
+	
+private:
+	quint16 version;
 };
 
 
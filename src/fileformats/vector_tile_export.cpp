@@ -0,0 +1,902 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vector_tile_export.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include <QtMath>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLatin1String>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include "core/georeferencing.h"
+#include "core/latlon.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/objects/text_object.h"
+#include "core/symbols/symbol.h"
+
+#include <clipper.hpp>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/** The tolerance for line simplification, in tile units. */
+constexpr qreal simplification_tolerance = 1.0;
+
+/** The number of tiles which are encoded by a single task. */
+constexpr std::size_t tile_chunk_size = 64;
+
+/** The highest supported zoom level. */
+constexpr int max_supported_zoom = 24;
+
+/** The latitude limit of Web Mercator, in degrees. */
+constexpr double max_latitude = 85.0511287798;
+
+
+// MVT geometry commands
+
+constexpr quint32 move_to = 1;
+constexpr quint32 line_to = 2;
+constexpr quint32 close_path = 7;
+
+constexpr quint32 command(quint32 id, quint32 count)
+{
+	return (id & 0x7) | (count << 3);
+}
+
+constexpr quint32 zigzag(qint32 value)
+{
+	return (quint32(value) << 1) ^ quint32(value >> 31);
+}
+
+
+// Protocol buffers encoding
+
+enum WireType
+{
+	Varint          = 0,
+	LengthDelimited = 2
+};
+
+void appendVarint(QByteArray& data, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		data.append(char(value | 0x80));
+		value >>= 7;
+	}
+	data.append(char(value));
+}
+
+void appendKey(QByteArray& data, quint32 field, WireType type)
+{
+	appendVarint(data, (quint64(field) << 3) | type);
+}
+
+void appendVarintField(QByteArray& data, quint32 field, quint64 value)
+{
+	appendKey(data, field, Varint);
+	appendVarint(data, value);
+}
+
+void appendBytesField(QByteArray& data, quint32 field, const QByteArray& bytes)
+{
+	appendKey(data, field, LengthDelimited);
+	appendVarint(data, quint64(bytes.size()));
+	data.append(bytes);
+}
+
+template< class T >
+void appendPackedField(QByteArray& data, quint32 field, const std::vector<T>& values)
+{
+	QByteArray packed;
+	for (auto value : values)
+		appendVarint(packed, value);
+	appendBytesField(data, field, packed);
+}
+
+
+/**
+ * Returns the squared distance of p from the segment between a and b.
+ */
+qreal squaredSegmentDistance(const QPointF& p, const QPointF& a, const QPointF& b)
+{
+	auto const ab = b - a;
+	auto const length_squared = QPointF::dotProduct(ab, ab);
+	auto t = (length_squared > 0) ? QPointF::dotProduct(p - a, ab) / length_squared : 0.0;
+	t = qBound(0.0, t, 1.0);
+	auto const d = p - (a + t * ab);
+	return QPointF::dotProduct(d, d);
+}
+
+/**
+ * Simplifies a polyline with the Douglas-Peucker algorithm.
+ *
+ * The first and the last point are always kept.
+ */
+std::vector<QPointF> simplified(const std::vector<QPointF>& points, qreal tolerance)
+{
+	if (points.size() < 3)
+		return points;
+
+	std::vector<bool> keep(points.size(), false);
+	keep.front() = true;
+	keep.back() = true;
+
+	auto const tolerance_squared = tolerance * tolerance;
+	std::vector<std::pair<std::size_t, std::size_t>> ranges = { { 0, points.size() - 1 } };
+	while (!ranges.empty())
+	{
+		auto const range = ranges.back();
+		ranges.pop_back();
+
+		auto max_distance = tolerance_squared;
+		auto max_index = range.first;
+		for (auto i = range.first + 1; i < range.second; ++i)
+		{
+			auto const distance = squaredSegmentDistance(points[i], points[range.first], points[range.second]);
+			if (distance > max_distance)
+			{
+				max_distance = distance;
+				max_index = i;
+			}
+		}
+		if (max_index != range.first)
+		{
+			keep[max_index] = true;
+			ranges.emplace_back(range.first, max_index);
+			ranges.emplace_back(max_index, range.second);
+		}
+	}
+
+	std::vector<QPointF> result;
+	result.reserve(std::size_t(std::count(begin(keep), end(keep), true)));
+	for (std::size_t i = 0; i < points.size(); ++i)
+	{
+		if (keep[i])
+			result.push_back(points[i]);
+	}
+	return result;
+}
+
+/**
+ * Converts points in tile units to a Clipper path, dropping duplicates.
+ */
+ClipperLib::Path toClipperPath(const std::vector<QPointF>& points)
+{
+	ClipperLib::Path path;
+	path.reserve(points.size());
+	for (const auto& point : points)
+	{
+		auto const int_point = ClipperLib::IntPoint(qRound64(point.x()), qRound64(point.y()));
+		if (path.empty() || !(path.back() == int_point))
+			path.push_back(int_point);
+	}
+	return path;
+}
+
+/**
+ * Returns twice the signed area of a ring, positive for clockwise rings
+ * in a coordinate system with y pointing down.
+ */
+qint64 signedArea(const ClipperLib::Path& ring)
+{
+	qint64 area = 0;
+	for (std::size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+		area += ring[j].X * ring[i].Y - ring[i].X * ring[j].Y;
+	return area;
+}
+
+
+/**
+ * Writes the geometry commands for a tile, tracking the cursor.
+ */
+class CommandWriter
+{
+public:
+	explicit CommandWriter(std::vector<quint32>& commands) : commands(commands) {}
+
+	void moveTo(const ClipperLib::IntPoint& point)
+	{
+		commands.push_back(command(move_to, 1));
+		append(point);
+	}
+
+	void lineTo(ClipperLib::Path::const_iterator first, ClipperLib::Path::const_iterator last)
+	{
+		commands.push_back(command(line_to, quint32(std::distance(first, last))));
+		for (; first != last; ++first)
+			append(*first);
+	}
+
+	void points(const ClipperLib::Path& path)
+	{
+		commands.push_back(command(move_to, quint32(path.size())));
+		for (const auto& point : path)
+			append(point);
+	}
+
+	void line(const ClipperLib::Path& path)
+	{
+		moveTo(path.front());
+		lineTo(path.begin() + 1, path.end());
+	}
+
+	void ring(const ClipperLib::Path& path)
+	{
+		line(path);
+		commands.push_back(command(close_path, 1));
+	}
+
+private:
+	void append(const ClipperLib::IntPoint& point)
+	{
+		commands.push_back(zigzag(qint32(point.X - cursor.X)));
+		commands.push_back(zigzag(qint32(point.Y - cursor.Y)));
+		cursor = point;
+	}
+
+	std::vector<quint32>& commands;
+	ClipperLib::IntPoint cursor = { 0, 0 };
+};
+
+/**
+ * Writes an outer ring with its holes, and recursively the islands in the holes.
+ */
+void writePolygon(CommandWriter& writer, const ClipperLib::PolyNode& outer)
+{
+	if (outer.Contour.size() < 3)
+		return;
+
+	auto ring = outer.Contour;
+	if (signedArea(ring) < 0)
+		std::reverse(begin(ring), end(ring));
+	writer.ring(ring);
+
+	for (auto hole : outer.Childs)
+	{
+		if (hole->Contour.size() < 3)
+			continue;
+		auto hole_ring = hole->Contour;
+		if (signedArea(hole_ring) > 0)
+			std::reverse(begin(hole_ring), end(hole_ring));
+		writer.ring(hole_ring);
+	}
+
+	for (auto hole : outer.Childs)
+	{
+		for (auto island : hole->Childs)
+			writePolygon(writer, *island);
+	}
+}
+
+
+/**
+ * Converts normalized Web Mercator coordinates to geographic coordinates.
+ */
+LatLon geographicCoords(const QPointF& world_coords)
+{
+	auto const longitude = world_coords.x() * 360.0 - 180.0;
+	auto const latitude = qRadiansToDegrees(std::atan(std::sinh(M_PI * (1.0 - 2.0 * world_coords.y()))));
+	return { latitude, longitude };
+}
+
+
+/**
+ * Encodes a range of tiles.
+ */
+class TileEncoder : public QRunnable
+{
+public:
+	TileEncoder(const VectorTileExport& exporter, const VectorTileExport::TileId* tiles, QByteArray* results, std::size_t count)
+	: exporter(exporter)
+	, tiles(tiles)
+	, results(results)
+	, count(count)
+	{}
+
+	void run() override
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			results[i] = exporter.encodeTile(tiles[i]);
+	}
+
+private:
+	const VectorTileExport& exporter;
+	const VectorTileExport::TileId* tiles;
+	QByteArray* results;
+	std::size_t count;
+};
+
+
+}  // namespace
+
+
+
+// ### VectorTileExport ###
+
+// static
+VectorTileExport::Options VectorTileExport::defaultOptions(const Map& map)
+{
+	// Ground resolution of a 256 pixel tile at zoom level 0, at the equator.
+	constexpr auto zoom_0_resolution = 156543.034;  // m/pixel
+	// Size of a pixel on a 96 dpi screen.
+	constexpr auto pixel_size = 0.0254 / 96;  // m
+
+	auto const resolution = map.getGeoreferencing().getScaleDenominator() * pixel_size;
+	Options options;
+	options.max_zoom = qBound(0, qRound(std::log2(zoom_0_resolution / resolution)), 22);
+	options.min_zoom = std::max(0, options.max_zoom - 5);
+	return options;
+}
+
+
+VectorTileExport::VectorTileExport(Map& map, const Options& options)
+: map(map)
+, export_options(options)
+{
+	// nothing else
+}
+
+VectorTileExport::~VectorTileExport()
+{
+	// nothing, not inlined
+}
+
+
+bool VectorTileExport::prepare()
+{
+	features.clear();
+	keys.clear();
+	values.clear();
+	key_indices.clear();
+	value_indices.clear();
+	tile_index.clear();
+	prepared = false;
+
+	if (export_options.min_zoom < 0
+	    || export_options.max_zoom > max_supported_zoom
+	    || export_options.min_zoom > export_options.max_zoom
+	    || export_options.extent == 0
+	    || export_options.buffer < 0)
+	{
+		error_string = tr("Invalid zoom levels or tile extent.");
+		return false;
+	}
+
+	if (map.getGeoreferencing().isLocal())
+	{
+		error_string = tr("The map must be georeferenced in order to export vector tiles.");
+		return false;
+	}
+
+	features.reserve(std::size_t(map.getNumObjects()));
+	quint64 id = 0;
+	auto failed = 0;
+	for (int i = 0; i < map.getNumParts(); ++i)
+	{
+		auto part = map.getPart(i);
+		for (int j = 0; j < part->getNumObjects(); ++j)
+		{
+			if (!addObject(part->getObject(j), ++id))
+				++failed;
+		}
+	}
+	if (failed)
+		export_warnings.push_back(tr("Failed to transform the coordinates of %n object(s).", nullptr, failed));
+
+	tile_index.resize(std::size_t(export_options.max_zoom - export_options.min_zoom + 1));
+	for (auto zoom = export_options.min_zoom; zoom <= export_options.max_zoom; ++zoom)
+	{
+		auto& index = tile_index[std::size_t(zoom - export_options.min_zoom)];
+		auto const num_tiles = 1 << zoom;
+		auto const margin = qreal(export_options.buffer) / export_options.extent;
+		for (std::size_t i = 0; i < features.size(); ++i)
+		{
+			const auto& bounds = features[i].bounds;
+			auto const x0 = qBound(0, int(std::floor(bounds.left() * num_tiles - margin)), num_tiles - 1);
+			auto const x1 = qBound(0, int(std::floor(bounds.right() * num_tiles + margin)), num_tiles - 1);
+			auto const y0 = qBound(0, int(std::floor(bounds.top() * num_tiles - margin)), num_tiles - 1);
+			auto const y1 = qBound(0, int(std::floor(bounds.bottom() * num_tiles + margin)), num_tiles - 1);
+			for (auto x = x0; x <= x1; ++x)
+			{
+				for (auto y = y0; y <= y1; ++y)
+					index[tileKey(x, y)].push_back(i);
+			}
+		}
+	}
+
+	prepared = true;
+	return true;
+}
+
+
+bool VectorTileExport::addObject(Object* object, quint64 id)
+{
+	auto symbol = object->getSymbol();
+	if (!symbol || symbol->isHidden())
+		return true;
+
+	object->update();
+
+	Feature feature;
+	feature.id = id;
+
+	std::vector<std::vector<MapCoordF>> parts;
+	switch (object->getType())
+	{
+	case Object::Point:
+		feature.type = Feature::Point;
+		parts.push_back({ static_cast<const PointObject*>(object)->getCoordF() });
+		break;
+
+	case Object::Text:
+		feature.type = Feature::Point;
+		parts.push_back({ static_cast<const TextObject*>(object)->getAnchorCoordF() });
+		break;
+
+	case Object::Path:
+		{
+			feature.type = (symbol->getContainedTypes() & Symbol::Area) ? Feature::Polygon : Feature::LineString;
+			auto const min_size = (feature.type == Feature::Polygon) ? 3u : 2u;
+			for (const auto& part : static_cast<const PathObject*>(object)->parts())
+			{
+				if (part.path_coords.size() < min_size)
+					continue;
+				parts.emplace_back();
+				parts.back().reserve(part.path_coords.size());
+				for (const auto& path_coord : part.path_coords)
+					parts.back().push_back(path_coord.pos);
+			}
+		}
+		break;
+	}
+	if (parts.empty())
+		return true;
+
+	const auto& georef = map.getGeoreferencing();
+	auto left = 1.0, top = 1.0, right = 0.0, bottom = 0.0;
+	feature.parts.reserve(parts.size());
+	for (const auto& part : parts)
+	{
+		feature.parts.emplace_back();
+		auto& world_part = feature.parts.back();
+		world_part.reserve(part.size());
+		for (const auto& coord : part)
+		{
+			bool ok = false;
+			auto const latlon = georef.toGeographicCoords(coord, &ok);
+			if (!ok)
+				return false;
+			auto const world = worldCoords(latlon.latitude(), latlon.longitude());
+			left = std::min(left, world.x());
+			right = std::max(right, world.x());
+			top = std::min(top, world.y());
+			bottom = std::max(bottom, world.y());
+			world_part.push_back(world);
+		}
+	}
+	feature.bounds = QRectF(QPointF(left, top), QPointF(right, bottom));
+
+	static const auto symbol_key = QStringLiteral("symbol");
+	static const auto symbol_name_key = QStringLiteral("symbol_name");
+	static const auto text_key = QStringLiteral("text");
+	feature.tags.emplace_back(keyIndex(symbol_key), valueIndex(symbol->getNumberAsString()));
+	feature.tags.emplace_back(keyIndex(symbol_name_key), valueIndex(symbol->getPlainTextName()));
+	if (object->getType() == Object::Text)
+		feature.tags.emplace_back(keyIndex(text_key), valueIndex(static_cast<const TextObject*>(object)->getText()));
+	const auto& tags = object->tags();
+	for (auto tag = tags.constBegin(); tag != tags.constEnd(); ++tag)
+	{
+		if (tag.key() != symbol_key && tag.key() != symbol_name_key && tag.key() != text_key)
+			feature.tags.emplace_back(keyIndex(tag.key()), valueIndex(tag.value()));
+	}
+
+	features.push_back(std::move(feature));
+	return true;
+}
+
+
+int VectorTileExport::keyIndex(const QString& key)
+{
+	auto found = key_indices.constFind(key);
+	if (found != key_indices.constEnd())
+		return *found;
+
+	auto const index = int(keys.size());
+	keys.push_back(key);
+	key_indices.insert(key, index);
+	return index;
+}
+
+
+int VectorTileExport::valueIndex(const QString& value)
+{
+	auto found = value_indices.constFind(value);
+	if (found != value_indices.constEnd())
+		return *found;
+
+	auto const index = int(values.size());
+	values.push_back(value);
+	value_indices.insert(value, index);
+	return index;
+}
+
+
+std::vector<VectorTileExport::TileId> VectorTileExport::tiles(int zoom) const
+{
+	std::vector<TileId> result;
+	if (!prepared || zoom < export_options.min_zoom || zoom > export_options.max_zoom)
+		return result;
+
+	const auto& index = tile_index[std::size_t(zoom - export_options.min_zoom)];
+	result.reserve(std::size_t(index.size()));
+	for (auto it = index.constBegin(); it != index.constEnd(); ++it)
+		result.push_back({ zoom, int(it.key() >> 32), int(it.key() & 0xffffffff) });
+	std::sort(begin(result), end(result), [](const TileId& a, const TileId& b) {
+		return a.x < b.x || (a.x == b.x && a.y < b.y);
+	});
+	return result;
+}
+
+
+QByteArray VectorTileExport::encodeTile(const TileId& tile) const
+{
+	QByteArray result;
+	if (!prepared || tile.zoom < export_options.min_zoom || tile.zoom > export_options.max_zoom)
+		return result;
+
+	const auto& index = tile_index[std::size_t(tile.zoom - export_options.min_zoom)];
+	auto const candidates = index.constFind(tileKey(tile.x, tile.y));
+	if (candidates == index.constEnd())
+		return result;
+
+	// Keys and values are stored per tile, and only if they are used.
+	QHash<int, quint32> local_keys;
+	QHash<int, quint32> local_values;
+	std::vector<int> used_keys;
+	std::vector<int> used_values;
+
+	QByteArray layer;
+	appendBytesField(layer, 1, export_options.layer_name.toUtf8());
+
+	std::vector<quint32> geometry;
+	std::vector<quint32> tags;
+	auto num_features = 0;
+	for (auto i : *candidates)
+	{
+		const auto& feature = features[i];
+		geometry.clear();
+		if (!encodeGeometry(feature, tile, geometry))
+			continue;
+
+		tags.clear();
+		for (const auto& tag : feature.tags)
+		{
+			auto key = local_keys.constFind(tag.first);
+			if (key == local_keys.constEnd())
+			{
+				key = local_keys.insert(tag.first, quint32(used_keys.size()));
+				used_keys.push_back(tag.first);
+			}
+			auto value = local_values.constFind(tag.second);
+			if (value == local_values.constEnd())
+			{
+				value = local_values.insert(tag.second, quint32(used_values.size()));
+				used_values.push_back(tag.second);
+			}
+			tags.push_back(*key);
+			tags.push_back(*value);
+		}
+
+		QByteArray encoded_feature;
+		appendVarintField(encoded_feature, 1, feature.id);
+		appendPackedField(encoded_feature, 2, tags);
+		appendVarintField(encoded_feature, 3, feature.type);
+		appendPackedField(encoded_feature, 4, geometry);
+		appendBytesField(layer, 2, encoded_feature);
+		++num_features;
+	}
+	if (num_features == 0)
+		return result;
+
+	for (auto key : used_keys)
+		appendBytesField(layer, 3, keys[std::size_t(key)].toUtf8());
+	for (auto value : used_values)
+	{
+		QByteArray encoded_value;
+		appendBytesField(encoded_value, 1, values[std::size_t(value)].toUtf8());
+		appendBytesField(layer, 4, encoded_value);
+	}
+	appendVarintField(layer, 5, export_options.extent);
+	appendVarintField(layer, 15, 2);  // MVT version
+
+	appendBytesField(result, 3, layer);
+	return result;
+}
+
+
+bool VectorTileExport::encodeGeometry(const Feature& feature, const TileId& tile, std::vector<quint32>& commands) const
+{
+	auto const extent = qreal(export_options.extent);
+	auto const scale = extent * (1 << tile.zoom);
+	auto const offset = QPointF(tile.x * extent, tile.y * extent);
+	auto to_tile = [scale, offset](const QPointF& world) { return world * scale - offset; };
+
+	auto const low = qint64(-export_options.buffer);
+	auto const high = qint64(export_options.extent) + export_options.buffer;
+	auto inside = [low, high](const ClipperLib::IntPoint& point) {
+		return point.X >= low && point.X <= high && point.Y >= low && point.Y <= high;
+	};
+
+	CommandWriter writer(commands);
+	switch (feature.type)
+	{
+	case Feature::Point:
+		{
+			std::vector<QPointF> tile_points;
+			for (const auto& part : feature.parts)
+				std::transform(begin(part), end(part), std::back_inserter(tile_points), to_tile);
+			auto points = toClipperPath(tile_points);
+			points.erase(std::remove_if(begin(points), end(points), [&inside](const ClipperLib::IntPoint& p) {
+				return !inside(p);
+			}), end(points));
+			if (points.empty())
+				return false;
+			writer.points(points);
+		}
+		break;
+
+	case Feature::LineString:
+	case Feature::Polygon:
+		{
+			ClipperLib::Paths paths;
+			paths.reserve(feature.parts.size());
+			auto all_inside = true;
+			for (const auto& part : feature.parts)
+			{
+				std::vector<QPointF> tile_points;
+				tile_points.reserve(part.size());
+				std::transform(begin(part), end(part), std::back_inserter(tile_points), to_tile);
+				auto path = toClipperPath(simplified(tile_points, simplification_tolerance));
+				if (path.size() < 2)
+					continue;
+				all_inside = all_inside && std::all_of(begin(path), end(path), inside);
+				paths.push_back(std::move(path));
+			}
+			if (paths.empty())
+				return false;
+
+			auto const is_polygon = feature.type == Feature::Polygon;
+			if (!is_polygon && all_inside)
+			{
+				// Fast path: no clipping needed
+				for (const auto& path : paths)
+					writer.line(path);
+				break;
+			}
+
+			ClipperLib::Path clip_rect = { { low, low }, { high, low }, { high, high }, { low, high } };
+			ClipperLib::Clipper clipper;
+			clipper.AddPaths(paths, ClipperLib::ptSubject, is_polygon);
+			clipper.AddPath(clip_rect, ClipperLib::ptClip, true);
+			ClipperLib::PolyTree tree;
+			clipper.Execute(ClipperLib::ctIntersection, tree, ClipperLib::pftEvenOdd, ClipperLib::pftNonZero);
+
+			if (is_polygon)
+			{
+				for (auto outer : tree.Childs)
+					writePolygon(writer, *outer);
+			}
+			else
+			{
+				ClipperLib::Paths lines;
+				ClipperLib::OpenPathsFromPolyTree(tree, lines);
+				for (const auto& line : lines)
+				{
+					if (line.size() >= 2)
+						writer.line(line);
+				}
+			}
+		}
+		break;
+	}
+
+	return !commands.empty();
+}
+
+
+bool VectorTileExport::exportToDirectory(const QString& directory, const Progress& progress)
+{
+	if (!prepared && !prepare())
+		return false;
+
+	QDir dir(directory);
+	if (!dir.mkpath(QStringLiteral(".")))
+	{
+		error_string = tr("Cannot create directory:\n%1").arg(directory);
+		return false;
+	}
+
+	std::vector<std::vector<TileId>> all_tiles;
+	all_tiles.reserve(tile_index.size());
+	std::size_t num_tiles = 0;
+	for (auto zoom = export_options.min_zoom; zoom <= export_options.max_zoom; ++zoom)
+	{
+		all_tiles.push_back(tiles(zoom));
+		num_tiles += all_tiles.back().size();
+	}
+
+	auto const batch_size = tile_chunk_size * std::size_t(std::max(1, QThread::idealThreadCount())) * 4;
+	std::size_t tiles_done = 0;
+	std::vector<QByteArray> data;
+	for (const auto& zoom_tiles : all_tiles)
+	{
+		for (std::size_t batch = 0; batch < zoom_tiles.size(); batch += batch_size)
+		{
+			auto const batch_end = std::min(batch + batch_size, zoom_tiles.size());
+			data.assign(batch_end - batch, {});
+			{
+				QThreadPool pool;
+				for (auto i = batch; i < batch_end; i += tile_chunk_size)
+				{
+					auto const count = std::min(tile_chunk_size, batch_end - i);
+					pool.start(new TileEncoder(*this, &zoom_tiles[i], &data[i - batch], count));
+				}
+				pool.waitForDone();
+			}
+
+			for (auto i = batch; i < batch_end; ++i)
+			{
+				const auto& tile_data = data[i - batch];
+				if (tile_data.isEmpty())
+					continue;
+
+				const auto& tile = zoom_tiles[i];
+				auto const tile_dir = QString::fromLatin1("%1/%2").arg(tile.zoom).arg(tile.x);
+				if (!dir.mkpath(tile_dir))
+				{
+					error_string = tr("Cannot create directory:\n%1").arg(dir.filePath(tile_dir));
+					return false;
+				}
+				auto const path = dir.filePath(QString::fromLatin1("%1/%2.mvt").arg(tile_dir).arg(tile.y));
+				QFile file(path);
+				if (!file.open(QIODevice::WriteOnly) || file.write(tile_data) != tile_data.size())
+				{
+					error_string = tr("Cannot save file\n%1:\n%2").arg(path, file.errorString());
+					return false;
+				}
+			}
+
+			tiles_done += batch_end - batch;
+			if (progress && !progress(int(100 * tiles_done / num_tiles)))
+				return false;
+		}
+	}
+
+	// Metadata in the style of TileJSON / MBTiles
+	auto left = 1.0, top = 1.0, right = 0.0, bottom = 0.0;
+	for (const auto& feature : features)
+	{
+		left = std::min(left, feature.bounds.left());
+		top = std::min(top, feature.bounds.top());
+		right = std::max(right, feature.bounds.right());
+		bottom = std::max(bottom, feature.bounds.bottom());
+	}
+	QJsonObject fields;
+	for (const auto& key : keys)
+		fields.insert(key, QStringLiteral("String"));
+	QJsonObject layer;
+	layer.insert(QStringLiteral("id"), export_options.layer_name);
+	layer.insert(QStringLiteral("fields"), fields);
+	layer.insert(QStringLiteral("minzoom"), export_options.min_zoom);
+	layer.insert(QStringLiteral("maxzoom"), export_options.max_zoom);
+	QJsonObject metadata;
+	metadata.insert(QStringLiteral("format"), QStringLiteral("pbf"));
+	metadata.insert(QStringLiteral("minzoom"), export_options.min_zoom);
+	metadata.insert(QStringLiteral("maxzoom"), export_options.max_zoom);
+	if (!features.empty())
+	{
+		auto const south_west = geographicCoords({ left, bottom });
+		auto const north_east = geographicCoords({ right, top });
+		QJsonArray bounds;
+		bounds.append(south_west.longitude());
+		bounds.append(south_west.latitude());
+		bounds.append(north_east.longitude());
+		bounds.append(north_east.latitude());
+		metadata.insert(QStringLiteral("bounds"), bounds);
+	}
+	QJsonArray layers;
+	layers.append(layer);
+	metadata.insert(QStringLiteral("vector_layers"), layers);
+
+	auto const path = dir.filePath(QStringLiteral("metadata.json"));
+	QFile file(path);
+	auto const json = QJsonDocument(metadata).toJson();
+	if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size())
+	{
+		error_string = tr("Cannot save file\n%1:\n%2").arg(path, file.errorString());
+		return false;
+	}
+
+	return true;
+}
+
+
+// static
+QPointF VectorTileExport::worldCoords(double latitude, double longitude)
+{
+	auto const phi = qDegreesToRadians(qBound(-max_latitude, latitude, max_latitude));
+	auto const x = (longitude + 180.0) / 360.0;
+	auto const y = 0.5 - std::log(std::tan(M_PI / 4 + phi / 2)) / (2 * M_PI);
+	return { x, y };
+}
+
+
+// static
+quint64 VectorTileExport::tileKey(int x, int y)
+{
+	return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+
+
+// ### VectorTileExportTask ###
+
+VectorTileExportTask::VectorTileExportTask(Map& map, const VectorTileExport::Options& options, const QString& directory)
+: exporter(map, options)
+, directory(directory)
+{
+	// The features must be collected on the map's thread.
+	prepared = exporter.prepare();
+}
+
+VectorTileExportTask::~VectorTileExportTask()
+{
+	abort();
+}
+
+
+bool VectorTileExportTask::run()
+{
+	auto const success = prepared && exporter.exportToDirectory(directory, [this](int value) {
+		setProgress(value);
+		return !isCanceled();
+	});
+	if (!success)
+		setErrorString(exporter.errorString());
+	return success;
+}
+
+
+}  // namespace OpenOrienteering
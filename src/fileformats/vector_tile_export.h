@@ -0,0 +1,255 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_VECTOR_TILE_EXPORT_H
+#define OPENORIENTEERING_VECTOR_TILE_EXPORT_H
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QHash>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+#include "util/background_task.h"
+
+namespace OpenOrienteering {
+
+class Map;
+class Object;
+
+
+/**
+ * An exporter which writes a map as a pyramid of Mapbox Vector Tiles (MVT).
+ *
+ * The tiles use the common XYZ scheme of web maps, i.e. Web Mercator
+ * (EPSG:3857) with the origin in the north-west. The map must be
+ * georeferenced.
+ *
+ * All objects go to a single layer. Each feature is tagged with the symbol
+ * number ("symbol"), the symbol name ("symbol_name"), the object's tags,
+ * and the text of text objects ("text").
+ *
+ * prepare() converts the object geometry to normalized Web Mercator
+ * coordinates and builds a tile index per zoom level. This is the only step
+ * which accesses the map. After that, tiles can be encoded concurrently:
+ * Each feature is simplified in tile units, which reduces the level of detail
+ * with decreasing zoom, and clipped to the buffered tile.
+ */
+class VectorTileExport
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::VectorTileExport)
+
+public:
+	/** Identifies a tile in the XYZ scheme. */
+	struct TileId
+	{
+		int zoom;
+		int x;
+		int y;
+	};
+
+	/** Export options. */
+	struct Options
+	{
+		int min_zoom = 12;      ///< The lowest zoom level to be exported.
+		int max_zoom = 17;      ///< The highest zoom level to be exported.
+		quint32 extent = 4096;  ///< The number of units along a tile's edge.
+		int buffer = 64;        ///< The extra margin for clipping, in tile units.
+		QString layer_name = QStringLiteral("map");
+	};
+
+	/**
+	 * A function which receives the progress of the export, from 0 to 100.
+	 *
+	 * It returns false in order to stop the export.
+	 */
+	using Progress = std::function<bool (int)>;
+
+	/**
+	 * Returns options with zoom levels which suit the scale of the given map.
+	 *
+	 * The maximum zoom level shows the map at roughly its printed size on a
+	 * 96 dpi screen.
+	 */
+	static Options defaultOptions(const Map& map);
+
+
+	/** Constructs a new exporter. */
+	VectorTileExport(Map& map, const Options& options);
+
+	VectorTileExport(const VectorTileExport&) = delete;
+	VectorTileExport& operator=(const VectorTileExport&) = delete;
+
+	/** Destructor. */
+	~VectorTileExport();
+
+
+	/** Returns the options. */
+	const Options& options() const { return export_options; }
+
+	/** Returns the warnings collected during prepare() and export. */
+	const std::vector<QString>& warnings() const { return export_warnings; }
+
+	/** Returns a description of the last error. */
+	const QString& errorString() const { return error_string; }
+
+
+	/**
+	 * Collects the map's objects and builds the tile index.
+	 *
+	 * Returns false on error.
+	 */
+	bool prepare();
+
+	/**
+	 * Returns the tiles at the given zoom level which may contain features.
+	 *
+	 * The result is sorted by x and y.
+	 */
+	std::vector<TileId> tiles(int zoom) const;
+
+	/**
+	 * Returns the encoded tile.
+	 *
+	 * Returns an empty byte array if the tile contains no features.
+	 * This function is thread-safe after prepare().
+	 */
+	QByteArray encodeTile(const TileId& tile) const;
+
+	/**
+	 * Writes all tiles as DIRECTORY/z/x/y.mvt, and a metadata.json file.
+	 *
+	 * Calls prepare() if this wasn't done before. The tiles are encoded in
+	 * batches on a private thread pool. The progress function, if given, is
+	 * called after each batch. Returns false on error, or when stopped by the
+	 * progress function.
+	 *
+	 * After prepare(), this function does not access the map, so it may
+	 * run on a worker thread.
+	 */
+	bool exportToDirectory(const QString& directory, const Progress& progress = {});
+
+
+	/**
+	 * Converts geographic coordinates to normalized Web Mercator coordinates.
+	 *
+	 * The whole world is mapped to the unit square, with x and y growing
+	 * towards east and south.
+	 */
+	static QPointF worldCoords(double latitude, double longitude);
+
+private:
+	/** A feature with geometry in normalized Web Mercator coordinates. */
+	struct Feature
+	{
+		enum GeometryType
+		{
+			Point      = 1,
+			LineString = 2,
+			Polygon    = 3
+		};
+
+		quint64 id;
+		GeometryType type;
+		std::vector<std::vector<QPointF>> parts;
+		QRectF bounds;
+		std::vector<std::pair<int, int>> tags;  ///< Pairs of key and value indices
+	};
+
+	/**
+	 * Adds the feature for an object.
+	 *
+	 * Returns false if the coordinates cannot be transformed.
+	 */
+	bool addObject(Object* object, quint64 id);
+
+	/** Returns the index of a key, adding it if needed. */
+	int keyIndex(const QString& key);
+
+	/** Returns the index of a value, adding it if needed. */
+	int valueIndex(const QString& value);
+
+	/** Encodes the geometry of a feature for a tile, or returns false if clipped away. */
+	bool encodeGeometry(const Feature& feature, const TileId& tile, std::vector<quint32>& commands) const;
+
+	/** Returns the key of a tile in the index of its zoom level. */
+	static quint64 tileKey(int x, int y);
+
+
+	Map& map;
+	Options export_options;
+	std::vector<QString> export_warnings;
+	QString error_string;
+	std::vector<Feature> features;
+	std::vector<QString> keys;
+	std::vector<QString> values;
+	QHash<QString, int> key_indices;
+	QHash<QString, int> value_indices;
+	std::vector<QHash<quint64, std::vector<std::size_t>>> tile_index;  ///< Feature indices per zoom level and tile
+	bool prepared = false;
+};
+
+
+
+/**
+ * A background task which exports vector tiles to a directory.
+ *
+ * The constructor collects the map's features. run() encodes and writes
+ * the tiles.
+ */
+class VectorTileExportTask : public BackgroundTask
+{
+Q_OBJECT
+public:
+	/**
+	 * Prepares the export of the given map.
+	 */
+	VectorTileExportTask(Map& map, const VectorTileExport::Options& options, const QString& directory);
+
+	/**
+	 * Destructor.
+	 */
+	~VectorTileExportTask() override;
+
+	/** Returns the warnings collected by the exporter. */
+	const std::vector<QString>& warnings() const { return exporter.warnings(); }
+
+protected:
+	/**
+	 * Writes the tiles.
+	 */
+	bool run() override;
+
+private:
+	VectorTileExport exporter;
+	const QString directory;
+	bool prepared;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
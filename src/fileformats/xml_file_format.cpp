@@ -60,6 +60,7 @@
 #include "templates/template.h"
 #include "undo/undo_manager.h"
 #include "util/xml_stream_util.h"
+#include "util/xml_utf8_writer.h"
 
 
 namespace OpenOrienteering {
@@ -374,6 +375,12 @@ void XMLFileExporter::exportSymbols()
 
 void XMLFileExporter::exportMapParts()
 {
+	if (XMLFileFormat::active_version >= 6 && !xml.autoFormatting())
+	{
+		exportMapPartsDirectly();
+		return;
+	}
+	
 	XmlElementWriter parts_element(xml, literal::parts);
 	
 	auto num_parts = std::size_t(map->getNumParts());
@@ -387,6 +394,27 @@ void XMLFileExporter::exportMapParts()
 	writeLineBreak(xml);
 }
 
+void XMLFileExporter::exportMapPartsDirectly()
+{
+	// QXmlStreamWriter writes to the device immediately, and there is no
+	// open start tag after writeLineBreak(). So the objects, i.e. the bulk
+	// of the data, can bypass QXmlStreamWriter's transcoding.
+	XmlUtf8Writer writer(stream);
+	writer.writeStartElement(literal::parts);
+	
+	auto num_parts = std::size_t(map->getNumParts());
+	writer.writeAttribute(literal::count, num_parts);
+	writer.writeAttribute(literal::current, map->current_part_index);
+	for (auto i = 0u; i < num_parts; ++i)
+	{
+		writer.writeLineBreak();
+		map->getPart(i)->save(writer);
+	}
+	writer.writeLineBreak();
+	writer.writeEndElement();
+	writer.flush();
+}
+
 void XMLFileExporter::exportTemplates()
 {
 	// Update the relative paths of templates
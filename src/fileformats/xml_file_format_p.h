@@ -46,6 +46,7 @@ protected:
 	void exportColors();
 	void exportSymbols();
 	void exportMapParts();
+	void exportMapPartsDirectly();
 	void exportTemplates();
 	void exportView();
 	void exportPrint();
@@ -0,0 +1,722 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contour_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include <cpl_error.h>
+#include <gdal.h>
+#include <ogr_api.h>
+#include <ogr_srs_api.h>
+
+#include <QtGlobal>
+#include <QFile>
+#include <QHash>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include "core/georeferencing.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "gdal/gdal_manager.h"
+#include "gdal/ogr_file_format_p.h"
+#include "undo/map_part_undo.h"
+#include "undo/object_undo.h"
+#include "undo/undo.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The number of cell rows and columns which are traced by a single task.
+constexpr int tile_cells = 64;
+
+/// The number of levels which are stitched by a single task.
+constexpr int level_chunk_size = 16;
+
+
+class GDALDatasetHDeleter
+{
+public:
+	void operator()(GDALDatasetH dataset) const
+	{
+		GDALClose(dataset);
+	}
+};
+
+/** A convenience class for GDAL C API dataset handles, similar to std::unique_ptr. */
+using unique_dataset = std::unique_ptr<typename std::remove_pointer<GDALDatasetH>::type, GDALDatasetHDeleter>;
+
+
+/**
+ * A contour segment within a single grid cell.
+ *
+ * The end points are identified by the grid edge they are located on.
+ * Grid coordinates refer to the samples, i.e. (0, 0) is the first sample.
+ */
+struct Segment
+{
+	quint64 edges[2];
+	QPointF coords[2];
+};
+
+/** A contour line in grid coordinates. */
+struct GridLine
+{
+	std::vector<QPointF> coords;
+	bool closed;
+};
+
+/** Segments, per level. */
+using LevelSegments = std::vector<std::vector<Segment>>;
+
+/** The segments of a tile, for the levels from first_level. */
+struct TileSegments
+{
+	int first_level = 0;
+	LevelSegments levels;
+};
+
+
+/**
+ * Traces the contour segments of a tile (marching squares).
+ *
+ * The tile's samples include the first row and column of the next tiles,
+ * so that the cells at the tile's border can be traced.
+ */
+class TileTracer : public QRunnable
+{
+public:
+	TileTracer(std::vector<float>&& samples, int sample_width, int col_offset, int row_offset,
+	           int width, double base, double step, TileSegments& result, QSemaphore& pending)
+	: samples(std::move(samples))
+	, sample_width(sample_width)
+	, col_offset(col_offset)
+	, row_offset(row_offset)
+	, width(width)
+	, base(base)
+	, step(step)
+	, result(result)
+	, pending(pending)
+	{}
+
+	void run() override
+	{
+		trace();
+		// Release the samples before letting the next tile be read.
+		samples = {};
+		pending.release();
+	}
+
+private:
+	void trace()
+	{
+		auto low = std::numeric_limits<float>::infinity();
+		auto high = -low;
+		for (auto value : samples)
+		{
+			if (!std::isnan(value))
+			{
+				low = std::min(low, value);
+				high = std::max(high, value);
+			}
+		}
+		if (!(low < high))
+			return;
+
+		// A level is crossed if low < level <= high.
+		auto const first_level = int(std::floor((low - base) / step)) + 1;
+		auto const last_level = int(std::floor((high - base) / step));
+		if (first_level > last_level)
+			return;
+
+		result.first_level = first_level;
+		result.levels.resize(std::size_t(last_level - first_level + 1));
+
+		auto const sample_height = int(samples.size()) / sample_width;
+		for (auto row = 0; row + 1 < sample_height; ++row)
+		{
+			auto const upper = &samples[std::size_t(row) * std::size_t(sample_width)];
+			auto const lower = upper + sample_width;
+			for (auto col = 0; col + 1 < sample_width; ++col)
+			{
+				// Clockwise, starting at the top left corner.
+				double const values[4] = { upper[col], upper[col+1], lower[col+1], lower[col] };
+				if (std::any_of(values, values + 4, [](double v) { return std::isnan(v); }))
+					continue;
+
+				auto const minmax = std::minmax_element(values, values + 4);
+				auto const first = int(std::floor((*minmax.first - base) / step)) + 1;
+				auto const last = int(std::floor((*minmax.second - base) / step));
+				for (auto level = first; level <= last; ++level)
+					traceCell(row_offset + row, col_offset + col, values, level);
+			}
+		}
+	}
+
+	void traceCell(int row, int col, const double* values, int level)
+	{
+		auto const elevation = base + level * step;
+		bool above[4];
+		for (int i = 0; i < 4; ++i)
+			above[i] = values[i] >= elevation;
+
+		// Edge i connects corner i and corner i+1.
+		// For an isolated corner i, the contour connects edge i-1 and edge i.
+		auto& segments = result.levels[std::size_t(level - result.first_level)];
+		auto crossings = 0;
+		int crossed[2] = {};
+		for (int i = 0; i < 4; ++i)
+		{
+			if (above[i] != above[(i + 1) % 4])
+			{
+				if (crossings < 2)
+					crossed[crossings] = i;
+				++crossings;
+			}
+		}
+		if (crossings == 2)
+		{
+			segments.push_back(makeSegment(row, col, values, elevation, crossed[0], crossed[1]));
+		}
+		else if (crossings == 4)
+		{
+			// Saddle: The mean value decides which corners are connected.
+			auto const center_above = (values[0] + values[1] + values[2] + values[3]) / 4 >= elevation;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (above[i] != center_above)
+					segments.push_back(makeSegment(row, col, values, elevation, (i + 3) % 4, i));
+			}
+		}
+	}
+
+	Segment makeSegment(int row, int col, const double* values, double elevation, int edge0, int edge1) const
+	{
+		Segment segment;
+		setEndPoint(segment, 0, row, col, values, elevation, edge0);
+		setEndPoint(segment, 1, row, col, values, elevation, edge1);
+		return segment;
+	}
+
+	void setEndPoint(Segment& segment, int end, int row, int col, const double* values, double elevation, int edge) const
+	{
+		static const int dx[4] = { 0, 1, 1, 0 };
+		static const int dy[4] = { 0, 0, 1, 1 };
+		auto const a = edge;
+		auto const b = (edge + 1) % 4;
+		auto const t = (elevation - values[a]) / (values[b] - values[a]);
+		segment.coords[end] = QPointF(col + dx[a] + t * (dx[b] - dx[a]),
+		                              row + dy[a] + t * (dy[b] - dy[a]));
+
+		// Horizontal edges have even keys, vertical edges have odd keys.
+		auto const edge_row = quint64(row + (edge == 2 ? 1 : 0));
+		auto const edge_col = quint64(col + (edge == 1 ? 1 : 0));
+		segment.edges[end] = (edge_row * quint64(width) + edge_col) * 2 + ((edge % 2) ? 1 : 0);
+	}
+
+	std::vector<float> samples;  ///< Row-major, NaN for no data
+	int sample_width;
+	int col_offset;
+	int row_offset;
+	int width;                   ///< The width of the whole grid
+	double base;
+	double step;
+	TileSegments& result;
+	QSemaphore& pending;
+};
+
+
+/**
+ * Applies Chaikin's corner cutting to a line.
+ *
+ * The end points of open lines are kept.
+ */
+void smooth(GridLine& line)
+{
+	auto const& coords = line.coords;
+	auto const size = coords.size();
+	if (size < 3)
+		return;
+
+	std::vector<QPointF> smoothed;
+	smoothed.reserve(2 * size);
+	if (line.closed)
+	{
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			auto const& p0 = coords[i];
+			auto const& p1 = coords[(i + 1) % size];
+			smoothed.push_back(0.75 * p0 + 0.25 * p1);
+			smoothed.push_back(0.25 * p0 + 0.75 * p1);
+		}
+	}
+	else
+	{
+		smoothed.push_back(coords.front());
+		for (std::size_t i = 0; i + 1 < size; ++i)
+		{
+			auto const& p0 = coords[i];
+			auto const& p1 = coords[i + 1];
+			if (i > 0)
+				smoothed.push_back(0.75 * p0 + 0.25 * p1);
+			if (i + 2 < size)
+				smoothed.push_back(0.25 * p0 + 0.75 * p1);
+		}
+		smoothed.push_back(coords.back());
+	}
+	line.coords.swap(smoothed);
+}
+
+
+/**
+ * Stitches the segments of a range of levels into lines, and smoothes them.
+ */
+class LevelStitcher : public QRunnable
+{
+public:
+	LevelStitcher(const std::vector<TileSegments>& tiles, int first_level, std::size_t level_begin, std::size_t level_end,
+	              int smoothing, std::vector<std::vector<GridLine>>& result)
+	: tiles(tiles)
+	, first_level(first_level)
+	, level_begin(level_begin)
+	, level_end(level_end)
+	, smoothing(smoothing)
+	, result(result)
+	{}
+
+	void run() override
+	{
+		for (auto level = level_begin; level < level_end; ++level)
+			stitch(level);
+	}
+
+private:
+	void stitch(std::size_t level)
+	{
+		std::vector<const Segment*> segments;
+		auto const tile_level = first_level + int(level);
+		for (const auto& tile : tiles)
+		{
+			auto const index = tile_level - tile.first_level;
+			if (index < 0 || index >= int(tile.levels.size()))
+				continue;
+			for (const auto& segment : tile.levels[std::size_t(index)])
+				segments.push_back(&segment);
+		}
+
+		// Each grid edge is shared by at most two segments.
+		QHash<quint64, std::pair<int, int>> incidences;
+		incidences.reserve(int(2 * segments.size()));
+		for (int i = 0; i < int(segments.size()); ++i)
+		{
+			for (auto edge : segments[std::size_t(i)]->edges)
+			{
+				auto incidence = incidences.find(edge);
+				if (incidence == incidences.end())
+					incidences.insert(edge, { i, -1 });
+				else
+					incidence->second = i;
+			}
+		}
+
+		auto& lines = result[level];
+		std::vector<bool> used(segments.size(), false);
+		auto trace = [&](int first, int start_end) {
+			GridLine line;
+			line.coords.push_back(segments[std::size_t(first)]->coords[start_end]);
+			auto current = first;
+			auto end = start_end;
+			while (true)
+			{
+				used[std::size_t(current)] = true;
+				const auto* segment = segments[std::size_t(current)];
+				auto const next_end = 1 - end;
+				line.coords.push_back(segment->coords[next_end]);
+
+				auto const edge = segment->edges[next_end];
+				auto const& incidence = incidences[edge];
+				auto const next = (incidence.first == current) ? incidence.second : incidence.first;
+				if (next < 0 || used[std::size_t(next)])
+					break;
+				current = next;
+				end = (segments[std::size_t(next)]->edges[0] == edge) ? 0 : 1;
+			}
+			return line;
+		};
+
+		// Open lines start at an edge with a single incidence.
+		for (int i = 0; i < int(segments.size()); ++i)
+		{
+			for (int end = 0; end < 2; ++end)
+			{
+				if (used[std::size_t(i)])
+					break;
+				if (incidences[segments[std::size_t(i)]->edges[end]].second < 0)
+				{
+					lines.push_back(trace(i, end));
+					lines.back().closed = false;
+				}
+			}
+		}
+		// The remaining segments form closed lines.
+		for (int i = 0; i < int(segments.size()); ++i)
+		{
+			if (used[std::size_t(i)])
+				continue;
+			lines.push_back(trace(i, 0));
+			lines.back().coords.pop_back();  // same as the first point
+			lines.back().closed = true;
+		}
+
+		for (auto& line : lines)
+		{
+			auto& coords = line.coords;
+			coords.erase(std::unique(begin(coords), end(coords)), end(coords));
+			if (line.closed && coords.size() > 1 && coords.front() == coords.back())
+				coords.pop_back();
+			for (int i = 0; i < smoothing; ++i)
+				smooth(line);
+		}
+		lines.erase(std::remove_if(begin(lines), end(lines), [](const GridLine& line) {
+			return line.coords.size() < (line.closed ? 3u : 2u);
+		}), end(lines));
+	}
+
+	const std::vector<TileSegments>& tiles;
+	int first_level;
+	std::size_t level_begin;
+	std::size_t level_end;
+	int smoothing;
+	std::vector<std::vector<GridLine>>& result;
+};
+
+
+}  // namespace
+
+
+
+// ### ContourGenerator ###
+
+struct ContourGenerator::Dataset
+{
+	unique_dataset handle;
+	GDALRasterBandH band;
+};
+
+
+ContourGenerator::ContourGenerator(const Options& options)
+: contour_options(options)
+{
+	// nothing else
+}
+
+ContourGenerator::~ContourGenerator()
+{
+	// nothing, not inlined
+}
+
+
+bool ContourGenerator::loadElevationModel(const QString& path)
+{
+	dataset.reset();
+	crs_wkt.clear();
+	grid_width = 0;
+	grid_height = 0;
+
+	GdalManager();
+	auto handle = unique_dataset(GDALOpen(QFile::encodeName(path).constData(), GA_ReadOnly));
+	if (!handle)
+	{
+		error_string = tr("Cannot open file\n%1:\n%2").arg(path, QString::fromUtf8(CPLGetLastErrorMsg()));
+		return false;
+	}
+
+	auto band = GDALGetRasterBand(handle.get(), 1);
+	if (!band)
+	{
+		error_string = tr("The file does not contain raster data.");
+		return false;
+	}
+
+	auto const width = GDALGetRasterBandXSize(band);
+	auto const height = GDALGetRasterBandYSize(band);
+	if (width < 2 || height < 2)
+	{
+		error_string = tr("The elevation model is too small.");
+		return false;
+	}
+
+	double transform[6];
+	if (GDALGetGeoTransform(handle.get(), transform) == CE_None)
+		std::copy(transform, transform + 6, geo_transform);
+
+	auto has_no_data_value = 0;
+	no_data = GDALGetRasterNoDataValue(band, &has_no_data_value);
+	has_no_data = has_no_data_value != 0;
+
+	crs_wkt = QByteArray(GDALGetProjectionRef(handle.get()));
+
+	dataset.reset(new Dataset{ std::move(handle), band });
+	grid_width = width;
+	grid_height = height;
+	return true;
+}
+
+
+std::vector<ContourGenerator::ContourLine> ContourGenerator::generate()
+{
+	std::vector<ContourLine> result;
+	error_string.clear();
+	if (!dataset || !(contour_options.interval > 0))
+		return result;
+
+	auto const base = contour_options.base;
+	auto const step = levelStep();
+	auto const num_cell_cols = grid_width - 1;
+	auto const num_cell_rows = grid_height - 1;
+	auto const tiles_x = (num_cell_cols + tile_cells - 1) / tile_cells;
+	auto const tiles_y = (num_cell_rows + tile_cells - 1) / tile_cells;
+	std::vector<TileSegments> tiles(std::size_t(tiles_x) * std::size_t(tiles_y));
+	{
+		// Limits the number of tiles which are held in memory.
+		QSemaphore pending(2 * std::max(1, QThread::idealThreadCount()));
+		QThreadPool pool;
+		for (std::size_t i = 0; i < tiles.size(); ++i)
+		{
+			auto const col_offset = int(i % std::size_t(tiles_x)) * tile_cells;
+			auto const row_offset = int(i / std::size_t(tiles_x)) * tile_cells;
+			// One more sample than cells, shared with the next tile.
+			auto const cols = std::min(tile_cells, num_cell_cols - col_offset) + 1;
+			auto const rows = std::min(tile_cells, num_cell_rows - row_offset) + 1;
+
+			pending.acquire();
+			std::vector<float> samples(std::size_t(cols) * std::size_t(rows));
+			if (GDALRasterIO(dataset->band, GF_Read, col_offset, row_offset, cols, rows,
+			                 samples.data(), cols, rows, GDT_Float32, 0, 0) != CE_None)
+			{
+				error_string = tr("Cannot read the elevation model:\n%1").arg(QString::fromUtf8(CPLGetLastErrorMsg()));
+				pool.waitForDone();
+				return result;
+			}
+			if (has_no_data)
+				std::replace(begin(samples), end(samples), float(no_data), std::numeric_limits<float>::quiet_NaN());
+
+			pool.start(new TileTracer(std::move(samples), cols, col_offset, row_offset, grid_width,
+			                          base, step, tiles[i], pending));
+		}
+		pool.waitForDone();
+	}
+
+	auto first_level = std::numeric_limits<int>::max();
+	auto last_level = std::numeric_limits<int>::min();
+	for (const auto& tile : tiles)
+	{
+		if (tile.levels.empty())
+			continue;
+		first_level = std::min(first_level, tile.first_level);
+		last_level = std::max(last_level, tile.first_level + int(tile.levels.size()) - 1);
+	}
+	if (first_level > last_level)
+		return result;
+
+	auto const num_levels = std::size_t(last_level - first_level + 1);
+	std::vector<std::vector<GridLine>> lines(num_levels);
+	{
+		QThreadPool pool;
+		for (std::size_t i = 0; i < num_levels; i += level_chunk_size)
+		{
+			auto const level_end = std::min(i + level_chunk_size, num_levels);
+			pool.start(new LevelStitcher(tiles, first_level, i, level_end, contour_options.smoothing, lines));
+		}
+		pool.waitForDone();
+	}
+
+	for (std::size_t i = 0; i < num_levels; ++i)
+	{
+		auto const level = first_level + int(i);
+		for (auto& grid_line : lines[i])
+		{
+			ContourLine line;
+			line.elevation = base + level * step;
+			line.type = contourType(level);
+			line.closed = grid_line.closed;
+			line.coords.reserve(grid_line.coords.size());
+			for (const auto& pos : grid_line.coords)
+				line.coords.push_back(projectedCoords(pos.x(), pos.y()));
+			result.push_back(std::move(line));
+		}
+	}
+	return result;
+}
+
+
+MapPart* ContourGenerator::addToMap(Map& map, const QString& part_name)
+{
+	if (!contour_options.contour_symbol)
+	{
+		error_string = tr("No symbol selected for contours.");
+		return nullptr;
+	}
+	if (!dataset)
+	{
+		error_string = tr("No elevation model loaded.");
+		return nullptr;
+	}
+
+	const auto& georef = map.getGeoreferencing();
+	auto transformation = ogr::unique_transformation { nullptr };
+	if (!crs_wkt.isEmpty() && georef.isValid() && !georef.isLocal())
+	{
+		auto dem_srs = ogr::unique_srs { OSRNewSpatialReference(crs_wkt.constData()) };
+		auto map_srs = ogr::unique_srs { OSRNewSpatialReference(nullptr) };
+		OSRSetProjCS(map_srs.get(), "Projected map SRS");
+		OSRSetWellKnownGeogCS(map_srs.get(), "WGS84");
+		auto const spec = QByteArray(georef.getProjectedCRSSpec().toLatin1() + " +wktext");
+		if (OSRImportFromProj4(map_srs.get(), spec.constData()) != OGRERR_NONE)
+		{
+			error_string = tr("Unable to setup \"%1\" SRS for GDAL.").arg(georef.getProjectedCRSSpec());
+			return nullptr;
+		}
+		if (!OSRIsSame(dem_srs.get(), map_srs.get()))
+		{
+			transformation.reset(OCTNewCoordinateTransformation(dem_srs.get(), map_srs.get()));
+			if (!transformation)
+			{
+				error_string = tr("Cannot transform the coordinates of the elevation model to the coordinate reference system of the map.");
+				return nullptr;
+			}
+		}
+	}
+
+	auto lines = generate();
+	if (lines.empty() && !error_string.isEmpty())
+		return nullptr;
+
+	if (transformation)
+	{
+		// Lines which cannot be transformed are dropped.
+		std::vector<double> xs;
+		std::vector<double> ys;
+		lines.erase(std::remove_if(begin(lines), end(lines), [&](ContourLine& line) {
+			auto& coords = line.coords;
+			xs.resize(coords.size());
+			ys.resize(coords.size());
+			for (std::size_t i = 0; i < coords.size(); ++i)
+			{
+				xs[i] = coords[i].x();
+				ys[i] = coords[i].y();
+			}
+			if (!OCTTransform(transformation.get(), int(coords.size()), xs.data(), ys.data(), nullptr))
+				return true;
+			for (std::size_t i = 0; i < coords.size(); ++i)
+				coords[i] = { xs[i], ys[i] };
+			return false;
+		}), end(lines));
+	}
+
+	auto part = new MapPart(part_name, &map);
+	auto const part_index = map.getCurrentPartIndex() + 1;
+	map.addPart(part, part_index);
+	map.setCurrentPart(part);
+
+	auto delete_step = new DeleteObjectsUndoStep(&map);
+	for (const auto& line : lines)
+	{
+		const Symbol* symbol = nullptr;
+		switch (line.type)
+		{
+		case FormLine:
+			symbol = contour_options.form_line_symbol;
+			break;
+		case Contour:
+			symbol = contour_options.contour_symbol;
+			break;
+		case IndexContour:
+			symbol = contour_options.index_symbol ? contour_options.index_symbol : contour_options.contour_symbol;
+			break;
+		}
+		if (!symbol)
+			continue;
+
+		MapCoordVector coords;
+		coords.reserve(line.coords.size());
+		for (const auto& pos : line.coords)
+			coords.emplace_back(georef.toMapCoordF(pos));
+
+		auto object = new PathObject(symbol, coords, &map);
+		if (line.closed)
+			object->closeAllParts();
+		delete_step->addObject(map.addObject(object, int(part_index)));
+	}
+
+	// Undo deletes the objects first, then removes the part.
+	auto undo_step = new CombinedUndoStep(&map);
+	undo_step->push(new MapPartUndoStep(&map, MapPartUndoStep::RemoveMapPart, part));
+	undo_step->push(delete_step);
+	map.push(undo_step);
+	map.setObjectsDirty();
+
+	return part;
+}
+
+
+double ContourGenerator::levelStep() const
+{
+	return contour_options.form_line_symbol ? contour_options.interval / 2 : contour_options.interval;
+}
+
+
+ContourGenerator::ContourType ContourGenerator::contourType(int level) const
+{
+	if (contour_options.form_line_symbol)
+	{
+		if (level % 2 != 0)
+			return FormLine;
+		level /= 2;
+	}
+	if (contour_options.index_interval > 0 && level % contour_options.index_interval == 0)
+		return IndexContour;
+	return Contour;
+}
+
+
+QPointF ContourGenerator::projectedCoords(double column, double row) const
+{
+	// The geo transform refers to the outer corner of the first pixel,
+	// the elevations to the pixel centers.
+	auto const x = column + 0.5;
+	auto const y = row + 0.5;
+	return { geo_transform[0] + x * geo_transform[1] + y * geo_transform[2],
+	         geo_transform[3] + x * geo_transform[4] + y * geo_transform[5] };
+}
+
+
+}  // namespace OpenOrienteering
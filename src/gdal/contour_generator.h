@@ -0,0 +1,174 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_CONTOUR_GENERATOR_H
+#define OPENORIENTEERING_CONTOUR_GENERATOR_H
+
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QPointF>
+#include <QString>
+
+namespace OpenOrienteering {
+
+class Map;
+class MapPart;
+class Symbol;
+
+
+/**
+ * Generates contour lines from a digital elevation model (DEM).
+ *
+ * The DEM is read through GDAL in tiles which share one row and column of
+ * samples with their neighbours. Contours are traced with marching squares
+ * on these tiles concurrently, while the next tiles are read. So the DEM
+ * is never held in memory as a whole. The segments are stitched into lines
+ * via the shared cell edges, smoothed, and classified as index contours,
+ * normal contours, or form lines.
+ *
+ * When both the DEM and the map have got a CRS, the contours are transformed
+ * to the map's projected CRS. Otherwise the coordinates of the DEM are taken
+ * as projected coordinates of the map's georeferencing.
+ */
+class ContourGenerator
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::ContourGenerator)
+
+public:
+	/** The classification of a contour line. */
+	enum ContourType
+	{
+		FormLine,
+		Contour,
+		IndexContour
+	};
+
+	/** Options for contour generation. */
+	struct Options
+	{
+		double interval = 5.0;     ///< The contour interval, in DEM units.
+		double base = 0.0;         ///< The reference elevation for contours and index contours.
+		int index_interval = 5;    ///< Every n-th contour is an index contour.
+		int smoothing = 2;         ///< The number of smoothing iterations.
+		const Symbol* contour_symbol = nullptr;
+		const Symbol* index_symbol = nullptr;      ///< Optional, defaults to the contour symbol.
+		const Symbol* form_line_symbol = nullptr;  ///< Optional, enables form lines at half the interval.
+	};
+
+	/** A contour line in projected coordinates. */
+	struct ContourLine
+	{
+		double elevation;
+		ContourType type;
+		std::vector<QPointF> coords;
+		bool closed;
+	};
+
+
+	/** Constructs a new generator. */
+	explicit ContourGenerator(const Options& options);
+
+	ContourGenerator(const ContourGenerator&) = delete;
+	ContourGenerator& operator=(const ContourGenerator&) = delete;
+
+	/** Destructor. */
+	~ContourGenerator();
+
+
+	/** Returns the options. */
+	const Options& options() const { return contour_options; }
+
+	/** Returns a description of the last error. */
+	const QString& errorString() const { return error_string; }
+
+
+	/**
+	 * Opens the first band of a raster file supported by GDAL.
+	 *
+	 * The file remains open until another file is loaded, or until the
+	 * generator is destroyed. Returns false on error.
+	 */
+	bool loadElevationModel(const QString& path);
+
+	/** Returns the number of columns of the elevation grid. */
+	int width() const { return grid_width; }
+
+	/** Returns the number of rows of the elevation grid. */
+	int height() const { return grid_height; }
+
+
+	/** Returns the WKT of the elevation model's CRS, or an empty string. */
+	const QByteArray& crsWkt() const { return crs_wkt; }
+
+
+	/**
+	 * Traces, stitches, smoothes and classifies the contour lines.
+	 *
+	 * The result is ordered by elevation. The coordinates are projected
+	 * coordinates, as defined by the elevation model's geo transform.
+	 * Returns an empty list on error.
+	 */
+	std::vector<ContourLine> generate();
+
+	/**
+	 * Generates the contours and adds them to a new part of the given map.
+	 *
+	 * The objects use the symbols from the options. Contour types without a
+	 * symbol are skipped. The new part becomes the current part, and the
+	 * change is pushed to the map's undo manager as a single step.
+	 *
+	 * If the CRS of the elevation model differs from the map's projected CRS,
+	 * the contours are transformed. Lines which cannot be transformed are
+	 * skipped. It is an error if there is no transformation between the CRS.
+	 *
+	 * Returns the new part, or nullptr on error.
+	 */
+	MapPart* addToMap(Map& map, const QString& part_name);
+
+private:
+	/** Returns the geometric level step, i.e. half the interval with form lines. */
+	double levelStep() const;
+
+	/** Returns the type of the contour at the given multiple of the level step. */
+	ContourType contourType(int level) const;
+
+	/** Returns the projected coordinates for the given grid coordinates. */
+	QPointF projectedCoords(double column, double row) const;
+
+
+	struct Dataset;
+
+	Options contour_options;
+	QString error_string;
+	std::unique_ptr<Dataset> dataset;
+	QByteArray crs_wkt;
+	int grid_width = 0;
+	int grid_height = 0;
+	double no_data = 0.0;
+	bool has_no_data = false;
+	double geo_transform[6] = { 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };  ///< As in GDAL
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2016-2017 Kai Pastor
+ *    Copyright 2016-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -50,7 +50,8 @@ public:
 	GdalManagerPrivate()
 	: dirty{ true }
 	{
-		// GDAL 2.0: GDALAllRegister();
+		// GDAL 2.0: GDALAllRegister() is sufficient.
+		GDALAllRegister();
 		OGRRegisterAll();
 	}
 	
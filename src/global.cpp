@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013, 2014 Thomas Schöps
- *    Copyright 2012-2017 Kai Pastor
+ *    Copyright 2012-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -24,6 +24,7 @@
 #include "mapper_config.h" // IWYU pragma: keep
 
 #include "fileformats/file_format_registry.h"
+#include "fileformats/file_import_export.h"
 #include "fileformats/native_file_format.h"
 #include "fileformats/xml_file_format.h"
 #include "fileformats/ocd_file_format.h"
@@ -38,6 +39,8 @@ void doStaticInitializations()
 	FileFormats.registerFormat(new XMLFileFormat());
 #ifndef MAPPER_BIG_ENDIAN
 	FileFormats.registerFormat(new OcdFileFormat());
+	FileFormats.registerFormat(new OcdFileFormat("OCD12", ::OpenOrienteering::ImportExport::tr("OCAD version 12"), 12));
+	FileFormats.registerFormat(new OcdFileFormat("OCD11", ::OpenOrienteering::ImportExport::tr("OCAD version 11"), 11));
 #endif
 #ifdef MAPPER_USE_GDAL
 	FileFormats.registerFormat(new OgrFileFormat());
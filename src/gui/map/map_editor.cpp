@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2017 Kai Pastor
+ *    Copyright 2012-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -47,6 +47,7 @@
 #include <QDockWidget>
 #include <QEvent>
 #include <QFile>
+#include <QFileDialog>
 #include <QFileInfo>
 #include <QFlags>
 #include <QFont>
@@ -104,17 +105,20 @@
 #include "core/objects/boolean_tool.h"
 #include "core/objects/object.h"
 #include "core/objects/object_operations.h"
+#include "core/selection_statistics.h"
 #include "core/symbols/point_symbol.h"
 #include "core/symbols/area_symbol.h"
 #include "core/symbols/symbol.h"
 #include "core/symbols/symbol_icon_decorator.h"
 #include "fileformats/file_format.h"
 #include "fileformats/file_format_registry.h"
+#include "fileformats/vector_tile_export.h"
 #include "gui/configure_grid_dialog.h"
 #include "gui/file_dialog.h"
 #include "gui/georeferencing_dialog.h"
 #include "gui/main_window.h"
 #include "gui/print_widget.h"
+#include "gui/task_progress_dialog.h"
 #include "gui/text_browser_dialog.h"
 #include "gui/util_gui.h"
 #include "gui/map/map_dialog_rotate.h"
@@ -127,6 +131,7 @@
 #include "gui/widgets/color_list_widget.h"
 #include "gui/widgets/compass_display.h"
 #include "gui/widgets/key_button_bar.h" // IWYU pragma: keep
+#include "gui/widgets/map_validator_widget.h"
 #include "gui/widgets/measure_widget.h"
 #include "gui/widgets/symbol_widget.h"
 #include "gui/widgets/tags_widget.h"
@@ -215,6 +220,28 @@ namespace {
 		});
 	}
 	
+	/**
+	 * Runs a boolean operation on the selected objects, showing a progress
+	 * dialog if the operation takes some time.
+	 * 
+	 * Returns false if the operation failed or didn't change the map.
+	 * Returns true if the map was changed, or if the user canceled the
+	 * operation.
+	 */
+	bool runBooleanTask(BooleanTool::Operation op, BooleanTask::Mode mode, Map* map, QWidget* parent)
+	{
+		BooleanTask task(op, map, mode);
+		switch (TaskProgressDialog::run(task, ::OpenOrienteering::MapEditorController::tr("Processing..."), parent))
+		{
+		case BackgroundTask::Canceled:
+			return true;
+		case BackgroundTask::Finished:
+			return task.hasChanges();
+		default:
+			return false;
+		}
+	}
+	
 	
 }  // namespace
 
@@ -276,6 +303,7 @@ MapEditorController::MapEditorController(OperatingMode mode, Map* map, MapView*
 	toolbar_advanced_editing = nullptr;
 	print_dock_widget = nullptr;
 	measure_dock_widget = nullptr;
+	validator_dock_widget = nullptr;
 	symbol_dock_widget = nullptr;
 	
 	statusbar_zoom_frame = nullptr;
@@ -305,6 +333,7 @@ MapEditorController::~MapEditorController()
 	delete toolbar_mapparts;
 	delete print_dock_widget;
 	delete measure_dock_widget;
+	delete validator_dock_widget;
 	if (color_dock_widget)
 		delete color_dock_widget;
 	delete symbol_dock_widget;
@@ -600,6 +629,7 @@ void MapEditorController::attach(MainWindow* window)
 {
 	print_dock_widget = nullptr;
 	measure_dock_widget = nullptr;
+	validator_dock_widget = nullptr;
 	color_dock_widget = nullptr;
 	symbol_dock_widget = nullptr;
 	std::function<void(const QString&)> zoom_display_function;
@@ -854,6 +884,7 @@ void MapEditorController::createActions()
 	export_image_act = nullptr;
 	export_pdf_act = nullptr;
 #endif
+	export_vector_tiles_act = newAction("export-vector-tiles", tr("&Vector tiles..."), this, SLOT(exportVectorTiles()), nullptr, QString{}, "file_menu.html");
 	
 	undo_act = newAction("undo", tr("Undo"), this, SLOT(undo()), "undo.png", tr("Undo the last step"), "edit_menu.html");
 	redo_act = newAction("redo", tr("Redo"), this, SLOT(redo()), "redo.png", tr("Redo the last step"), "edit_menu.html");
@@ -938,6 +969,7 @@ void MapEditorController::createActions()
 	rotate_pattern_act = newToolAction("rotatepatterns", tr("Rotate pattern"), this, SLOT(rotatePatternClicked()), "tool-rotate-pattern.png", QString{}, "toolbars.html#tool_rotate_pattern");
 	scale_act = newToolAction("scaleobjects", tr("Scale objects"), this, SLOT(scaleClicked()), "tool-scale.png", QString{}, "toolbars.html#scale");
 	measure_act = newCheckAction("measure", tr("Measure lengths and areas"), this, SLOT(measureClicked(bool)), "tool-measure.png", QString{}, "toolbars.html#measure");
+	validate_map_act = newCheckAction("validatemap", tr("Validate map"), this, SLOT(validateMapClicked(bool)), nullptr, QString{}, nullptr);
 	boolean_union_act = newAction("booleanunion", tr("Unify areas"), this, SLOT(booleanUnionClicked()), "tool-boolean-union.png", QString{}, "toolbars.html#unify_areas");
 	boolean_intersection_act = newAction("booleanintersection", tr("Intersect areas"), this, SLOT(booleanIntersectionClicked()), "tool-boolean-intersection.png", QString{}, "toolbars.html#intersect_areas");
 	boolean_difference_act = newAction("booleandifference", tr("Cut away from area"), this, SLOT(booleanDifferenceClicked()), "tool-boolean-difference.png", QString{}, "toolbars.html#area_difference");
@@ -1025,12 +1057,13 @@ void MapEditorController::createMenuAndToolbars()
 	insertion_act = print_act;
 #endif
 	file_menu->insertAction(insertion_act, import_act);
-#ifdef QT_PRINTSUPPORT_LIB
 	QMenu* export_menu = new QMenu(tr("&Export as..."), file_menu);
+#ifdef QT_PRINTSUPPORT_LIB
 	export_menu->addAction(export_image_act);
 	export_menu->addAction(export_pdf_act);
-	file_menu->insertMenu(insertion_act, export_menu);
 #endif
+	export_menu->addAction(export_vector_tiles_act);
+	file_menu->insertMenu(insertion_act, export_menu);
 	file_menu->insertSeparator(insertion_act);
 		
 	// Edit menu
@@ -1111,6 +1144,7 @@ void MapEditorController::createMenuAndToolbars()
 	tools_menu->addAction(rotate_pattern_act);
 	tools_menu->addAction(scale_act);
 	tools_menu->addAction(measure_act);
+	tools_menu->addAction(validate_map_act);
 	tools_menu->addAction(convert_to_curves_act);
 	tools_menu->addAction(simplify_path_act);
 	tools_menu->addAction(cutout_physical_act);
@@ -1607,6 +1641,27 @@ void MapEditorController::printClicked(int task)
 #endif
 }
 
+void MapEditorController::exportVectorTiles()
+{
+	auto const directory = QFileDialog::getExistingDirectory(window, tr("Export vector tiles"));
+	if (directory.isEmpty())
+		return;
+	
+	VectorTileExportTask task(*map, VectorTileExport::defaultOptions(*map), directory);
+	auto const state = TaskProgressDialog::run(task, tr("Exporting vector tiles..."), window);
+	if (state == BackgroundTask::Failed)
+	{
+		QMessageBox::warning(window, tr("Error"), task.errorString());
+	}
+	else if (state == BackgroundTask::Finished && !task.warnings().empty())
+	{
+		QStringList messages;
+		for (const auto& warning : task.warnings())
+			messages.append(warning);
+		QMessageBox::warning(window, tr("Warning"), messages.join(QLatin1Char('\n')));
+	}
+}
+
 void MapEditorController::undo()
 {
 	doUndo(false);
@@ -2199,23 +2254,10 @@ void MapEditorController::objectSelectionChanged()
 	// Automatic symbol selection of selected objects
 	if (symbol_widget && !editing_in_progress)
 	{
-		bool uniform_symbol_selected = true;
-		const Symbol* uniform_symbol = nullptr;
-		for (const auto object : map->selectedObjects())
-		{
-			const auto symbol = object->getSymbol();
-			if (!uniform_symbol)
-			{
-				uniform_symbol = symbol;
-			}
-			else if (uniform_symbol != symbol)
-			{
-				uniform_symbol_selected = false;
-				break;
-			}
-		}
+		const auto& statistics = map->selectionStatistics();
+		bool uniform_symbol_selected = statistics.symbolCounts().size() <= 1;
 		if (uniform_symbol_selected && Settings::getInstance().getSettingCached(Settings::MapEditor_ChangeSymbolWhenSelecting).toBool())
-			symbol_widget->selectSingleSymbol(uniform_symbol);
+			symbol_widget->selectSingleSymbol(statistics.uniformSymbol());
 	}
 	
 	updateSymbolAndObjectDependentActions();
@@ -2248,81 +2290,38 @@ void MapEditorController::updateObjectDependentActions()
 	bool have_multiple_parts     = map->getNumParts() > 1;
 	bool have_selection          = map->getNumSelectedObjects() > 0 && !editing_in_progress;
 	bool single_object_selected  = map->getNumSelectedObjects() == 1 && !editing_in_progress;
-	bool have_line               = false;
-	bool have_area               = false;
-	bool have_area_with_holes    = false;
-	bool have_rotatable_pattern  = false;
-	bool have_rotatable_point    = false;
-	int  num_selected_paths      = 0;
 	bool first_selected_is_path  = have_selection && map->getFirstSelectedObject()->getType() == Object::Path;
-	bool uniform_symbol_selected = true;
-	const Symbol* uniform_symbol = nullptr;
 	const Symbol* first_selected_symbol= have_selection ? map->getFirstSelectedObject()->getSymbol() : nullptr;
-	std::vector< bool > symbols_in_selection(map->getNumSymbols(), false);
 	
-	if (!editing_in_progress)
+	const auto& statistics = map->selectionStatistics();
+	bool have_line               = !editing_in_progress && statistics.contains(SelectionStatistics::Line);
+	bool have_area               = !editing_in_progress && statistics.contains(SelectionStatistics::Area);
+	bool have_area_with_holes    = !editing_in_progress && statistics.contains(SelectionStatistics::AreaWithHoles);
+	bool have_rotatable_pattern  = !editing_in_progress && statistics.contains(SelectionStatistics::RotatablePattern);
+	bool have_rotatable_point    = !editing_in_progress && statistics.contains(SelectionStatistics::RotatablePoint);
+	int  num_selected_paths      = editing_in_progress ? 0 : statistics.count(SelectionStatistics::Path);
+	
+	if (have_area && !have_rotatable_pattern)
 	{
-		for (const auto object : map->selectedObjects())
+		// Combined symbols may contain area symbols with rotatable patterns.
+		std::vector< bool > symbols_in_selection(map->getNumSymbols(), false);
+		for (auto it = statistics.symbolCounts().begin(), end = statistics.symbolCounts().end(); it != end; ++it)
 		{
-			const auto symbol = object->getSymbol();
-			int symbol_index = map->findSymbolIndex(symbol);
+			int symbol_index = map->findSymbolIndex(it.key());
 			if (symbol_index >= 0 && symbol_index < (int)symbols_in_selection.size())
 				symbols_in_selection[symbol_index] = true;
-			
-			if (uniform_symbol_selected)
-			{
-				if (!uniform_symbol)
-				{
-					uniform_symbol = symbol;
-				}
-				else if (uniform_symbol != symbol)
-				{
-					uniform_symbol = nullptr;
-					uniform_symbol_selected = false;
-				}
-			}
-			
-			if (symbol->getType() == Symbol::Point)
-			{
-				have_rotatable_point |= symbol->asPoint()->isRotatable();
-			}
-			else if (Symbol::areTypesCompatible(symbol->getType(), Symbol::Area))
-			{
-				++num_selected_paths;
-				
-				if (symbol->getType() == Symbol::Area)
-				{
-					have_rotatable_pattern |= symbol->asArea()->hasRotatableFillPattern();
-				}
-				
-				int const contained_types = symbol->getContainedTypes();
-				
-				if (contained_types & Symbol::Line)
-				{
-					have_line = true;
-				}
-				
-				if (contained_types & Symbol::Area)
-				{
-					have_area = true;
-					have_area_with_holes |= object->asPath()->parts().size() > 1;
-				}
-			}
 		}
 		
-		if (have_area && !have_rotatable_pattern)
+		map->determineSymbolUseClosure(symbols_in_selection);
+		for (std::size_t i = 0, end = symbols_in_selection.size(); i < end; ++i)
 		{
-			map->determineSymbolUseClosure(symbols_in_selection);
-			for (std::size_t i = 0, end = symbols_in_selection.size(); i < end; ++i)
+			if (symbols_in_selection[i])
 			{
-				if (symbols_in_selection[i])
+				Symbol* symbol = map->getSymbol(i);
+				if (symbol->getType() == Symbol::Area)
 				{
-					Symbol* symbol = map->getSymbol(i);
-					if (symbol->getType() == Symbol::Area)
-					{
-						have_rotatable_pattern = symbol->asArea()->hasRotatableFillPattern();
-						break;
-					}
+					have_rotatable_pattern = symbol->asArea()->hasRotatableFillPattern();
+					break;
 				}
 			}
 		}
@@ -3107,27 +3106,42 @@ void MapEditorController::measureClicked(bool checked)
 	measure_dock_widget->setVisible(checked);
 }
 
+void MapEditorController::validateMapClicked(bool checked)
+{
+	if (!validator_dock_widget)
+	{
+		validator_dock_widget = new EditorDockWidget(tr("Map Validation"), validate_map_act, this, window);
+		validator_dock_widget->toggleViewAction()->setVisible(false);
+		auto validator_widget = new MapValidatorWidget(this);
+		validator_dock_widget->setWidget(validator_widget);
+		validator_dock_widget->setObjectName(QString::fromLatin1("Map validation dock widget"));
+		addFloatingDockWidget(validator_dock_widget);
+	}
+	
+	validator_dock_widget->setVisible(checked);
+}
+
 void MapEditorController::booleanUnionClicked()
 {
-	if (!BooleanTool(BooleanTool::Union, map).executePerSymbol())
+	if (!runBooleanTask(BooleanTool::Union, BooleanTask::PerSymbol, map, window))
 		QMessageBox::warning(window, tr("Error"), tr("Unification failed."));
 }
 
 void MapEditorController::booleanIntersectionClicked()
 {
-	if (!BooleanTool(BooleanTool::Intersection, map).execute())
+	if (!runBooleanTask(BooleanTool::Intersection, BooleanTask::SelectedObjects, map, window))
 		QMessageBox::warning(window, tr("Error"), tr("Intersection failed."));
 }
 
 void MapEditorController::booleanDifferenceClicked()
 {
-	if (!BooleanTool(BooleanTool::Difference, map).execute())
+	if (!runBooleanTask(BooleanTool::Difference, BooleanTask::SelectedObjects, map, window))
 		QMessageBox::warning(window, tr("Error"), tr("Difference failed."));
 }
 
 void MapEditorController::booleanXOrClicked()
 {
-	if (!BooleanTool(BooleanTool::XOr, map).execute())
+	if (!runBooleanTask(BooleanTool::XOr, BooleanTask::SelectedObjects, map, window))
 		QMessageBox::warning(window, tr("Error"), tr("XOr failed."));
 }
 
@@ -3136,7 +3150,7 @@ void MapEditorController::booleanMergeHolesClicked()
 	if (map->getNumSelectedObjects() != 1)
 		return;
 	
-	if (!BooleanTool(BooleanTool::MergeHoles, map).execute())
+	if (!runBooleanTask(BooleanTool::MergeHoles, BooleanTask::SelectedObjects, map, window))
 		QMessageBox::warning(window, tr("Error"), tr("Merging holes failed."));
 }
 
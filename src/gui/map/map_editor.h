@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013, 2014 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -259,6 +259,11 @@ public slots:
 	 */
 	void printClicked(int task);
 	
+	/**
+	 * Asks for a directory, and exports the map as a pyramid of vector tiles.
+	 */
+	void exportVectorTiles();
+	
 	/** Undoes the last object edit step. */
 	void undo();
 	/** Redoes the last object edit step */
@@ -431,6 +436,8 @@ public slots:
 	void scaleClicked();
 	/** Shows or hides the MeasureWidget */
 	void measureClicked(bool checked);
+	/** Shows or hides the MapValidatorWidget */
+	void validateMapClicked(bool checked);
 	/** Calculates the union of selected same-symbol area objects */
 	void booleanUnionClicked();
 	/** Calculates the intersection of selected same-symbol area objects */
@@ -628,6 +635,7 @@ private:
 	QAction* print_act;
 	QAction* export_image_act;
 	QAction* export_pdf_act;
+	QAction* export_vector_tiles_act;
 	
 	QAction* undo_act;
 	QAction* redo_act;
@@ -711,6 +719,8 @@ private:
 	QAction* scale_act;
 	QAction* measure_act;
 	EditorDockWidget* measure_dock_widget;
+	QAction* validate_map_act;
+	EditorDockWidget* validator_dock_widget;
 	QAction* boolean_union_act;
 	QAction* boolean_intersection_act;
 	QAction* boolean_difference_act;
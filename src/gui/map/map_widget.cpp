@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,12 +21,15 @@
 
 #include "map_widget.h"
 
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <stdexcept>
 
 #include <QApplication>
 #include <QColor>
 #include <QContextMenuEvent>
+#include <QElapsedTimer>
 #include <QEvent>
 #include <QFlags>
 #include <QFont>
@@ -36,6 +39,7 @@
 #include <QLatin1String>
 #include <QList>
 #include <QLocale>
+#include <QLoggingCategory>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPaintEvent>
@@ -53,9 +57,11 @@
 #include "core/georeferencing.h"
 #include "core/latlon.h"
 #include "core/map.h"
+#include "core/map_part.h"
 #include "core/renderables/renderable.h"
 #include "gui/touch_cursor.h"
 #include "gui/map/map_editor_activity.h"
+#include "gui/map/object_pick_buffer.h"
 #include "gui/widgets/action_grid_bar.h"
 #include "gui/widgets/key_button_bar.h"
 #include "gui/widgets/pie_menu.h"
@@ -72,6 +78,19 @@ class QGesture;
 
 namespace OpenOrienteering {
 
+namespace {
+
+/**
+ * Logs the time of map cache updates.
+ * 
+ * Enable with QT_LOGGING_RULES="mapper.mapwidget.cache.debug=true".
+ */
+Q_LOGGING_CATEGORY(lcMapCache, "mapper.mapwidget.cache", QtWarningMsg)
+
+}  // namespace
+
+
+
 MapWidget::MapWidget(bool show_help, bool force_antialiasing, QWidget* parent)
  : QWidget(parent)
  , view(nullptr)
@@ -105,6 +124,10 @@ MapWidget::MapWidget(bool show_help, bool force_antialiasing, QWidget* parent)
 	setMouseTracking(true);
 	setFocusPolicy(Qt::ClickFocus);
 	setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
+	
+	full_quality_timer.setSingleShot(true);
+	full_quality_timer.setInterval(300);
+	connect(&full_quality_timer, &QTimer::timeout, this, &MapWidget::restoreFullQuality);
 }
 
 MapWidget::~MapWidget()
@@ -118,27 +141,31 @@ void MapWidget::setMapView(MapView* view)
 	{
 		if (this->view)
 		{
-			auto map = view->getMap();
+			auto map = this->view->getMap();
 			map->removeMapWidget(this);
 			
 			disconnect(this->view, &MapView::viewChanged, this, &MapWidget::viewChanged);
 			disconnect(this->view, &MapView::panOffsetChanged, this, &MapWidget::setPanOffset);
-			disconnect(this->view, &MapView::visibilityChanged, this, &MapWidget::updateEverything);
+			disconnect(this->view, &MapView::visibilityChanged, this, &MapWidget::onVisibilityChanged);
+			disconnect(map, &Map::templateDeleted, this, &MapWidget::onTemplateDeleted);
 		}
 		
 		this->view = view;
+		rotated_caches = view && view->getRotation() != 0;
+		releaseCaches();
 		
 		if (view)
 		{
 			connect(this->view, &MapView::viewChanged, this, &MapWidget::viewChanged);
 			connect(this->view, &MapView::panOffsetChanged, this, &MapWidget::setPanOffset);
-			connect(this->view, &MapView::visibilityChanged, this, &MapWidget::updateEverything);
+			connect(this->view, &MapView::visibilityChanged, this, &MapWidget::onVisibilityChanged);
 			
 			auto map = this->view->getMap();
 			map->addMapWidget(this);
+			connect(map, &Map::templateDeleted, this, &MapWidget::onTemplateDeleted);
 		}
 		
-		update();
+		updateEverything();
 	}
 }
 
@@ -149,6 +176,7 @@ void MapWidget::setTool(MapEditorTool* tool)
 		&& (this->tool->usesTouchCursor() || tool->usesTouchCursor()));
 
 	this->tool = tool;
+	setObjectPickingEnabled(tool && tool->usesObjectPicking());
 	
 	if (tool)
 		setCursor(tool->getCursor());
@@ -178,6 +206,39 @@ void MapWidget::setGesturesEnabled(bool enabled)
 }
 
 
+void MapWidget::setObjectPickingEnabled(bool enabled)
+{
+	if (enabled == objectPickingEnabled())
+		return;
+	
+	if (enabled)
+	{
+		object_pick_buffer.reset(new ObjectPickBuffer());
+		object_pick_buffer->markDirty(cacheRect());
+		update();
+	}
+	else
+	{
+		object_pick_buffer.reset();
+	}
+}
+
+
+bool MapWidget::findObjectCandidatesAt(MapCoordF position, qreal radius, std::vector<Object*>& out) const
+{
+	if (!object_pick_buffer || !view || map_cache_dirty_rect.isValid())
+		return false;
+	
+	// Hatched and baseline areas do not cover the area of the object.
+	auto map = view->getMap();
+	if (map->isAreaHatchingEnabled() || map->isBaselineViewEnabled())
+		return false;
+	
+	auto const pos = viewToCache().map(view->mapToView(position)).toPoint();
+	return object_pick_buffer->findCandidates(*map->getCurrentPart(), pos, int(std::ceil(radius)), out);
+}
+
+
 void MapWidget::applyMapTransform(QPainter* painter) const
 {
 	painter->translate(width() / 2.0 + getMapView()->panOffset().x(),
@@ -263,6 +324,18 @@ void MapWidget::viewChanged(MapView::ChangeFlags changes)
 {
 	setDrawingBoundingBox(drawing_dirty_rect_map, drawing_dirty_rect_border, true);
 	setActivityBoundingBox(activity_dirty_rect_map, activity_dirty_rect_border, true);
+	if (rotated_caches && changes == MapView::RotationChange)
+	{
+		// The north-up caches are still valid.
+		update();
+		return;
+	}
+	
+	if (!rotated_caches && view->getRotation() != 0)
+	{
+		rotated_caches = true;
+		releaseCaches();
+	}
 	updateEverything();
 	if (changes.testFlag(MapView::ZoomChange))
 		updateZoomDisplay();
@@ -282,6 +355,7 @@ void MapWidget::startDragging(QPoint cursor_pos)
 	drag_start_pos = cursor_pos;
 	normal_cursor  = cursor();
 	setCursor(Qt::ClosedHandCursor);
+	startInteraction();
 }
 
 void MapWidget::updateDragging(QPoint cursor_pos)
@@ -296,6 +370,7 @@ void MapWidget::finishDragging(QPoint cursor_pos)
 	dragging = false;
 	view->finishPanning(cursor_pos - drag_start_pos);
 	setCursor(normal_cursor);
+	finishInteraction();
 }
 
 void MapWidget::cancelDragging()
@@ -303,6 +378,7 @@ void MapWidget::cancelDragging()
 	dragging = false;
 	view->setPanOffset(QPoint());
 	setCursor(normal_cursor);
+	finishInteraction();
 }
 
 qreal MapWidget::startPinching(QPoint center)
@@ -313,6 +389,7 @@ qreal MapWidget::startPinching(QPoint center)
 	drag_start_pos  = center;
 	pinching_center = center;
 	pinching_factor = 1.0;
+	startInteraction();
 	return pinching_factor;
 }
 
@@ -330,6 +407,7 @@ void MapWidget::finishPinching(QPoint center, qreal factor)
 	pinching = false;
 	view->finishPanning(center - drag_start_pos);
 	view->setZoom(factor * view->getZoom(), viewportToView(center));
+	finishInteraction();
 }
 
 void MapWidget::cancelPinching()
@@ -337,6 +415,26 @@ void MapWidget::cancelPinching()
 	pinching = false;
 	pinching_factor = 1.0;
 	update();
+	finishInteraction();
+}
+
+void MapWidget::startInteraction()
+{
+	full_quality_timer.stop();
+	reduced_quality = true;
+}
+
+void MapWidget::finishInteraction()
+{
+	if (reduced_quality && !dragging && !pinching)
+		full_quality_timer.start();
+}
+
+void MapWidget::restoreFullQuality()
+{
+	reduced_quality = false;
+	if (map_cache_reduced)
+		updateEverything();
 }
 
 void MapWidget::moveMap(int steps_x, int steps_y)
@@ -419,27 +517,38 @@ void MapWidget::moveDirtyRect(QRect& dirty_rect, qreal x, qreal y)
 		dirty_rect = dirty_rect.translated(x, y).intersected(rect());
 }
 
-void MapWidget::markTemplateCacheDirty(const QRectF& view_rect, int pixel_border, bool front_cache)
+void MapWidget::markTemplateCacheDirty(const QRectF& view_rect, int pixel_border, bool front_cache, const Template* temp)
 {
 	QRect& cache_dirty_rect = front_cache ? above_template_cache_dirty_rect : below_template_cache_dirty_rect;
-	QRectF viewport_rect = viewToViewport(view_rect);
-	QRect integer_rect = QRect(viewport_rect.left() - (1+pixel_border), viewport_rect.top() - (1+pixel_border),
-							   viewport_rect.width() + 2*(1+pixel_border), viewport_rect.height() + 2*(1+pixel_border));
+	auto const border = 1 + pixel_border;
+	auto const cache_rect = calculateCacheBoundingBox(view_rect.adjusted(-border, -border, +border, +border));
 	
-	if (!integer_rect.intersects(rect()))
+	// With rotated caches, the cache area extends beyond the widget area.
+	if (!cache_rect.intersects(cacheRect()))
 		return;
 	
-	if (cache_dirty_rect.isValid())
-		cache_dirty_rect = cache_dirty_rect.united(integer_rect);
-	else
-		cache_dirty_rect = integer_rect;
+	rectIncludeSafe(cache_dirty_rect, cache_rect);
 	
-	update(integer_rect);
+	for (auto& layer : template_layers)
+	{
+		if (layer.temp == temp)
+			rectIncludeSafe(layer.dirty_rect, cache_rect);
+	}
+	
+	QRectF viewport_rect = viewToViewport(view_rect);
+	update(QRect(viewport_rect.left() - border, viewport_rect.top() - border,
+	             viewport_rect.width() + 2*border, viewport_rect.height() + 2*border));
 }
 
 void MapWidget::markObjectAreaDirty(const QRectF& map_rect)
 {
-	updateMapRect(map_rect, 0, map_cache_dirty_rect);
+	auto const cache_rect = (view->worldTransform() * viewToCache()).mapRect(map_rect)
+	                        .adjusted(-1.0, -1.0, +1.0, +1.0).toAlignedRect();
+	if (cache_rect.intersects(cacheRect()))
+	{
+		rectIncludeSafe(map_cache_dirty_rect, cache_rect);
+		updateDrawing(map_rect, 0);
+	}
 }
 
 void MapWidget::setDrawingBoundingBox(QRectF map_rect, int pixel_border, bool do_update)
@@ -536,19 +645,50 @@ void MapWidget::updateDrawingLaterSlot()
 	cached_update_rect = QRect();
 }
 
+void MapWidget::onVisibilityChanged(MapView::VisibilityFeature feature, bool active, const Template* temp)
+{
+	auto map = view->getMap();
+	auto pos = temp ? map->findTemplateIndex(temp) : -1;
+	if (feature != MapView::TemplateVisible || pos < 0)
+	{
+		updateEverything();
+		return;
+	}
+	
+	// The layer is drawn at full opacity. Only when the template is shown
+	// again, the (new) layer needs to be drawn.
+	if (!active)
+		releaseTemplateLayer(temp);
+	if (pos >= map->getFirstFrontTemplate())
+		above_template_cache_dirty_rect = cacheRect();
+	else
+		below_template_cache_dirty_rect = cacheRect();
+	update();
+}
+
+void MapWidget::onTemplateDeleted(int /*pos*/, const Template* temp)
+{
+	releaseTemplateLayer(temp);
+}
+
 void MapWidget::updateEverything()
 {
-	map_cache_dirty_rect = rect();
+	map_cache_dirty_rect = cacheRect();
 	below_template_cache_dirty_rect = map_cache_dirty_rect;
 	above_template_cache_dirty_rect = map_cache_dirty_rect;
-	update(map_cache_dirty_rect);
+	for (auto& layer : template_layers)
+		layer.dirty_rect = map_cache_dirty_rect;
+	update();
 }
 
 void MapWidget::updateEverythingInRect(const QRect& dirty_rect)
 {
-	rectIncludeSafe(map_cache_dirty_rect, dirty_rect);
-	rectIncludeSafe(below_template_cache_dirty_rect, dirty_rect);
-	rectIncludeSafe(above_template_cache_dirty_rect, dirty_rect);
+	auto const cache_rect = calculateCacheBoundingBox(viewportToView(dirty_rect));
+	rectIncludeSafe(map_cache_dirty_rect, cache_rect);
+	rectIncludeSafe(below_template_cache_dirty_rect, cache_rect);
+	rectIncludeSafe(above_template_cache_dirty_rect, cache_rect);
+	for (auto& layer : template_layers)
+		rectIncludeSafe(layer.dirty_rect, cache_rect);
 	update(dirty_rect);
 }
 
@@ -559,6 +699,44 @@ QRect MapWidget::calculateViewportBoundingBox(const QRectF& map_rect, int pixel_
 	return viewToViewport(view_rect).toAlignedRect();
 }
 
+QSize MapWidget::cacheSize() const
+{
+	if (!rotated_caches)
+		return size();
+	
+	// The side length has the parity of the width, so that the cache is
+	// aligned with the pixels of the widget when the rotation is zero.
+	auto side = int(std::ceil(std::hypot(width(), height())));
+	side += (side - width()) & 1;
+	return { side, side };
+}
+
+QRect MapWidget::cacheRect() const
+{
+	return { QPoint(0, 0), cacheSize() };
+}
+
+QTransform MapWidget::viewToCache() const
+{
+	auto const cache_size = cacheSize();
+	QTransform transform;
+	transform.translate(cache_size.width() / 2.0, cache_size.height() / 2.0);
+	transform.rotateRadians(-view->getRotation());
+	return transform;
+}
+
+QRect MapWidget::calculateCacheBoundingBox(const QRectF& view_rect) const
+{
+	return viewToCache().mapRect(view_rect).toAlignedRect();
+}
+
+QRectF MapWidget::calculateViewedRect(const QRect& cache_rect) const
+{
+	// The caches are north-up, so the result is not bigger than necessary.
+	auto const map_to_cache = view->worldTransform() * viewToCache();
+	return map_to_cache.inverted().mapRect(QRectF(cache_rect)).adjusted(-0.001, -0.001, +0.001, +0.001);
+}
+
 void MapWidget::setZoomDisplay(std::function<void(const QString&)> setter)
 {
 	this->zoom_display = setter;
@@ -800,7 +978,6 @@ void MapWidget::paintEvent(QPaintEvent* event)
 	// TODO: It would be an idea to do these updates in a background thread and use the old caches in the meantime
 	updateAllDirtyCaches();
 	
-	QRect target = exposed;
 	if (pinching)
 	{
 		// Just draw the scaled map and templates
@@ -821,13 +998,19 @@ void MapWidget::paintEvent(QPaintEvent* event)
 			painter.fillRect(QRect(0, 0, width(), pan_offset.y()), QColor(Qt::gray));
 		else if (pan_offset.y() < 0)
 			painter.fillRect(QRect(0, height() + pan_offset.y(), width(), -pan_offset.y()), QColor(Qt::gray));
-		
-		target.translate(pan_offset);
 	}
 	
+	// Draw the caches in cache coordinates, applying the rotation of the view.
+	painter.save();
+	painter.translate(width() / 2.0 + pan_offset.x(), height() / 2.0 + pan_offset.y());
+	painter.setWorldTransform(viewToCache().inverted(), true);
+	if (view->getRotation() != 0)
+		painter.setRenderHint(QPainter::SmoothPixmapTransform);
+	auto const source = painter.worldTransform().inverted().mapRect(QRectF(exposed)).toAlignedRect().intersected(cacheRect());
+	
 	if (!view->areAllTemplatesHidden() && isBelowTemplateVisible() && !below_template_cache.isNull() && view->getMap()->getFirstFrontTemplate() > 0)
 	{
-		painter.drawImage(target, below_template_cache, exposed);
+		painter.drawImage(source, below_template_cache, source);
 	}
 	else if (show_help && no_contents)
 	{
@@ -843,7 +1026,7 @@ void MapWidget::paintEvent(QPaintEvent* event)
 	}
 	else
 	{
-		painter.fillRect(target, Qt::white);
+		painter.fillRect(source, Qt::white);
 	}
 	
 	const auto map_visibility = view->effectiveMapVisibility();
@@ -851,12 +1034,14 @@ void MapWidget::paintEvent(QPaintEvent* event)
 	{
 		qreal saved_opacity = painter.opacity();
 		painter.setOpacity(map_visibility.opacity);
-		painter.drawImage(target, map_cache, exposed);
+		painter.drawImage(source, map_cache, source);
 		painter.setOpacity(saved_opacity);
 	}
 	
 	if (!view->areAllTemplatesHidden() && isAboveTemplateVisible() && !above_template_cache.isNull() && view->getMap()->getNumTemplates() - view->getMap()->getFirstFrontTemplate() > 0)
-		painter.drawImage(target, above_template_cache, exposed);
+		painter.drawImage(source, above_template_cache, source);
+	
+	painter.restore();
 	
 	//painter.setClipRect(exposed);
 	
@@ -886,16 +1071,16 @@ void MapWidget::paintEvent(QPaintEvent* event)
 
 void MapWidget::resizeEvent(QResizeEvent* event)
 {
-	map_cache_dirty_rect = rect();
+	map_cache_dirty_rect = cacheRect();
 	below_template_cache_dirty_rect = map_cache_dirty_rect;
 	above_template_cache_dirty_rect = map_cache_dirty_rect;
+	for (auto& layer : template_layers)
+		layer.dirty_rect = map_cache_dirty_rect;
 	
 	if (map_cache.width() < map_cache_dirty_rect.width() ||
 	    map_cache.height() < map_cache_dirty_rect.height())
 	{
-		map_cache = QImage();
-		below_template_cache = QImage();
-		above_template_cache = QImage();
+		releaseCaches();
 	}
 	
 	for (QObject* const child : children())
@@ -1049,6 +1234,8 @@ void MapWidget::wheelEvent(QWheelEvent* event)
 	{
 		if (view)
 		{
+			startInteraction();
+			
 			auto degrees = event->delta() / 8.0;
 			auto num_steps = degrees / 15.0;
 			auto cursor_pos_view = viewportToView(event->pos());
@@ -1071,6 +1258,8 @@ void MapWidget::wheelEvent(QWheelEvent* event)
 				QMouseEvent mouse_event{ QEvent::HoverMove, event->pos(), Qt::NoButton, QApplication::mouseButtons(), Qt::NoModifier };
 				tool->mouseMoveEvent(&mouse_event, view->viewToMapF(cursor_pos_view), this);
 			}
+			
+			finishInteraction();
 		}
 		
 		event->accept();
@@ -1223,13 +1412,13 @@ void MapWidget::updateTemplateCache(QImage& cache, QRect& dirty_rect, int first_
 	if (cache.isNull())
 	{
 		// Lazy allocation of cache image
-		cache = QImage(size(), QImage::Format_ARGB32_Premultiplied);
-		dirty_rect = rect();
+		cache = QImage(cacheSize(), QImage::Format_ARGB32_Premultiplied);
+		dirty_rect = cacheRect();
 	}
 	else
 	{
 		// Make sure not to use a bigger draw rect than necessary
-		dirty_rect = dirty_rect.intersected(rect());
+		dirty_rect = dirty_rect.intersected(cacheRect());
 	}
 		
 	// Start drawing
@@ -1247,30 +1436,87 @@ void MapWidget::updateTemplateCache(QImage& cache, QRect& dirty_rect, int first_
 		painter.setCompositionMode(mode);
 	}
 	
-	// Draw templates
-	painter.translate(width() / 2.0, height() / 2.0);
-	painter.setWorldTransform(view->worldTransform(), true);
-	
+	// Composite the template layers
 	Map* map = view->getMap();
-	QRectF map_view_rect = view->calculateViewedRect(viewportToView(dirty_rect));
-	
-	map->drawTemplates(&painter, map_view_rect, first_template, last_template, view, true);
+	for (int i = first_template; i <= last_template; ++i)
+	{
+		const Template* temp = map->getTemplate(i);
+		if (!view->isTemplateVisible(temp) || temp->getTemplateState() != Template::Loaded)
+			continue;
+		
+		const auto& layer = updateTemplateLayer(temp);
+		painter.setOpacity(view->getTemplateVisibility(temp).opacity);
+		painter.drawImage(dirty_rect, layer.image, dirty_rect);
+	}
 	
 	dirty_rect.setWidth(-1); // => !dirty_rect.isValid()
 }
 
+const MapWidget::TemplateLayer& MapWidget::updateTemplateLayer(const Template* temp)
+{
+	auto layer = std::find_if(begin(template_layers), end(template_layers), [temp](const TemplateLayer& entry) {
+		return entry.temp == temp;
+	});
+	if (layer == end(template_layers))
+	{
+		// Lazy allocation of layer image
+		template_layers.push_back({ temp, QImage(cacheSize(), QImage::Format_ARGB32_Premultiplied), cacheRect() });
+		layer = end(template_layers) - 1;
+	}
+	
+	auto& dirty_rect = layer->dirty_rect;
+	if (dirty_rect.isValid())
+	{
+		// Make sure not to use a bigger draw rect than necessary
+		dirty_rect = dirty_rect.intersected(cacheRect());
+		
+		QPainter painter(&layer->image);
+		painter.setClipRect(dirty_rect);
+		painter.setCompositionMode(QPainter::CompositionMode_Clear);
+		painter.fillRect(dirty_rect, Qt::transparent);
+		painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+		
+		painter.setWorldTransform(view->worldTransform() * viewToCache());
+		
+		QRectF map_view_rect = calculateViewedRect(dirty_rect);
+		double scale = std::max(temp->getTemplateScaleX(), temp->getTemplateScaleY()) * view->getZoom();
+		// The opacity is applied when compositing the layers.
+		temp->drawTemplate(&painter, map_view_rect, scale, true, 1.0f);
+		
+		dirty_rect.setWidth(-1); // => !dirty_rect.isValid()
+	}
+	return *layer;
+}
+
+void MapWidget::releaseTemplateLayer(const Template* temp)
+{
+	template_layers.erase(std::remove_if(begin(template_layers), end(template_layers), [temp](const TemplateLayer& layer) {
+		                      return layer.temp == temp;
+	                      }),
+	                      end(template_layers));
+}
+
+void MapWidget::releaseHiddenTemplateLayers()
+{
+	template_layers.erase(std::remove_if(begin(template_layers), end(template_layers), [this](const TemplateLayer& layer) {
+		                      return !view->isTemplateVisible(layer.temp)
+		                             || layer.temp->getTemplateState() != Template::Loaded;
+	                      }),
+	                      end(template_layers));
+}
+
 void MapWidget::updateMapCache(bool use_background)
 {
 	if (map_cache.isNull())
 	{
 		// Lazy allocation of cache image
-		map_cache = QImage(size(), QImage::Format_ARGB32_Premultiplied);
-		map_cache_dirty_rect = rect();
+		map_cache = QImage(cacheSize(), QImage::Format_ARGB32_Premultiplied);
+		map_cache_dirty_rect = cacheRect();
 	}
 	else
 	{
 		// Make sure not to use a bigger draw rect than necessary
-		map_cache_dirty_rect = map_cache_dirty_rect.intersected(rect());
+		map_cache_dirty_rect = map_cache_dirty_rect.intersected(cacheRect());
 	}
 	
 	// Start drawing
@@ -1291,20 +1537,26 @@ void MapWidget::updateMapCache(bool use_background)
 		painter.setCompositionMode(mode);
 	}
 	
+	QElapsedTimer frame_timer;
+	frame_timer.start();
+	
 	RenderConfig::Options options(RenderConfig::Screen | RenderConfig::HelperSymbols);
 	bool use_antialiasing = force_antialiasing || Settings::getInstance().getSettingCached(Settings::MapDisplay_Antialiasing).toBool();
-	if (use_antialiasing)
+	if (reduced_quality)
+		options |= RenderConfig::Preview;
+	if (Settings::getInstance().getSettingCached(Settings::MapDisplay_StrokeOutlines).toBool())
+		options |= RenderConfig::StrokeOutlines;
+	if (use_antialiasing && !reduced_quality)
 		painter.setRenderHint(QPainter::Antialiasing);
 	else
 		options |= RenderConfig::DisableAntialiasing | RenderConfig::ForceMinSize;
 		
 	Map* map = view->getMap();
-	QRectF map_view_rect = view->calculateViewedRect(viewportToView(map_cache_dirty_rect));
+	QRectF map_view_rect = calculateViewedRect(map_cache_dirty_rect);
 
 	RenderConfig config = { *map, map_view_rect, view->calculateFinalZoomFactor(), options, 1.0 };
 	
-	painter.translate(width() / 2.0, height() / 2.0);
-	painter.setWorldTransform(view->worldTransform(), true);
+	painter.setWorldTransform(view->worldTransform() * viewToCache());
 #ifndef Q_OS_ANDROID
 	if (view->isOverprintingSimulationEnabled())
 		map->drawOverprintingSimulation(&painter, config);
@@ -1318,6 +1570,15 @@ void MapWidget::updateMapCache(bool use_background)
 	// Finish drawing
 	painter.end();
 	
+	if (reduced_quality)
+		map_cache_reduced = true;
+	else if (map_cache_dirty_rect.contains(cacheRect()))
+		map_cache_reduced = false;
+	qCDebug(lcMapCache, "Map cache updated in %lld ms (%s quality)",
+	        frame_timer.elapsed(), reduced_quality ? "reduced" : "full");
+	
+	if (object_pick_buffer)
+		object_pick_buffer->markDirty(map_cache_dirty_rect);
 	map_cache_dirty_rect.setWidth(-1); // => !map_cache_dirty_rect.isValid()
 }
 
@@ -1326,8 +1587,14 @@ void MapWidget::updateAllDirtyCaches()
 	if (map_cache_dirty_rect.isValid())
 		updateMapCache(false);
 	
+	// The pick buffer is not needed during continuous interaction.
+	if (object_pick_buffer && object_pick_buffer->isDirty() && !reduced_quality)
+		updateObjectPickBuffer();
+	
 	if (!view->areAllTemplatesHidden())
 	{
+		releaseHiddenTemplateLayers();
+		
 		if (below_template_cache_dirty_rect.isValid() && isBelowTemplateVisible())
 			updateTemplateCache(below_template_cache, below_template_cache_dirty_rect, 0, view->getMap()->getFirstFrontTemplate() - 1, true);
 		
@@ -1336,6 +1603,21 @@ void MapWidget::updateAllDirtyCaches()
 	}
 }
 
+void MapWidget::updateObjectPickBuffer()
+{
+	object_pick_buffer->update(*view->getMap(), cacheSize(), view->worldTransform() * viewToCache(), view->calculateFinalZoomFactor());
+}
+
+void MapWidget::releaseCaches()
+{
+	if (object_pick_buffer)
+		object_pick_buffer->release();
+	map_cache = QImage();
+	below_template_cache = QImage();
+	above_template_cache = QImage();
+	template_layers.clear();
+}
+
 void MapWidget::shiftCache(int sx, int sy, QImage& cache)
 {
 	if (!cache.isNull())
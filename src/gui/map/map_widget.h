@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -24,6 +24,7 @@
 
 #include <functional>
 #include <type_traits>
+#include <vector>
 
 #include <Qt>
 #include <QtGlobal>
@@ -38,6 +39,7 @@
 #include <QSize>
 #include <QString>
 #include <QTime>
+#include <QTimer>
 #include <QVariant>
 #include <QWidget>
 
@@ -56,6 +58,7 @@ class QPaintEvent;
 class QPainter;
 class QPixmap;
 class QResizeEvent;
+class QTransform;
 class QWheelEvent;
 
 namespace OpenOrienteering {
@@ -64,7 +67,10 @@ class GPSDisplay;
 class GPSTemporaryMarkers;
 class MapEditorActivity;
 class MapEditorTool;
+class Object;
+class ObjectPickBuffer;
 class PieMenu;
+class Template;
 class TouchCursor;
 
 
@@ -82,6 +88,17 @@ class TouchCursor;
  * <li>The <b>above template cache</b> contains the currently
  *     visible part of all templates above the map</li>
  * </ul>
+ * 
+ * The template caches are composited from template layers: each visible
+ * template has its own cache which is drawn at full opacity. Changing the
+ * opacity of a template or updating a single template thus does not require
+ * drawing the other templates again.
+ * 
+ * As soon as the view is rotated, the caches are drawn north-up into a square
+ * which covers the circumcircle of the widget area, and the rotation is
+ * applied when the caches are drawn on the widget. Changing only the rotation
+ * of the view, e.g. when the map is aligned with a compass, thus does not
+ * require redrawing any cache.
  */
 class MapWidget : public QWidget
 {
@@ -155,6 +172,36 @@ public:
 	bool gesturesEnabled() const;
 	
 	
+	/**
+	 * Enables or disables the object pick buffer.
+	 * 
+	 * When enabled, a raster of object IDs is drawn together with the map
+	 * cache, so that the objects near a position can be found without
+	 * testing every object of the map.
+	 * 
+	 * @see findObjectCandidatesAt()
+	 */
+	void setObjectPickingEnabled(bool enabled);
+	
+	/** Returns true if the object pick buffer is enabled. */
+	bool objectPickingEnabled() const;
+	
+	/**
+	 * Finds the objects of the current map part which are drawn near the
+	 * given position, using the object pick buffer.
+	 * 
+	 * The candidates still need to be confirmed by an exact test, such as
+	 * Object::isPointOnObject(). Objects which are completely hidden by other
+	 * objects are not found.
+	 * 
+	 * Returns false if the object pick buffer is disabled or not up to date.
+	 * Then the objects must be searched in the map.
+	 * 
+	 * @param radius The search radius in pixels.
+	 */
+	bool findObjectCandidatesAt(MapCoordF position, qreal radius, std::vector<Object*>& out) const;
+	
+	
 	/**
 	 * Applies the complete transform to the painter which enables to draw
 	 * map objects with map coordinates and have them correctly displayed in
@@ -228,8 +275,10 @@ public:
 	 *     pixels. Allows to specify zoom-independent extents.
 	 * @param front_cache If set to true, invalidates the cache for templates
 	 *     in front of the map, else invalidates the cache for templates behind the map.
+	 * @param temp The template which needs to be redrawn. The layers of other
+	 *     templates are only composited again.
 	 */
-	void markTemplateCacheDirty(const QRectF& view_rect, int pixel_border, bool front_cache);
+	void markTemplateCacheDirty(const QRectF& view_rect, int pixel_border, bool front_cache, const Template* temp);
 	
 	/**
 	 * Mark a rectangular region given in map coordinates of the map cache
@@ -362,6 +411,16 @@ signals:
 private slots:
 	void updateDrawingLaterSlot();
 	
+	/**
+	 * Updates the caches after a change of visibility.
+	 * 
+	 * For a single template, only the composited template cache is redrawn.
+	 */
+	void onVisibilityChanged(MapView::VisibilityFeature feature, bool active, const Template* temp);
+	
+	/** Releases the layer of a template which is removed from the map. */
+	void onTemplateDeleted(int pos, const Template* temp);
+	
 protected:
 	bool event(QEvent *event) override;
 	
@@ -406,6 +465,28 @@ private:
 	 *     drawing the templates, else makes it transparent.
 	 */
 	void updateTemplateCache(QImage& cache, QRect& dirty_rect, int first_template, int last_template, bool use_background);
+	
+	/** A cache for a single template, drawn at full opacity. */
+	struct TemplateLayer
+	{
+		const Template* temp;
+		QImage image;
+		QRect dirty_rect;  ///< In viewport coordinates
+	};
+	
+	/**
+	 * Returns the layer for the given template, after redrawing its dirty rect.
+	 * 
+	 * The layer is allocated if it does not exist yet.
+	 */
+	const TemplateLayer& updateTemplateLayer(const Template* temp);
+	
+	/** Releases the layer for the given template. */
+	void releaseTemplateLayer(const Template* temp);
+	
+	/** Releases the layers of templates which are no longer drawn. */
+	void releaseHiddenTemplateLayers();
+	
 	/**
 	 * Redraws the map cache in the map cache dirty rect.
 	 * @param use_background If set to true, fills the cache with white before
@@ -414,6 +495,34 @@ private:
 	void updateMapCache(bool use_background);
 	/** Redraws all dirty caches. */
 	void updateAllDirtyCaches();
+	/** Redraws the dirty rect of the object pick buffer. */
+	void updateObjectPickBuffer();
+	/** Releases all cache images. */
+	void releaseCaches();
+	
+	/**
+	 * Returns the size of the cache images.
+	 * 
+	 * This is the size of the widget, or a square covering the widget area
+	 * at any rotation when the caches are drawn north-up.
+	 */
+	QSize cacheSize() const;
+	/** Returns the area of the cache images, in cache coordinates. */
+	QRect cacheRect() const;
+	/**
+	 * Returns the transformation from view coordinates to cache coordinates.
+	 * 
+	 * The center of the view is at the center of the cache images, and the
+	 * rotation of the view is undone.
+	 */
+	QTransform viewToCache() const;
+	/**
+	 * Calculates the bounding box of the given view coordinates rect in
+	 * integer cache coordinates.
+	 */
+	QRect calculateCacheBoundingBox(const QRectF& view_rect) const;
+	/** Calculates the map area which is drawn in the given rect of the caches. */
+	QRectF calculateViewedRect(const QRect& cache_rect) const;
 	/** Shifts the content in the cache by the given amount of pixels. */
 	void shiftCache(int sx, int sy, QImage& cache);
 	void shiftCache(int sx, int sy, QPixmap& cache);
@@ -450,6 +559,18 @@ private:
 	/** Cancels a pinching interaction. */
 	void cancelPinching();
 	
+	/**
+	 * Switches the map cache to reduced quality for continuous interaction.
+	 * 
+	 * While the interaction is active, the map is drawn without antialiasing,
+	 * text and tiny point details.
+	 */
+	void startInteraction();
+	/** Schedules a full-quality redraw for when the input has been idle for a while. */
+	void finishInteraction();
+	/** Leaves the reduced quality mode and redraws the map cache if needed. */
+	void restoreFullQuality();
+	
 	/** Moves the map a given number of big "steps" in x and/or y direction. */
 	void moveMap(int steps_x, int steps_y);
 	
@@ -490,6 +611,17 @@ private:
 	qreal pinching_factor;
 	QPoint pinching_center;
 	
+	// Progressive quality (interaction)
+	/** Triggers the full-quality redraw after an interaction. */
+	QTimer full_quality_timer;
+	/** Set while the map is to be drawn in reduced quality. */
+	bool reduced_quality = false;
+	/** Set when the map cache contains content drawn in reduced quality. */
+	bool map_cache_reduced = false;
+	
+	/** Set when the caches are drawn north-up for a rotated view. */
+	bool rotated_caches = false;
+	
 	// Panning (operation)
 	QPoint pan_offset;
 	
@@ -502,10 +634,16 @@ private:
 	QImage above_template_cache;
 	QRect above_template_cache_dirty_rect;
 	
+	/** Per-template caches from which the template caches are composited */
+	std::vector<TemplateLayer> template_layers;
+	
 	/** Map layer cache  */
 	QImage map_cache;
 	QRect map_cache_dirty_rect;
 	
+	/** Object IDs for picking, in cache coordinates. Drawn when enabled. */
+	QScopedPointer<ObjectPickBuffer> object_pick_buffer;
+	
 	// Dirty regions for drawings (tools) and activities
 	/** Dirty rect for the current tool, in viewport coordinates (pixels). */
 	QRect drawing_dirty_rect;
@@ -566,6 +704,12 @@ bool MapWidget::gesturesEnabled() const
 	return gestures_enabled;
 }
 
+inline
+bool MapWidget::objectPickingEnabled() const
+{
+	return bool(object_pick_buffer);
+}
+
 inline
 QPointF MapWidget::mapToViewport(QPointF input) const
 {
@@ -0,0 +1,198 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "object_pick_buffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+#include <QColor>
+#include <QFlags>
+#include <QPainter>
+#include <QRectF>
+#include <QRgb>
+#include <QTransform>
+
+#include "core/map.h"
+#include "core/map_color.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/renderables/renderable.h"
+#include "core/symbols/symbol.h"
+#include "util/util.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+Q_STATIC_ASSERT(RGB_MASK == 0x00ffffff);
+
+/// The pixel value for areas without objects.
+constexpr QRgb no_object = RGB_MASK;
+
+}  // namespace
+
+
+
+ObjectPickBuffer::ObjectPickBuffer() = default;
+
+ObjectPickBuffer::~ObjectPickBuffer()
+{
+	// nothing, not inlined
+}
+
+
+
+void ObjectPickBuffer::markDirty(const QRect& rect)
+{
+	rectIncludeSafe(dirty_rect, rect);
+}
+
+
+void ObjectPickBuffer::release()
+{
+	image = QImage();
+	dirty_rect = {};
+	drawn_part = nullptr;
+	drawn_objects.clear();
+}
+
+
+
+void ObjectPickBuffer::update(Map& map, const QSize& size, const QTransform& transform, qreal scaling)
+{
+	Q_STATIC_ASSERT(MapColor::Reserved == -1);
+
+	auto part = map.getCurrentPart();
+	if (image.size() != size || part != drawn_part)
+	{
+		image = QImage(size, QImage::Format_RGB32);
+		dirty_rect = image.rect();
+		drawn_part = part;
+		drawn_objects.clear();
+	}
+	dirty_rect = dirty_rect.intersected(image.rect());
+	if (!dirty_rect.isValid())
+		return;
+
+	// The IDs are indices in the part. When objects were inserted or removed,
+	// pixels outside of the dirty rect would keep shifted IDs.
+	auto const num_objects = qMin(part->getNumObjects(), int(no_object));
+	auto objects_changed = drawn_objects.size() != std::size_t(num_objects);
+	for (int o = 0; o < num_objects && !objects_changed; ++o)
+		objects_changed = part->getObject(o) != drawn_objects[std::size_t(o)];
+	if (objects_changed)
+	{
+		dirty_rect = image.rect();
+		drawn_objects.resize(std::size_t(num_objects));
+	}
+
+	auto const map_rect = transform.inverted().mapRect(QRectF(dirty_rect));
+
+	// Collect the objects in the dirty rect, with their IDs.
+	std::vector<int> ids;
+	for (int o = 0; o < num_objects; ++o)
+	{
+		auto object = part->getObject(o);
+		drawn_objects[std::size_t(o)] = object;
+		if (object->getSymbol() && object->getSymbol()->isHidden())
+			continue;
+
+		object->update();
+		if (!object->getExtent().intersects(map_rect))
+			continue;
+
+		if (object->hasEvictedRenderables())
+			object->restoreRenderables();
+		ids.push_back(o);
+	}
+
+	QPainter painter(&image);
+	painter.setClipRect(dirty_rect);
+	painter.fillRect(dirty_rect, QColor(no_object | ~RGB_MASK));
+	painter.setWorldTransform(transform);
+
+	auto const options = RenderConfig::Screen | RenderConfig::HelperSymbols
+	                     | RenderConfig::DisableAntialiasing | RenderConfig::ForceMinSize;
+	RenderConfig config = { map, map_rect, scaling, options, 1.0 };
+	for (auto c = map.getNumColors() - 1; c >= MapColor::Reserved; --c)
+	{
+		for (auto o : ids)
+		{
+			auto object = drawn_objects[std::size_t(o)];
+			object->renderables().draw(c, QRgb(o) | ~RGB_MASK, &painter, config);
+		}
+	}
+	painter.end();
+
+	dirty_rect = {};
+}
+
+
+
+bool ObjectPickBuffer::findCandidates(const MapPart& part, QPoint pos, int radius, std::vector<Object*>& out) const
+{
+	if (image.isNull() || isDirty() || &part != drawn_part || !image.rect().contains(pos))
+		return false;
+
+	auto const window = QRect(pos.x() - radius, pos.y() - radius, 2 * radius + 1, 2 * radius + 1)
+	                    .intersected(image.rect());
+	std::vector<QRgb> ids;
+	for (auto y = window.top(); y <= window.bottom(); ++y)
+	{
+		auto const dy = y - pos.y();
+		auto const line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+		for (auto x = window.left(); x <= window.right(); ++x)
+		{
+			auto const dx = x - pos.x();
+			if (dx * dx + dy * dy > radius * radius)
+				continue;
+
+			auto const id = line[x] & RGB_MASK;
+			if (id != no_object && (ids.empty() || ids.back() != id))
+				ids.push_back(id);
+		}
+	}
+
+	std::sort(begin(ids), end(ids));
+	ids.erase(std::unique(begin(ids), end(ids)), end(ids));
+
+	auto const size = out.size();
+	for (auto id : ids)
+	{
+		// A mismatch means that objects were inserted or removed
+		// without the affected pixels being redrawn.
+		auto const index = std::size_t(id);
+		if (index >= drawn_objects.size()
+		    || int(id) >= part.getNumObjects()
+		    || part.getObject(int(id)) != drawn_objects[index])
+		{
+			out.resize(size);
+			return false;
+		}
+		out.push_back(drawn_objects[index]);
+	}
+	return true;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,122 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_OBJECT_PICK_BUFFER_H
+#define OPENORIENTEERING_OBJECT_PICK_BUFFER_H
+
+#include <vector>
+
+#include <QtGlobal>
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+
+class QTransform;
+
+namespace OpenOrienteering {
+
+class Map;
+class MapPart;
+class Object;
+
+
+/**
+ * A raster of object IDs for picking objects in a map widget.
+ *
+ * The objects of the current map part are drawn from their renderables in
+ * flat colors which encode the objects' IDs, in the same stacking order as
+ * on screen. Looking up the pixels within the pick tolerance around a
+ * position yields the objects which are visible near this position. These
+ * candidates still need to be confirmed by an exact test.
+ *
+ * The buffer is updated in dirty rects, like the map widget's map cache.
+ * The ID of an object is its index in the map part. The buffer records the
+ * objects of the part by ID. When objects were inserted or removed, the
+ * IDs shift, so the next update redraws the whole buffer. Until then, IDs
+ * which became stale are detected when looking up candidates.
+ */
+class ObjectPickBuffer
+{
+public:
+	/** Constructs an empty buffer. */
+	ObjectPickBuffer();
+
+	ObjectPickBuffer(const ObjectPickBuffer&) = delete;
+	ObjectPickBuffer& operator=(const ObjectPickBuffer&) = delete;
+
+	/** Destructor. */
+	~ObjectPickBuffer();
+
+
+	/** Returns true if the buffer is not allocated. */
+	bool isNull() const { return image.isNull(); }
+
+	/** Returns true if parts of the buffer need to be redrawn. */
+	bool isDirty() const { return dirty_rect.isValid(); }
+
+	/** Marks a rect of the buffer as dirty, in buffer pixels. */
+	void markDirty(const QRect& rect);
+
+	/** Releases the buffer's memory. */
+	void release();
+
+
+	/**
+	 * Redraws the dirty rect of the buffer.
+	 *
+	 * The whole buffer is drawn when its size changed, when the current
+	 * part of the map is not the part which was drawn before, or when
+	 * objects were inserted into or removed from the part.
+	 *
+	 * @param map        The map.
+	 * @param size       The size of the buffer in pixels.
+	 * @param transform  The transformation from map coordinates to buffer pixels.
+	 * @param scaling    The scaling of the rendering, cf. RenderConfig.
+	 */
+	void update(Map& map, const QSize& size, const QTransform& transform, qreal scaling);
+
+	/**
+	 * Finds the objects which are drawn near a position.
+	 *
+	 * The candidates are appended to out in the order of the map part.
+	 *
+	 * Returns false if the buffer cannot be used for the given part: when the
+	 * buffer is dirty, when it was drawn for another part, when the position
+	 * is outside of the buffer, or when a found ID became stale.
+	 *
+	 * @param part    The map part, used for resolving IDs to objects.
+	 * @param pos     The position in buffer pixels.
+	 * @param radius  The radius of the lookup in buffer pixels.
+	 */
+	bool findCandidates(const MapPart& part, QPoint pos, int radius, std::vector<Object*>& out) const;
+
+
+private:
+	QImage image;
+	QRect dirty_rect;
+	const MapPart* drawn_part = nullptr;
+	std::vector<Object*> drawn_objects;  ///< The objects of the drawn part, by ID.
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
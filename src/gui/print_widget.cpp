@@ -265,6 +265,9 @@ PrintWidget::PrintWidget(Map* map, MainWindow* main_window, MapView* main_view,
 	overprinting_check = new QCheckBox(tr("Simulate overprinting"));
 	layout->addRow(overprinting_check);
 	
+	text_outlines_check = new QCheckBox(tr("Text as outlines"));
+	layout->addRow(text_outlines_check);
+	
 	color_mode_combo = new QComboBox();
 	color_mode_combo->setEditable(false);
 	color_mode_combo->addItem(tr("Default"), QVariant());
@@ -327,6 +330,7 @@ PrintWidget::PrintWidget(Map* map, MainWindow* main_window, MapView* main_view,
 	connect(show_templates_check, &QAbstractButton::clicked, this, &PrintWidget::showTemplatesClicked);
 	connect(show_grid_check, &QAbstractButton::clicked, this, &PrintWidget::showGridClicked);
 	connect(overprinting_check, &QAbstractButton::clicked, this, &PrintWidget::overprintingClicked);
+	connect(text_outlines_check, &QAbstractButton::clicked, this, &PrintWidget::textOutlinesClicked);
 	connect(color_mode_combo, &QComboBox::currentTextChanged, this, &PrintWidget::colorModeChanged);
 	
 	connect(preview_button, &QAbstractButton::clicked, this, &PrintWidget::previewClicked);
@@ -867,6 +871,7 @@ void PrintWidget::setOptions(const MapPrinterOptions& options)
 	            show_templates_check,
 	            show_grid_check,
 	            overprinting_check,
+	            text_outlines_check,
 	            color_mode_combo,
 	            vector_mode_button,
 	            raster_mode_button,
@@ -885,6 +890,7 @@ void PrintWidget::setOptions(const MapPrinterOptions& options)
 		setEnabledAndChecked(show_templates_check, options.show_templates);
 		setEnabledAndChecked(show_grid_check,      options.show_grid);
 		setDisabledAndChecked(overprinting_check,  options.simulate_overprinting);
+		setEnabledAndChecked(text_outlines_check,  options.text_as_outlines);
 		main_view->setAllTemplatesHidden(!options.show_templates);
 		main_view->setGridVisible(options.show_grid);
 		main_view->setOverprintingSimulationEnabled(false);
@@ -894,6 +900,7 @@ void PrintWidget::setOptions(const MapPrinterOptions& options)
 		setEnabledAndChecked(show_templates_check, options.show_templates);
 		setEnabledAndChecked(show_grid_check,      options.show_grid);
 		setEnabledAndChecked(overprinting_check,   options.simulate_overprinting);
+		setDisabledAndChecked(text_outlines_check, options.text_as_outlines);
 		main_view->setAllTemplatesHidden(!options.show_templates);
 		main_view->setGridVisible(options.show_grid);
 		main_view->setOverprintingSimulationEnabled(options.simulate_overprinting);
@@ -903,6 +910,7 @@ void PrintWidget::setOptions(const MapPrinterOptions& options)
 		setDisabledAndChecked(show_templates_check, options.show_templates);
 		setDisabledAndChecked(show_grid_check,      options.show_grid);
 		setDisabledAndChecked(overprinting_check,   options.simulate_overprinting);
+		setEnabledAndChecked(text_outlines_check,   options.text_as_outlines);
 		main_view->setAllTemplatesHidden(true);
 		main_view->setGridVisible(false);
 		main_view->setOverprintingSimulationEnabled(true);
@@ -1083,6 +1091,12 @@ void PrintWidget::overprintingClicked(bool checked)
 	map_printer->setSimulateOverprinting(checked);
 }
 
+// slot
+void PrintWidget::textOutlinesClicked(bool checked)
+{
+	map_printer->setTextAsOutlines(checked);
+}
+
 void PrintWidget::colorModeChanged()
 {
 	if (color_mode_combo->currentData().toBool())
@@ -211,6 +211,9 @@ protected slots:
 	/** This slot reacts to changes of the "Simulate overprinting" option. */
 	void overprintingClicked(bool checked);
 	
+	/** This slot reacts to changes of the "Text as outlines" option. */
+	void textOutlinesClicked(bool checked);
+	
 	/** This slot reacts to changes of the "Color mode" option. */
 	void colorModeChanged();
 	
@@ -294,6 +297,7 @@ private:
 	QLabel* templates_warning_text;
 	QCheckBox* show_grid_check;
 	QCheckBox* overprinting_check;
+	QCheckBox* text_outlines_check;
 	QCheckBox* different_scale_check;
 	QSpinBox* different_scale_edit;
 	QComboBox* color_mode_combo;
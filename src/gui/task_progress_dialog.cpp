@@ -0,0 +1,97 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "task_progress_dialog.h"
+
+#include <Qt>
+#include <QPushButton>
+
+
+namespace OpenOrienteering {
+
+TaskProgressDialog::TaskProgressDialog(BackgroundTask& task, const QString& label, QWidget* parent)
+: QProgressDialog(parent)
+, task(task)
+, label(label)
+{
+	setWindowModality(Qt::ApplicationModal); // Required for OSX, cf. QTBUG-40112
+	setAutoReset(false);
+	setRange(0, 100);
+	setMinimumDuration(0);
+	setLabelText(label);
+	setValue(task.progress());
+	
+	connect(&task, &BackgroundTask::progressChanged, this, &TaskProgressDialog::setProgress);
+	connect(&task, &BackgroundTask::finished, this, &TaskProgressDialog::accept);
+	// QProgressDialog would hide itself on cancel, but the task may need
+	// some time to return.
+	disconnect(this, &QProgressDialog::canceled, this, &QProgressDialog::cancel);
+	connect(this, &TaskProgressDialog::canceled, this, &TaskProgressDialog::cancelTask);
+}
+
+TaskProgressDialog::~TaskProgressDialog()
+{
+	// nothing, not inlined
+}
+
+
+// static
+BackgroundTask::State TaskProgressDialog::run(BackgroundTask& task, const QString& label, QWidget* parent)
+{
+	task.start();
+	if (!task.waitForFinished(show_delay))
+	{
+		TaskProgressDialog dialog(task, label, parent);
+		if (task.state() == BackgroundTask::Running)
+			dialog.exec();
+	}
+	return task.state();
+}
+
+
+void TaskProgressDialog::reject()
+{
+	if (task.state() == BackgroundTask::Running)
+		cancelTask();
+	else
+		QProgressDialog::reject();
+}
+
+
+void TaskProgressDialog::setProgress(int value, const QString& message)
+{
+	if (!task.isCanceled())
+		setLabelText(message.isEmpty() ? label : message);
+	setValue(value);
+}
+
+
+void TaskProgressDialog::cancelTask()
+{
+	if (task.isCanceled())
+		return;
+	
+	task.cancel();
+	setLabelText(tr("Canceling..."));
+	if (auto* button = findChild<QPushButton*>())
+		button->setEnabled(false);
+}
+
+
+}  // namespace OpenOrienteering
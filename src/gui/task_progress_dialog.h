@@ -0,0 +1,88 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_TASK_PROGRESS_DIALOG_H
+#define OPENORIENTEERING_TASK_PROGRESS_DIALOG_H
+
+#include <QObject>
+#include <QProgressDialog>
+#include <QString>
+
+#include "util/background_task.h"
+
+class QWidget;
+
+namespace OpenOrienteering {
+
+
+/**
+ * A modal progress dialog for a BackgroundTask.
+ * 
+ * The dialog shows the progress reported by the task, and cancels the task
+ * when the user presses the Cancel button. Being application modal, it
+ * prevents changes to the map while the task is running. After canceling,
+ * the dialog stays open until the task has returned.
+ */
+class TaskProgressDialog : public QProgressDialog
+{
+Q_OBJECT
+public:
+	/**
+	 * Constructs a new dialog for the given task.
+	 */
+	TaskProgressDialog(BackgroundTask& task, const QString& label, QWidget* parent = nullptr);
+	
+	~TaskProgressDialog() override;
+	
+	/**
+	 * Starts the task and waits for its completion.
+	 * 
+	 * The dialog is shown only if the task doesn't finish within a short time.
+	 * When this function returns, the task is completed, i.e. its results are
+	 * committed unless it was canceled or failed.
+	 * 
+	 * Returns the final state of the task.
+	 */
+	static BackgroundTask::State run(BackgroundTask& task, const QString& label, QWidget* parent = nullptr);
+	
+	/**
+	 * The time in milliseconds to wait for a task before showing the dialog.
+	 */
+	static constexpr int show_delay = 200;
+	
+	/**
+	 * Cancels the task instead of closing the dialog.
+	 * 
+	 * The dialog is closed when the task has finished.
+	 */
+	void reject() override;
+	
+private:
+	void setProgress(int value, const QString& message);
+	
+	void cancelTask();
+	
+	BackgroundTask& task;
+	const QString label;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
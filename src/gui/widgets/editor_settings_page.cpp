@@ -53,6 +53,10 @@ EditorSettingsPage::EditorSettingsPage(QWidget* parent)
 	text_antialiasing->setToolTip(tr("Antialiasing makes the map look much better, but also slows down the map display"));
 	layout->addRow(text_antialiasing);
 	
+	stroke_outlines = new QCheckBox(tr("Fast display of wide lines, uses more memory"), this);
+	stroke_outlines->setToolTip(tr("Keeps the outlines of wide lines for faster redrawing at high zoom levels"));
+	layout->addRow(stroke_outlines);
+	
 	tolerance = Util::SpinBox::create(0, 50, tr("mm", "millimeters"));
 	layout->addRow(tr("Click tolerance:"), tolerance);
 	
@@ -90,6 +94,9 @@ EditorSettingsPage::EditorSettingsPage(QWidget* parent)
 	edit_tool_delete_bezier_point_action_alternative->addItem(tr("Keep outer curve handles"), (int)Settings::DeleteBezierPoint_KeepHandles);
 	layout->addRow(tr("Action on deleting a curve point with %1:").arg(ModifierKey::controlShift()), edit_tool_delete_bezier_point_action_alternative);
 	
+	edit_tool_move_shared_nodes = new QCheckBox(tr("Move identical points of adjacent objects, too"));
+	layout->addRow(edit_tool_move_shared_nodes);
+	
 	layout->addItem(Util::SpacerItem::create(this));
 	layout->addRow(Util::Headline::create(tr("Rectangle tool:")));
 	
@@ -120,6 +127,7 @@ void EditorSettingsPage::apply()
 	setSetting(Settings::SymbolWidget_IconSizeMM, icon_size->value());
 	setSetting(Settings::MapDisplay_Antialiasing, antialiasing->isChecked());
 	setSetting(Settings::MapDisplay_TextAntialiasing, text_antialiasing->isChecked());
+	setSetting(Settings::MapDisplay_StrokeOutlines, stroke_outlines->isChecked());
 	setSetting(Settings::MapEditor_ClickToleranceMM, tolerance->value());
 	setSetting(Settings::MapEditor_SnapDistanceMM, snap_distance->value());
 	setSetting(Settings::MapEditor_FixedAngleStepping, fixed_angle_stepping->value());
@@ -129,6 +137,7 @@ void EditorSettingsPage::apply()
 	setSetting(Settings::Templates_KeepSettingsOfClosed, keep_settings_of_closed_templates->isChecked());
 	setSetting(Settings::EditTool_DeleteBezierPointAction, edit_tool_delete_bezier_point_action->currentData());
 	setSetting(Settings::EditTool_DeleteBezierPointActionAlternative, edit_tool_delete_bezier_point_action_alternative->currentData());
+	setSetting(Settings::EditTool_MoveSharedNodes, edit_tool_move_shared_nodes->isChecked());
 	setSetting(Settings::RectangleTool_HelperCrossRadiusMM, rectangle_helper_cross_radius->value());
 	setSetting(Settings::RectangleTool_PreviewLineWidth, rectangle_preview_line_width->isChecked());
 }
@@ -144,6 +153,7 @@ void EditorSettingsPage::updateWidgets()
 	antialiasing->setChecked(getSetting(Settings::MapDisplay_Antialiasing).toBool());
 	text_antialiasing->setEnabled(antialiasing->isChecked());
 	text_antialiasing->setChecked(getSetting(Settings::MapDisplay_TextAntialiasing).toBool());
+	stroke_outlines->setChecked(getSetting(Settings::MapDisplay_StrokeOutlines).toBool());
 	tolerance->setValue(getSetting(Settings::MapEditor_ClickToleranceMM).toInt());
 	snap_distance->setValue(getSetting(Settings::MapEditor_SnapDistanceMM).toInt());
 	fixed_angle_stepping->setValue(getSetting(Settings::MapEditor_FixedAngleStepping).toInt());
@@ -154,6 +164,7 @@ void EditorSettingsPage::updateWidgets()
 	
 	edit_tool_delete_bezier_point_action->setCurrentIndex(edit_tool_delete_bezier_point_action->findData(getSetting(Settings::EditTool_DeleteBezierPointAction).toInt()));
 	edit_tool_delete_bezier_point_action_alternative->setCurrentIndex(edit_tool_delete_bezier_point_action_alternative->findData(getSetting(Settings::EditTool_DeleteBezierPointActionAlternative).toInt()));
+	edit_tool_move_shared_nodes->setChecked(getSetting(Settings::EditTool_MoveSharedNodes).toBool());
 	
 	rectangle_helper_cross_radius->setValue(getSetting(Settings::RectangleTool_HelperCrossRadiusMM).toInt());
 	rectangle_preview_line_width->setChecked(getSetting(Settings::RectangleTool_PreviewLineWidth).toBool());
@@ -55,6 +55,7 @@ private:
 	QSpinBox* icon_size;
 	QCheckBox* antialiasing;
 	QCheckBox* text_antialiasing;
+	QCheckBox* stroke_outlines;
 	QSpinBox* tolerance;
 	QSpinBox* snap_distance;
 	QSpinBox* fixed_angle_stepping;
@@ -65,6 +66,7 @@ private:
 	
 	QComboBox* edit_tool_delete_bezier_point_action;
 	QComboBox* edit_tool_delete_bezier_point_action_alternative;
+	QCheckBox* edit_tool_move_shared_nodes;
 	
 	QSpinBox* rectangle_helper_cross_radius;
 	QCheckBox* rectangle_preview_line_width;
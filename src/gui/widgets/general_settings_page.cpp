@@ -113,6 +113,10 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget* parent)
 	ppi_calculate_button->setIcon(QIcon(QLatin1String(":/images/settings.png")));
 	ppi_layout->addWidget(ppi_calculate_button);
 	
+	memory_budget_edit = Util::SpinBox::create(0, 1 << 20, tr("MiB", "unit mebibytes"), 256);
+	memory_budget_edit->setSpecialValueText(tr("No limit"));
+	layout->addRow(tr("Memory for map display:"), memory_budget_edit);
+	
 	layout->addItem(Util::SpacerItem::create(this));
 	layout->addRow(Util::Headline::create(tr("Program start")));
 	
@@ -235,6 +239,7 @@ void GeneralSettingsPage::apply()
 	setSetting(Settings::General_RetainCompatiblity, compatibility_check->isChecked());
 	setSetting(Settings::General_SaveUndoRedo, undo_check->isChecked());
 	setSetting(Settings::General_PixelsPerInch, ppi_edit->value());
+	setSetting(Settings::General_ObjectMemoryBudget, memory_budget_edit->value());
 	
 	auto encoding = encoding_box->currentText().toLatin1();
 	if (QLatin1String(encoding) == encoding_box->itemText(0)
@@ -290,6 +295,7 @@ void GeneralSettingsPage::updateWidgets()
 	updateLanguageBox(getSetting(Settings::General_Language));
 	
 	ppi_edit->setValue(getSetting(Settings::General_PixelsPerInch).toDouble());
+	memory_budget_edit->setValue(getSetting(Settings::General_ObjectMemoryBudget).toInt());
 	open_mru_check->setChecked(getSetting(Settings::General_OpenMRUFile).toBool());
 	tips_visible_check->setChecked(getSetting(Settings::HomeScreen_TipsVisible).toBool());
 	compatibility_check->setChecked(getSetting(Settings::General_RetainCompatiblity).toBool());
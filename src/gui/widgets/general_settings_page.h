@@ -80,6 +80,7 @@ private:
 	QComboBox* language_box;
 	
 	QDoubleSpinBox* ppi_edit;
+	QSpinBox* memory_budget_edit;
 	QCheckBox* open_mru_check;
 	QCheckBox* tips_visible_check;
 	
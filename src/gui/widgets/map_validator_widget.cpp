@@ -0,0 +1,227 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "map_validator_widget.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QAbstractItemView>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QListWidget>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/map_validator.h"
+#include "core/objects/object.h"
+#include "gui/main_window.h"
+#include "gui/util_gui.h"
+#include "gui/map/map_editor.h"
+#include "gui/map/map_widget.h"
+#include "undo/object_undo.h"
+
+
+namespace OpenOrienteering {
+
+MapValidatorWidget::MapValidatorWidget(MapEditorController* controller, QWidget* parent)
+: QWidget(parent)
+, controller(controller)
+, map(controller->getMap())
+{
+	MapValidator::SymbolRule rule;
+	
+	min_area_edit = Util::SpinBox::create(2, 0.0, 99999.9, trUtf8("mm²"));
+	min_area_edit->setValue(rule.min_area);
+	min_length_edit = Util::SpinBox::create(2, 0.0, 99999.9, tr("mm"));
+	min_length_edit->setValue(rule.min_length);
+	min_gap_edit = Util::SpinBox::create(2, 0.0, 99999.9, tr("mm"));
+	min_gap_edit->setValue(rule.min_gap);
+	min_point_distance_edit = Util::SpinBox::create(2, 0.0, 99999.9, tr("mm"));
+	min_point_distance_edit->setValue(rule.min_point_distance);
+	check_overlap_check = new QCheckBox(tr("Report overlapping areas"));
+	check_overlap_check->setChecked(rule.check_overlap);
+	
+	auto form_layout = new QFormLayout();
+	form_layout->addRow(tr("Minimum area:"), min_area_edit);
+	form_layout->addRow(tr("Minimum length:"), min_length_edit);
+	form_layout->addRow(tr("Minimum gap:"), min_gap_edit);
+	form_layout->addRow(tr("Minimum point distance:"), min_point_distance_edit);
+	form_layout->addRow(check_overlap_check);
+	
+	issue_list = new QListWidget();
+	issue_list->setSelectionMode(QAbstractItemView::SingleSelection);
+	
+	auto check_button = new QPushButton(tr("Check"));
+	fix_button = new QPushButton(tr("Apply suggestion"));
+	
+	auto buttons_layout = new QHBoxLayout();
+	buttons_layout->addWidget(check_button);
+	buttons_layout->addStretch(1);
+	buttons_layout->addWidget(fix_button);
+	
+	auto layout = new QVBoxLayout();
+	layout->addLayout(form_layout);
+	layout->addWidget(issue_list, 1);
+	layout->addLayout(buttons_layout);
+	setLayout(layout);
+	
+	connect(check_button, &QPushButton::clicked, this, &MapValidatorWidget::checkMap);
+	connect(fix_button, &QPushButton::clicked, this, &MapValidatorWidget::applyFix);
+	connect(issue_list, &QListWidget::itemActivated, this, &MapValidatorWidget::showCurrentIssue);
+	connect(issue_list, &QListWidget::currentRowChanged, this, &MapValidatorWidget::updateButtons);
+	
+	updateButtons();
+}
+
+MapValidatorWidget::~MapValidatorWidget() = default;
+
+
+void MapValidatorWidget::checkMap()
+{
+	MapValidator::Options options;
+	options.default_rule.min_area = min_area_edit->value();
+	options.default_rule.min_length = min_length_edit->value();
+	options.default_rule.min_gap = min_gap_edit->value();
+	options.default_rule.min_point_distance = min_point_distance_edit->value();
+	options.default_rule.check_overlap = check_overlap_check->isChecked();
+	
+	auto row = issue_list->currentRow();
+	issue_list->clear();
+	
+	validator = std::make_unique<MapValidator>(*map, options);
+	if (!validator->validate())
+	{
+		controller->getWindow()->showStatusBarMessage(validator->errorString(), 2000);
+		validator.reset();
+		updateButtons();
+		return;
+	}
+	
+	const auto& issues = validator->issues();
+	for (const auto& issue : issues)
+		issue_list->addItem(MapValidator::description(issue));
+	
+	if (!issues.empty())
+		issue_list->setCurrentRow(std::max(0, std::min(row, int(issues.size()) - 1)));
+	controller->getWindow()->showStatusBarMessage(tr("%n issue(s) found", nullptr, int(issues.size())), 2000);
+	updateButtons();
+}
+
+
+void MapValidatorWidget::showCurrentIssue()
+{
+	auto row = issue_list->currentRow();
+	if (!isIssueValid(row))
+	{
+		controller->getWindow()->showStatusBarMessage(tr("The map was modified. Please check again."), 2000);
+		return;
+	}
+	
+	const auto& issue = validator->issues()[std::size_t(row)];
+	if (map->getCurrentPartIndex() != std::size_t(issue.part))
+		map->setCurrentPartIndex(std::size_t(issue.part));
+	
+	map->clearObjectSelection(false);
+	map->addObjectToSelection(issue.object, false);
+	if (issue.other)
+		map->addObjectToSelection(issue.other, false);
+	map->emitSelectionChanged();
+	
+	controller->getMainWidget()->ensureVisibilityOfRect(issue.extent, MapWidget::DiscreteZoom);
+}
+
+
+void MapValidatorWidget::applyFix()
+{
+	auto row = issue_list->currentRow();
+	if (!isIssueValid(row))
+	{
+		controller->getWindow()->showStatusBarMessage(tr("The map was modified. Please check again."), 2000);
+		return;
+	}
+	
+	showCurrentIssue();
+	
+	const auto& issue = validator->issues()[std::size_t(row)];
+	switch (issue.fix)
+	{
+	case MapValidator::NoFix:
+		return;
+		
+	case MapValidator::DeleteObject:
+		map->clearObjectSelection(false);
+		map->addObjectToSelection(issue.object, true);
+		map->deleteSelectedObjects();
+		break;
+		
+	case MapValidator::MergeObjects:
+		controller->booleanUnionClicked();
+		break;
+		
+	case MapValidator::MoveObject:
+		{
+			auto part = map->getCurrentPart();
+			auto undo_step = new ReplaceObjectsUndoStep(map);
+			undo_step->addObject(part->findObjectIndex(issue.object), issue.object->duplicate());
+			issue.object->move(MapCoord(issue.fix_offset));
+			issue.object->update();
+			map->setObjectsDirty();
+			map->push(undo_step);
+			map->emitSelectionEdited();
+		}
+		break;
+	}
+	
+	checkMap();
+}
+
+
+void MapValidatorWidget::updateButtons()
+{
+	auto row = issue_list->currentRow();
+	fix_button->setEnabled(validator
+	                       && row >= 0 && std::size_t(row) < validator->issues().size()
+	                       && validator->issues()[std::size_t(row)].fix != MapValidator::NoFix);
+}
+
+
+bool MapValidatorWidget::isIssueValid(int row) const
+{
+	if (!validator || row < 0 || std::size_t(row) >= validator->issues().size())
+		return false;
+	
+	const auto& issue = validator->issues()[std::size_t(row)];
+	if (issue.part < 0 || issue.part >= map->getNumParts())
+		return false;
+	
+	auto part = map->getPart(std::size_t(issue.part));
+	return part->findObjectIndex(issue.object) >= 0
+	       && (!issue.other || part->findObjectIndex(issue.other) >= 0);
+}
+
+
+}  // namespace OpenOrienteering
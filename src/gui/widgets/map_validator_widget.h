@@ -0,0 +1,97 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef OPENORIENTEERING_MAP_VALIDATOR_WIDGET_H
+#define OPENORIENTEERING_MAP_VALIDATOR_WIDGET_H
+
+#include <memory>
+
+#include <QObject>
+#include <QWidget>
+
+class QCheckBox;
+class QDoubleSpinBox;
+class QListWidget;
+class QPushButton;
+
+namespace OpenOrienteering {
+
+class Map;
+class MapEditorController;
+class MapValidator;
+
+
+/**
+ * The widget which is shown in a dock widget for map validation.
+ * 
+ * It lets the user edit the default validation rule, and it lists the issues
+ * found by MapValidator. Activating an issue selects the involved objects and
+ * shows them in the main map widget. The suggested fix of the current issue
+ * can be applied with an undo step.
+ */
+class MapValidatorWidget : public QWidget
+{
+Q_OBJECT
+public:
+	/** Creates a new MapValidatorWidget for the controller's map. */
+	explicit MapValidatorWidget(MapEditorController* controller, QWidget* parent = nullptr);
+	
+	/** Destroys the MapValidatorWidget. */
+	~MapValidatorWidget() override;
+	
+protected slots:
+	/** Validates the map and updates the list of issues. */
+	void checkMap();
+	
+	/** Selects the objects of the current issue and shows them. */
+	void showCurrentIssue();
+	
+	/** Applies the suggested fix of the current issue, and checks the map again. */
+	void applyFix();
+	
+	/** Enables the fix button if the current issue has a suggested fix. */
+	void updateButtons();
+	
+private:
+	/**
+	 * Returns true if the objects of the issue are still in the map.
+	 * 
+	 * The issues are not updated when the map is edited.
+	 */
+	bool isIssueValid(int row) const;
+	
+	MapEditorController* controller;
+	Map* map;
+	std::unique_ptr<MapValidator> validator;
+	
+	QDoubleSpinBox* min_area_edit;
+	QDoubleSpinBox* min_length_edit;
+	QDoubleSpinBox* min_gap_edit;
+	QDoubleSpinBox* min_point_distance_edit;
+	QCheckBox* check_overlap_check;
+	QListWidget* issue_list;
+	QPushButton* fix_button;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -25,6 +25,7 @@
 #include <QScroller>
 
 #include "core/map.h"
+#include "core/selection_statistics.h"
 #include "core/objects/object.h"
 #include "core/symbols/symbol.h"
 #include "core/symbols/area_symbol.h"
@@ -55,6 +56,10 @@ void MeasureWidget::objectSelectionChanged()
 	QString body;       // HTML blocks
 	QString extra_text; // inline HTML
 	
+	static const QString table_row{ QLatin1String{
+	  "<tr><td>%1</td><td align=\"center\">%2 %3</td><td align=\"center\">(%4 %5)</td></tr>" 
+	} };
+	
 	auto& selected_objects = map->selectedObjects();
 	if (selected_objects.empty())
 	{
@@ -63,6 +68,29 @@ void MeasureWidget::objectSelectionChanged()
 	else if (selected_objects.size() > 1)
 	{
 		extra_text = tr("%1 objects selected.").arg(locale().toString(map->getNumSelectedObjects()));
+		
+		const auto& statistics = map->selectionStatistics();
+		if (statistics.contains(SelectionStatistics::Path))
+		{
+			body = QLatin1String{ "<table>" };
+			
+			double paper_to_real = 0.001 * map->getScaleDenominator();
+			
+			auto paper_length = statistics.totalLength();
+			body.append(table_row.arg(tr("Total length:"),
+			                          locale().toString(paper_length, 'f', 2), tr("mm", "millimeters"),
+			                          locale().toString(paper_length * paper_to_real, 'f', 0), tr("m", "meters")));
+			
+			if (statistics.contains(SelectionStatistics::Area))
+			{
+				auto paper_area = statistics.totalArea();
+				body.append(table_row.arg(tr("Total area:"),
+				                          locale().toString(paper_area, 'f', 2), trUtf8("mm²", "square millimeters"),
+				                          locale().toString(paper_area * paper_to_real * paper_to_real, 'f', 0), trUtf8("m²", "square meters")));
+			}
+			
+			body.append(QLatin1String("</table>"));
+		}
 	}
 	else
 	{
@@ -77,9 +105,6 @@ void MeasureWidget::objectSelectionChanged()
 		else
 		{
 			body = QLatin1String{ "<table>" };
-			static const QString table_row{ QLatin1String{
-			  "<tr><td>%1</td><td align=\"center\">%2 %3</td><td align=\"center\">(%4 %5)</td></tr>" 
-			} };
 			
 			double paper_to_real = 0.001 * map->getScaleDenominator();
 			
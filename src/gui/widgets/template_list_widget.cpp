@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2017 Kai Pastor
+ *    Copyright 2012-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -49,6 +49,7 @@
 #include "templates/template.h"
 #include "templates/template_adjust.h"
 #include "templates/template_map.h"
+#include "templates/template_point_cloud.h"
 #include "templates/template_tool_move.h"
 #include "util/item_delegates.h"
 
@@ -236,6 +237,7 @@ TemplateListWidget::TemplateListWidget(Map* map, MapView* main_view, MapEditorCo
 	position_action = edit_menu->addAction(tr("Positioning..."));
 	position_action->setCheckable(true);
 	import_action =  edit_menu->addAction(tr("Import and remove"), this, SLOT(importClicked()));
+	point_cloud_action = edit_menu->addAction(tr("Point cloud settings..."), this, SLOT(pointCloudSettingsClicked()));
 	
 	edit_button = newToolButton(QIcon(QString::fromLatin1(":/images/settings.png")),
 	                            ::OpenOrienteering::MapEditorController::tr("&Edit").remove(QLatin1Char('&')));
@@ -722,8 +724,8 @@ void TemplateListWidget::cellChange(int row, int column)
 				if (!qFuzzyCompare(1.0f+opacity, 1.0f+visibility.opacity))
 				{
 					visibility.opacity = qBound(0.0f, opacity, 1.0f);
+					// The map widgets composite the template layers again.
 					updateVisibility(temp, visibility);
-					setAreaDirty();
 					template_table->item(row, 1)->setData(Qt::DecorationRole, QColor::fromCmykF(0.0f, 0.0f, 0.0f, visibility.opacity));
 				}
 			}
@@ -793,6 +795,7 @@ void TemplateListWidget::updateButtons()
 	bool custom_visible = false;
 	bool custom_active  = false;
 	bool import_active  = false;
+	bool point_cloud_active = false;
 	if (mobile_mode)
 	{
 		// Leave most buttons invisible
@@ -812,6 +815,7 @@ void TemplateListWidget::updateButtons()
 			custom_active = template_table->item(visited_row, 0)->checkState() == Qt::Checked;
 		}
 		import_active = qobject_cast<TemplateMap*>(getCurrentTemplate());
+		point_cloud_active = qobject_cast<TemplatePointCloud*>(getCurrentTemplate());
 	}
 	else if (single_row_selected)
 	{
@@ -828,6 +832,7 @@ void TemplateListWidget::updateButtons()
 	position_action->setEnabled(custom_active);
 	position_action->setVisible(custom_visible);
 	import_action->setVisible(import_active);
+	point_cloud_action->setVisible(point_cloud_active);
 	
 /*	if (enable_active_buttons)
 	{
@@ -951,6 +956,21 @@ void TemplateListWidget::positionClicked(bool checked)
 		controller->addTemplatePositionDockWidget(temp);
 }
 
+void TemplateListWidget::pointCloudSettingsClicked()
+{
+	auto point_cloud = qobject_cast<TemplatePointCloud*>(getCurrentTemplate());
+	if (!point_cloud)
+		return;
+	
+	TemplatePointCloudDialog dialog(point_cloud, window());
+	dialog.setWindowModality(Qt::WindowModal);
+	if (dialog.exec() == QDialog::Accepted)
+	{
+		point_cloud->setProduct(dialog.product(), dialog.band());
+		map->setTemplatesDirty();
+	}
+}
+
 void TemplateListWidget::importClicked()
 {
 	auto prototype = qobject_cast<const TemplateMap*>(getCurrentTemplate());
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2015 Kai Pastor
+ *    Copyright 2015, 2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -19,6 +19,8 @@
 
 #include "advanced_pdf_printer.h"
 
+#include <QPainter>
+
 #include <advanced_pdf_p.h>
 #include <printengine_advanced_pdf_p.h>
 
@@ -48,3 +50,28 @@ QPaintEngine::Type AdvancedPdfPrinter::paintEngineType()
 {
 	return AdvancedPdfEngine::PaintEngineType;
 }
+
+bool AdvancedPdfPrinter::fillTilingPattern(QPainter& painter, const QPainterPath& path, const QPainterPath& cell, const QTransform& matrix, const QColor& color)
+{
+	auto engine = painter.paintEngine();
+	if (!engine || engine->type() != paintEngineType())
+		return false;
+	
+	// The painter passes its state lazily.
+	engine->syncState();
+	static_cast<AdvancedPdfEngine*>(engine)->fillTilingPattern(path, cell, matrix, color);
+	return true;
+}
+
+bool AdvancedPdfPrinter::drawText(QPainter& painter, const QPointF& position, const QString& text, bool stroke)
+{
+	auto engine = painter.paintEngine();
+	if (!engine || engine->type() != paintEngineType())
+		return false;
+	
+	auto pdf_engine = static_cast<AdvancedPdfEngine*>(engine);
+	pdf_engine->setStrokeText(stroke);
+	painter.drawText(position, text);
+	pdf_engine->setStrokeText(false);
+	return true;
+}
@@ -1,5 +1,5 @@
 /*
- *    Copyright 2015 Kai Pastor
+ *    Copyright 2015, 2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -25,6 +25,12 @@
 #include <QPaintEngine>
 #include <QPrinter>
 
+class QColor;
+class QPainter;
+class QPainterPath;
+class QPointF;
+class QString;
+class QTransform;
 
 class AdvancedPdfPrintEngine;
 
@@ -43,6 +49,31 @@ public:
 	/** Returns the paint engine type which is used for advanced pdf generation. */
 	static QPaintEngine::Type paintEngineType();
 	
+	/**
+	 * Fills the path with a vector tiling pattern in the given color.
+	 * 
+	 * The pattern cell is given in pattern space where the pattern repeats
+	 * with a step of 1 in both directions. The matrix maps pattern space to
+	 * the painter's logical coordinates. The cell is written to the PDF only
+	 * once per document, no matter how often it is used.
+	 * 
+	 * Returns false if the painter does not paint on the advanced PDF engine.
+	 */
+	static bool fillTilingPattern(QPainter& painter, const QPainterPath& path,
+	                              const QPainterPath& cell, const QTransform& matrix,
+	                              const QColor& color);
+	
+	/**
+	 * Draws the text with an embedded font subset.
+	 * 
+	 * The text is filled with the painter's pen color, or stroked with the
+	 * painter's pen if stroke is true. In contrast to QPainter::drawText(),
+	 * the latter produces outlined glyphs in the PDF's text object.
+	 * 
+	 * Returns false if the painter does not paint on the advanced PDF engine.
+	 */
+	static bool drawText(QPainter& painter, const QPointF& position, const QString& text, bool stroke);
+	
 private:
 	std::unique_ptr<AdvancedPdfPrintEngine> engine;
 };
@@ -13,6 +13,8 @@ cd $SUBDIR
 patch -p1 < ../patches/producer.diff || exit 1
 patch -p1 < ../patches/devicecmyk.diff || exit 1
 patch -p1 < ../patches/enginetype.diff || exit 1
+patch -p1 < ../patches/tilingpattern.diff || exit 1
+patch -p1 < ../patches/textstroke.diff || exit 1
 cd
 
 exit 0
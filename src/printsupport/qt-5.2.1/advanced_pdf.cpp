@@ -24,6 +24,8 @@
  * - Change of the PDF Producer property
  * - Use of DeviceCMYK color space in PDF output
  * - Distinct paint engine type
+ * - Tiling patterns from vector pattern cells
+ * - Stroked text
  */
 /****************************************************************************
 **
@@ -1169,6 +1171,15 @@ void AdvancedPdfEngine::drawTextItem(const QPointF &p, const QTextItem &textItem
     if(!d->simplePen)
         *d->currentPage << AdvancedPdf::generateMatrix(d->stroker.matrix);
 
+    if (d->strokeText) {
+        setPen();
+        const QTextItemInt &ti = static_cast<const QTextItemInt &>(textItem);
+        Q_ASSERT(ti.fontEngine->type() != QFontEngine::Multi);
+        d->drawTextItem(p, ti);
+        *d->currentPage << "Q\n";
+        return;
+    }
+
     bool hp = d->hasPen;
     d->hasPen = false;
     QBrush b = d->brush;
@@ -1183,6 +1194,12 @@ void AdvancedPdfEngine::drawTextItem(const QPointF &p, const QTextItem &textItem
     *d->currentPage << "Q\n";
 }
 
+void AdvancedPdfEngine::setStrokeText(bool enabled)
+{
+    Q_D(AdvancedPdfEngine);
+    d->strokeText = enabled;
+}
+
 
 void AdvancedPdfEngine::updateState(const QPaintEngineState &state)
 {
@@ -1415,6 +1432,113 @@ bool AdvancedPdfEngine::newPage()
     return true;
 }
 
+void AdvancedPdfEngine::fillTilingPattern(const QPainterPath &path, const QPainterPath &cell,
+                                          const QTransform &matrix, const QColor &color)
+{
+    Q_D(AdvancedPdfEngine);
+
+    if (d->clipEnabled && d->allClipped)
+        return;
+
+    // Like brush patterns, the pattern matrix refers to the default page space.
+    int patternObject = d->addTilingPattern(cell, matrix * d->stroker.matrix * d->pageMatrix());
+    if (!patternObject)
+        return;
+
+    *d->currentPage << "q\n/PCSp cs ";
+    if (d->grayscale) {
+        qreal gray = (255-qGray(color.rgba()))/255.0;
+        *d->currentPage << 0.0 << 0.0 << 0.0 << gray;
+    } else {
+        *d->currentPage << color.cyanF()
+                        << color.magentaF()
+                        << color.yellowF()
+                        << color.blackF();
+    }
+    *d->currentPage << "/Pat" << patternObject << "scn\n";
+    *d->currentPage << AdvancedPdf::generatePath(path, d->simplePen ? QTransform() : d->stroker.matrix, AdvancedPdf::FillPath);
+    *d->currentPage << "Q\n";
+}
+
+// The cell's content is written once per document as a form XObject.
+// Each distinct matrix on a page gets a small uncolored tiling pattern
+// which paints this form.
+int AdvancedPdfEnginePrivate::addTilingPattern(const QPainterPath &cell, const QTransform &matrix)
+{
+    const QRectF bbox = cell.boundingRect();
+    if (bbox.isEmpty())
+        return 0;
+
+    const QByteArray content = AdvancedPdf::generatePath(cell, QTransform(), AdvancedPdf::FillPath);
+    int cellObject = tilingCellCache.value(content, 0);
+    if (!cellObject) {
+        QByteArray str;
+        AdvancedPdf::ByteStream s(&str);
+        s << "<<\n"
+            "/Type /XObject\n"
+            "/Subtype /Form\n"
+            "/BBox [" << bbox.left() << bbox.top() << bbox.right() << bbox.bottom() << "]\n"
+            "/Length " << content.length() << "\n"
+            ">>\n"
+            "stream\n"
+          << content
+          << "endstream\n"
+            "endobj\n";
+        cellObject = addXrefEntry(-1);
+        write(str);
+        tilingCellCache.insert(content, cellObject);
+    }
+
+    QByteArray key;
+    {
+        AdvancedPdf::ByteStream s(&key);
+        s << cellObject
+          << matrix.m11() << matrix.m12()
+          << matrix.m21() << matrix.m22()
+          << matrix.dx() << matrix.dy();
+    }
+    int patternObject = currentPage->tilingPatterns.value(key, 0);
+    if (patternObject)
+        return patternObject;
+
+    QByteArray pattern;
+    {
+        AdvancedPdf::ByteStream s(&pattern);
+        s << "/Cell" << cellObject << "Do\n";
+    }
+
+    QByteArray str;
+    AdvancedPdf::ByteStream s(&str);
+    s << "<<\n"
+        "/Type /Pattern\n"
+        "/PatternType 1\n"
+        "/PaintType 2\n"
+        "/TilingType 1\n"
+        "/BBox [" << bbox.left() << bbox.top() << bbox.right() << bbox.bottom() << "]\n"
+        "/XStep 1\n"
+        "/YStep 1\n"
+        "/Matrix ["
+      << matrix.m11()
+      << matrix.m12()
+      << matrix.m21()
+      << matrix.m22()
+      << matrix.dx()
+      << matrix.dy() << "]\n"
+        "/Resources \n<< /XObject << /Cell" << cellObject << cellObject << "0 R >> >>\n"
+        "/Length " << pattern.length() << "\n"
+        ">>\n"
+        "stream\n"
+      << pattern
+      << "endstream\n"
+        "endobj\n";
+
+    patternObject = addXrefEntry(-1);
+    write(str);
+    currentPage->patterns.append(patternObject);
+    currentPage->tilingPatterns.insert(key, patternObject);
+    return patternObject;
+}
+
 AdvancedPdfEngine::PaintEngineTypeStruct AdvancedPdfEngine::PaintEngineType = {};
 
 QPaintEngine::Type AdvancedPdfEngine::type() const
@@ -1474,7 +1598,7 @@ static inline QSizeF pageSizeToPostScriptPoints(const QSizeF &pageSizeMM)
 }
 
 AdvancedPdfEnginePrivate::AdvancedPdfEnginePrivate()
-    : clipEnabled(false), allClipped(false), hasPen(true), hasBrush(false), simplePen(false),
+    : clipEnabled(false), allClipped(false), hasPen(true), hasBrush(false), simplePen(false), strokeText(false),
       outDevice(0), ownsDevice(false),
       fullPage(false), embedFonts(true),
       landscape(false),
@@ -1541,6 +1665,7 @@ bool AdvancedPdfEngine::begin(QPaintDevice *pdev)
     d->pages.clear();
     d->imageCache.clear();
     d->alphaCache.clear();
+    d->tilingCellCache.clear();
 
     setActive(true);
     d->writeHeader();
@@ -2538,6 +2663,7 @@ void AdvancedPdfEnginePrivate::drawTextItem(const QPointF &p, const QTextItemInt
     qreal stretch = synthesized & QFontEngine::SynthesizedStretch ? ti.fontEngine->fontDef.stretch/100. : 1.;
 
     *currentPage << "BT\n"
+                 << (strokeText ? "1 Tr " : "")
                  << "/F" << font->object_id << size << "Tf "
                  << stretch << (synthesized & QFontEngine::SynthesizedItalic
                                 ? "0 .3 -1 0 0 Tm\n"
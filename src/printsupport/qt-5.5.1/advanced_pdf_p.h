@@ -22,6 +22,8 @@
  *   - Adjustment of include statements
  *   - Removal of Q_XXX_EXPORT
  *   - Distinct paint engine type
+ *   - Tiling patterns from vector pattern cells
+ *   - Stroked text
  */
 /****************************************************************************
 **
@@ -51,6 +53,7 @@
 #include "QtGui/qmatrix.h"
 #include "QtCore/qstring.h"
 #include "QtCore/qvector.h"
+#include "QtCore/qhash.h"
 #include <private/qstroker_p.h>
 #include <private/qpaintengine_p.h>
 #include <private/qfontengine_p.h>
@@ -146,6 +149,7 @@ public:
     QVector<uint> patterns;
     QVector<uint> fonts;
     QVector<uint> annotations;
+    QHash<QByteArray, uint> tilingPatterns;
 
     void streamImage(int w, int h, int object);
 
@@ -215,6 +219,16 @@ public:
     void setBrush();
     void setupGraphicsState(QPaintEngine::DirtyFlags flags);
 
+    // Fills the path with a vector tiling pattern in the given color.
+    // The cell is given in pattern space where the steps are 1 in both
+    // directions. The matrix maps pattern space to user space.
+    void fillTilingPattern(const QPainterPath &path, const QPainterPath &cell,
+                           const QTransform &matrix, const QColor &color);
+
+    // Controls whether text is stroked with the current pen (text rendering
+    // mode 1) instead of being filled with the pen's color.
+    void setStrokeText(bool enabled);
+
 private:
     void updateClipPath(const QPainterPath & path, Qt::ClipOperation op);
 };
@@ -234,6 +248,7 @@ public:
     int addImage(const QImage &image, bool *bitmap, qint64 serial_no);
     int addConstantAlphaObject(int brushAlpha, int penAlpha = 255);
     int addBrushPattern(const QTransform &matrix, bool *specifyColor, int *gStateObject);
+    int addTilingPattern(const QPainterPath &cell, const QTransform &matrix);
 
     void drawTextItem(const QPointF &p, const QTextItemInt &ti);
 
@@ -255,6 +270,7 @@ public:
     bool hasPen;
     bool hasBrush;
     bool simplePen;
+    bool strokeText;
     qreal opacity;
 
     QHash<QFontEngine::FaceId, QFontSubset *> fonts;
@@ -313,6 +329,7 @@ private:
     QVector<uint> pages;
     QHash<qint64, uint> imageCache;
     QHash<QPair<uint, uint>, uint > alphaCache;
+    QHash<QByteArray, uint> tilingCellCache;
 };
 
 QT_END_NAMESPACE
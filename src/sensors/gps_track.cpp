@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2014-2017 Kai Pastor
+ *    Copyright 2014-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,21 +21,34 @@
 
 #include "gps_track.h"
 
+#include <cstddef>
+
 #include <QApplication>
 #include <QFile>
 #include <QHash>
 #include <QMessageBox>
+#include <QPointF>
+#include <QRectF>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 // IWYU pragma: no_include <qxmlstream.h>
 
 #include "core/georeferencing.h"
+#include "core/transform_grid.h"
 #include "templates/template_track.h"
 #include "util/dxfparser.h"
 
 
 namespace OpenOrienteering {
 
+namespace {
+
+/// The minimum number of points for which a TransformGrid pays off.
+constexpr std::size_t min_points_for_transform_grid = 256;
+
+}  // namespace
+
+
 // There is some (mis?)use of TrackPoint's gps_coord LatLon
 // as sort-of MapCoordF.
 // This function serves both for explicit conversion and highlighting.
@@ -618,26 +631,36 @@ bool Track::loadFromOSM(QFile* file, bool project_points, QWidget* dialog_parent
 
 void Track::projectPoints()
 {
+	TransformGrid::Transform transform;
 	if (track_crs->getProjectedCRSSpec() == Georeferencing::geographic_crs_spec)
 	{
-		int size = waypoints.size();
-		for (int i = 0; i < size; ++i)
-			waypoints[i].map_coord = map_georef.toMapCoordF(waypoints[i].gps_coord, nullptr); // FIXME: check for errors
-			
-		size = segment_points.size();
-		for (int i = 0; i < size; ++i)
-			segment_points[i].map_coord = map_georef.toMapCoordF(segment_points[i].gps_coord, nullptr); // FIXME: check for errors
+		transform = [this](const QPointF& source, QPointF& target) {
+			bool ok;
+			target = map_georef.toMapCoordF(LatLon(source.y(), source.x()), &ok);
+			return ok;
+		};
 	}
 	else
 	{
-		int size = waypoints.size();
-		for (int i = 0; i < size; ++i)
-			waypoints[i].map_coord = map_georef.toMapCoordF(track_crs, fakeMapCoordF(waypoints[i].gps_coord), nullptr); // FIXME: check for errors
-			
-		size = segment_points.size();
-		for (int i = 0; i < size; ++i)
-			segment_points[i].map_coord = map_georef.toMapCoordF(track_crs, fakeMapCoordF(segment_points[i].gps_coord), nullptr); // FIXME: check for errors
+		transform = [this](const QPointF& source, QPointF& target) {
+			bool ok;
+			target = map_georef.toMapCoordF(track_crs, MapCoordF(source), &ok);
+			return ok;
+		};
 	}
+	
+	// For many points, most of the exact transformations are replaced by
+	// interpolation. The error stays below the resolution of map coordinates.
+	auto const source = [](const TrackPoint& point) { return QPointF(fakeMapCoordF(point.gps_coord)); };
+	auto extent = QRectF();
+	if (waypoints.size() + segment_points.size() >= min_points_for_transform_grid)
+		extent = TransformGrid::boundingBox(waypoints, source).united(TransformGrid::boundingBox(segment_points, source));
+	TransformGrid grid(transform, extent, 0.001);
+	
+	for (auto& point : waypoints)
+		point.map_coord = MapCoordF(grid.map(source(point))); // FIXME: check for errors
+	for (auto& point : segment_points)
+		point.map_coord = MapCoordF(grid.map(source(point))); // FIXME: check for errors
 }
 
 
@@ -111,6 +111,7 @@ Settings::Settings()
 		ppi = QApplication::primaryScreen()->logicalDotsPerInch();
 	
 	registerSetting(MapDisplay_TextAntialiasing, "MapDisplay/text_antialiasing", false);
+	registerSetting(MapDisplay_StrokeOutlines, "MapDisplay/stroke_outlines", false);
 	registerSetting(MapEditor_ClickToleranceMM, "MapEditor/click_tolerance_mm", map_editor_click_tolerance_default);
 	registerSetting(MapEditor_SnapDistanceMM, "MapEditor/snap_distance_mm", map_editor_snap_distance_default);
 	registerSetting(MapEditor_FixedAngleStepping, "MapEditor/fixed_angle_stepping", 15);
@@ -120,6 +121,7 @@ Settings::Settings()
 	
 	registerSetting(EditTool_DeleteBezierPointAction, "EditTool/delete_bezier_point_action", int(DeleteBezierPoint_RetainExistingShape));
 	registerSetting(EditTool_DeleteBezierPointActionAlternative, "EditTool/delete_bezier_point_action_alternative", int(DeleteBezierPoint_ResetHandles));
+	registerSetting(EditTool_MoveSharedNodes, "EditTool/move_shared_nodes", false);
 	
 	registerSetting(RectangleTool_HelperCrossRadiusMM, "RectangleTool/helper_cross_radius_mm", 100.0f);
 	registerSetting(RectangleTool_PreviewLineWidth, "RectangleTool/preview_line_with", true);
@@ -140,6 +142,7 @@ Settings::Settings()
 	registerSetting(General_Local8BitEncoding, "local_8bit_encoding", QLatin1String("Default"));
 	registerSetting(General_NewOcd8Implementation, "new_ocd8_implementation", true);
 	registerSetting(General_StartDragDistance, "startDragDistance", start_drag_distance_default);
+	registerSetting(General_ObjectMemoryBudget, "objectMemoryBudget", 1024); // unit: MiB, 0: no limit
 	
 	registerSetting(HomeScreen_TipsVisible, "HomeScreen/tipsVisible", true);
 	registerSetting(HomeScreen_CurrentTip, "HomeScreen/currentTip", -1);
@@ -45,6 +45,7 @@ public:
 	{
 		MapDisplay_Antialiasing = 0,
 		MapDisplay_TextAntialiasing,
+		MapDisplay_StrokeOutlines,
 		MapEditor_ClickToleranceMM,
 		MapEditor_SnapDistanceMM,
 		MapEditor_FixedAngleStepping,
@@ -53,6 +54,7 @@ public:
 		MapEditor_DrawLastPointOnRightClick,
 		EditTool_DeleteBezierPointAction,
 		EditTool_DeleteBezierPointActionAlternative,
+		EditTool_MoveSharedNodes,
 		RectangleTool_HelperCrossRadiusMM,
 		RectangleTool_PreviewLineWidth,
 		Templates_KeepSettingsOfClosed,
@@ -69,6 +71,7 @@ public:
 		General_Local8BitEncoding,
 		General_NewOcd8Implementation,
 		General_StartDragDistance,
+		General_ObjectMemoryBudget,
 		HomeScreen_TipsVisible,
 		HomeScreen_CurrentTip,
 		END_OF_SETTINGSENUM /* Don't add items below this line. */
@@ -0,0 +1,251 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "las_reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QtEndian>
+#include <QIODevice>
+#include <QRegularExpression>
+#include <QRegularExpressionMatchIterator>
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The size of the LAS 1.0 to 1.2 header
+constexpr int legacy_header_size = 227;
+
+/// The size of the LAS 1.4 header
+constexpr int header_size_14 = 375;
+
+/// The minimum record length of point data record formats 0 to 10
+constexpr int min_record_length[11] = { 20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67 };
+
+/// The size of the header of a variable length record
+constexpr int vlr_header_size = 54;
+
+/// The record ID of the GeoTIFF GeoKeyDirectoryTag record
+constexpr quint16 geo_key_directory_id = 34735;
+
+/// The record ID of the OGC coordinate system WKT record
+constexpr quint16 ogc_wkt_id = 2112;
+
+/// The GeoTIFF key for the EPSG code of a projected CRS
+constexpr quint16 projected_cs_type_key = 3072;
+
+/// The GeoTIFF value for user-defined parameters
+constexpr quint16 user_defined = 32767;
+
+
+template <class T>
+T readLE(const char* data)
+{
+	return qFromLittleEndian<T>(reinterpret_cast<const uchar*>(data));
+}
+
+double readDouble(const char* data)
+{
+	auto const bits = readLE<quint64>(data);
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+
+}  // namespace
+
+
+
+LasReader::LasReader(const QString& path)
+: file(path)
+{
+	// nothing else
+}
+
+LasReader::~LasReader()
+{
+	// nothing, not inlined
+}
+
+
+bool LasReader::open()
+{
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		error_string = file.errorString();
+		return false;
+	}
+
+	auto const header = file.read(header_size_14);
+	if (header.size() < legacy_header_size || !header.startsWith("LASF"))
+	{
+		error_string = tr("Not a LAS file.");
+		return false;
+	}
+
+	auto const data = header.constData();
+	las_version = 10 * quint8(data[24]) + quint8(data[25]);
+	auto const header_size = int(readLE<quint16>(data + 94));
+	point_offset = readLE<quint32>(data + 96);
+	auto const format = quint8(data[104]);
+	record_length = readLE<quint16>(data + 105);
+	point_count = readLE<quint32>(data + 107);
+
+	if (format & 0xc0)
+	{
+		error_string = tr("Compressed LAS files (LAZ) are not supported.");
+		return false;
+	}
+	point_format = format;
+	if (point_format > 10 || record_length < min_record_length[point_format])
+	{
+		error_string = tr("Unsupported point data format: %1").arg(point_format);
+		return false;
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		scale[i] = readDouble(data + 131 + 8 * i);
+		offset[i] = readDouble(data + 155 + 8 * i);
+	}
+	max_x = readDouble(data + 179);
+	min_x = readDouble(data + 187);
+	max_y = readDouble(data + 195);
+	min_y = readDouble(data + 203);
+	max_z = readDouble(data + 211);
+	min_z = readDouble(data + 219);
+
+	if (las_version >= 14 && header_size >= header_size_14 && header.size() >= header_size_14)
+	{
+		auto const count = readLE<quint64>(data + 247);
+		if (count > 0)
+			point_count = count;
+	}
+
+	if (!readCrs(header_size, readLE<quint32>(data + 100)))
+		return false;
+
+	if (!file.seek(qint64(point_offset)))
+	{
+		error_string = file.errorString();
+		return false;
+	}
+	points_read = 0;
+	return true;
+}
+
+
+bool LasReader::readCrs(int header_size, quint32 num_records)
+{
+	epsg_code = 0;
+	auto pos = qint64(header_size);
+	for (quint32 i = 0; i < num_records; ++i)
+	{
+		if (pos + vlr_header_size > qint64(point_offset) || !file.seek(pos))
+			break;  // Not a valid record, but the points may be fine.
+
+		auto const vlr_header = file.read(vlr_header_size);
+		if (vlr_header.size() != vlr_header_size)
+		{
+			error_string = file.error() == QFileDevice::NoError ? tr("Unexpected end of file.") : file.errorString();
+			return false;
+		}
+		auto const user_id = QByteArray(vlr_header.constData() + 2, 16);
+		auto const record_id = readLE<quint16>(vlr_header.constData() + 18);
+		auto const length = readLE<quint16>(vlr_header.constData() + 20);
+		pos += vlr_header_size + length;
+		if (!user_id.startsWith("LASF_Projection"))
+			continue;
+
+		auto const record = file.read(length);
+		if (record_id == geo_key_directory_id && record.size() >= 8)
+		{
+			// Header and entries of four unsigned shorts each
+			auto const num_keys = int(readLE<quint16>(record.constData() + 6));
+			for (int key = 1; key <= num_keys && 8 * key + 8 <= record.size(); ++key)
+			{
+				auto const entry = record.constData() + 8 * key;
+				auto const location = readLE<quint16>(entry + 2);
+				auto const value = readLE<quint16>(entry + 6);
+				if (readLE<quint16>(entry) == projected_cs_type_key && location == 0 && value != user_defined)
+					epsg_code = value;
+			}
+		}
+		else if (record_id == ogc_wkt_id && epsg_code == 0)
+		{
+			// The last EPSG authority refers to the CRS as a whole.
+			QRegularExpression authority(QStringLiteral("(?:AUTHORITY\\[\"EPSG\",\\s*\"|ID\\[\"EPSG\",\\s*)(\\d+)"));
+			auto matches = authority.globalMatch(QString::fromUtf8(record));
+			while (matches.hasNext())
+				epsg_code = matches.next().captured(1).toInt();
+		}
+	}
+	return true;
+}
+
+
+bool LasReader::read(std::vector<LasPoint>& points, std::size_t max_count)
+{
+	points.clear();
+	auto const count = std::size_t(std::min(quint64(max_count), point_count - points_read));
+	if (count == 0)
+		return true;
+
+	buffer.resize(int(count * std::size_t(record_length)));
+	if (file.read(buffer.data(), buffer.size()) != buffer.size())
+	{
+		error_string = file.error() == QFileDevice::NoError ? tr("Unexpected end of file.") : file.errorString();
+		return false;
+	}
+	points_read += count;
+
+	points.resize(count);
+	auto record = buffer.constData();
+	auto const extended_format = point_format >= 6;
+	for (auto& point : points)
+	{
+		point.x = readLE<qint32>(record) * scale[0] + offset[0];
+		point.y = readLE<qint32>(record + 4) * scale[1] + offset[1];
+		point.z = readLE<qint32>(record + 8) * scale[2] + offset[2];
+		point.intensity = readLE<quint16>(record + 12);
+		auto const returns = quint8(record[14]);
+		if (extended_format)
+		{
+			point.return_number = returns & 0x0f;
+			point.number_of_returns = returns >> 4;
+			point.classification = quint8(record[16]);
+		}
+		else
+		{
+			point.return_number = returns & 0x07;
+			point.number_of_returns = (returns >> 3) & 0x07;
+			point.classification = quint8(record[15]) & 0x1f;
+		}
+		record += record_length;
+	}
+	return true;
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,162 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_LAS_READER_H
+#define OPENORIENTEERING_LAS_READER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QFile>
+#include <QString>
+
+
+namespace OpenOrienteering {
+
+/**
+ * A point of a LiDAR point cloud.
+ */
+struct LasPoint
+{
+	/// ASPRS standard classes
+	enum Classification
+	{
+		Unclassified   = 1,
+		Ground         = 2,
+		LowVegetation  = 3,
+		MedVegetation  = 4,
+		HighVegetation = 5,
+		Building       = 6,
+		Noise          = 7,
+		Water          = 9
+	};
+
+	double x;
+	double y;
+	double z;
+	quint16 intensity;
+	quint8 classification;
+	quint8 return_number;
+	quint8 number_of_returns;
+};
+
+
+/**
+ * A streaming reader for ASPRS LAS files, versions 1.0 to 1.4.
+ *
+ * The point records are read sequentially in chunks of limited size, so that
+ * the memory use does not depend on the size of the file. Only the core
+ * attributes of the point data record formats 0 to 10 are decoded.
+ * Compressed files (LAZ) are not supported.
+ *
+ * \see https://www.asprs.org/committee-general/laser-las-file-format-exchange-activities.html
+ */
+class LasReader
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::LasReader)
+
+public:
+	/** Constructs a reader for the given file. */
+	explicit LasReader(const QString& path);
+
+	LasReader(const LasReader&) = delete;
+	LasReader& operator=(const LasReader&) = delete;
+
+	/** Destructor. */
+	~LasReader();
+
+	/**
+	 * Opens the file and reads the header.
+	 *
+	 * Returns false on error.
+	 */
+	bool open();
+
+	/** Returns a description of the last error. */
+	const QString& errorString() const { return error_string; }
+
+	/** Returns the version as major * 10 + minor, e.g. 12 for LAS 1.2. */
+	int version() const { return las_version; }
+
+	/** Returns the point data record format. */
+	int pointFormat() const { return point_format; }
+
+	/** Returns the number of point records. */
+	quint64 pointCount() const { return point_count; }
+
+	double minX() const { return min_x; }
+	double minY() const { return min_y; }
+	double minZ() const { return min_z; }
+	double maxX() const { return max_x; }
+	double maxY() const { return max_y; }
+	double maxZ() const { return max_z; }
+
+	/**
+	 * Returns the EPSG code of the projected CRS, or 0 if unknown.
+	 *
+	 * The code is taken from the GeoTIFF keys or from the OGC WKT in the
+	 * variable length records. Extended variable length records (LAS 1.4)
+	 * are not read.
+	 */
+	int epsgCode() const { return epsg_code; }
+
+	/**
+	 * Reads the next chunk of at most max_count points.
+	 *
+	 * The points replace the previous contents of the given vector. At the
+	 * end of the data, the vector is empty. Returns false on error.
+	 */
+	bool read(std::vector<LasPoint>& points, std::size_t max_count);
+
+private:
+	/**
+	 * Reads the CRS from the variable length records.
+	 *
+	 * Returns false on error.
+	 */
+	bool readCrs(int header_size, quint32 num_records);
+
+	QFile file;
+	QString error_string;
+	QByteArray buffer;
+	int las_version = 0;
+	int point_format = 0;
+	int record_length = 0;
+	quint64 point_offset = 0;
+	quint64 point_count = 0;
+	quint64 points_read = 0;
+	double scale[3] = {};
+	double offset[3] = {};
+	double min_x = 0;
+	double min_y = 0;
+	double min_z = 0;
+	double max_x = 0;
+	double max_y = 0;
+	double max_z = 0;
+	int epsg_code = 0;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -40,6 +40,7 @@
 #include "gui/file_dialog.h"
 #include "templates/template_image.h"
 #include "templates/template_map.h"
+#include "templates/template_point_cloud.h"
 #include "templates/template_track.h"
 #include "util/backports.h"  // IWYU pragma: keep
 #include "util/util.h"
@@ -840,14 +841,17 @@ const std::vector<QByteArray>& Template::supportedExtensions()
 #else
 		auto ogr_extensions    = std::vector<QByteArray>{ };
 #endif
+		auto& point_cloud_extensions = TemplatePointCloud::supportedExtensions();
 		auto& track_extensions = TemplateTrack::supportedExtensions();
 		extensions.reserve(image_extensions.size()
 		                   + map_extensions.size()
 		                   + ogr_extensions.size()
+		                   + point_cloud_extensions.size()
 		                   + track_extensions.size());
 		extensions.insert(end(extensions), begin(image_extensions), end(image_extensions));
 		extensions.insert(end(extensions), begin(map_extensions), end(map_extensions));
 		extensions.insert(end(extensions), begin(ogr_extensions), end(ogr_extensions));
+		extensions.insert(end(extensions), begin(point_cloud_extensions), end(point_cloud_extensions));
 		extensions.insert(end(extensions), begin(track_extensions), end(track_extensions));
 	}
 	return extensions;
@@ -871,6 +875,8 @@ std::unique_ptr<Template> Template::templateForFile(const QString& path, Map* ma
 	else if (path_ends_with_any_of(OgrTemplate::supportedExtensions()))
 		t.reset(new OgrTemplate(path, map));
 #endif
+	else if (path_ends_with_any_of(TemplatePointCloud::supportedExtensions()))
+		t.reset(new TemplatePointCloud(path, map));
 	else if (path_ends_with_any_of(TemplateTrack::supportedExtensions()))
 		t.reset(new TemplateTrack(path, map));
 #ifdef MAPPER_USE_GDAL
@@ -0,0 +1,1017 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "template_point_cloud.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include <QtEndian>
+#include <QByteArray>
+#include <QComboBox>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QLatin1Char>
+#include <QLatin1String>
+#include <QLocale>
+#include <QMessageBox>
+#include <QPainter>
+#include <QRunnable>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTransform>
+#include <QXmlStreamAttributes>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "core/georeferencing.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "gui/task_progress_dialog.h"
+#include "gui/util_gui.h"
+#include "templates/las_reader.h"
+#include "util/transformation.h"
+#include "util/util.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/// The version of the cache layout
+constexpr int cache_version = 1;
+
+/// The magic number of tile files ("MPCT")
+constexpr quint32 tile_magic = 0x4d504354;
+
+/// The size of a point record in the temporary tile files
+constexpr int point_record_size = 16;
+
+/// The maximum number of tiles in a raster
+constexpr double max_num_tiles = 1 << 20;
+
+/// The maximum total size of the rendered tile images, in KiB
+constexpr int image_cache_size = 64 * 1024;
+
+
+/**
+ * Statistics of a single rasterized tile.
+ */
+struct TileStats
+{
+	float min_ground = std::numeric_limits<float>::infinity();
+	float max_ground = -std::numeric_limits<float>::infinity();
+	float max_intensity = 0;
+	QString error;
+};
+
+
+/**
+ * Rasterizes a single tile from its temporary point file.
+ */
+class TileRasterizer : public QRunnable
+{
+public:
+	TileRasterizer(const QString& points_path, const QString& tile_path,
+	               const PointCloudTiles::Options& options, TileStats& stats, std::atomic<int>& done)
+	: points_path(points_path)
+	, tile_path(tile_path)
+	, options(options)
+	, stats(stats)
+	, done(done)
+	{}
+
+	void run() override
+	{
+		rasterize();
+		++done;
+	}
+
+private:
+	void rasterize()
+	{
+		QByteArray data;
+		{
+			QFile points_file(points_path);
+			if (!points_file.open(QIODevice::ReadOnly))
+			{
+				stats.error = points_file.errorString();
+				return;
+			}
+			data = points_file.readAll();
+			points_file.close();
+			points_file.remove();
+		}
+
+		auto const cells = options.tile_cells;
+		auto const num_cells = std::size_t(cells) * std::size_t(cells);
+		auto const num_bands = options.band_limits.size() - 1;
+		auto const num_points = std::size_t(data.size() / point_record_size);
+		auto const records = data.constData();
+
+		auto cellIndex = [&](const char* record) {
+			auto const col = qBound(0, int(readFloat(record) / options.cell_size), cells - 1);
+			auto const row = qBound(0, int(readFloat(record + 4) / options.cell_size), cells - 1);
+			return std::size_t(row) * std::size_t(cells) + std::size_t(col);
+		};
+
+		std::vector<quint32> counts(num_cells, 0);
+		std::vector<quint32> ground_counts(num_cells, 0);
+		std::vector<double> ground_sums(num_cells, 0);
+		std::vector<double> intensity_sums(num_cells, 0);
+		std::vector<float> lowest(num_cells, std::numeric_limits<float>::infinity());
+		for (std::size_t i = 0; i < num_points; ++i)
+		{
+			auto const record = records + i * point_record_size;
+			auto const index = cellIndex(record);
+			auto const z = readFloat(record + 8);
+			++counts[index];
+			intensity_sums[index] += qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(record + 12));
+			lowest[index] = std::min(lowest[index], z);
+			if (quint8(record[14]) == LasPoint::Ground)
+			{
+				++ground_counts[index];
+				ground_sums[index] += z;
+			}
+		}
+
+		PointCloudTiles::Tile tile;
+		tile.ground.resize(num_cells);
+		tile.intensity.resize(num_cells);
+		for (std::size_t i = 0; i < num_cells; ++i)
+		{
+			if (counts[i] == 0)
+			{
+				tile.ground[i] = std::numeric_limits<float>::quiet_NaN();
+				tile.intensity[i] = std::numeric_limits<float>::quiet_NaN();
+				continue;
+			}
+			// Without classified ground points, the lowest point is used.
+			tile.ground[i] = ground_counts[i] ? float(ground_sums[i] / ground_counts[i]) : lowest[i];
+			tile.intensity[i] = float(intensity_sums[i] / counts[i]);
+			stats.min_ground = std::min(stats.min_ground, tile.ground[i]);
+			stats.max_ground = std::max(stats.max_ground, tile.ground[i]);
+			stats.max_intensity = std::max(stats.max_intensity, tile.intensity[i]);
+		}
+
+		std::vector<std::vector<quint32>> band_counts(num_bands, std::vector<quint32>(num_cells, 0));
+		for (std::size_t i = 0; i < num_points; ++i)
+		{
+			auto const record = records + i * point_record_size;
+			if (quint8(record[14]) == LasPoint::Ground)
+				continue;
+			auto const index = cellIndex(record);
+			auto const height = double(readFloat(record + 8)) - tile.ground[index];
+			auto const& limits = options.band_limits;
+			auto const band = std::upper_bound(begin(limits), end(limits), height) - begin(limits) - 1;
+			if (band >= 0 && std::size_t(band) < num_bands)
+				++band_counts[std::size_t(band)][index];
+		}
+
+		tile.density.resize(num_bands);
+		for (std::size_t band = 0; band < num_bands; ++band)
+		{
+			auto& density = tile.density[band];
+			density.resize(num_cells);
+			for (std::size_t i = 0; i < num_cells; ++i)
+				density[i] = counts[i] ? float(band_counts[band][i]) / counts[i] : 0.0f;
+		}
+
+		QFile tile_file(tile_path);
+		if (!tile_file.open(QIODevice::WriteOnly))
+		{
+			stats.error = tile_file.errorString();
+			return;
+		}
+		QDataStream stream(&tile_file);
+		stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+		stream << tile_magic << qint32(cells) << qint32(num_bands);
+		for (auto value : tile.ground)
+			stream << value;
+		for (const auto& density : tile.density)
+		{
+			for (auto value : density)
+				stream << value;
+		}
+		for (auto value : tile.intensity)
+			stream << value;
+		if (stream.status() != QDataStream::Ok)
+			stats.error = tile_file.errorString();
+	}
+
+	static float readFloat(const char* data)
+	{
+		auto const bits = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data));
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	QString points_path;
+	QString tile_path;
+	const PointCloudTiles::Options& options;
+	TileStats& stats;
+	std::atomic<int>& done;
+};
+
+
+/**
+ * Appends a point record for the temporary tile files.
+ *
+ * x and y are relative to the tile's north-west corner, growing towards
+ * east and south.
+ */
+void appendPointRecord(QByteArray& buffer, float x, float y, const LasPoint& point)
+{
+	uchar record[point_record_size];
+	auto writeFloat = [](float value, uchar* dest) {
+		quint32 bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		qToLittleEndian(bits, dest);
+	};
+	writeFloat(x, record);
+	writeFloat(y, record + 4);
+	writeFloat(float(point.z), record + 8);
+	qToLittleEndian(point.intensity, record + 12);
+	record[14] = point.classification;
+	record[15] = uchar((point.return_number & 0x0f) | (point.number_of_returns << 4));
+	buffer.append(reinterpret_cast<const char*>(record), point_record_size);
+}
+
+
+QString productName(TemplatePointCloud::Product product)
+{
+	switch (product)
+	{
+	case TemplatePointCloud::GroundHeight:
+		return QStringLiteral("ground");
+	case TemplatePointCloud::VegetationDensity:
+		return QStringLiteral("vegetation");
+	case TemplatePointCloud::Intensity:
+		return QStringLiteral("intensity");
+	}
+	return {};
+}
+
+
+}  // namespace
+
+
+
+// ### PointCloudTiles ###
+
+PointCloudTiles::PointCloudTiles(const QString& source_path, const QString& cache_path, const Options& options)
+: source_path(source_path)
+, cache_path(cache_path)
+, tile_options(options)
+{
+	// nothing else
+}
+
+PointCloudTiles::~PointCloudTiles()
+{
+	// nothing, not inlined
+}
+
+
+// static
+QString PointCloudTiles::defaultCachePath(const QString& source_path)
+{
+	return source_path + QLatin1String(".tiles");
+}
+
+
+bool PointCloudTiles::open(const Progress& progress)
+{
+	was_built = false;
+	if (!(tile_options.cell_size > 0)
+	    || tile_options.tile_cells <= 0
+	    || tile_options.band_limits.size() < 2
+	    || !std::is_sorted(begin(tile_options.band_limits), end(tile_options.band_limits)))
+	{
+		error_string = tr("Invalid raster options.");
+		return false;
+	}
+
+	if (loadMetadata())
+		return true;
+
+	was_built = true;
+	return build(progress);
+}
+
+
+bool PointCloudTiles::hasTile(int x, int y) const
+{
+	return x >= 0 && x < tiles_x && y >= 0 && y < tiles_y
+	       && tile_exists[std::size_t(y) * std::size_t(tiles_x) + std::size_t(x)];
+}
+
+
+bool PointCloudTiles::loadTile(int x, int y, Tile& tile) const
+{
+	if (!hasTile(x, y))
+		return false;
+
+	QFile file(tilePath(x, y, "tile"));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+	quint32 magic;
+	qint32 cells, num_bands;
+	stream >> magic >> cells >> num_bands;
+	if (magic != tile_magic || cells != tile_options.tile_cells || num_bands != numBands())
+		return false;
+
+	auto const num_cells = std::size_t(cells) * std::size_t(cells);
+	auto readLayer = [&stream, num_cells](std::vector<float>& layer) {
+		layer.resize(num_cells);
+		for (auto& value : layer)
+			stream >> value;
+	};
+	readLayer(tile.ground);
+	tile.density.resize(std::size_t(num_bands));
+	for (auto& density : tile.density)
+		readLayer(density);
+	readLayer(tile.intensity);
+	return stream.status() == QDataStream::Ok;
+}
+
+
+bool PointCloudTiles::loadMetadata()
+{
+	QFile file(QDir(cache_path).filePath(QStringLiteral("metadata.json")));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	auto const metadata = QJsonDocument::fromJson(file.readAll()).object();
+	QFileInfo source_info(source_path);
+	QJsonArray band_limits;
+	for (auto limit : tile_options.band_limits)
+		band_limits.append(limit);
+	if (metadata.value(QStringLiteral("version")).toInt() != cache_version
+	    || metadata.value(QStringLiteral("source_size")).toDouble() != double(source_info.size())
+	    || metadata.value(QStringLiteral("source_modified")).toDouble() != double(source_info.lastModified().toMSecsSinceEpoch())
+	    || metadata.value(QStringLiteral("cell_size")).toDouble() != tile_options.cell_size
+	    || metadata.value(QStringLiteral("tile_cells")).toInt() != tile_options.tile_cells
+	    || metadata.value(QStringLiteral("band_limits")).toArray() != band_limits)
+	{
+		return false;
+	}
+
+	raster_origin = QPointF(metadata.value(QStringLiteral("origin_x")).toDouble(),
+	                        metadata.value(QStringLiteral("origin_y")).toDouble());
+	tiles_x = metadata.value(QStringLiteral("tiles_x")).toInt();
+	tiles_y = metadata.value(QStringLiteral("tiles_y")).toInt();
+	if (tiles_x <= 0 || tiles_y <= 0 || double(tiles_x) * tiles_y > max_num_tiles)
+		return false;
+
+	tile_exists.assign(std::size_t(tiles_x) * std::size_t(tiles_y), false);
+	for (auto value : metadata.value(QStringLiteral("tiles")).toArray())
+	{
+		auto const index = value.toInt(-1);
+		if (index < 0 || std::size_t(index) >= tile_exists.size())
+			return false;
+		tile_exists[std::size_t(index)] = true;
+	}
+	min_ground = float(metadata.value(QStringLiteral("min_ground")).toDouble());
+	max_ground = float(metadata.value(QStringLiteral("max_ground")).toDouble());
+	max_intensity = float(metadata.value(QStringLiteral("max_intensity")).toDouble());
+	return true;
+}
+
+
+bool PointCloudTiles::build(const Progress& progress)
+{
+	LasReader reader(source_path);
+	if (!reader.open())
+	{
+		error_string = reader.errorString();
+		return false;
+	}
+
+	QDir dir(cache_path);
+	if (!dir.mkpath(QStringLiteral(".")))
+	{
+		error_string = tr("Cannot create directory:\n%1").arg(cache_path);
+		return false;
+	}
+	// Remove any outdated cache contents.
+	dir.remove(QStringLiteral("metadata.json"));
+	for (const auto& name : dir.entryList({ QStringLiteral("*.tile"), QStringLiteral("*.points") }, QDir::Files))
+		dir.remove(name);
+
+	auto const cell_size = tile_options.cell_size;
+	auto const tile_size = cell_size * tile_options.tile_cells;
+	raster_origin = QPointF(std::floor(reader.minX() / cell_size) * cell_size,
+	                        std::ceil(reader.maxY() / cell_size) * cell_size);
+	auto const num_tiles_x = std::floor((reader.maxX() - raster_origin.x()) / tile_size) + 1;
+	auto const num_tiles_y = std::floor((raster_origin.y() - reader.minY()) / tile_size) + 1;
+	if (!(num_tiles_x >= 1 && num_tiles_y >= 1 && num_tiles_x * num_tiles_y <= max_num_tiles))
+	{
+		error_string = tr("The extent of the point cloud is too large for the raster cell size.");
+		return false;
+	}
+	tiles_x = int(num_tiles_x);
+	tiles_y = int(num_tiles_y);
+	auto const num_tiles = std::size_t(tiles_x) * std::size_t(tiles_y);
+	tile_exists.assign(num_tiles, false);
+
+	// Stage 1: Distribute the points to temporary files per tile.
+	std::vector<QByteArray> buffers(num_tiles);
+	std::size_t buffered = 0;
+	auto flush = [&]() -> bool {
+		for (std::size_t i = 0; i < num_tiles; ++i)
+		{
+			auto& buffer = buffers[i];
+			if (buffer.isEmpty())
+				continue;
+			QFile file(tilePath(int(i % std::size_t(tiles_x)), int(i / std::size_t(tiles_x)), "points"));
+			if (!file.open(QIODevice::WriteOnly | QIODevice::Append)
+			    || file.write(buffer) != buffer.size())
+			{
+				error_string = tr("Cannot save file\n%1:\n%2").arg(file.fileName(), file.errorString());
+				return false;
+			}
+			buffer.clear();
+		}
+		buffered = 0;
+		return true;
+	};
+
+	// Reading the points takes most of the time.
+	auto const num_points = std::max(quint64(1), reader.pointCount());
+	quint64 points_read = 0;
+	std::vector<LasPoint> points;
+	points.reserve(tile_options.chunk_size);
+	while (true)
+	{
+		if (!reader.read(points, tile_options.chunk_size))
+		{
+			error_string = reader.errorString();
+			return false;
+		}
+		if (points.empty())
+			break;
+
+		for (const auto& point : points)
+		{
+			if (point.classification == LasPoint::Noise)
+				continue;
+			auto const x = (point.x - raster_origin.x()) / tile_size;
+			auto const y = (raster_origin.y() - point.y) / tile_size;
+			if (!(x >= 0 && x < tiles_x && y >= 0 && y < tiles_y))
+				continue;  // outside of the header's bounding box
+			auto const tile_x = int(x);
+			auto const tile_y = int(y);
+			auto const index = std::size_t(tile_y) * std::size_t(tiles_x) + std::size_t(tile_x);
+			appendPointRecord(buffers[index], float((x - tile_x) * tile_size), float((y - tile_y) * tile_size), point);
+			tile_exists[index] = true;
+		}
+		buffered += points.size() * point_record_size;
+		if (buffered > tile_options.buffer_budget && !flush())
+			return false;
+
+		points_read += points.size();
+		if (progress && !progress(int(80 * std::min(points_read, num_points) / num_points)))
+			return false;
+	}
+	if (!flush())
+		return false;
+
+	// Stage 2: Rasterize the tiles concurrently.
+	std::vector<TileStats> stats(num_tiles);
+	{
+		std::atomic<int> done(0);
+		auto started = 0;
+		QThreadPool pool;
+		for (std::size_t i = 0; i < num_tiles; ++i)
+		{
+			if (!tile_exists[i])
+				continue;
+			auto const x = int(i % std::size_t(tiles_x));
+			auto const y = int(i / std::size_t(tiles_x));
+			pool.start(new TileRasterizer(tilePath(x, y, "points"), tilePath(x, y, "tile"), tile_options, stats[i], done));
+			++started;
+		}
+		while (!pool.waitForDone(100))
+		{
+			if (progress && !progress(80 + 20 * done / std::max(1, started)))
+			{
+				pool.clear();
+				pool.waitForDone();
+				return false;
+			}
+		}
+	}
+
+	TileStats total;
+	QJsonArray tiles;
+	for (std::size_t i = 0; i < num_tiles; ++i)
+	{
+		if (!tile_exists[i])
+			continue;
+		if (!stats[i].error.isEmpty())
+		{
+			error_string = stats[i].error;
+			return false;
+		}
+		total.min_ground = std::min(total.min_ground, stats[i].min_ground);
+		total.max_ground = std::max(total.max_ground, stats[i].max_ground);
+		total.max_intensity = std::max(total.max_intensity, stats[i].max_intensity);
+		tiles.append(int(i));
+	}
+	min_ground = std::isfinite(total.min_ground) ? total.min_ground : 0.0f;
+	max_ground = std::isfinite(total.max_ground) ? total.max_ground : 0.0f;
+	max_intensity = total.max_intensity;
+
+	QFileInfo source_info(source_path);
+	QJsonArray band_limits;
+	for (auto limit : tile_options.band_limits)
+		band_limits.append(limit);
+	QJsonObject metadata;
+	metadata.insert(QStringLiteral("version"), cache_version);
+	metadata.insert(QStringLiteral("source_size"), double(source_info.size()));
+	metadata.insert(QStringLiteral("source_modified"), double(source_info.lastModified().toMSecsSinceEpoch()));
+	metadata.insert(QStringLiteral("cell_size"), tile_options.cell_size);
+	metadata.insert(QStringLiteral("tile_cells"), tile_options.tile_cells);
+	metadata.insert(QStringLiteral("band_limits"), band_limits);
+	metadata.insert(QStringLiteral("origin_x"), raster_origin.x());
+	metadata.insert(QStringLiteral("origin_y"), raster_origin.y());
+	metadata.insert(QStringLiteral("tiles_x"), tiles_x);
+	metadata.insert(QStringLiteral("tiles_y"), tiles_y);
+	metadata.insert(QStringLiteral("tiles"), tiles);
+	metadata.insert(QStringLiteral("min_ground"), double(min_ground));
+	metadata.insert(QStringLiteral("max_ground"), double(max_ground));
+	metadata.insert(QStringLiteral("max_intensity"), double(max_intensity));
+
+	QFile file(dir.filePath(QStringLiteral("metadata.json")));
+	auto const json = QJsonDocument(metadata).toJson();
+	if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size())
+	{
+		error_string = tr("Cannot save file\n%1:\n%2").arg(file.fileName(), file.errorString());
+		return false;
+	}
+	return true;
+}
+
+
+QString PointCloudTiles::tilePath(int x, int y, const char* suffix) const
+{
+	return QDir(cache_path).filePath(QString::fromLatin1("%1_%2.%3").arg(x).arg(y).arg(QLatin1String(suffix)));
+}
+
+
+
+// ### PointCloudTilesTask ###
+
+PointCloudTilesTask::PointCloudTilesTask(PointCloudTiles& tiles)
+: tiles(tiles)
+{
+	// nothing else
+}
+
+PointCloudTilesTask::~PointCloudTilesTask()
+{
+	abort();
+}
+
+
+bool PointCloudTilesTask::run()
+{
+	auto const success = tiles.open([this](int value) {
+		setProgress(value);
+		return !isCanceled();
+	});
+	if (!success)
+		setErrorString(tiles.errorString());
+	return success;
+}
+
+
+
+// ### TemplatePointCloud ###
+
+const std::vector<QByteArray>& TemplatePointCloud::supportedExtensions()
+{
+	static std::vector<QByteArray> extensions = { "las" };
+	return extensions;
+}
+
+
+TemplatePointCloud::TemplatePointCloud(const QString& path, Map* map)
+: Template(path, map)
+, images(image_cache_size)
+{
+	const Georeferencing& georef = map->getGeoreferencing();
+	connect(&georef, &Georeferencing::projectionChanged, this, &TemplatePointCloud::updateGeoreferencing);
+	connect(&georef, &Georeferencing::transformationChanged, this, &TemplatePointCloud::updateGeoreferencing);
+	connect(&georef, &Georeferencing::stateChanged, this, &TemplatePointCloud::updateGeoreferencing);
+	connect(&georef, &Georeferencing::declinationChanged, this, &TemplatePointCloud::updateGeoreferencing);
+}
+
+TemplatePointCloud::~TemplatePointCloud()
+{
+	if (template_state == Loaded)
+		unloadTemplateFile();
+}
+
+
+bool TemplatePointCloud::loadTemplateFileImpl(bool configuring)
+{
+	LasReader reader(template_path);
+	if (!reader.open())
+	{
+		setErrorString(reader.errorString());
+		return false;
+	}
+	epsg_code = reader.epsgCode();
+
+	point_cloud_tiles.reset(new PointCloudTiles(template_path, PointCloudTiles::defaultCachePath(template_path), tile_options));
+	PointCloudTilesTask task(*point_cloud_tiles);
+	switch (TaskProgressDialog::run(task, tr("Building the cache for %1...").arg(getTemplateFilename())))
+	{
+	case BackgroundTask::Finished:
+		break;
+	case BackgroundTask::Canceled:
+		setErrorString(tr("Building the cache was canceled."));
+		point_cloud_tiles.reset();
+		return false;
+	default:
+		setErrorString(task.errorString());
+		point_cloud_tiles.reset();
+		return false;
+	}
+	images.clear();
+
+	if (!configuring)
+		updatePosFromGeoreferencing();
+	return true;
+}
+
+
+bool TemplatePointCloud::postLoadConfiguration(QWidget* dialog_parent, bool& out_center_in_view)
+{
+	auto const warning = crsWarning();
+	if (!warning.isEmpty())
+		QMessageBox::warning(dialog_parent, tr("Warning"), warning);
+
+	TemplatePointCloudDialog dialog(this, dialog_parent);
+	dialog.setWindowModality(Qt::WindowModal);
+	if (dialog.exec() == QDialog::Rejected)
+		return false;
+	setProduct(dialog.product(), dialog.band());
+
+	is_georeferenced = true;
+	out_center_in_view = false;
+	updatePosFromGeoreferencing();
+	return true;
+}
+
+
+void TemplatePointCloud::unloadTemplateFileImpl()
+{
+	images.clear();
+	point_cloud_tiles.reset();
+}
+
+
+void TemplatePointCloud::drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, float opacity) const
+{
+	Q_UNUSED(scale);
+	Q_UNUSED(on_screen);
+
+	if (!point_cloud_tiles)
+		return;
+
+	// Determine the visible tiles.
+	QRectF visible;
+	rectIncludeSafe(visible, mapToTemplate(MapCoordF(clip_rect.topLeft())));
+	rectIncludeSafe(visible, mapToTemplate(MapCoordF(clip_rect.topRight())));
+	rectIncludeSafe(visible, mapToTemplate(MapCoordF(clip_rect.bottomLeft())));
+	rectIncludeSafe(visible, mapToTemplate(MapCoordF(clip_rect.bottomRight())));
+	auto const tile_cells = point_cloud_tiles->options().tile_cells;
+	auto tileRange = [tile_cells](double first, double last, int count) {
+		return std::make_pair(int(qBound(0.0, std::floor(first / tile_cells), count - 1.0)),
+		                      int(qBound(0.0, std::floor(last / tile_cells), count - 1.0)));
+	};
+	auto const x_range = tileRange(visible.left(), visible.right(), point_cloud_tiles->tilesX());
+	auto const y_range = tileRange(visible.top(), visible.bottom(), point_cloud_tiles->tilesY());
+
+	painter->save();
+	applyTemplateTransform(painter);
+	painter->setOpacity(opacity);
+	for (auto y = y_range.first; y <= y_range.second; ++y)
+	{
+		for (auto x = x_range.first; x <= x_range.second; ++x)
+		{
+			if (!point_cloud_tiles->hasTile(x, y))
+				continue;
+
+			auto const key = (quint64(y) << 32) | quint64(x);
+			QImage image;
+			if (auto cached = images.object(key))
+			{
+				image = *cached;
+			}
+			else
+			{
+				image = renderTile(x, y);
+				images.insert(key, new QImage(image), std::max(1, image.byteCount() / 1024));
+			}
+			painter->drawImage(QRectF(x * tile_cells, y * tile_cells, tile_cells, tile_cells), image);
+		}
+	}
+	painter->restore();
+}
+
+
+QRectF TemplatePointCloud::getTemplateExtent() const
+{
+	if (!point_cloud_tiles)
+		return QRectF();
+
+	auto const tile_cells = point_cloud_tiles->options().tile_cells;
+	return QRectF(0, 0, point_cloud_tiles->tilesX() * tile_cells, point_cloud_tiles->tilesY() * tile_cells);
+}
+
+
+void TemplatePointCloud::setProduct(Product product, int band)
+{
+	if (product == current_product && band == current_band)
+		return;
+
+	current_product = product;
+	current_band = band;
+	images.clear();
+	if (template_state == Loaded)
+		setTemplateAreaDirty();
+}
+
+
+QString TemplatePointCloud::crsWarning() const
+{
+	if (epsg_code == 0)
+		return {};
+
+	const auto& georef = map->getGeoreferencing();
+	if (!georef.isValid() || georef.isLocal())
+		return tr("The point cloud uses the coordinate reference system EPSG:%1, but the map is not georeferenced. "
+		          "The coordinates are taken as local map coordinates.").arg(epsg_code);
+
+	// Only CRS which are identified by EPSG codes can be compared.
+	auto map_epsg_code = 0;
+	auto const crs_id = georef.getProjectedCRSId();
+	const auto& parameters = georef.getProjectedCRSParameters();
+	if (crs_id == QLatin1String("EPSG") && parameters.size() == 1)
+	{
+		map_epsg_code = parameters.front().toInt();
+	}
+	else if (crs_id == QLatin1String("UTM") && parameters.size() == 1)
+	{
+		// WGS 84 / UTM zones
+		auto const zone = parameters.front().split(QLatin1Char(' '));
+		auto const south = zone.size() > 1 && zone.at(1) == QLatin1String("S");
+		map_epsg_code = (south ? 32700 : 32600) + zone.front().toInt();
+	}
+	if (map_epsg_code == 0 || map_epsg_code == epsg_code)
+		return {};
+
+	return tr("The point cloud uses the coordinate reference system EPSG:%1, but the map uses EPSG:%2. "
+	          "The point cloud will not be transformed, so it will be displayed at a wrong position.")
+	       .arg(epsg_code).arg(map_epsg_code);
+}
+
+
+void TemplatePointCloud::updateGeoreferencing()
+{
+	if (is_georeferenced && template_state == Template::Loaded)
+		updatePosFromGeoreferencing();
+}
+
+
+Template* TemplatePointCloud::duplicateImpl() const
+{
+	auto copy = new TemplatePointCloud(template_path, map);
+	copy->tile_options = tile_options;
+	copy->current_product = current_product;
+	copy->current_band = current_band;
+	copy->epsg_code = epsg_code;
+	if (point_cloud_tiles)
+	{
+		copy->point_cloud_tiles.reset(new PointCloudTiles(template_path, PointCloudTiles::defaultCachePath(template_path), tile_options));
+		if (!copy->point_cloud_tiles->open())
+			copy->point_cloud_tiles.reset();
+	}
+	return copy;
+}
+
+
+void TemplatePointCloud::saveTypeSpecificTemplateConfiguration(QXmlStreamWriter& xml) const
+{
+	xml.writeStartElement(QString::fromLatin1("point_cloud"));
+	xml.writeAttribute(QString::fromLatin1("product"), productName(current_product));
+	xml.writeAttribute(QString::fromLatin1("band"), QString::number(current_band));
+	xml.writeAttribute(QString::fromLatin1("cell_size"), QString::number(tile_options.cell_size));
+	xml.writeAttribute(QString::fromLatin1("tile_cells"), QString::number(tile_options.tile_cells));
+	xml.writeEndElement(/*point_cloud*/);
+}
+
+
+bool TemplatePointCloud::loadTypeSpecificTemplateConfiguration(QXmlStreamReader& xml)
+{
+	if (xml.name() == QLatin1String("point_cloud"))
+	{
+		auto const attributes = xml.attributes();
+		auto const product = attributes.value(QLatin1String("product")).toString();
+		for (auto candidate : { GroundHeight, VegetationDensity, Intensity })
+		{
+			if (product == productName(candidate))
+				current_product = candidate;
+		}
+		current_band = std::max(0, attributes.value(QLatin1String("band")).toInt());
+		auto const cell_size = attributes.value(QLatin1String("cell_size")).toDouble();
+		if (cell_size > 0)
+			tile_options.cell_size = cell_size;
+		auto const tile_cells = attributes.value(QLatin1String("tile_cells")).toInt();
+		if (tile_cells > 0)
+			tile_options.tile_cells = tile_cells;
+	}
+	xml.skipCurrentElement();
+	return true;
+}
+
+
+void TemplatePointCloud::updatePosFromGeoreferencing()
+{
+	if (!point_cloud_tiles)
+		return;
+
+	const auto& georef = map->getGeoreferencing();
+	auto const extent = getTemplateExtent();
+	auto const origin = point_cloud_tiles->origin();
+	auto const cell_size = point_cloud_tiles->options().cell_size;
+
+	// Template coordinates are raster cells, growing towards east and south.
+	PassPointList pp_list;
+	PassPoint pp;
+	pp.src_coords = MapCoordF(0, 0);
+	pp.dest_coords = georef.toMapCoordF(origin);
+	pp_list.push_back(pp);
+	pp.src_coords = MapCoordF(extent.width(), 0);
+	pp.dest_coords = georef.toMapCoordF(origin + QPointF(extent.width() * cell_size, 0));
+	pp_list.push_back(pp);
+	pp.src_coords = MapCoordF(0, extent.height());
+	pp.dest_coords = georef.toMapCoordF(origin - QPointF(0, extent.height() * cell_size));
+	pp_list.push_back(pp);
+
+	QTransform q_transform;
+	if (!pp_list.estimateNonIsometricSimilarityTransform(&q_transform))
+		return;
+	transform = TemplateTransform::fromQTransform(q_transform);
+	updateTransformationMatrices();
+}
+
+
+QImage TemplatePointCloud::renderTile(int x, int y) const
+{
+	PointCloudTiles::Tile tile;
+	if (!point_cloud_tiles || !point_cloud_tiles->loadTile(x, y, tile))
+		return QImage();
+
+	auto const cells = point_cloud_tiles->options().tile_cells;
+	QImage image(cells, cells, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+
+	auto gray = [](float value, float min, float max) {
+		auto const level = (max > min) ? qBound(0, int(255 * (value - min) / (max - min)), 255) : 128;
+		return qRgb(level, level, level);
+	};
+
+	for (int row = 0; row < cells; ++row)
+	{
+		auto line = reinterpret_cast<QRgb*>(image.scanLine(row));
+		for (int col = 0; col < cells; ++col)
+		{
+			auto const i = std::size_t(row) * std::size_t(cells) + std::size_t(col);
+			switch (current_product)
+			{
+			case GroundHeight:
+				if (!std::isnan(tile.ground[i]))
+					line[col] = gray(tile.ground[i], point_cloud_tiles->minGround(), point_cloud_tiles->maxGround());
+				break;
+			case VegetationDensity:
+				if (!tile.density.empty())
+				{
+					auto const band = std::size_t(qBound(0, current_band, int(tile.density.size()) - 1));
+					auto const alpha = qBound(0, qRound(255 * tile.density[band][i]), 255);
+					line[col] = qRgba(0, alpha * 160 / 255, 0, alpha);  // premultiplied
+				}
+				break;
+			case Intensity:
+				if (!std::isnan(tile.intensity[i]))
+					line[col] = gray(tile.intensity[i], 0, point_cloud_tiles->maxIntensity());
+				break;
+			}
+		}
+	}
+	return image;
+}
+
+
+// ### TemplatePointCloudDialog ###
+
+TemplatePointCloudDialog::TemplatePointCloudDialog(const TemplatePointCloud* templ, QWidget* parent)
+: QDialog(parent, Qt::WindowSystemMenuHint | Qt::WindowTitleHint)
+{
+	setWindowTitle(templ->getTemplateFilename());
+
+	product_combo = new QComboBox();
+	product_combo->addItem(tr("Ground height"), int(TemplatePointCloud::GroundHeight));
+	product_combo->addItem(tr("Vegetation density"), int(TemplatePointCloud::VegetationDensity));
+	product_combo->addItem(tr("Intensity"), int(TemplatePointCloud::Intensity));
+	product_combo->setCurrentIndex(product_combo->findData(int(templ->product())));
+
+	band_combo = new QComboBox();
+	const auto& limits = templ->bandLimits();
+	for (std::size_t i = 0; i + 1 < limits.size(); ++i)
+	{
+		//: Height band above ground, e.g. "0.5 - 2 m"
+		band_combo->addItem(tr("%1 - %2 m").arg(locale().toString(limits[i]), locale().toString(limits[i+1])));
+	}
+	band_combo->setCurrentIndex(qBound(0, templ->band(), band_combo->count() - 1));
+
+	auto button_box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+
+	auto layout = new QFormLayout();
+	layout->addRow(tr("Display:"), product_combo);
+	layout->addRow(tr("Height above ground:"), band_combo);
+	layout->addItem(Util::SpacerItem::create(this));
+	layout->addRow(button_box);
+	setLayout(layout);
+
+	connect(product_combo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &TemplatePointCloudDialog::productChanged);
+	connect(button_box, &QDialogButtonBox::accepted, this, &QDialog::accept);
+	connect(button_box, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+	productChanged();
+}
+
+TemplatePointCloudDialog::~TemplatePointCloudDialog()
+{
+	// nothing, not inlined
+}
+
+
+TemplatePointCloud::Product TemplatePointCloudDialog::product() const
+{
+	return TemplatePointCloud::Product(product_combo->currentData().toInt());
+}
+
+
+int TemplatePointCloudDialog::band() const
+{
+	return std::max(0, band_combo->currentIndex());
+}
+
+
+void TemplatePointCloudDialog::productChanged()
+{
+	band_combo->setEnabled(product() == TemplatePointCloud::VegetationDensity);
+}
+
+
+}  // namespace OpenOrienteering
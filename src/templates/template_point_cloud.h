@@ -0,0 +1,329 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_TEMPLATE_POINT_CLOUD_H
+#define OPENORIENTEERING_TEMPLATE_POINT_CLOUD_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QtGlobal>
+#include <QCache>
+#include <QCoreApplication>
+#include <QDialog>
+#include <QImage>
+#include <QObject>
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+#include "templates/template.h"
+#include "util/background_task.h"
+
+class QByteArray;
+class QComboBox;
+class QPainter;
+class QWidget;
+class QXmlStreamReader;
+class QXmlStreamWriter;
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * Raster products of a LiDAR point cloud, in tiles which are cached on disk.
+ *
+ * The raster is aligned with the projected coordinates of the point cloud.
+ * Each cell holds the ground height, the vegetation density for a number of
+ * height bands above ground, and the mean intensity.
+ *
+ * The cache is built in two stages. First, the point records are streamed
+ * in chunks, and the points are appended to one temporary file per tile.
+ * The buffers for these files are flushed when they exceed a fixed budget.
+ * Second, the tiles are rasterized concurrently, each from its own file.
+ * So the memory use is bounded by the chunk size, the buffer budget, and
+ * the number of points per tile, regardless of the size of the point cloud.
+ */
+class PointCloudTiles
+{
+	Q_DECLARE_TR_FUNCTIONS(OpenOrienteering::PointCloudTiles)
+
+public:
+	/** Options for building the tiles. */
+	struct Options
+	{
+		double cell_size = 1.0;      ///< The size of a raster cell, in projected units.
+		int tile_cells = 256;        ///< The number of cells along a tile's edge.
+		std::vector<double> band_limits = { 0.5, 2.0, 5.0, 30.0 };  ///< Height band limits above ground
+		std::size_t chunk_size = 1 << 18;        ///< The number of points read at once.
+		std::size_t buffer_budget = 32 << 20;    ///< The maximum size of the tile buffers, in bytes.
+	};
+
+	/**
+	 * A function which receives the progress of building the cache, from 0 to 100.
+	 *
+	 * It returns false in order to stop building.
+	 */
+	using Progress = std::function<bool (int)>;
+
+	/** The raster products of a single tile, row by row from north to south. */
+	struct Tile
+	{
+		std::vector<float> ground;                ///< NaN for cells without points
+		std::vector<std::vector<float>> density;  ///< Per height band, 0..1
+		std::vector<float> intensity;             ///< NaN for cells without points
+	};
+
+
+	/** Constructs an object for the given point cloud and cache directory. */
+	PointCloudTiles(const QString& source_path, const QString& cache_path, const Options& options);
+
+	PointCloudTiles(const PointCloudTiles&) = delete;
+	PointCloudTiles& operator=(const PointCloudTiles&) = delete;
+
+	/** Destructor. */
+	~PointCloudTiles();
+
+	/** Returns the default cache directory for a point cloud file. */
+	static QString defaultCachePath(const QString& source_path);
+
+
+	/** Returns the options. */
+	const Options& options() const { return tile_options; }
+
+	/** Returns a description of the last error. */
+	const QString& errorString() const { return error_string; }
+
+	/**
+	 * Loads the cache metadata, or builds the cache if it is missing or outdated.
+	 *
+	 * The progress function, if given, is called while building the cache.
+	 * Returns false on error, or when stopped by the progress function.
+	 */
+	bool open(const Progress& progress = {});
+
+	/** Returns true if the last call to open() had to build the cache. */
+	bool wasBuilt() const { return was_built; }
+
+
+	/** Returns the projected coordinates of the north-west corner of the raster. */
+	QPointF origin() const { return raster_origin; }
+
+	/** Returns the number of tile columns. */
+	int tilesX() const { return tiles_x; }
+
+	/** Returns the number of tile rows. */
+	int tilesY() const { return tiles_y; }
+
+	/** Returns true if the given tile contains points. */
+	bool hasTile(int x, int y) const;
+
+	/** Returns the number of height bands. */
+	int numBands() const { return int(tile_options.band_limits.size()) - 1; }
+
+	/** Returns the range of the ground height. */
+	float minGround() const { return min_ground; }
+	float maxGround() const { return max_ground; }
+
+	/** Returns the maximum of the mean intensity. */
+	float maxIntensity() const { return max_intensity; }
+
+	/**
+	 * Reads a tile from the cache.
+	 *
+	 * Returns false if the tile does not exist or cannot be read.
+	 * This function is thread-safe.
+	 */
+	bool loadTile(int x, int y, Tile& tile) const;
+
+private:
+	/** Returns true if the cache metadata matches the source and options. */
+	bool loadMetadata();
+
+	/** Builds the cache. */
+	bool build(const Progress& progress);
+
+	/** Returns the path of a tile file with the given suffix. */
+	QString tilePath(int x, int y, const char* suffix) const;
+
+
+	QString source_path;
+	QString cache_path;
+	Options tile_options;
+	QString error_string;
+	QPointF raster_origin;
+	int tiles_x = 0;
+	int tiles_y = 0;
+	std::vector<bool> tile_exists;
+	float min_ground = 0;
+	float max_ground = 0;
+	float max_intensity = 0;
+	bool was_built = false;
+};
+
+
+
+/**
+ * A background task which opens point cloud tiles.
+ *
+ * Building the cache for a large point cloud takes a long time, so this is
+ * done on a worker thread. Opening an existing cache is fast.
+ */
+class PointCloudTilesTask : public BackgroundTask
+{
+Q_OBJECT
+public:
+	/** Prepares opening the given tiles. */
+	explicit PointCloudTilesTask(PointCloudTiles& tiles);
+
+	/** Destructor. */
+	~PointCloudTilesTask() override;
+
+protected:
+	/** Opens the tiles, building the cache if needed. */
+	bool run() override;
+
+private:
+	PointCloudTiles& tiles;
+};
+
+
+
+/**
+ * A template which shows raster products of a LiDAR point cloud (LAS file).
+ *
+ * The point cloud's coordinates are taken as projected coordinates of the
+ * map's georeferencing. When the point cloud declares a CRS which differs
+ * from the map's CRS, the user is warned. The raster tiles are cached on disk
+ * next to the point cloud file, and rendered to images on demand. The
+ * rendered images are kept in a cache of limited size.
+ */
+class TemplatePointCloud : public Template
+{
+Q_OBJECT
+public:
+	/** The raster product which is displayed. */
+	enum Product
+	{
+		GroundHeight,
+		VegetationDensity,
+		Intensity
+	};
+
+	/**
+	 * Returns the filename extensions supported by this template class.
+	 */
+	static const std::vector<QByteArray>& supportedExtensions();
+
+	TemplatePointCloud(const QString& path, Map* map);
+	~TemplatePointCloud() override;
+
+	const char* getTemplateType() const override {return "TemplatePointCloud";}
+	bool isRasterGraphics() const override {return true;}
+
+	bool loadTemplateFileImpl(bool configuring) override;
+	bool postLoadConfiguration(QWidget* dialog_parent, bool& out_center_in_view) override;
+	void unloadTemplateFileImpl() override;
+
+	void drawTemplate(QPainter* painter, const QRectF& clip_rect, double scale, bool on_screen, float opacity) const override;
+	QRectF getTemplateExtent() const override;
+
+	/** Returns the displayed raster product. */
+	Product product() const { return current_product; }
+
+	/** Returns the displayed height band of the vegetation density. */
+	int band() const { return current_band; }
+
+	/** Sets the displayed raster product, and the height band for the vegetation density. */
+	void setProduct(Product product, int band = 0);
+
+	/** Returns the tiles, or nullptr if the template is not loaded. */
+	const PointCloudTiles* tiles() const { return point_cloud_tiles.get(); }
+
+	/** Returns the height band limits of the vegetation density. */
+	const std::vector<double>& bandLimits() const { return tile_options.band_limits; }
+
+	/**
+	 * Returns a warning if the CRS of the point cloud differs from the map's CRS.
+	 *
+	 * A local map is regarded as different. Returns an empty string if the
+	 * CRS match, or if they cannot be compared by EPSG code.
+	 */
+	QString crsWarning() const;
+
+public slots:
+	void updateGeoreferencing();
+
+protected:
+	Template* duplicateImpl() const override;
+	void saveTypeSpecificTemplateConfiguration(QXmlStreamWriter& xml) const override;
+	bool loadTypeSpecificTemplateConfiguration(QXmlStreamReader& xml) override;
+
+	/** Calculates the template transformation from the map's georeferencing. */
+	void updatePosFromGeoreferencing();
+
+	/** Renders the current product of a tile to an image. */
+	QImage renderTile(int x, int y) const;
+
+private:
+	std::unique_ptr<PointCloudTiles> point_cloud_tiles;
+	PointCloudTiles::Options tile_options;
+	Product current_product = GroundHeight;
+	int current_band = 0;
+	int epsg_code = 0;
+	mutable QCache<quint64, QImage> images;
+
+	Q_DISABLE_COPY(TemplatePointCloud)
+};
+
+
+
+/**
+ * A dialog for choosing the displayed product of a point cloud template.
+ */
+class TemplatePointCloudDialog : public QDialog
+{
+Q_OBJECT
+public:
+	TemplatePointCloudDialog(const TemplatePointCloud* templ, QWidget* parent);
+	~TemplatePointCloudDialog() override;
+
+	/** Returns the selected product. */
+	TemplatePointCloud::Product product() const;
+
+	/** Returns the selected height band. */
+	int band() const;
+
+private:
+	void productChanged();
+
+	QComboBox* product_combo;
+	QComboBox* band_combo;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
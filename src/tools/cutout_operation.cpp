@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2013, 2014, 2017 Kai Pastor
+ *    Copyright 2013, 2014, 2017, 2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,8 +21,8 @@
 
 #include "cutout_operation.h"
 
+#include <cstddef>
 #include <iterator>
-#include <vector>
 
 #include <QtGlobal>
 #include <QRectF>
@@ -30,7 +30,6 @@
 #include "core/map.h"
 #include "core/map_coord.h"
 #include "core/map_part.h"
-#include "core/objects/boolean_tool.h"
 #include "core/objects/object.h"
 #include "core/symbols/symbol.h"
 #include "undo/object_undo.h"
@@ -41,27 +40,28 @@ namespace OpenOrienteering {
 
 CutoutOperation::CutoutOperation(Map* map, PathObject* cutout_object, bool cut_away)
 : map(map)
-, cutout_object(cutout_object)
-, add_step(new AddObjectsUndoStep(map))
+, cutout_copy(cutout_object->duplicate())
 , boolean_tool(cut_away ? BooleanTool::Difference : BooleanTool::Intersection, map)
 , cut_away(cut_away)
 {
-	// nothing else
+	map->getCurrentPart()->applyOnAllObjects([this, cutout_object](Object* object) {
+		prepare(object, cutout_object);
+	});
 }
 
 
 CutoutOperation::~CutoutOperation()
 {
-	if (auto undo_step = finish())
+	abort();
+	for (auto& job : jobs)
 	{
-		map->setObjectsDirty();
-		map->push(undo_step);
-		map->emitSelectionEdited();
+		for (auto object : job.results)
+			delete object;
 	}
 }
 
 
-void CutoutOperation::operator()(Object* object)
+void CutoutOperation::prepare(Object* object, const PathObject* cutout_object)
 {
 	// If there is a selection, only clip selected objects
 	if (!map->selectedObjects().empty() && !map->isObjectSelected(object))
@@ -75,7 +75,7 @@ void CutoutOperation::operator()(Object* object)
 	if (!object->getExtent().intersects(cutout_object->getExtent()))
 	{
 		if (!cut_away)
-			add_step->addObject(object, object);
+			jobs.push_back({ object, nullptr, {}, false });
 		return;
 	}
 	
@@ -85,39 +85,74 @@ void CutoutOperation::operator()(Object* object)
 	case Object::Text:
 		// Simple check if the (first) point is inside the area
 		if (cutout_object->isPointInsideArea(MapCoordF(object->getRawCoordinateVector().at(0))) == cut_away)
-			add_step->addObject(object, object);
+			jobs.push_back({ object, nullptr, {}, false });
 		break;
 		
 	case Object::Path:
-		out_objects.clear();
-		if (object->getSymbol()->getContainedTypes() & Symbol::Area)
+		// The copy is clipped in run().
+		jobs.push_back({ object, std::unique_ptr<PathObject>(object->asPath()->duplicate()), {}, false });
+		break;
+	}
+}
+
+
+bool CutoutOperation::run()
+{
+	auto const num_jobs = jobs.size();
+	for (std::size_t i = 0; i < num_jobs; ++i)
+	{
+		if (isCanceled())
+			return false;
+		
+		auto& job = jobs[i];
+		if (!job.copy)
+			continue;
+		
+		auto* path = job.copy.get();
+		if (path->getSymbol()->getContainedTypes() & Symbol::Area)
 		{
 			// Use the Clipper library to clip the area
 			BooleanTool::PathObjects in_objects;
-			in_objects.push_back(cutout_object);
-			in_objects.push_back(object->asPath());
-			if (!boolean_tool.executeForObjects(object->asPath(), in_objects, out_objects))
-				break;
+			in_objects.push_back(cutout_copy.get());
+			in_objects.push_back(path);
+			job.replace = boolean_tool.executeForObjects(path, in_objects, job.results);
 		}
 		else
 		{
 			// Use some custom code to clip the line
-			boolean_tool.executeForLine(cutout_object, object->asPath(), out_objects);
+			boolean_tool.executeForLine(cutout_copy.get(), path, job.results);
+			job.replace = true;
 		}
-		
-		add_step->addObject(object, object);
-		new_objects.insert(end(new_objects), begin(out_objects), end(out_objects));
-		break;
+		setProgress(int(100 * (i + 1) / num_jobs));
+	}
+	return true;
+}
+
+
+void CutoutOperation::commit()
+{
+	if (auto undo_step = finish())
+	{
+		map->setObjectsDirty();
+		map->push(undo_step);
+		map->emitSelectionEdited();
 	}
-	
-	return;
 }
 
 
 UndoStep* CutoutOperation::finish()
 {
-	// Whenever operator() adds to new_objects, it adds to add_step, too.
-	Q_ASSERT(new_objects.empty() || !add_step->isEmpty());
+	auto add_step = new AddObjectsUndoStep(map);
+	std::vector<PathObject*> new_objects;
+	for (auto& job : jobs)
+	{
+		if (job.copy && !job.replace)
+			continue;  // Clipping failed, keep the object.
+		
+		add_step->addObject(job.object, job.object);
+		new_objects.insert(end(new_objects), begin(job.results), end(job.results));
+		job.results.clear();
+	}
 	
 	if (add_step->isEmpty())
 	{
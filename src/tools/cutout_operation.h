@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2013, 2014, 2017 Kai Pastor
+ *    Copyright 2013, 2014, 2017, 2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -22,13 +22,16 @@
 #ifndef OPENORIENTEERING_CUTOUT_OPERATION_H
 #define OPENORIENTEERING_CUTOUT_OPERATION_H
 
+#include <memory>
 #include <vector>
 
+#include <QObject>
+
 #include "core/objects/boolean_tool.h"
+#include "util/background_task.h"
 
 namespace OpenOrienteering {
 
-class AddObjectsUndoStep;
 class Map;
 class Object;
 class PathObject;
@@ -38,15 +41,22 @@ class UndoStep;
 /**
  * Operation to make map cutouts.
  * 
- * This functor must not be applied to map parts other than the current one.
+ * The operation works on the objects of the current map part. If there is a
+ * selection, only selected objects are clipped.
+ * 
+ * The constructor decides about the simple cases, and it takes copies of the
+ * paths which need to be clipped. Clipping these copies is done in run(),
+ * which may execute on a worker thread. commit() replaces the original
+ * objects and pushes an undo step.
  * 
  * See CutoutTool::apply for usage example.
  */
-class CutoutOperation
+class CutoutOperation : public BackgroundTask
 {
+Q_OBJECT
 public:
 	/**
-	 * Function object constructor.
+	 * Prepares the operation.
 	 * 
 	 * Setting cut_away to true inverts the tool's effect, i.e. it will remove
 	 * the object parts inside the outline of cutout_object instead of the
@@ -54,38 +64,53 @@ public:
 	 */
 	CutoutOperation(Map* map, PathObject* cutout_object, bool cut_away);
 	
-	/** 
-	 * This functor must not be copied.
+	/**
+	 * Destructor.
 	 * 
-	 * If it is to be used via std::function, std::ref can be used to explicitly
-	 * create a copyable reference.
+	 * Discards results which were not committed.
+	 */
+	~CutoutOperation() override;
+	
+protected:
+	/**
+	 * Clips the copies of the path objects.
 	 */
-	CutoutOperation(const CutoutOperation&) = delete;
+	bool run() override;
 	
 	/**
-	 * Commits the changes.
+	 * Replaces the affected objects in the map, and pushes an undo step.
 	 */
-	~CutoutOperation();
+	void commit() override;
 	
-	/** 
-	 * This functor must not be assigned to.
+private:
+	/**
+	 * An object which is affected by the operation.
+	 * 
+	 * If copy is set, the object is to be replaced by the results of
+	 * clipping the copy. Otherwise it is to be removed.
 	 */
-	CutoutOperation& operator=(const CutoutOperation&) = delete;
+	struct Job
+	{
+		Object* object;
+		std::unique_ptr<PathObject> copy;
+		BooleanTool::PathObjects results;
+		bool replace;
+	};
 	
 	/**
-	 * Applies the configured cutting operation on the given object.
+	 * Determines the treatment of the given object.
 	 */
-	void operator()(Object* object);
+	void prepare(Object* object, const PathObject* cutout_object);
 	
-private:
+	/**
+	 * Creates the undo step and modifies the map.
+	 */
 	UndoStep* finish();
 	
 	Map* map;
-	PathObject* cutout_object;
-	std::vector<PathObject*> new_objects;
-	AddObjectsUndoStep* add_step;
+	std::unique_ptr<PathObject> cutout_copy;
+	std::vector<Job> jobs;
 	BooleanTool boolean_tool;
-	BooleanTool::PathObjects out_objects;
 	bool cut_away;
 };
 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2013 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,8 +21,6 @@
 
 #include "cutout_tool.h"
 
-#include <functional>
-
 #include <Qt>
 #include <QtGlobal>
 #include <QCursor>
@@ -38,6 +36,7 @@
 #include "core/objects/object.h"
 #include "core/symbols/combined_symbol.h"
 #include "gui/modifier_key.h"
+#include "gui/task_progress_dialog.h"
 #include "gui/map/map_editor.h"
 #include "gui/map/map_widget.h"
 #include "tools/cutout_operation.h"
@@ -54,7 +53,7 @@ CutoutTool::CutoutTool(MapEditorController* editor, QAction* tool_action, bool c
 , object_selector(new ObjectSelector(map()))
 , cut_away(cut_away)
 {
-	// nothing else
+	useObjectPicking(true);
 }
 
 CutoutTool::~CutoutTool() = default;
@@ -112,7 +111,7 @@ bool CutoutTool::keyPress(QKeyEvent* event)
 		cutout_object_index = -1;
 		
 		// Apply tool via static function and deselect this tool
-		apply(map(), cutout_object, cut_away);
+		apply(map(), cutout_object, cut_away, window());
 		editor->setEditTool();
 		return true;
 		
@@ -164,7 +163,7 @@ void CutoutTool::objectSelectionChangedImpl()
 
 void CutoutTool::clickRelease()
 {
-	object_selector->selectAt(cur_pos_map, cur_map_widget->getMapView()->pixelToLength(clickTolerance()), active_modifiers & Qt::ShiftModifier);
+	object_selector->selectAt(cur_pos_map, cur_map_widget->getMapView()->pixelToLength(clickTolerance()), active_modifiers & Qt::ShiftModifier, cur_map_widget);
 	updateStatusText();
 }
 
@@ -185,10 +184,10 @@ void CutoutTool::dragFinish()
 }
 
 
-void CutoutTool::apply(Map* map, PathObject* cutout_object, bool cut_away)
+void CutoutTool::apply(Map* map, PathObject* cutout_object, bool cut_away, QWidget* dialog_parent)
 {
 	CutoutOperation operation(map, cutout_object, cut_away);
-	map->getCurrentPart()->applyOnAllObjects(std::ref(operation));
+	TaskProgressDialog::run(operation, tr("Cutting..."), dialog_parent);
 }
 
 
@@ -32,6 +32,7 @@ class QAction;
 class QKeyEvent;
 class QPainter;
 class QRectF;
+class QWidget;
 
 namespace OpenOrienteering {
 
@@ -68,8 +69,11 @@ public:
 	 * 
 	 * Setting cut_away to true inverts the effect, cutting the
 	 * part inside the cut shape away instead of the part outside.
+	 * 
+	 * A progress dialog with the given parent is shown if the operation
+	 * takes some time.
 	 */
-	static void apply(Map* map, PathObject* cutout_object, bool cut_away);
+	static void apply(Map* map, PathObject* cutout_object, bool cut_away, QWidget* dialog_parent = nullptr);
 	
 	
 protected:
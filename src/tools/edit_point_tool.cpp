@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012-2014 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -38,6 +38,8 @@
 #include <QPainter>
 #include <QPoint>
 #include <QPointF>
+#include <QRectF>
+#include <QSizeF>
 #include <QToolButton>
 
 #include "settings.h"
@@ -327,7 +329,7 @@ void EditPointTool::clickRelease()
 		return;
 	}
 	
-	object_selector->selectAt(cur_pos_map, cur_map_widget->getMapView()->pixelToLength(clickTolerance()), active_modifiers & Qt::ShiftModifier);
+	object_selector->selectAt(cur_pos_map, cur_map_widget->getMapView()->pixelToLength(clickTolerance()), active_modifiers & Qt::ShiftModifier, cur_map_widget);
 	updateHoverState(cur_pos_map);
 }
 
@@ -341,7 +343,11 @@ void EditPointTool::dragStart()
 	}
 	else
 	{
-		startEditing(map()->selectedObjects());
+		auto objects = map()->selectedObjects();
+		findSharedNode();
+		for (const auto& incidence : shared_node)
+			objects.insert(incidence.object);
+		startEditing(objects);
 		startEditingSetup();
 		
 		if (active_modifiers & Qt::ControlModifier)
@@ -904,6 +910,8 @@ void EditPointTool::startEditingSetup()
 			
 		case Object::Path:
 			object_mover->addPoint(hover_object->asPath(), hover_point);
+			for (const auto& incidence : shared_node)
+				object_mover->addPoint(incidence.object, incidence.index);
 			setupAngleHelperFromHoverObject();
 			break;
 			
@@ -927,6 +935,36 @@ void EditPointTool::startEditingSetup()
 		setupAngleHelperFromEditedObjects();
 		angle_helper->setCenter(click_pos_map);
 	}
+	shared_node.clear();
+}
+
+void EditPointTool::findSharedNode()
+{
+	shared_node.clear();
+	if (!hover_state.testFlag(OverObjectNode)
+	    || hover_object->getType() != Object::Path
+	    || hoveringOverCurveHandle()
+	    || !Settings::getInstance().getSettingCached(Settings::EditTool_MoveSharedNodes).toBool())
+	{
+		return;
+	}
+	
+	const PathObject* path = hover_object->asPath();
+	auto const position = path->getCoordinate(hover_point);
+	auto const epsilon = 0.001;
+	auto const area = QRectF(QPointF(MapCoordF(position)), QSizeF()).adjusted(-epsilon, -epsilon, epsilon, epsilon);
+	MapTopology topology(*map()->getCurrentPart(), area);
+	for (const auto& incidence : topology.incidences(position))
+	{
+		// Don't modify objects which the user cannot see or unlock.
+		auto const symbol = incidence.object->getSymbol();
+		if (incidence.object != hover_object
+		    && !symbol->isHidden()
+		    && !symbol->isProtected())
+		{
+			shared_node.push_back(incidence);
+		}
+	}
 }
 
 bool EditPointTool::hoveringOverSingleText() const
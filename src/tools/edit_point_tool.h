@@ -22,6 +22,8 @@
 #ifndef OPENORIENTEERING_EDIT_POINT_TOOL_H
 #define OPENORIENTEERING_EDIT_POINT_TOOL_H
 
+#include <vector>
+
 #include <QElapsedTimer>
 #include <QScopedPointer>
 
@@ -33,6 +35,7 @@
 #include <QVariant>
 
 #include "core/map_coord.h"
+#include "core/map_topology.h"
 #include "tools/edit_tool.h"
 
 class QAction;
@@ -122,6 +125,14 @@ protected:
 	 */
 	void setupAngleHelperFromHoverObject();
 	
+	/**
+	 * Finds the points of other objects at the position of the hovered point.
+	 * 
+	 * The points are only collected if moving shared nodes is enabled in the
+	 * settings, and the hovered point is a regular path point.
+	 */
+	void findSharedNode();
+	
 	/** Does additional editing setup required after calling startEditing(). */
 	void startEditingSetup();
 	
@@ -172,6 +183,11 @@ protected:
 	 */
 	MapCoordVector::size_type hover_point = 0;
 	
+	/**
+	 * Points of other objects which are moved together with the hovered point.
+	 */
+	std::vector<MapTopology::Incidence> shared_node;
+	
 	
 	/** Is a box selection in progress? */
 	bool box_selection = false;
@@ -341,6 +341,8 @@ void FillTool::drawObjectIDs(Map* map, QPainter* painter, const RenderConfig &co
 			}
 			
 			object->update();
+			if (object->hasEvictedRenderables() && object->getExtent().intersects(config.bounding_box))
+				object->restoreRenderables();
 			object->renderables().draw(c, QRgb(o) | ~RGB_MASK, painter, config);
 		}
 	}
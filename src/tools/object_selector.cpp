@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -21,6 +21,7 @@
 #include "object_selector.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <map>
 #include <memory>
@@ -29,7 +30,10 @@
 
 #include "core/map.h"
 #include "core/map_coord.h"
+#include "core/map_view.h"
 #include "core/objects/object.h"
+#include "core/symbols/symbol.h"
+#include "gui/map/map_widget.h"
 
 
 namespace OpenOrienteering {
@@ -42,7 +46,7 @@ ObjectSelector::ObjectSelector(Map* map)
 
 
 
-bool ObjectSelector::selectAt(MapCoordF position, double tolerance, bool toggle)
+bool ObjectSelector::selectAt(MapCoordF position, double tolerance, bool toggle, const MapWidget* widget)
 {
 	bool selection_changed;
 	
@@ -53,9 +57,18 @@ bool ObjectSelector::selectAt(MapCoordF position, double tolerance, bool toggle)
 	
 	// Clicked - get objects below cursor
 	SelectionInfoVector objects;
-	map->findObjectsAt(position, 0.001f * tolerance, false, false, false, false, objects);
+	auto const repeated_click = has_last_position
+	                            && position.distanceSquaredTo(last_position) <= 0.000001 * tolerance * tolerance;
+	if (widget && !repeated_click)
+		findDrawnObjectsAt(widget, position, tolerance, objects);
 	if (objects.empty())
-		map->findObjectsAt(position, 0.001f * 1.5f * tolerance, false, true, false, false, objects);
+	{
+		map->findObjectsAt(position, 0.001f * tolerance, false, false, false, false, objects);
+		if (objects.empty())
+			map->findObjectsAt(position, 0.001f * 1.5f * tolerance, false, true, false, false, objects);
+	}
+	last_position = position;
+	has_last_position = true;
 	
 	// Selection logic, trying to select the most relevant object(s)
 	if (!toggle || map->getNumSelectedObjects() == 0)
@@ -161,6 +174,31 @@ bool ObjectSelector::selectBox(MapCoordF corner1, MapCoordF corner2, bool toggle
 }
 
 
+void ObjectSelector::findDrawnObjectsAt(const MapWidget* widget, MapCoordF position, double tolerance, SelectionInfoVector& out) const
+{
+	// Point objects are selected within the square root of the tolerance
+	// (in mm), cf. Object::isPointOnObject().
+	auto const tolerance_mm = 0.001 * tolerance;
+	auto const radius_mm = std::max(tolerance_mm, std::sqrt(tolerance_mm));
+	auto const radius = widget->getMapView()->lengthToPixel(1000 * radius_mm);
+	
+	std::vector<Object*> candidates;
+	if (!widget->findObjectCandidatesAt(position, radius, candidates))
+		return;
+	
+	for (auto object : candidates)
+	{
+		if (object->getSymbol()->isHidden() || object->getSymbol()->isProtected())
+			continue;
+		
+		object->update();
+		int selected_type = object->isPointOnObject(position, float(tolerance_mm), false, false);
+		if (selected_type != int(Symbol::NoSymbol))
+			out.emplace_back(selected_type, object);
+	}
+}
+
+
 bool ObjectSelector::sortObjects(const std::pair< int, Object* >& a, const std::pair< int, Object* >& b)
 {
 	if (a.first != b.first)
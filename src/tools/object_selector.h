@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2015-2017 Kai Pastor
+ *    Copyright 2015-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -24,10 +24,12 @@
 #include <utility>
 #include <vector>
 
+#include "core/map_coord.h"
+
 namespace OpenOrienteering {
 
 class Map;
-class MapCoordF;
+class MapWidget;
 class Object;
 
 using SelectionInfoVector = std::vector<std::pair<int, Object*>>;
@@ -46,12 +48,19 @@ public:
 	 * Selects an object at the given position.
 	 * If there is already an object selected at this position, switches through
 	 * the available objects.
+	 * 
+	 * When a map widget is given, the first click at a position only considers
+	 * the objects which are drawn near this position, taken from the widget's
+	 * object pick buffer. Repeated clicks at the same position, and clicks
+	 * where the pick buffer yields no object, search all objects in the map.
+	 * 
 	 * @param tolerance maximum, normal selection distance in map units.
 	 *    It is enlarged by 1.5 if no objects are found with the normal distance.
 	 * @param toggle corresponds to the shift key modifier.
+	 * @param widget the map widget which received the click, or nullptr.
 	 * @return true if the selection has changed.
 	 */
-	bool selectAt(MapCoordF position, double tolerance, bool toggle);
+	bool selectAt(MapCoordF position, double tolerance, bool toggle, const MapWidget* widget = nullptr);
 	
 	/**
 	 * Applies box selection.
@@ -66,10 +75,20 @@ public:
 private:
 	bool selectionInfosEqual(const SelectionInfoVector& a, const SelectionInfoVector& b);
 	
+	/**
+	 * Finds the objects at the given position among the candidates from the
+	 * widget's object pick buffer.
+	 * 
+	 * Leaves out empty if the pick buffer cannot be used.
+	 */
+	void findDrawnObjectsAt(const MapWidget* widget, MapCoordF position, double tolerance, SelectionInfoVector& out) const;
+	
 	// Information about the last click
 	SelectionInfoVector last_results;
 	SelectionInfoVector last_results_ordered;
 	SelectionInfoVector::size_type next_object_to_select;
+	MapCoordF last_position;
+	bool has_last_position = false;
 	
 	Map* map;
 };
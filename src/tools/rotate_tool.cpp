@@ -35,6 +35,7 @@
 #include <QPointF>
 #include <QRectF>
 #include <QString>
+#include <QTransform>
 
 #include "core/map.h"
 #include "core/map_view.h"
@@ -150,15 +151,20 @@ void RotateTool::drawImpl(QPainter* painter, MapWidget* widget)
 {
 	const auto center = widget->mapToViewport(rotation_center);
 	
-	painter->save();
-	if (isDragging())
+	if (editingInProgress())
+	{
+		// The objects are modified in dragFinish() only.
+		// Until then, show the rotated original renderables.
+		QTransform transform;
+		transform.translate(center.x(), center.y());
+		transform.rotate(qRadiansToDegrees(current_rotation));
+		transform.translate(-center.x(), -center.y());
+		drawTransformedPreview(painter, widget, transform);
+	}
+	else
 	{
-		painter->translate(center);
-		painter->rotate(qRadiansToDegrees(current_rotation));
-		painter->translate(-center);
+		map()->drawSelection(painter, true, widget);
 	}
-	map()->drawSelection(painter, true, widget);
-	painter->restore();
 	
 	const auto saved_hints = painter->renderHints();
 	painter->setRenderHint(QPainter::Antialiasing, true);
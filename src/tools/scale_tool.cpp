@@ -31,6 +31,7 @@
 #include <QPointF>
 #include <QRectF>
 #include <QString>
+#include <QTransform>
 
 #include "core/map.h"
 #include "core/map_view.h"
@@ -86,31 +87,37 @@ void ScaleTool::dragStart()
 {
 	// WARNING: reference_length may become 0.
 	reference_length = (click_pos_map - scaling_center).length();
+	scaling_factor = 1;
 	startEditing(map()->selectedObjects());
 }
 
 
 void ScaleTool::dragMove()
 {
-	resetEditedObjects();
-	
 	// minimum_length will replace any shorter length, 
 	// in order to avoid extreme values and division by zero.
 	auto minimum_length = 1.0 / cur_map_widget->getMapView()->getZoom();
 	
 	auto scaling_length = (cur_pos_map - scaling_center).length();
 	scaling_factor = qMax(minimum_length, scaling_length) / qMax(minimum_length, reference_length);
-	for (auto object : editedObjects())
-		object->scale(scaling_center, scaling_factor);
 	
-	updatePreviewObjects();
+	// The objects are modified in dragFinish() only.
+	// Until then, drawImpl() shows the scaled original renderables.
+	updateDirtyRect();
 	updateStatusText();
 }
 
 
 void ScaleTool::dragFinish()
 {
+	if (scaling_factor != 1)
+	{
+		for (auto object : editedObjects())
+			object->scale(scaling_center, scaling_factor);
+	}
 	finishEditing();
+	scaling_factor = 1;
+	updateDirtyRect();
 	updateStatusText();
 }
 
@@ -118,21 +125,42 @@ void ScaleTool::dragFinish()
 
 void ScaleTool::drawImpl(QPainter* painter, MapWidget* widget)
 {
-	drawSelectionOrPreviewObjects(painter, widget);
+	QPointF center = widget->mapToViewport(scaling_center);
+	
+	if (editingInProgress())
+	{
+		QTransform transform;
+		transform.translate(center.x(), center.y());
+		transform.scale(scaling_factor, scaling_factor);
+		transform.translate(-center.x(), -center.y());
+		drawTransformedPreview(painter, widget, transform);
+	}
+	else
+	{
+		drawSelectionOrPreviewObjects(painter, widget);
+	}
 	
 	painter->setPen(Qt::white);
 	painter->setBrush(Qt::NoBrush);
 	
-	QPoint center = widget->mapToViewport(scaling_center).toPoint();
-	painter->drawEllipse(center, 3, 3);
+	painter->drawEllipse(center.toPoint(), 3, 3);
 	painter->setPen(Qt::black);
-	painter->drawEllipse(center, 4, 4);
+	painter->drawEllipse(center.toPoint(), 4, 4);
 }
 
 
 int ScaleTool::updateDirtyRectImpl(QRectF& rect)
 {
 	rectIncludeSafe(rect, scaling_center);
+	if (editingInProgress() && rect.isValid())
+	{
+		// Cover the scaled preview
+		const QPointF center = scaling_center;
+		const auto top_left = center + (rect.topLeft() - center) * scaling_factor;
+		const auto bottom_right = center + (rect.bottomRight() - center) * scaling_factor;
+		rectIncludeSafe(rect, top_left);
+		rectIncludeSafe(rect, bottom_right);
+	}
 	return 5;
 }
 
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -209,6 +209,11 @@ void MapEditorTool::useTouchCursor(bool enabled)
 	uses_touch_cursor = enabled;
 }
 
+void MapEditorTool::useObjectPicking(bool enabled)
+{
+	uses_object_picking = enabled;
+}
+
 Map* MapEditorTool::map() const
 {
 	return editor->getMap();
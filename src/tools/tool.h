@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2013-2017 Kai Pastor
+ *    Copyright 2013-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -202,6 +202,13 @@ public:
 	 */
 	bool usesTouchCursor() const { return uses_touch_cursor; }
 	
+	/**
+	 * @brief Returns whether the map widget shall maintain an object pick buffer for this tool.
+	 * 
+	 * @see MapWidget::findObjectCandidatesAt()
+	 */
+	bool usesObjectPicking() const { return uses_object_picking; }
+	
 	
 	/** 
 	 * @brief Returns the map being edited.
@@ -309,6 +316,15 @@ protected:
 	 */
 	void useTouchCursor(bool enabled);
 	
+	/**
+	 * Sets the flag which indicates whether the object pick buffer shall be used.
+	 * 
+	 * This must be set before the tool is activated.
+	 * 
+	 * @see usesObjectPicking()
+	 */
+	void useObjectPicking(bool enabled);
+	
 	/**
 	 * @brief Sets a flag which indicates an active editing operation.
 	 * 
@@ -378,6 +394,7 @@ private:
 	unsigned int scale_factor = 1;
 	bool editing_in_progress  = false;
 	bool uses_touch_cursor    = false;
+	bool uses_object_picking  = false;
 	bool draw_on_right_click  = false;
 };
 
@@ -29,7 +29,9 @@
 #include <QTimer>
 #include <QEvent>
 #include <QKeyEvent>
+#include <QPainter>
 #include <QRectF>
+#include <QTransform>
 
 #include "core/map.h"
 #include "core/objects/object.h"
@@ -484,6 +486,14 @@ void MapEditorToolBase::drawSelectionOrPreviewObjects(QPainter* painter, MapWidg
 	map()->drawSelection(painter, true, widget, renderables->empty() ? nullptr : renderables.get(), draw_opaque);
 }
 
+void MapEditorToolBase::drawTransformedPreview(QPainter* painter, MapWidget* widget, const QTransform& transform, bool draw_opaque)
+{
+	painter->save();
+	painter->setWorldTransform(transform, true);
+	map()->drawSelection(painter, true, widget, old_renderables.get(), draw_opaque);
+	painter->restore();
+}
+
 
 void MapEditorToolBase::startEditing()
 {
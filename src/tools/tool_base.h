@@ -44,6 +44,7 @@ class QKeyEvent;
 class QMouseEvent;
 class QPainter;
 class QRectF;
+class QTransform;
 
 namespace OpenOrienteering {
 
@@ -246,6 +247,10 @@ protected:
 	/// else draws the renderables of the selected map objects.
 	void drawSelectionOrPreviewObjects(QPainter* painter, MapWidget* widget, bool draw_opaque = false);
 	
+	/// Draws the original renderables of the edited objects, transformed by the given viewport transformation.
+	/// This is a fast preview for affine changes which are applied to the objects only in dragFinish().
+	void drawTransformedPreview(QPainter* painter, MapWidget* widget, const QTransform& transform, bool draw_opaque = false);
+	
 	/// Activates or deactivates the angle helper, recalculates (un-)constrained cursor position,
 	/// and calls mouseMove() or dragMove() to update the tool.
 	void activateAngleHelperWhileEditing(bool enable = true);
@@ -0,0 +1,200 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "background_task.h"
+
+#include <climits>
+
+#include <QtGlobal>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+
+namespace OpenOrienteering {
+
+/**
+ * Executes a BackgroundTask on a thread pool.
+ */
+class BackgroundTask::Runner : public QRunnable
+{
+public:
+	explicit Runner(BackgroundTask& task) : task(task) {}
+
+	void run() override
+	{
+		task.execute();
+	}
+
+private:
+	BackgroundTask& task;
+};
+
+
+
+BackgroundTask::BackgroundTask(QObject* parent)
+: QObject(parent)
+, progress_value(0)
+, canceled(false)
+{
+	// nothing else
+}
+
+BackgroundTask::~BackgroundTask()
+{
+	abort();
+}
+
+
+QString BackgroundTask::errorString() const
+{
+	QMutexLocker locker(&mutex);
+	return error_string;
+}
+
+
+void BackgroundTask::start()
+{
+	if (current_state != NotStarted)
+		return;
+
+	current_state = Running;
+	auto runner = new Runner(*this);
+	runner->setAutoDelete(true);
+	QThreadPool::globalInstance()->start(runner);
+}
+
+
+void BackgroundTask::cancel()
+{
+	canceled = true;
+}
+
+
+void BackgroundTask::abort()
+{
+	if (current_state != Running)
+		return;
+
+	cancel();
+	QMutexLocker locker(&mutex);
+	while (!work_done)
+		work_done_condition.wait(&mutex);
+}
+
+
+bool BackgroundTask::waitForFinished(int timeout)
+{
+	Q_ASSERT(thread() == QThread::currentThread());
+
+	if (current_state == NotStarted)
+		return false;
+
+	{
+		QMutexLocker locker(&mutex);
+		while (!work_done)
+		{
+			if (!work_done_condition.wait(&mutex, timeout < 0 ? ULONG_MAX : ulong(timeout)))
+				return false;
+		}
+	}
+	// The queued call to complete() will have no effect.
+	complete();
+	return true;
+}
+
+
+bool BackgroundTask::runSynchronously()
+{
+	if (current_state != NotStarted)
+		return false;
+
+	current_state = Running;
+	execute();
+	complete();
+	return current_state == Finished;
+}
+
+
+void BackgroundTask::commit()
+{
+	// nothing
+}
+
+
+void BackgroundTask::setProgress(int value, const QString& message)
+{
+	progress_value = qBound(0, value, 100);
+	emit progressChanged(progress_value, message);
+}
+
+
+void BackgroundTask::setErrorString(const QString& message)
+{
+	QMutexLocker locker(&mutex);
+	error_string = message;
+}
+
+
+void BackgroundTask::execute()
+{
+	auto const result = !canceled && run();
+
+	QMutexLocker locker(&mutex);
+	run_result = result;
+	work_done = true;
+	// Pass the completion to the task's thread. This must be done before
+	// waking up the destructor.
+	QMetaObject::invokeMethod(this, "complete", Qt::QueuedConnection);
+	work_done_condition.wakeAll();
+}
+
+
+void BackgroundTask::complete()
+{
+	if (current_state != Running)
+		return;
+
+	{
+		QMutexLocker locker(&mutex);
+		if (!work_done)
+			return;
+	}
+
+	if (canceled)
+	{
+		current_state = Canceled;
+	}
+	else if (!run_result)
+	{
+		current_state = Failed;
+	}
+	else
+	{
+		commit();
+		current_state = Finished;
+		setProgress(100);
+	}
+	emit finished();
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,199 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_BACKGROUND_TASK_H
+#define OPENORIENTEERING_BACKGROUND_TASK_H
+
+#include <atomic>
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QWaitCondition>
+
+namespace OpenOrienteering {
+
+
+/**
+ * A long-running operation which does its work on a thread pool.
+ *
+ * A task has two parts:
+ *
+ * - run() does the expensive work on a worker thread. It must not access
+ *   the map or any other object which is used by the GUI thread. Instead,
+ *   the constructor of a concrete task shall take a snapshot of its input,
+ *   e.g. by duplicating the objects it is going to operate on. run() shall
+ *   check isCanceled() regularly, and report its progress via setProgress().
+ *
+ * - commit() is called on the thread which owns the task (normally the GUI
+ *   thread) after run() succeeded. This is where results are applied to the
+ *   map, and where undo steps are pushed.
+ *
+ * The owner must make sure that the snapshot's origin stays unchanged while
+ * the task is running, e.g. by showing a modal TaskProgressDialog.
+ */
+class BackgroundTask : public QObject
+{
+Q_OBJECT
+public:
+	/** The states of a task. */
+	enum State
+	{
+		NotStarted,  ///< The task was not yet started.
+		Running,     ///< The task is queued or running.
+		Finished,    ///< The task finished and committed its results.
+		Canceled,    ///< The task was canceled. No results were committed.
+		Failed       ///< The task failed. No results were committed.
+	};
+
+	/** Constructs a new task. */
+	explicit BackgroundTask(QObject* parent = nullptr);
+
+	/**
+	 * Destroys the task.
+	 *
+	 * If the task is still running, it is aborted.
+	 */
+	~BackgroundTask() override;
+
+
+	/** Returns the current state. */
+	State state() const { return current_state; }
+
+	/** Returns the last reported progress, from 0 to 100. */
+	int progress() const { return progress_value; }
+
+	/** Returns a description of the error if the task failed. */
+	QString errorString() const;
+
+	/** Returns true if the task was asked to stop. Thread-safe. */
+	bool isCanceled() const { return canceled; }
+
+
+	/**
+	 * Starts the task on the global thread pool.
+	 *
+	 * Has no effect if the task was already started.
+	 */
+	void start();
+
+	/**
+	 * Asks the task to stop as soon as possible. Thread-safe.
+	 *
+	 * Results which are not yet committed will be discarded.
+	 */
+	void cancel();
+
+	/**
+	 * Cancels the task, and waits for run() to return.
+	 *
+	 * Concrete tasks must call this function in their destructor when run()
+	 * accesses members of the concrete task.
+	 */
+	void abort();
+
+	/**
+	 * Waits for run() to return, and completes the task immediately.
+	 *
+	 * Must be called on the thread which owns the task. If the timeout (in
+	 * milliseconds) expires before run() returns, this function returns false.
+	 * Otherwise it returns true, and the state is Finished, Canceled or Failed.
+	 */
+	bool waitForFinished(int timeout = -1);
+
+	/**
+	 * Runs and completes the task on the current thread.
+	 *
+	 * Returns true if the task finished and committed its results.
+	 */
+	bool runSynchronously();
+
+
+signals:
+	/**
+	 * Reports the progress of the task.
+	 *
+	 * This signal is emitted from the worker thread. Receivers on other
+	 * threads get it via queued connections.
+	 *
+	 * @param value    The progress, from 0 (not started) to 100 (finished).
+	 * @param message  A description of the current step, may be empty.
+	 */
+	void progressChanged(int value, const QString& message);
+
+	/**
+	 * Indicates that the task is no longer running.
+	 *
+	 * This signal is emitted on the owner's thread, after the results were
+	 * committed, or after the task was canceled or failed.
+	 */
+	void finished();
+
+
+protected:
+	/**
+	 * Does the actual work.
+	 *
+	 * Called on a worker thread, or on the current thread by
+	 * runSynchronously(). Returns false on error.
+	 */
+	virtual bool run() = 0;
+
+	/**
+	 * Applies the results of run().
+	 *
+	 * Called on the owner's thread when run() returned true and the task
+	 * was not canceled. The default implementation does nothing.
+	 */
+	virtual void commit();
+
+	/** Reports the progress. Thread-safe. */
+	void setProgress(int value, const QString& message = {});
+
+	/** Sets the error string. To be called from run() before returning false. */
+	void setErrorString(const QString& message);
+
+
+private slots:
+	/** Commits the result and sets the final state. */
+	void complete();
+
+
+private:
+	class Runner;
+
+	/** Calls run() and records its result. */
+	void execute();
+
+	Q_DISABLE_COPY(BackgroundTask)
+
+	mutable QMutex mutex;
+	QWaitCondition work_done_condition;
+	QString error_string;
+	State current_state = NotStarted;
+	std::atomic<int> progress_value;
+	std::atomic<bool> canceled;
+	bool work_done = false;
+	bool run_result = false;
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
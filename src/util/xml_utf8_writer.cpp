@@ -0,0 +1,252 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "xml_utf8_writer.h"
+
+#include <QIODevice>
+
+#include "fileformats/file_format.h"
+#include "util/xml_stream_util.h"
+
+
+namespace OpenOrienteering {
+
+namespace literal = XmlStreamLiteral;
+
+
+
+XmlUtf8Writer::XmlUtf8Writer(QIODevice* device)
+: device(device)
+{
+	buffer.reserve(buffer_size + 4096);
+}
+
+XmlUtf8Writer::~XmlUtf8Writer()
+{
+	if (!buffer.isEmpty())
+		device->write(buffer);
+}
+
+
+void XmlUtf8Writer::writeStartElement(const QLatin1String& name)
+{
+	finishStartTag();
+	buffer.append('<').append(name.data(), name.size());
+	open_elements.push_back(name);
+	start_tag_open = true;
+}
+
+void XmlUtf8Writer::writeEndElement()
+{
+	Q_ASSERT(!open_elements.empty());
+	auto const name = open_elements.back();
+	open_elements.pop_back();
+	if (start_tag_open)
+	{
+		buffer.append("/>", 2);
+		start_tag_open = false;
+	}
+	else
+	{
+		buffer.append("</", 2).append(name.data(), name.size()).append('>');
+	}
+	flushIfFull();
+}
+
+void XmlUtf8Writer::writeTextElement(const QLatin1String& name, const QString& text)
+{
+	writeStartElement(name);
+	writeCharacters(text);
+	writeEndElement();
+}
+
+void XmlUtf8Writer::writeCharacters(const QString& text)
+{
+	finishStartTag();
+	writeEscaped(text, false);
+}
+
+void XmlUtf8Writer::writeLineBreak()
+{
+	finishStartTag();
+	buffer.append('\n');
+}
+
+
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, const QString& value)
+{
+	Q_ASSERT(start_tag_open);
+	buffer.append(' ').append(name.data(), name.size()).append("=\"", 2);
+	writeEscaped(value, true);
+	buffer.append('"');
+}
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, const QLatin1String& value)
+{
+	Q_ASSERT(start_tag_open);
+	buffer.append(' ').append(name.data(), name.size()).append("=\"", 2)
+	      .append(value.data(), value.size()).append('"');
+}
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, double value)
+{
+	writeRawAttribute(name, QByteArray::number(value));
+}
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, int value)
+{
+	writeRawAttribute(name, QByteArray::number(value));
+}
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, unsigned int value)
+{
+	writeRawAttribute(name, QByteArray::number(value));
+}
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, qint64 value)
+{
+	writeRawAttribute(name, QByteArray::number(value));
+}
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, long unsigned int value)
+{
+	writeRawAttribute(name, QByteArray::number(quint64(value)));
+}
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, quint64 value)
+{
+	writeRawAttribute(name, QByteArray::number(value));
+}
+
+void XmlUtf8Writer::writeAttribute(const QLatin1String& name, bool value)
+{
+	if (value)
+		writeAttribute(name, literal::string_true);
+}
+
+
+
+void XmlUtf8Writer::write(const MapCoordVector& coords)
+{
+	writeAttribute(literal::count, coords.size());
+	finishStartTag();
+	for (const auto& coord : coords)
+	{
+		coord.appendText(buffer);
+		flushIfFull();
+	}
+}
+
+void XmlUtf8Writer::write(const QHash<QString, QString>& tags)
+{
+	for (auto tag = tags.constBegin(), end = tags.constEnd(); tag != end; ++tag)
+	{
+		writeStartElement(literal::t);
+		writeAttribute(literal::k, tag.key());
+		writeCharacters(tag.value());
+		writeEndElement();
+	}
+}
+
+
+
+void XmlUtf8Writer::flush()
+{
+	if (buffer.isEmpty())
+		return;
+	
+	auto const written = device->write(buffer);
+	buffer.resize(0);
+	if (written < 0)
+		throw FileFormatException(device->errorString());
+}
+
+void XmlUtf8Writer::flushIfFull()
+{
+	if (buffer.size() >= buffer_size)
+		flush();
+}
+
+void XmlUtf8Writer::finishStartTag()
+{
+	if (start_tag_open)
+	{
+		buffer.append('>');
+		start_tag_open = false;
+	}
+}
+
+void XmlUtf8Writer::writeRawAttribute(const QLatin1String& name, const QByteArray& value)
+{
+	Q_ASSERT(start_tag_open);
+	buffer.append(' ').append(name.data(), name.size()).append("=\"", 2)
+	      .append(value).append('"');
+}
+
+void XmlUtf8Writer::writeEscaped(const QString& text, bool escape_whitespace)
+{
+	// The characters to be escaped are ASCII, and UTF-8 never uses bytes
+	// in the ASCII range for multi-byte sequences. So the escaping can be
+	// done on the UTF-8 data. The rules follow QXmlStreamWriter.
+	auto const utf8 = text.toUtf8();
+	for (auto c : utf8)
+	{
+		switch (c)
+		{
+		case '<':
+			buffer.append("&lt;", 4);
+			break;
+		case '>':
+			buffer.append("&gt;", 4);
+			break;
+		case '&':
+			buffer.append("&amp;", 5);
+			break;
+		case '"':
+			buffer.append("&quot;", 6);
+			break;
+		case '\n':
+			if (escape_whitespace)
+				buffer.append("&#10;", 5);
+			else
+				buffer.append(c);
+			break;
+		case '\r':
+			if (escape_whitespace)
+				buffer.append("&#13;", 5);
+			else
+				buffer.append(c);
+			break;
+		case '\t':
+			if (escape_whitespace)
+				buffer.append("&#9;", 4);
+			else
+				buffer.append(c);
+			break;
+		default:
+			buffer.append(c);
+		}
+	}
+	flushIfFull();
+}
+
+
+}  // namespace OpenOrienteering
@@ -0,0 +1,269 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "background_task_t.h"
+
+#include <atomic>
+#include <cstddef>
+
+#include <QtTest>
+#include <QSemaphore>
+#include <QSignalSpy>
+#include <QThread>
+
+#include "test_helpers.h"
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/objects/boolean_tool.h"
+#include "core/objects/object.h"
+#include "core/symbols/area_symbol.h"
+#include "tools/cutout_operation.h"
+#include "undo/undo_manager.h"
+#include "util/background_task.h"
+
+using namespace OpenOrienteering;
+using namespace OpenOrienteering::TestHelpers;
+
+
+namespace
+{
+
+/**
+ * A task which counts up to a limit, or until it is canceled.
+ */
+class CountingTask : public BackgroundTask
+{
+public:
+	explicit CountingTask(int limit) : limit(limit) {}
+	
+	~CountingTask() override { abort(); }
+	
+	bool run() override
+	{
+		run_thread = QThread::currentThread();
+		started.release();
+		for (count = 0; limit < 0 || count < limit; ++count)
+		{
+			if (isCanceled())
+				return false;
+			if (limit > 0)
+				setProgress(100 * count / limit);
+			else
+				QThread::msleep(1);
+		}
+		if (count == 13)
+		{
+			setErrorString(QStringLiteral("Unlucky"));
+			return false;
+		}
+		return true;
+	}
+	
+	void commit() override
+	{
+		commit_thread = QThread::currentThread();
+		++commits;
+	}
+	
+	const int limit;
+	std::atomic<int> count { 0 };
+	QSemaphore started;
+	QThread* run_thread = nullptr;
+	QThread* commit_thread = nullptr;
+	int commits = 0;
+};
+
+
+}  // namespace
+
+
+
+void BackgroundTaskTest::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
+void BackgroundTaskTest::threadsTest()
+{
+	CountingTask task(1000);
+	QSignalSpy finished_spy(&task, &BackgroundTask::finished);
+	QCOMPARE(task.state(), BackgroundTask::NotStarted);
+	
+	task.start();
+	QCOMPARE(task.state(), BackgroundTask::Running);
+	QVERIFY(task.waitForFinished());
+	QCOMPARE(task.state(), BackgroundTask::Finished);
+	QCOMPARE(int(task.count), 1000);
+	QCOMPARE(task.progress(), 100);
+	QCOMPARE(task.commits, 1);
+	QCOMPARE(finished_spy.count(), 1);
+	QVERIFY(task.run_thread != QThread::currentThread());
+	QCOMPARE(task.commit_thread, QThread::currentThread());
+	
+	// Completion is done once only.
+	QCoreApplication::processEvents();
+	QCOMPARE(task.commits, 1);
+	QCOMPARE(finished_spy.count(), 1);
+	
+	CountingTask sync_task(10);
+	QVERIFY(sync_task.runSynchronously());
+	QCOMPARE(sync_task.run_thread, QThread::currentThread());
+	QCOMPARE(sync_task.commits, 1);
+}
+
+
+void BackgroundTaskTest::eventLoopTest()
+{
+	CountingTask task(100);
+	QSignalSpy progress_spy(&task, &BackgroundTask::progressChanged);
+	QSignalSpy finished_spy(&task, &BackgroundTask::finished);
+	task.start();
+	QVERIFY(finished_spy.wait());
+	QCOMPARE(task.state(), BackgroundTask::Finished);
+	QCOMPARE(task.commits, 1);
+	QVERIFY(progress_spy.count() > 0);
+	QCOMPARE(progress_spy.last().at(0).toInt(), 100);
+}
+
+
+void BackgroundTaskTest::cancelTest()
+{
+	CountingTask task(-1);  // Endless
+	task.start();
+	task.started.acquire();
+	task.cancel();
+	QVERIFY(task.isCanceled());
+	QVERIFY(task.waitForFinished());
+	QCOMPARE(task.state(), BackgroundTask::Canceled);
+	QCOMPARE(task.commits, 0);
+	
+	// Destroying a running task cancels it.
+	{
+		CountingTask endless(-1);
+		endless.start();
+		endless.started.acquire();
+	}
+}
+
+
+void BackgroundTaskTest::failureTest()
+{
+	CountingTask task(13);
+	task.start();
+	QVERIFY(task.waitForFinished());
+	QCOMPARE(task.state(), BackgroundTask::Failed);
+	QCOMPARE(task.errorString(), QStringLiteral("Unlucky"));
+	QCOMPARE(task.commits, 0);
+}
+
+
+void BackgroundTaskTest::cutoutTest()
+{
+	Map map;
+	auto area = new AreaSymbol();
+	map.addSymbol(area, 0);
+	
+	makeSquare(map, area, 0, 0, 10);     // partially inside
+	makeSquare(map, area, 100, 100, 10); // outside
+	auto inside = makeSquare(map, area, 10, 2, 2);
+	auto cutout = makeSquare(map, area, 5, -5, 20);
+	QCOMPARE(map.getNumObjects(), 4);
+	
+	{
+		CutoutOperation operation(&map, cutout, false);
+		operation.start();
+		QVERIFY(operation.waitForFinished());
+		QCOMPARE(operation.state(), BackgroundTask::Finished);
+	}
+	
+	// The outside square is removed, the first square is replaced by its
+	// clipped part (appended at the end), the inside square is unchanged.
+	QCOMPARE(map.getNumObjects(), 3);
+	auto part = map.getCurrentPart();
+	QCOMPARE(part->getObject(0), inside);
+	QCOMPARE(part->getObject(1), cutout);
+	auto clipped = part->getObject(2);
+	clipped->update();
+	QCOMPARE(clipped->getExtent(), QRectF(5, 0, 5, 10));
+	
+	QVERIFY(map.undoManager().canUndo());
+	QVERIFY(map.undoManager().undo());
+	QCOMPARE(map.getNumObjects(), 4);
+}
+
+
+void BackgroundTaskTest::booleanUnionTest()
+{
+	Map map;
+	auto area = new AreaSymbol();
+	map.addSymbol(area, 0);
+	auto other_area = new AreaSymbol();
+	map.addSymbol(other_area, 1);
+	
+	for (auto object : { makeSquare(map, area, 0, 0, 10),
+	                     makeSquare(map, area, 5, 0, 10),
+	                     makeSquare(map, other_area, 0, 20, 10),
+	                     makeSquare(map, other_area, 30, 20, 10) })
+	{
+		map.addObjectToSelection(object, false);
+	}
+	
+	BooleanTask task(BooleanTool::Union, &map, BooleanTask::PerSymbol);
+	task.start();
+	QVERIFY(task.waitForFinished());
+	QCOMPARE(task.state(), BackgroundTask::Finished);
+	QVERIFY(task.hasChanges());
+	
+	// The first two squares are merged, the other two remain separate.
+	QCOMPARE(map.getNumObjects(), 3);
+	QCOMPARE(map.getNumSelectedObjects(), 3);
+	
+	QVERIFY(map.undoManager().undo());
+	QCOMPARE(map.getNumObjects(), 4);
+}
+
+
+void BackgroundTaskTest::booleanCancelTest()
+{
+	Map map;
+	auto area = new AreaSymbol();
+	map.addSymbol(area, 0);
+	
+	auto subject = makeSquare(map, area, 0, 0, 10);
+	BooleanTool::PathObjects in_objects = { subject, makeSquare(map, area, 5, 5, 10) };
+	BooleanTool::PathObjects out_objects;
+	BooleanTool tool(BooleanTool::Intersection, &map);
+	
+	CountingTask task(1);
+	QVERIFY(tool.executeForObjects(subject, in_objects, out_objects, &task));
+	QCOMPARE(out_objects.size(), std::size_t(1));
+	delete out_objects.front();
+	out_objects.clear();
+	
+	task.cancel();
+	QVERIFY(!tool.executeForObjects(subject, in_objects, out_objects, &task));
+	QVERIFY(out_objects.empty());
+}
+
+
+QTEST_MAIN(BackgroundTaskTest)
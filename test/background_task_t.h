@@ -0,0 +1,57 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_BACKGROUND_TASK_T_H
+#define OPENORIENTEERING_BACKGROUND_TASK_T_H
+
+#include <QObject>
+
+
+/**
+ * @test Tests the background task framework and the operations using it.
+ */
+class BackgroundTaskTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	
+	/** Tests that run() and commit() are executed on the right threads. */
+	void threadsTest();
+	
+	/** Tests the completion via the event loop. */
+	void eventLoopTest();
+	
+	/** Tests cooperative cancellation. */
+	void cancelTest();
+	
+	/** Tests the reporting of errors. */
+	void failureTest();
+	
+	/** Tests the cutout operation, including its undo step. */
+	void cutoutTest();
+	
+	/** Tests the boolean union per symbol. */
+	void booleanUnionTest();
+	
+	/** Tests that a single boolean operation stops when canceled. */
+	void booleanCancelTest();
+};
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compact_coord_vector_t.h"
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QBuffer>
+#include <QXmlStreamWriter>
+
+#include "core/compact_coord_vector.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/objects/object.h"
+#include "core/symbols/line_symbol.h"
+
+Q_DECLARE_METATYPE(OpenOrienteering::MapCoordVector)
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/** Returns a valid path with gaps, a hole and a closed part. */
+MapCoordVector makePath(int num_coords)
+{
+	MapCoordVector coords;
+	for (int i = 0; i < num_coords; ++i)
+	{
+		coords.push_back(MapCoord::fromNative(i * 1000, (i % 2) * 500 - i * 10));
+		if (i % 7 == 3)
+			coords.back().setGapPoint(true);
+	}
+	coords.back().setHolePoint(true);
+	for (auto c : { MapCoord(0, 10), MapCoord(5, 10), MapCoord(5, 15), MapCoord(0, 10) })
+		coords.push_back(c);
+	coords.back().setClosePoint(true);
+	return coords;
+}
+
+}  // namespace
+
+
+
+void CompactCoordVectorTest::initTestCase()
+{
+	// Initializes the static symbols, e.g. Map::getUndefinedLine().
+	Map map;
+	Q_UNUSED(map)
+}
+
+
+void CompactCoordVectorTest::roundTripTest_data()
+{
+	QTest::addColumn<MapCoordVector>("coords");
+	
+	auto const min = std::numeric_limits<qint32>::min();
+	auto const max = std::numeric_limits<qint32>::max();
+	
+	QTest::newRow("empty") << MapCoordVector{};
+	QTest::newRow("single") << MapCoordVector{ MapCoord::fromNative(-7, 11) };
+	QTest::newRow("extremes") << MapCoordVector{
+	    MapCoord::fromNative(max, min, MapCoord::DashPoint),
+	    MapCoord::fromNative(min, max, MapCoord::ClosePoint),
+	    MapCoord::fromNative(max, max),
+	    MapCoord::fromNative(min, min, MapCoord::HolePoint),
+	    MapCoord::fromNative(0, 0) };
+	
+	// Each combination of flags, with deltas of increasing magnitude
+	MapCoordVector flags;
+	auto const all_flags = int(MapCoord::CurveStart | MapCoord::ClosePoint | MapCoord::GapPoint
+	                           | MapCoord::HolePoint | MapCoord::DashPoint);
+	for (int i = 0; i < 64; ++i)
+	{
+		auto const delta = qint32(1) << (i % 31);
+		auto const sign = (i % 2) ? -1 : 1;
+		flags.push_back(MapCoord::fromNative(sign * delta, -sign * (delta / 3), MapCoord::Flags(QFlag(i & all_flags))));
+	}
+	QTest::newRow("flags") << flags;
+	
+	QTest::newRow("path") << makePath(1000);
+}
+
+void CompactCoordVectorTest::roundTripTest()
+{
+	QFETCH(MapCoordVector, coords);
+	
+	CompactCoordVector compact_coords(coords);
+	QCOMPARE(compact_coords.size(), coords.size());
+	QCOMPARE(compact_coords.empty(), coords.empty());
+	
+	MapCoordVector decoded = { MapCoord(1, 1) };
+	compact_coords.decode(decoded);
+	QVERIFY(decoded == coords);
+	
+	compact_coords.encode(decoded);
+	compact_coords.decode(decoded);
+	QVERIFY(decoded == coords);
+	
+	compact_coords.clear();
+	QVERIFY(compact_coords.empty());
+	QCOMPARE(compact_coords.byteSize(), std::size_t(0));
+}
+
+
+void CompactCoordVectorTest::objectTest()
+{
+	auto const coords = makePath(50);
+	PathObject object(Map::getUndefinedLine(), coords);
+	object.update();
+	// Non-const access to the parts would mark the object as dirty.
+	const auto& const_object = object;
+	auto const num_parts = const_object.parts().size();
+	auto const length = const_object.parts().front().length();
+	auto const extent = object.getExtent();
+	std::unique_ptr<PathObject> duplicate { object.duplicate() };
+	
+	QVERIFY(object.compact());
+	QVERIFY(object.isCompacted());
+	QVERIFY(!object.compact());
+	QCOMPARE(object.getExtent(), extent);
+	
+	QVERIFY(object.getRawCoordinateVector() == coords);
+	QVERIFY(!object.isCompacted());
+	QVERIFY(!object.isOutputDirty());
+	QCOMPARE(const_object.parts().size(), num_parts);
+	QCOMPARE(const_object.parts().front().length(), length);
+	
+	// Copies are never compacted.
+	QVERIFY(object.compact());
+	std::unique_ptr<PathObject> copy { object.duplicate() };
+	QVERIFY(!copy->isCompacted());
+	QVERIFY(object.equals(duplicate.get(), true));
+	QVERIFY(copy->equals(duplicate.get(), true));
+	
+	// Short paths are not compacted.
+	PathObject short_object(Map::getUndefinedLine(), makePath(2));
+	short_object.update();
+	QVERIFY(!short_object.compact());
+	
+	// Dirty paths are not compacted.
+	PathObject dirty_object(Map::getUndefinedLine(), coords);
+	QVERIFY(!dirty_object.compact());
+}
+
+
+void CompactCoordVectorTest::mutationTest()
+{
+	PathObject proto(Map::getUndefinedLine(), makePath(30));
+	
+	using Mutation = std::function<void (PathObject&)>;
+	const std::pair<const char*, Mutation> mutations[] = {
+	    { "setCoordinate", [](PathObject& object) { object.setCoordinate(5, MapCoord(1, 2)); } },
+	    { "addCoordinate", [](PathObject& object) { object.addCoordinate(3, MapCoord(7, 7)); } },
+	    { "addCoordinate, new part", [](PathObject& object) { object.addCoordinate(MapCoord(9, 9), true); } },
+	    { "deleteCoordinate", [](PathObject& object) { object.deleteCoordinate(4, false); } },
+	    { "deletePart", [](PathObject& object) { object.deletePart(0); } },
+	    { "clearCoordinates", [](PathObject& object) { object.clearCoordinates(); } },
+	    { "assignCoordinates", [&proto](PathObject& object) { object.assignCoordinates(proto, 2, 10); } },
+	    { "reverse", [](PathObject& object) { object.reverse(); } },
+	    { "closeAllParts", [](PathObject& object) { object.closeAllParts(); } },
+	    { "convertToCurves", [](PathObject& object) { object.convertToCurves(); } },
+	    { "normalize", [](PathObject& object) { object.normalize(); } },
+	    { "recalculateParts", [](PathObject& object) { object.recalculateParts(); } },
+	};
+	
+	for (const auto& mutation : mutations)
+	{
+		PathObject expected(Map::getUndefinedLine(), makePath(50));
+		expected.update();
+		mutation.second(expected);
+		
+		PathObject object(Map::getUndefinedLine(), makePath(50));
+		object.update();
+		QVERIFY(object.compact());
+		mutation.second(object);
+		QVERIFY2(!object.isCompacted(), mutation.first);
+		
+		QVERIFY2(object.getRawCoordinateVector() == expected.getRawCoordinateVector(), mutation.first);
+		const auto& parts = static_cast<const PathObject&>(object).parts();
+		const auto& expected_parts = static_cast<const PathObject&>(expected).parts();
+		QVERIFY2(parts.size() == expected_parts.size(), mutation.first);
+		for (std::size_t i = 0; i < parts.size(); ++i)
+		{
+			QVERIFY2(parts[i].first_index == expected_parts[i].first_index, mutation.first);
+			QVERIFY2(parts[i].last_index == expected_parts[i].last_index, mutation.first);
+		}
+	}
+}
+
+
+void CompactCoordVectorTest::saveTest()
+{
+	auto const save = [](const Object& object) {
+		QBuffer buffer;
+		buffer.open(QIODevice::WriteOnly);
+		QXmlStreamWriter xml(&buffer);
+		object.save(xml);
+		return buffer.data();
+	};
+	
+	PathObject object(Map::getUndefinedLine(), makePath(50));
+	object.update();
+	auto const expected = save(object);
+	
+	QVERIFY(object.compact());
+	object.resetRecentlyUsed();
+	QCOMPARE(save(object), expected);
+	QVERIFY(object.isCompacted());
+	QVERIFY(!object.isRecentlyUsed());
+}
+
+
+}  // namespace OpenOrienteering
+
+QTEST_MAIN(OpenOrienteering::CompactCoordVectorTest)
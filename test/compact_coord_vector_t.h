@@ -0,0 +1,58 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_COMPACT_COORD_VECTOR_T_H
+#define OPENORIENTEERING_COMPACT_COORD_VECTOR_T_H
+
+#include <QObject>
+
+
+namespace OpenOrienteering {
+
+/**
+ * @test Tests the compact coordinate storage for idle objects.
+ * 
+ * The benchmarks are in compact_coords_t.
+ */
+class CompactCoordVectorTest : public QObject
+{
+Q_OBJECT
+	
+private slots:
+	/** Initialization. */
+	void initTestCase();
+	
+	/** Verifies that encoding and decoding is lossless. */
+	void roundTripTest();
+	void roundTripTest_data();
+	
+	/** Verifies that compacting and expanding a path object is transparent. */
+	void objectTest();
+	
+	/** Verifies that modifying a compacted path object gives the same result as for an expanded one. */
+	void mutationTest();
+	
+	/** Verifies that saving leaves compacted objects compacted. */
+	void saveTest();
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compact_coords_t.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include <QtGlobal>
+#include <QtTest>
+
+#include "core/compact_coord_vector.h"
+#include "core/map.h"
+#include "core/path_coord.h"
+#include "core/objects/object.h"
+#include "core/symbols/line_symbol.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+std::size_t plainSize(const PathObject& object)
+{
+	auto size = object.getRawCoordinateVector().capacity() * sizeof(MapCoord);
+	for (const auto& part : object.parts())
+		size += part.path_coords.capacity() * sizeof(PathCoord);
+	return size;
+}
+
+}  // namespace
+
+
+
+void CompactCoordsTest::initTestCase()
+{
+	// Initializes the static symbols, e.g. Map::getUndefinedLine().
+	Map map;
+	Q_UNUSED(map)
+}
+
+
+void CompactCoordsTest::common_data()
+{
+	QTest::addColumn<int>("num_coords");
+	QTest::newRow("num_coords = 50") << 50;
+	QTest::newRow("num_coords = 500") << 500;
+	QTest::newRow("num_coords = 5000") << 5000;
+	QTest::newRow("num_coords = 50000") << 50000;
+}
+
+
+MapCoordVector CompactCoordsTest::makeCoords(int num_coords)
+{
+	MapCoordVector coords;
+	coords.reserve(std::size_t(num_coords));
+	for (int i = 0; i < num_coords; ++i)
+	{
+		auto const x = qint32(i * 700 + (i * 7919) % 300);
+		auto const y = qint32(std::lround(5000 * std::sin(i / 20.0)));
+		coords.push_back(MapCoord::fromNative(x, y));
+		
+		auto const index_in_segment = i % 8;
+		if (index_in_segment == 0 && i + 3 < num_coords)
+			coords.back().setCurveStart(true);
+		else if (index_in_segment == 5 && i % 40 == 5)
+			coords.back().setGapPoint(true);
+		else if (index_in_segment == 6 && i == (num_coords / 16) * 8 + 6)
+			coords.back().setHolePoint(true);
+	}
+	coords.back().setCurveStart(false);
+	return coords;
+}
+
+
+void CompactCoordsTest::memoryUsage_data()
+{
+	common_data();
+}
+
+void CompactCoordsTest::memoryUsage()
+{
+	QFETCH(int, num_coords);
+	
+	PathObject object(Map::getUndefinedLine(), makeCoords(num_coords));
+	object.update();
+	auto const plain_size = plainSize(object);
+	
+	auto const compact_size = CompactCoordVector(object.getRawCoordinateVector()).byteSize();
+	qDebug("%d coords: %u bytes plain, %u bytes compact (%.1f%%)",
+	       num_coords, unsigned(plain_size), unsigned(compact_size),
+	       100.0 * compact_size / plain_size);
+	QVERIFY(compact_size < plain_size / 4);
+}
+
+
+void CompactCoordsTest::encode_data()
+{
+	common_data();
+}
+
+void CompactCoordsTest::encode()
+{
+	QFETCH(int, num_coords);
+	auto const coords = makeCoords(num_coords);
+	CompactCoordVector compact_coords;
+	QBENCHMARK
+	{
+		compact_coords.encode(coords);
+	}
+	QCOMPARE(compact_coords.size(), coords.size());
+}
+
+
+void CompactCoordsTest::decode_data()
+{
+	common_data();
+}
+
+void CompactCoordsTest::decode()
+{
+	QFETCH(int, num_coords);
+	auto const compact_coords = CompactCoordVector(makeCoords(num_coords));
+	MapCoordVector coords;
+	QBENCHMARK
+	{
+		compact_coords.decode(coords);
+	}
+	QCOMPARE(coords.size(), compact_coords.size());
+}
+
+
+void CompactCoordsTest::compactAndExpandObject_data()
+{
+	common_data();
+}
+
+void CompactCoordsTest::compactAndExpandObject()
+{
+	QFETCH(int, num_coords);
+	PathObject object(Map::getUndefinedLine(), makeCoords(num_coords));
+	object.update();
+	const auto& const_object = object;
+	qreal length = 0;
+	QBENCHMARK
+	{
+		object.compact();
+		length = const_object.parts().front().length();
+	}
+	QVERIFY(!object.isOutputDirty());
+	QVERIFY(length > 0);
+}
+
+
+void CompactCoordsTest::accessPlainObject_data()
+{
+	common_data();
+}
+
+void CompactCoordsTest::accessPlainObject()
+{
+	QFETCH(int, num_coords);
+	PathObject object(Map::getUndefinedLine(), makeCoords(num_coords));
+	object.update();
+	const auto& const_object = object;
+	qreal length = 0;
+	QBENCHMARK
+	{
+		length = const_object.parts().front().length();
+	}
+	QVERIFY(length > 0);
+}
+
+
+}  // namespace OpenOrienteering
+
+QTEST_MAIN(OpenOrienteering::CompactCoordsTest)
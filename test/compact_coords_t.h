@@ -0,0 +1,72 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_COMPACT_COORDS_T_H
+#define OPENORIENTEERING_COMPACT_COORDS_T_H
+
+#include <QObject>
+
+#include "core/map_coord.h"
+
+
+namespace OpenOrienteering {
+
+/**
+ * @test Benchmarks the memory usage and access cost of the compact
+ *       coordinate storage for idle objects.
+ */
+class CompactCoordsTest : public QObject
+{
+Q_OBJECT
+	
+private slots:
+	/** Initialization. */
+	void initTestCase();
+	
+	/** Compares the memory used by plain and compacted path objects. */
+	void memoryUsage();
+	void memoryUsage_data();
+	
+	/** Measures the encoding of coordinates. */
+	void encode();
+	void encode_data();
+	
+	/** Measures the decoding of coordinates. */
+	void decode();
+	void decode_data();
+	
+	/** Measures compacting and expanding a path object, including path coords. */
+	void compactAndExpandObject();
+	void compactAndExpandObject_data();
+	
+	/** Measures regular access to the coordinates of a path object, for reference. */
+	void accessPlainObject();
+	void accessPlainObject_data();
+	
+private:
+	void common_data();
+	
+	/** Returns a line with curves, gaps and a hole, resembling real map data. */
+	static MapCoordVector makeCoords(int num_coords);
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -0,0 +1,365 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contour_generator_t.h"
+
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+
+#include <QtTest>
+#include <QFile>
+#include <QLineF>
+#include <QPointF>
+#include <QString>
+#include <QTextStream>
+
+#include "global.h"
+#include "core/crs_template.h"
+#include "core/georeferencing.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/symbols/line_symbol.h"
+#include "gdal/contour_generator.h"
+#include "undo/undo_manager.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+constexpr double no_data = std::numeric_limits<double>::quiet_NaN();
+
+/**
+ * Writes an ESRI ASCII grid with 10 m cells, starting at (1000, 2000).
+ */
+QString writeGrid(const QTemporaryDir& dir, const QString& name, int width, int height, std::function<double (int, int)> elevation)
+{
+	auto const path = dir.path() + QLatin1Char('/') + name;
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return {};
+	
+	QTextStream stream(&file);
+	stream << "ncols " << width << '\n'
+	       << "nrows " << height << '\n'
+	       << "xllcorner 1000\n"
+	       << "yllcorner 2000\n"
+	       << "cellsize 10\n"
+	       << "NODATA_value -9999\n";
+	for (int row = 0; row < height; ++row)
+	{
+		for (int col = 0; col < width; ++col)
+		{
+			auto const value = elevation(col, row);
+			stream << (std::isnan(value) ? -9999.0 : value) << ' ';
+		}
+		stream << '\n';
+	}
+	return path;
+}
+
+/**
+ * Writes a cone with its top of 200.3 m at the center sample, and a slope of 0.1.
+ */
+QString writeCone(const QTemporaryDir& dir)
+{
+	return writeGrid(dir, QString::fromLatin1("cone.asc"), 151, 151, [](int col, int row) {
+		return 200.3 - std::hypot(col - 75, row - 75);
+	});
+}
+
+/// The projected coordinates of the cone's top.
+const QPointF cone_center { 1000 + 75.5 * 10, 2000 + 151 * 10 - 75.5 * 10 };
+
+/**
+ * Writes the ESRI .prj file for a grid, for a WGS 84 / UTM zone (north).
+ */
+bool writeUtmPrj(const QString& grid_path, int zone)
+{
+	auto path = grid_path;
+	path.replace(QLatin1String(".asc"), QLatin1String(".prj"));
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+	
+	QTextStream stream(&file);
+	stream << "PROJCS[\"WGS_1984_UTM_Zone_" << zone << "N\","
+	          "GEOGCS[\"GCS_WGS_1984\",DATUM[\"D_WGS_1984\",SPHEROID[\"WGS_1984\",6378137.0,298.257223563]],"
+	          "PRIMEM[\"Greenwich\",0.0],UNIT[\"Degree\",0.0174532925199433]],"
+	          "PROJECTION[\"Transverse_Mercator\"],"
+	          "PARAMETER[\"False_Easting\",500000.0],PARAMETER[\"False_Northing\",0.0],"
+	          "PARAMETER[\"Central_Meridian\"," << (zone * 6 - 183) << ".0],"
+	          "PARAMETER[\"Scale_Factor\",0.9996],PARAMETER[\"Latitude_Of_Origin\",0.0],"
+	          "UNIT[\"Meter\",1.0]]";
+	return true;
+}
+
+/**
+ * Sets the map's projected CRS to WGS 84 / UTM zone 32N.
+ */
+void setupUtmGeoreferencing(Map& map)
+{
+	Georeferencing georef;
+	georef.setScaleDenominator(10000);
+	georef.setProjectedCRS(QString::fromLatin1("EPSG:32632"), CRSTemplateRegistry().find(QString::fromLatin1("EPSG"))->specificationTemplate().arg(QString::fromLatin1("32632")), { QString::fromLatin1("32632") });
+	georef.setProjectedRefPoint({ 1000.0, 2000.0 }, false);
+	map.setScaleDenominator(10000);
+	map.setGeoreferencing(georef);
+}
+
+}  // namespace
+
+
+
+void ContourGeneratorTest::initTestCase()
+{
+	doStaticInitializations();
+	QVERIFY(temp_dir.isValid());
+}
+
+
+void ContourGeneratorTest::coneTest()
+{
+	ContourGenerator::Options options;
+	options.contour_symbol = Map::getUndefinedLine();
+	ContourGenerator generator(options);
+	QVERIFY2(generator.loadElevationModel(writeCone(temp_dir)), qPrintable(generator.errorString()));
+	QCOMPARE(generator.width(), 151);
+	QCOMPARE(generator.height(), 151);
+	
+	auto const lines = generator.generate();
+	QVERIFY(!lines.empty());
+	
+	std::map<double, int> closed_lines;
+	auto open_lines = 0;
+	auto last_elevation = 0.0;
+	for (const auto& line : lines)
+	{
+		QVERIFY(line.elevation >= last_elevation);
+		last_elevation = line.elevation;
+		QVERIFY(std::fmod(line.elevation, 5.0) == 0);
+		QVERIFY(line.type != ContourGenerator::FormLine);
+		
+		if (!line.closed)
+		{
+			// Only the lowest contours reach the border of the raster.
+			QVERIFY(line.elevation <= 125);
+			++open_lines;
+			continue;
+		}
+		
+		++closed_lines[line.elevation];
+		QVERIFY(line.coords.size() >= 3);
+		auto const radius = (200.3 - line.elevation) * 10;
+		for (const auto& pos : line.coords)
+			QVERIFY(std::abs(QLineF(cone_center, pos).length() - radius) < 5);
+	}
+	QVERIFY(open_lines > 0);
+	
+	QCOMPARE(int(closed_lines.size()), 15);
+	for (auto elevation = 130; elevation <= 200; elevation += 5)
+		QCOMPARE(closed_lines[elevation], 1);
+}
+
+
+void ContourGeneratorTest::classificationTest()
+{
+	auto const cone = writeCone(temp_dir);
+	
+	ContourGenerator::Options options;
+	options.contour_symbol = Map::getUndefinedLine();
+	{
+		ContourGenerator generator(options);
+		QVERIFY(generator.loadElevationModel(cone));
+		for (const auto& line : generator.generate())
+		{
+			auto const expected = (std::fmod(line.elevation, 25.0) == 0) ? ContourGenerator::IndexContour : ContourGenerator::Contour;
+			QCOMPARE(line.type, expected);
+		}
+	}
+	
+	options.form_line_symbol = Map::getUndefinedLine();
+	options.base = 10;
+	options.index_interval = 2;
+	{
+		ContourGenerator generator(options);
+		QVERIFY(generator.loadElevationModel(cone));
+		auto form_lines = 0;
+		for (const auto& line : generator.generate())
+		{
+			auto expected = ContourGenerator::FormLine;
+			if (std::fmod(line.elevation - 10, 10.0) == 0)
+				expected = ContourGenerator::IndexContour;
+			else if (std::fmod(line.elevation - 10, 5.0) == 0)
+				expected = ContourGenerator::Contour;
+			else
+				++form_lines;
+			QCOMPARE(line.type, expected);
+		}
+		QVERIFY(form_lines > 0);
+	}
+}
+
+
+void ContourGeneratorTest::planeTest()
+{
+	auto const plane = [](int col, int /* row */) { return col + 0.3; };
+	
+	ContourGenerator::Options options;
+	options.contour_symbol = Map::getUndefinedLine();
+	{
+		ContourGenerator generator(options);
+		QVERIFY(generator.loadElevationModel(writeGrid(temp_dir, QString::fromLatin1("plane.asc"), 100, 90, plane)));
+		
+		auto const lines = generator.generate();
+		QCOMPARE(int(lines.size()), 19);
+		for (const auto& line : lines)
+		{
+			QVERIFY(!line.closed);
+			auto const x = 1000 + (line.elevation - 0.3 + 0.5) * 10;
+			for (const auto& pos : line.coords)
+				QVERIFY(std::abs(pos.x() - x) < 0.01);
+			// From the first row to the last row.
+			QCOMPARE(std::abs(line.coords.front().y() - line.coords.back().y()), 890.0);
+		}
+	}
+	
+	auto const plane_with_hole = [plane](int col, int row) {
+		return (row >= 40 && row < 45) ? no_data : plane(col, row);
+	};
+	{
+		ContourGenerator generator(options);
+		QVERIFY(generator.loadElevationModel(writeGrid(temp_dir, QString::fromLatin1("hole.asc"), 100, 90, plane_with_hole)));
+		
+		auto const lines = generator.generate();
+		QCOMPARE(int(lines.size()), 2 * 19);
+		for (const auto& line : lines)
+			QVERIFY(!line.closed);
+	}
+}
+
+
+void ContourGeneratorTest::addToMapTest()
+{
+	Map map;
+	auto contour_symbol = new LineSymbol();
+	map.addSymbol(contour_symbol, 0);
+	auto index_symbol = new LineSymbol();
+	map.addSymbol(index_symbol, 1);
+	
+	ContourGenerator::Options options;
+	options.contour_symbol = contour_symbol;
+	options.index_symbol = index_symbol;
+	ContourGenerator generator(options);
+	QVERIFY(generator.loadElevationModel(writeCone(temp_dir)));
+	auto const num_lines = int(generator.generate().size());
+	
+	QCOMPARE(map.getNumParts(), 1);
+	QCOMPARE(map.undoManager().undoStepCount(), 0);
+	
+	auto part = generator.addToMap(map, QString::fromLatin1("Contours"));
+	QVERIFY(part);
+	QCOMPARE(map.getNumParts(), 2);
+	QCOMPARE(map.getCurrentPart(), part);
+	QCOMPARE(part->getName(), QString::fromLatin1("Contours"));
+	QCOMPARE(part->getNumObjects(), num_lines);
+	QCOMPARE(map.getPart(0)->getNumObjects(), 0);
+	
+	auto index_contours = 0;
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		auto const symbol = part->getObject(i)->getSymbol();
+		QVERIFY(symbol == contour_symbol || symbol == index_symbol);
+		if (symbol == index_symbol)
+			++index_contours;
+	}
+	QVERIFY(index_contours > 0);
+	QVERIFY(index_contours < num_lines);
+	
+	QCOMPARE(map.undoManager().undoStepCount(), 1);
+	QVERIFY(map.undoManager().undo());
+	QCOMPARE(map.getNumParts(), 1);
+	QCOMPARE(map.getNumObjects(), 0);
+	
+	QVERIFY(map.undoManager().redo());
+	QCOMPARE(map.getNumParts(), 2);
+	QCOMPARE(map.getPart(1)->getName(), QString::fromLatin1("Contours"));
+	QCOMPARE(map.getPart(1)->getNumObjects(), num_lines);
+}
+
+
+void ContourGeneratorTest::crsTest()
+{
+	auto const plane = [](int col, int /* row */) { return col + 0.3; };
+	auto const same_crs = writeGrid(temp_dir, QString::fromLatin1("utm32.asc"), 20, 20, plane);
+	QVERIFY(writeUtmPrj(same_crs, 32));
+	auto const other_crs = writeGrid(temp_dir, QString::fromLatin1("utm33.asc"), 20, 20, plane);
+	QVERIFY(writeUtmPrj(other_crs, 33));
+	
+	ContourGenerator::Options options;
+	options.contour_symbol = Map::getUndefinedLine();
+	
+	// Returns the distance of the first contour from its position without transformation.
+	auto const offset = [&options](const QString& path) {
+		Map map;
+		setupUtmGeoreferencing(map);
+		ContourGenerator generator(options);
+		if (!generator.loadElevationModel(path) || generator.crsWkt().isEmpty())
+			return -1.0;
+		auto const lines = generator.generate();
+		auto const part = generator.addToMap(map, QString::fromLatin1("Contours"));
+		if (lines.empty() || !part || part->getNumObjects() != int(lines.size()))
+			return -1.0;
+		auto const object = part->getObject(0)->asPath();
+		auto const projected = map.getGeoreferencing().toProjectedCoords(object->getCoordinate(0));
+		return QLineF(projected, lines.front().coords.front()).length();
+	};
+	
+	auto const same_crs_offset = offset(same_crs);
+	QVERIFY(same_crs_offset >= 0);
+	QVERIFY(same_crs_offset < 0.01);
+	
+	auto const other_crs_offset = offset(other_crs);
+	QVERIFY(other_crs_offset >= 0);
+	QVERIFY(other_crs_offset > 1000);
+}
+
+
+void ContourGeneratorTest::missingFileTest()
+{
+	ContourGenerator::Options options;
+	options.contour_symbol = Map::getUndefinedLine();
+	ContourGenerator generator(options);
+	QVERIFY(!generator.loadElevationModel(temp_dir.path() + QLatin1String("/missing.asc")));
+	QVERIFY(!generator.errorString().isEmpty());
+	QVERIFY(generator.generate().empty());
+	
+	Map map;
+	QVERIFY(!generator.addToMap(map, QString::fromLatin1("Contours")));
+	QCOMPARE(map.getNumParts(), 1);
+}
+
+
+
+QTEST_MAIN(ContourGeneratorTest)
@@ -0,0 +1,73 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_CONTOUR_GENERATOR_T_H
+#define OPENORIENTEERING_CONTOUR_GENERATOR_T_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+
+/**
+ * @test Tests the contour generation from synthetic elevation models.
+ */
+class ContourGeneratorTest : public QObject
+{
+Q_OBJECT
+	
+private slots:
+	void initTestCase();
+	
+	/**
+	 * Tests that a cone results in one closed, circular line per level,
+	 * across the boundaries of the concurrently traced tiles.
+	 */
+	void coneTest();
+	
+	/**
+	 * Tests the classification of index contours, contours and form lines.
+	 */
+	void classificationTest();
+	
+	/**
+	 * Tests open lines on an inclined plane, and the handling of no data.
+	 */
+	void planeTest();
+	
+	/**
+	 * Tests the insertion into a new map part, as a single undo step.
+	 */
+	void addToMapTest();
+	
+	/**
+	 * Tests the transformation from the CRS of the elevation model to the
+	 * CRS of the map.
+	 */
+	void crsTest();
+	
+	/**
+	 * Tests the error handling for missing files.
+	 */
+	void missingFileTest();
+	
+private:
+	QTemporaryDir temp_dir;
+};
+
+#endif
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2017 Kai Pastor
+ *    Copyright 2012-2018 Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -20,6 +20,9 @@
 
 #include "file_format_t.h"
 
+#include <algorithm>
+#include <vector>
+
 #include <QtTest>
 
 #include "test_config.h"
@@ -32,6 +35,9 @@
 #include "core/map_grid.h"
 #include "core/map_printer.h"
 #include "core/objects/object.h"
+#include "core/objects/text_object.h"
+#include "core/symbols/combined_symbol.h"
+#include "core/symbols/symbol.h"
 #include "fileformats/file_format.h"
 #include "fileformats/file_format_registry.h"
 #include "fileformats/file_import_export.h"
@@ -78,6 +84,8 @@ namespace QTest
 			ba += ", grid";
 		if (options.simulate_overprinting)
 			ba += ", overprinting";
+		if (options.text_as_outlines)
+			ba += ", text outlines";
 		return qstrdup(ba.data());
 	}
 }
@@ -317,6 +325,39 @@ namespace
 		return out;
 	}
 	
+	/**
+	 * Exports the input with the given format, and imports the result with
+	 * the default OCD importer.
+	 */
+	std::unique_ptr<Map> exportAndImportOcd(Map& input, const FileFormat* format)
+	{
+		auto out = std::make_unique<Map>();
+		try {
+			QBuffer buffer;
+			buffer.open(QIODevice::ReadWrite);
+			
+			auto exporter = std::unique_ptr<Exporter>(format->createExporter(&buffer, &input, nullptr));
+			auto importer = std::unique_ptr<Importer>(FileFormats.findFormat("OCD")->createImporter(&buffer, out.get(), nullptr));
+			if (exporter && importer)
+			{
+				exporter->doExport();
+				buffer.seek(0);
+				
+				importer->doImport(false);
+				importer->finishImport();
+			}
+			else
+			{
+				out.reset();
+			}
+		}
+		catch (std::exception&)
+		{
+			out.reset();
+		}
+		return out;
+	}
+	
 	static const auto test_files = {
 	  "data:issue-513-coords-outside-printable.xmap",
 	  "data:issue-513-coords-outside-printable.omap",
@@ -482,6 +523,176 @@ void FileFormatTest::saveAndLoad()
 
 
 
+void FileFormatTest::ocdRoundTrip_data()
+{
+	QTest::addColumn<QByteArray>("id"); // memory management for test data tag
+	QTest::addColumn<QByteArray>("format_id");
+	QTest::addColumn<QString>("map_filename");
+	
+	for (auto format_id : { "OCD11", "OCD12" })
+	{
+		for (auto raw_path : test_files)
+		{
+			auto id = QByteArray{};
+			id.append(raw_path).append(" -> ").append(format_id);
+			QTest::newRow(id) << id << QByteArray{format_id} << QString::fromUtf8(raw_path);
+		}
+	}
+}
+
+void FileFormatTest::ocdRoundTrip()
+{
+	QFETCH(QByteArray, format_id);
+	QFETCH(QString, map_filename);
+	
+	const FileFormat* format = FileFormats.findFormat(format_id);
+	QVERIFY(format);
+	QVERIFY(format->supportsExport());
+	
+	Map original;
+	QVERIFY(original.loadFrom(map_filename, nullptr, nullptr, false, false));
+	
+	// The first cycle drops what cannot be represented in OCD.
+	auto first = exportAndImportOcd(original, format);
+	QVERIFY2(first, "Exception while exporting / importing.");
+	
+	// Objects with undefined symbols, and with combined symbols which have
+	// no line or area part, are not exported.
+	auto is_exported = [&original](const Symbol* symbol) {
+		if (original.findSymbolIndex(symbol) < 0)
+			return false;
+		if (symbol->getType() != Symbol::Combined)
+			return true;
+		auto combined = symbol->asCombined();
+		for (int i = 0; i < combined->getNumParts(); ++i)
+		{
+			auto part = combined->getPart(i);
+			if (part && (part->getType() == Symbol::Line || part->getType() == Symbol::Area))
+				return true;
+		}
+		return false;
+	};
+	
+	// The OCD symbol number is made from the first two number components.
+	auto ocd_number = [](const Symbol* symbol) {
+		auto number = std::max(0, symbol->getNumberComponent(0)) * 1000;
+		if (symbol->getNumberComponent(1) >= 0)
+			number += symbol->getNumberComponent(1) % 1000;
+		return number ? number : 1;
+	};
+	
+	// Colliding numbers are changed by the exporter. Combined symbols are
+	// numbered last, so only the numbers of the other symbols are stable.
+	QSet<int> used_numbers;
+	auto unique_numbers = true;
+	for (int i = 0; i < original.getNumSymbols(); ++i)
+	{
+		auto symbol = original.getSymbol(i);
+		if (symbol->getType() == Symbol::Combined)
+			continue;
+		auto number = ocd_number(symbol);
+		unique_numbers = unique_numbers && !used_numbers.contains(number);
+		used_numbers.insert(number);
+	}
+	
+	std::vector<const Object*> original_objects;
+	original.applyOnAllObjects([&original_objects, &is_exported](Object* object) {
+		if (is_exported(object->getSymbol()))
+			original_objects.push_back(object);
+	});
+	std::vector<const Object*> first_objects;
+	first->applyOnAllObjects([&first_objects](Object* object) { first_objects.push_back(object); });
+	QCOMPARE(first_objects.size(), original_objects.size());
+	
+	// Coordinates are shifted when the objects are outside of the OCD
+	// drawing area, and clamped when the objects are larger than this area.
+	constexpr auto ocd_limit = qreal(0x7fffff) / 100;  // mm
+	auto const extent = original.calculateExtent();
+	auto const compare_coords = extent.width() < 2 * ocd_limit && extent.height() < 2 * ocd_limit;
+	auto offset_known = false;
+	auto offset_x = qint64(0);
+	auto offset_y = qint64(0);
+	
+	constexpr auto ocd_resolution = 10;  // native coordinate units, i.e. 0.01 mm
+	for (std::size_t i = 0; i < original_objects.size(); ++i)
+	{
+		auto expected = original_objects[i];
+		auto actual = first_objects[i];
+		QCOMPARE(actual->getType(), expected->getType());
+		
+		auto expected_number = ocd_number(expected->getSymbol());
+		QCOMPARE(actual->getSymbol()->getNumberComponent(0), expected_number / 1000);
+		if (unique_numbers && expected->getSymbol()->getType() != Symbol::Combined)
+			QCOMPARE(actual->getSymbol()->getNumberComponent(1), expected_number % 1000);
+		
+		if (expected->getType() == Object::Text)
+		{
+			// Text coordinates are derived from the text layout.
+			QCOMPARE(static_cast<const TextObject*>(actual)->getText(), static_cast<const TextObject*>(expected)->getText());
+			continue;
+		}
+		
+		if (expected->getType() == Object::Path)
+			QCOMPARE(actual->asPath()->parts().size(), expected->asPath()->parts().size());
+		
+		const auto& expected_coords = expected->getRawCoordinateVector();
+		const auto& actual_coords = actual->getRawCoordinateVector();
+		QCOMPARE(actual_coords.size(), expected_coords.size());
+		if (!compare_coords || expected_coords.empty())
+			continue;
+		
+		if (!offset_known)
+		{
+			offset_x = qint64(expected_coords.front().nativeX()) - actual_coords.front().nativeX();
+			offset_y = qint64(expected_coords.front().nativeY()) - actual_coords.front().nativeY();
+			offset_known = true;
+		}
+		for (std::size_t j = 0; j < expected_coords.size(); ++j)
+		{
+			// The rounding of the offset adds to the rounding of the coordinates.
+			QVERIFY(qAbs(expected_coords[j].nativeX() - offset_x - actual_coords[j].nativeX()) <= ocd_resolution);
+			QVERIFY(qAbs(expected_coords[j].nativeY() - offset_y - actual_coords[j].nativeY()) <= ocd_resolution);
+			QCOMPARE(actual_coords[j].isCurveStart(), expected_coords[j].isCurveStart());
+		}
+	}
+	
+	// The second cycle must reproduce the result of the first cycle.
+	auto second = exportAndImportOcd(*first, format);
+	QVERIFY2(second, "Exception while exporting / importing.");
+	
+	QCOMPARE(second->getNumColors(), first->getNumColors());
+	for (int i = 0; i < first->getNumColors(); ++i)
+		QVERIFY(second->getColor(i)->equals(*first->getColor(i), true));
+	
+	QCOMPARE(second->getNumSymbols(), first->getNumSymbols());
+	for (int i = 0; i < first->getNumSymbols(); ++i)
+	{
+		auto expected = first->getSymbol(i);
+		auto actual = second->getSymbol(i);
+		QCOMPARE(actual->getType(), expected->getType());
+		QCOMPARE(actual->getNumberComponent(0), expected->getNumberComponent(0));
+		QCOMPARE(actual->getNumberComponent(1), expected->getNumberComponent(1));
+	}
+	
+	QCOMPARE(second->getNumObjects(), first->getNumObjects());
+	std::vector<const Object*> expected_objects;
+	first->applyOnAllObjects([&expected_objects](Object* object) { expected_objects.push_back(object); });
+	std::vector<const Object*> actual_objects;
+	second->applyOnAllObjects([&actual_objects](Object* object) { actual_objects.push_back(object); });
+	QCOMPARE(actual_objects.size(), expected_objects.size());
+	for (std::size_t i = 0; i < expected_objects.size(); ++i)
+	{
+		auto expected = expected_objects[i];
+		auto actual = actual_objects[i];
+		QCOMPARE(actual->getType(), expected->getType());
+		QCOMPARE(actual->getSymbol()->getType(), expected->getSymbol()->getType());
+		if (expected->getType() != Object::Text)
+			QCOMPARE(actual->getRawCoordinateVector(), expected->getRawCoordinateVector());
+	}
+}
+
+
+
 void FileFormatTest::pristineMapTest()
 {
 	auto spot_color = std::make_unique<MapColor>(QString::fromLatin1("spot color"), 0);
@@ -1,6 +1,6 @@
 /*
  *    Copyright 2012, 2013 Thomas Schöps
- *    Copyright 2012-2017  Kai Pastor
+ *    Copyright 2012-2018  Kai Pastor
  *
  *    This file is part of OpenOrienteering.
  *
@@ -56,6 +56,13 @@ private slots:
 	void saveAndLoad();
 	void saveAndLoad_data();
 	
+	/**
+	 * Tests that the native OCD exporters write files which can be imported
+	 * again, and that a second export-import cycle doesn't change the map.
+	 */
+	void ocdRoundTrip();
+	void ocdRoundTrip_data();
+	
 	/**
 	 * Test saving and loading a map which is created in memory and does not go
 	 * through an implicit export-import-cycle before the test.
@@ -0,0 +1,148 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fill_pattern_t.h"
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QByteArray>
+#include <QFile>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPointF>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_color.h"
+#include "core/map_coord.h"
+#include "core/objects/object.h"
+#include "core/renderables/renderable.h"
+#include "core/renderables/renderable_implementation.h"
+#include "core/symbols/area_symbol.h"
+#include "core/symbols/point_symbol.h"
+
+#if defined(QT_PRINTSUPPORT_LIB)
+#  include <QPrinter>
+#  include <advanced_pdf_printer.h>
+#endif
+
+using namespace OpenOrienteering;
+
+Q_DECLARE_METATYPE(AreaSymbol::FillPattern::Type)
+
+
+void FillPatternTest::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
+void FillPatternTest::lazyCellsTest()
+{
+	auto const config = PainterConfig{ 0, PainterConfig::BrushOnly, 0, nullptr };
+	auto const other_config = PainterConfig{ 1, PainterConfig::BrushOnly, 0, nullptr };
+	auto builds = 0;
+	PatternCells cells([&builds, &config](PatternCells::Cells& cells) {
+		++builds;
+		QPainterPath cell;
+		cell.addEllipse(QPointF(0.5, 0.5), 0.1, 0.1);
+		cells.emplace(config, cell);
+	});
+	QVERIFY(!cells.isBuilt());
+	QCOMPARE(builds, 0);
+	
+	QVERIFY(!cells.cell(config).isEmpty());
+	QVERIFY(cells.isBuilt());
+	QVERIFY(cells.cell(other_config).isEmpty());
+	QVERIFY(!cells.cell(config).isEmpty());
+	QCOMPARE(builds, 1);
+}
+
+
+void FillPatternTest::pdfPatternTest_data()
+{
+	QTest::addColumn<AreaSymbol::FillPattern::Type>("type");
+	QTest::newRow("line pattern") << AreaSymbol::FillPattern::LinePattern;
+	QTest::newRow("point pattern") << AreaSymbol::FillPattern::PointPattern;
+}
+
+void FillPatternTest::pdfPatternTest()
+{
+#if !defined(QT_PRINTSUPPORT_LIB)
+	QSKIP("The advanced PDF engine is not available.");
+#else
+	QFETCH(AreaSymbol::FillPattern::Type, type);
+	
+	Map map;
+	auto color = new MapColor(QStringLiteral("black"), 0);
+	color->setCmyk(MapColorCmyk(0.0f, 0.0f, 0.0f, 1.0f));
+	map.addColor(color, 0);
+	
+	auto area_symbol = new AreaSymbol();
+	area_symbol->setNumFillPatterns(1);
+	auto& pattern = area_symbol->getFillPattern(0);
+	pattern.type = type;
+	pattern.line_spacing = 1000;
+	pattern.point_distance = 1000;
+	if (type == AreaSymbol::FillPattern::LinePattern)
+	{
+		pattern.line_color = color;
+		pattern.line_width = 100;
+	}
+	else
+	{
+		pattern.point = new PointSymbol();
+		pattern.point->setInnerRadius(100);
+		pattern.point->setInnerColor(color);
+	}
+	map.addSymbol(area_symbol, 0);
+	
+	auto object = new PathObject(area_symbol, MapCoordVector{
+	    MapCoord(0, 0), MapCoord(100, 0), MapCoord(100, 100), MapCoord(0, 100) });
+	object->closeAllParts();
+	map.addObject(object);
+	map.updateObjects();
+	auto const extent = object->getExtent();
+	
+	// The PDF engine gets a single tiling pattern.
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	auto const path = dir.path() + QLatin1String("/pattern.pdf");
+	{
+		AdvancedPdfPrinter printer(QPrinter::HighResolution);
+		printer.setOutputFileName(path);
+		QPainter painter(&printer);
+		QVERIFY(painter.isActive());
+		auto const scale = printer.resolution() / 25.4;
+		painter.scale(scale, scale);
+		RenderConfig config = { map, extent, 1.0, RenderConfig::NoOptions, 1.0 };
+		map.draw(&painter, config);
+	}
+	
+	QFile file(path);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	auto const data = file.readAll();
+	QCOMPARE(data.count("/PatternType 1"), 1);
+#endif
+}
+
+
+QTEST_MAIN(FillPatternTest)
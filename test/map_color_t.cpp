@@ -172,10 +172,12 @@ void MapColorTest::equalsTest()
 	QVERIFY(black.equals(black_1, false));
 	QVERIFY(!black_1.equals(black, true));
 	QVERIFY(!black.equals(black_1, true));
+	QCOMPARE(black_1.structuralHash(), black.structuralHash());
 	
 	// Difference in case of name: equals operates case-insensitive.
 	black_1.setName(QString::fromLatin1("BLACK"));
 	QVERIFY(black_1.equals(black, false));
+	QCOMPARE(black_1.structuralHash(), black.structuralHash());
 	QVERIFY(!black_1.equals(black, true));
 	
 	// Difference in knockout attribute, spot color method undefined
@@ -0,0 +1,201 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_diff_t.h"
+
+#include <memory>
+
+#include <QtTest>
+#include <QDir>
+#include <QFileInfo>
+
+#include "test_config.h"
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_diff.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/symbols/line_symbol.h"
+#include "core/symbols/symbol.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+/** Creates a map with a grid of short lines. */
+void fillMap(Map& map, int num_objects)
+{
+	auto symbol = new LineSymbol();
+	symbol->setNumberComponent(0, 101);
+	map.addSymbol(symbol, 0);
+	for (int i = 0; i < num_objects; ++i)
+	{
+		auto const x = (i % 1000) * 20000;
+		auto const y = (i / 1000) * 20000;
+		auto object = new PathObject(symbol);
+		object->addCoordinate(MapCoord::fromNative(x, y));
+		object->addCoordinate(MapCoord::fromNative(x + 5000, y + 5000));
+		map.addObject(object);
+	}
+}
+
+}  // namespace
+
+
+
+void MapDiffTest::initTestCase()
+{
+	doStaticInitializations();
+	
+	map_path = QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("../examples/complete map.omap"));
+	QVERIFY(QFileInfo::exists(map_path));
+}
+
+
+void MapDiffTest::contentHashTest()
+{
+	Map map;
+	fillMap(map, 2);
+	auto object = map.getPart(0)->getObject(0)->asPath();
+	auto const hash = object->contentHash();
+	QVERIFY(hash != 0);
+	
+	std::unique_ptr<Object> duplicate { object->duplicate() };
+	QCOMPARE(duplicate->contentHash(), hash);
+	QVERIFY(map.getPart(0)->getObject(1)->contentHash() != hash);
+	
+	object->move(1, 0);
+	QVERIFY(object->contentHash() != hash);
+	object->move(-1, 0);
+	QCOMPARE(object->contentHash(), hash);
+	
+	object->setTag(QStringLiteral("name"), QStringLiteral("value"));
+	auto const tagged_hash = object->contentHash();
+	QVERIFY(tagged_hash != hash);
+	object->removeTag(QStringLiteral("name"));
+	QCOMPARE(object->contentHash(), hash);
+	
+	object->getCoordinate(1).setDashPoint(true);
+	QVERIFY(object->contentHash() != hash);
+	object->getCoordinate(1).setDashPoint(false);
+	QCOMPARE(object->contentHash(), hash);
+	
+	// The symbol number is part of the hash.
+	map.getSymbol(0)->setNumberComponent(0, 102);
+	QVERIFY(object->contentHash() != hash);
+}
+
+
+void MapDiffTest::identicalMapsTest()
+{
+	Map old_map;
+	QVERIFY(old_map.loadFrom(map_path, nullptr, nullptr, false, false));
+	Map new_map;
+	QVERIFY(new_map.loadFrom(map_path, nullptr, nullptr, false, false));
+	QVERIFY(new_map.getNumObjects() > 10);
+	
+	QVERIFY(MapDiff(old_map, new_map).isEmpty());
+	
+	// Reverse the order of the objects.
+	auto part = new_map.getPart(0);
+	auto const num_objects = part->getNumObjects();
+	for (int i = 0; i < num_objects; ++i)
+	{
+		auto object = part->getObject(num_objects - 1);
+		part->deleteObject(num_objects - 1, true);
+		part->addObject(object, i);
+	}
+	QVERIFY(part->getObject(0) != old_map.getPart(0)->getObject(0));
+	
+	QVERIFY(MapDiff(old_map, new_map).isEmpty());
+}
+
+
+void MapDiffTest::modifiedMapTest()
+{
+	Map old_map;
+	QVERIFY(old_map.loadFrom(map_path, nullptr, nullptr, false, false));
+	Map new_map;
+	QVERIFY(new_map.loadFrom(map_path, nullptr, nullptr, false, false));
+	
+	auto part = new_map.getPart(0);
+	QVERIFY(part->getNumObjects() > 10);
+	
+	auto moved = part->getObject(0);
+	moved->move(10, 0);
+	
+	auto removed = old_map.getPart(0)->getObject(1);
+	part->deleteObject(1, false);
+	
+	auto added = part->getObject(2)->duplicate();
+	added->move(50000000, 50000000);
+	new_map.addObject(added);
+	
+	auto modified_symbol = new_map.getSymbol(0);
+	modified_symbol->setName(modified_symbol->getName() + QStringLiteral(" (modified)"));
+	
+	MapDiff diff(old_map, new_map);
+	QVERIFY(!diff.isEmpty());
+	
+	QCOMPARE(int(diff.modifiedObjects().size()), 1);
+	QCOMPARE(diff.modifiedObjects().front().old_object, old_map.getPart(0)->getObject(0));
+	QCOMPARE(diff.modifiedObjects().front().new_object, static_cast<const Object*>(moved));
+	
+	QCOMPARE(int(diff.removedObjects().size()), 1);
+	QCOMPARE(diff.removedObjects().front(), static_cast<const Object*>(removed));
+	
+	QCOMPARE(int(diff.addedObjects().size()), 1);
+	QCOMPARE(diff.addedObjects().front(), static_cast<const Object*>(added));
+	
+	QVERIFY(diff.addedSymbols().empty());
+	QVERIFY(diff.removedSymbols().empty());
+	QCOMPARE(int(diff.modifiedSymbols().size()), 1);
+	QCOMPARE(diff.modifiedSymbols().front().new_symbol, static_cast<const Symbol*>(modified_symbol));
+}
+
+
+void MapDiffTest::largeMapTest()
+{
+	auto const num_objects = 100000;
+	Map old_map;
+	fillMap(old_map, num_objects);
+	Map new_map;
+	fillMap(new_map, num_objects);
+	
+	auto part = new_map.getPart(0);
+	for (int i = 0; i < num_objects; i += 10)
+		part->getObject(i)->move(100, 0);
+	
+	MapDiff diff(old_map, new_map);
+	QCOMPARE(int(diff.modifiedObjects().size()), num_objects / 10);
+	QVERIFY(diff.addedObjects().empty());
+	QVERIFY(diff.removedObjects().empty());
+	QVERIFY(diff.modifiedSymbols().empty());
+	for (const auto& change : diff.modifiedObjects())
+	{
+		QCOMPARE(change.old_object->getExtent().top(), change.new_object->getExtent().top());
+	}
+}
+
+
+QTEST_MAIN(MapDiffTest)
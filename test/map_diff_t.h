@@ -0,0 +1,52 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_MAP_DIFF_T_H
+#define OPENORIENTEERING_MAP_DIFF_T_H
+
+#include <QObject>
+#include <QString>
+
+
+/**
+ * @test Tests object content hashes and the structural map diff.
+ */
+class MapDiffTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	
+	/** Tests that the content hash follows object modifications. */
+	void contentHashTest();
+	
+	/** Tests that the diff of a map and its reordered copy is empty. */
+	void identicalMapsTest();
+	
+	/** Tests the detection of added, removed and modified objects and symbols. */
+	void modifiedMapTest();
+	
+	/** Tests the diff of large synthetic maps. */
+	void largeMapTest();
+	
+private:
+	QString map_path;
+};
+
+#endif
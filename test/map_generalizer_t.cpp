@@ -0,0 +1,375 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_generalizer_t.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <QtTest>
+#include <QDir>
+#include <QFileInfo>
+#include <QRectF>
+
+#include "test_config.h"
+#include "test_helpers.h"
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_generalizer.h"
+#include "core/map_part.h"
+#include "core/map_topology.h"
+#include "core/objects/object.h"
+#include "core/symbols/area_symbol.h"
+#include "core/symbols/line_symbol.h"
+#include "core/symbols/point_symbol.h"
+#include "core/symbols/symbol.h"
+
+using namespace OpenOrienteering;
+using namespace OpenOrienteering::TestHelpers;
+
+
+namespace
+{
+
+/** Returns the objects of the derived map which have the counterpart of the source symbol. */
+std::vector<Object*> objectsOf(const Map& derived, const Map& source, const Symbol* source_symbol)
+{
+	auto const symbol = derived.getSymbol(source.findSymbolIndex(source_symbol));
+	std::vector<Object*> objects;
+	for (int p = 0; p < derived.getNumParts(); ++p)
+	{
+		auto const part = derived.getPart(std::size_t(p));
+		for (int i = 0; i < part->getNumObjects(); ++i)
+		{
+			if (part->getObject(i)->getSymbol() == symbol)
+				objects.push_back(part->getObject(i));
+		}
+	}
+	return objects;
+}
+
+bool fuzzyEqual(const MapCoordF& actual, const MapCoordF& expected)
+{
+	return actual.distanceTo(expected) < 0.002;
+}
+
+}  // namespace
+
+
+
+void MapGeneralizerTest::initTestCase()
+{
+	doStaticInitializations();
+	
+	map_path = QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("../examples/complete map.omap"));
+	QVERIFY(QFileInfo::exists(map_path));
+}
+
+
+void MapGeneralizerTest::copyTest()
+{
+	Map map;
+	map.setScaleDenominator(10000);
+	auto area = addSymbol<AreaSymbol>(map, 401);
+	auto line = addSymbol<LineSymbol>(map, 501);
+	makeRectangle(map, area, 30, 0, 3, 3);
+	makePath(map, line, { MapCoord(0, 0), MapCoord(0.5, 0.02), MapCoord(1, 0) });
+	
+	MapGeneralizer::Options options;
+	options.scale_denominator = 15000;
+	MapGeneralizer generalizer(map, options);
+	auto derived = generalizer.generalize();
+	QVERIFY2(derived, qPrintable(generalizer.errorString()));
+	QCOMPARE(derived->getScaleDenominator(), 15000u);
+	QCOMPARE(derived->getNumObjects(), 2);
+	QCOMPARE(generalizer.report().input_objects, 2);
+	QCOMPARE(generalizer.report().output_objects, 2);
+	QCOMPARE(generalizer.report().partition_cells, 0);
+	QVERIFY(!generalizer.reportText().isEmpty());
+	
+	auto const areas = objectsOf(*derived, map, area);
+	QCOMPARE(int(areas.size()), 1);
+	QCOMPARE(areas.front()->getRawCoordinateVector().front(), MapCoord(20, 0));
+	auto const lines = objectsOf(*derived, map, line);
+	QCOMPARE(int(lines.size()), 1);
+	QCOMPARE(lines.front()->asPath()->getCoordinateCount(), MapCoordVector::size_type(3));
+	
+	// The source map is unchanged.
+	QCOMPARE(map.getScaleDenominator(), 10000u);
+	QCOMPARE(map.getNumObjects(), 2);
+	QCOMPARE(map.getPart(0)->getObject(0)->getRawCoordinateVector().front(), MapCoord(30, 0));
+}
+
+
+void MapGeneralizerTest::minimumSizeTest()
+{
+	Map map;
+	auto area = addSymbol<AreaSymbol>(map, 401);
+	auto other_area = addSymbol<AreaSymbol>(map, 402);
+	auto line = addSymbol<LineSymbol>(map, 501);
+	makeRectangle(map, area, 0, 0, 1, 1);
+	makeRectangle(map, area, 10, 0, 3, 3);
+	makeRectangle(map, other_area, 20, 0, 1, 1);
+	makePath(map, line, { MapCoord(0, 10), MapCoord(2, 10) });
+	makePath(map, line, { MapCoord(0, 20), MapCoord(10, 20) });
+	
+	MapGeneralizer generalizer(map, {});
+	MapGeneralizer::SymbolRule area_rule;
+	area_rule.min_area = 4;
+	generalizer.setRule(area, area_rule);
+	MapGeneralizer::SymbolRule line_rule;
+	line_rule.min_length = 5;
+	generalizer.setRule(line, line_rule);
+	QCOMPARE(generalizer.rule(area).min_area, 4.0);
+	QCOMPARE(generalizer.rule(other_area).min_area, 0.0);
+	
+	auto derived = generalizer.generalize();
+	QVERIFY(derived);
+	QCOMPARE(generalizer.report().removed_areas, 1);
+	QCOMPARE(generalizer.report().removed_lines, 1);
+	QCOMPARE(derived->getNumObjects(), 3);
+	
+	auto const areas = objectsOf(*derived, map, area);
+	QCOMPARE(int(areas.size()), 1);
+	QCOMPARE(areas.front()->getRawCoordinateVector().front(), MapCoord(10, 0));
+	QCOMPARE(int(objectsOf(*derived, map, other_area).size()), 1);
+	auto const lines = objectsOf(*derived, map, line);
+	QCOMPARE(int(lines.size()), 1);
+	QCOMPARE(lines.front()->getRawCoordinateVector().back(), MapCoord(10, 20));
+}
+
+
+void MapGeneralizerTest::aggregationTest()
+{
+	Map map;
+	auto area = addSymbol<AreaSymbol>(map, 401);
+	makeRectangle(map, area, 0, 0, 1, 1);
+	makeRectangle(map, area, 1.2, 0, 1, 1);
+	makeRectangle(map, area, 2.4, 0, 1, 1);
+	makeRectangle(map, area, 20, 0, 1, 1);
+	
+	MapGeneralizer generalizer(map, {});
+	MapGeneralizer::SymbolRule rule;
+	rule.aggregation_distance = 0.5;
+	rule.min_area = 2;
+	generalizer.setRule(area, rule);
+	
+	auto derived = generalizer.generalize();
+	QVERIFY(derived);
+	QCOMPARE(generalizer.report().aggregated_objects, 3);
+	QCOMPARE(generalizer.report().aggregates, 1);
+	QCOMPARE(generalizer.report().removed_areas, 1);
+	QCOMPARE(derived->getNumObjects(), 1);
+	
+	// The gaps are bridged, and the outline is retained.
+	auto const aggregate = derived->getPart(0)->getObject(0)->asPath();
+	aggregate->update();
+	QCOMPARE(int(aggregate->parts().size()), 1);
+	QVERIFY(std::abs(aggregate->parts().front().calculateArea() - 3.4) < 0.01);
+	auto const extent = aggregate->parts().front().calculateExtent();
+	QVERIFY(std::abs(extent.left()) < 0.01);
+	QVERIFY(std::abs(extent.right() - 3.4) < 0.01);
+	QVERIFY(std::abs(extent.top()) < 0.01);
+	QVERIFY(std::abs(extent.bottom() - 1) < 0.01);
+}
+
+
+void MapGeneralizerTest::displacementTest()
+{
+	Map map;
+	auto movable = addSymbol<PointSymbol>(map, 601);
+	auto fixed = addSymbol<PointSymbol>(map, 602);
+	makePoint(map, movable, 0, 0);
+	makePoint(map, movable, 0.2, 0);
+	makePoint(map, fixed, 10, 0);
+	makePoint(map, movable, 10.5, 0);
+	
+	MapGeneralizer::SymbolRule rule;
+	rule.displaceable = true;
+	
+	MapGeneralizer::Options options;
+	options.min_point_distance = 1;
+	options.max_displacement = 1;
+	{
+		MapGeneralizer generalizer(map, options);
+		generalizer.setRule(movable, rule);
+		auto derived = generalizer.generalize();
+		QVERIFY(derived);
+		QCOMPARE(generalizer.report().displaced_points, 3);
+		QCOMPARE(generalizer.report().unresolved_conflicts, 0);
+		
+		auto const part = derived->getPart(0);
+		QVERIFY(fuzzyEqual(part->getObject(0)->asPoint()->getCoordF(), MapCoordF(-0.4, 0)));
+		QVERIFY(fuzzyEqual(part->getObject(1)->asPoint()->getCoordF(), MapCoordF(0.6, 0)));
+		QVERIFY(fuzzyEqual(part->getObject(2)->asPoint()->getCoordF(), MapCoordF(10, 0)));
+		QVERIFY(fuzzyEqual(part->getObject(3)->asPoint()->getCoordF(), MapCoordF(11, 0)));
+	}
+	
+	// Limited displacement, and conflicts between fixed points
+	makePoint(map, fixed, 30, 0);
+	makePoint(map, fixed, 30.5, 0);
+	options.max_displacement = 0.1;
+	{
+		MapGeneralizer generalizer(map, options);
+		generalizer.setRule(movable, rule);
+		auto derived = generalizer.generalize();
+		QVERIFY(derived);
+		QCOMPARE(generalizer.report().displaced_points, 3);
+		QCOMPARE(generalizer.report().unresolved_conflicts, 3);
+		
+		auto const part = derived->getPart(0);
+		QVERIFY(fuzzyEqual(part->getObject(0)->asPoint()->getCoordF(), MapCoordF(-0.1, 0)));
+		QVERIFY(fuzzyEqual(part->getObject(1)->asPoint()->getCoordF(), MapCoordF(0.3, 0)));
+		QVERIFY(fuzzyEqual(part->getObject(3)->asPoint()->getCoordF(), MapCoordF(10.6, 0)));
+		QVERIFY(fuzzyEqual(part->getObject(5)->asPoint()->getCoordF(), MapCoordF(30.5, 0)));
+	}
+}
+
+
+void MapGeneralizerTest::simplificationTest()
+{
+	Map map;
+	auto line = addSymbol<LineSymbol>(map, 501);
+	auto other_line = addSymbol<LineSymbol>(map, 502);
+	
+	MapCoordVector zigzag;
+	for (int i = 0; i <= 10; ++i)
+		zigzag.push_back(MapCoord(i, 40 + (i % 2) * 0.05));
+	makePath(map, line, zigzag);
+	
+	// Taking the shortcut would cross the other line.
+	makePath(map, line, { MapCoord(0, 20), MapCoord(5, 20.08), MapCoord(10, 20) });
+	makePath(map, other_line, { MapCoord(5, 19.5), MapCoord(5, 20.04) });
+	
+	// The curve is retained.
+	MapCoord curve_start(0, 30);
+	curve_start.setCurveStart(true);
+	makePath(map, line, { curve_start, MapCoord(1, 31), MapCoord(2, 31), MapCoord(3, 30), MapCoord(4, 30.01), MapCoord(5, 30) });
+	
+	MapGeneralizer generalizer(map, {});
+	MapGeneralizer::SymbolRule rule;
+	rule.simplification_tolerance = 0.1;
+	generalizer.setRule(line, rule);
+	
+	auto derived = generalizer.generalize();
+	QVERIFY(derived);
+	QCOMPARE(generalizer.report().simplified_objects, 2);
+	QCOMPARE(generalizer.report().removed_coordinates, 10);
+	QCOMPARE(derived->getNumObjects(), 4);
+	
+	auto const part = derived->getPart(0);
+	auto const simplified_zigzag = part->getObject(0)->asPath();
+	QCOMPARE(simplified_zigzag->getCoordinateCount(), MapCoordVector::size_type(2));
+	QCOMPARE(simplified_zigzag->getCoordinate(0), MapCoord(0, 40));
+	QCOMPARE(simplified_zigzag->getCoordinate(1), MapCoord(10, 40));
+	QCOMPARE(part->getObject(1)->asPath()->getCoordinateCount(), MapCoordVector::size_type(3));
+	auto const simplified_curve = part->getObject(3)->asPath();
+	QCOMPARE(simplified_curve->getCoordinateCount(), MapCoordVector::size_type(5));
+	QVERIFY(simplified_curve->getCoordinate(0).isCurveStart());
+	QCOMPARE(simplified_curve->getCoordinate(3), MapCoord(3, 30));
+	QCOMPARE(simplified_curve->getCoordinate(4), MapCoord(5, 30));
+}
+
+
+void MapGeneralizerTest::topologyTest()
+{
+	Map map;
+	auto area = addSymbol<AreaSymbol>(map, 401);
+	
+	// Two areas with a common, wiggly border at x = 2
+	auto left = makePath(map, area, {
+	    MapCoord(0, 0), MapCoord(2, 0), MapCoord(2.05, 0.5), MapCoord(2, 1), MapCoord(2.05, 1.5),
+	    MapCoord(2, 2), MapCoord(0, 2), MapCoord(0, 1) }, true);
+	auto right = makePath(map, area, {
+	    MapCoord(2, 0), MapCoord(4, 0), MapCoord(4, 2), MapCoord(2, 2), MapCoord(2.05, 1.5),
+	    MapCoord(2, 1), MapCoord(2.05, 0.5) }, true);
+	auto const left_count = left->getCoordinateCount();
+	auto const right_count = right->getCoordinateCount();
+	auto const shared_nodes = MapTopology(*map.getPart(0)).sharedNodeCount();
+	QCOMPARE(int(shared_nodes), 5);
+	
+	MapGeneralizer generalizer(map, {});
+	MapGeneralizer::SymbolRule rule;
+	rule.simplification_tolerance = 0.1;
+	generalizer.setRule(area, rule);
+	
+	auto derived = generalizer.generalize();
+	QVERIFY(derived);
+	QCOMPARE(generalizer.report().simplified_objects, 1);
+	QCOMPARE(generalizer.report().removed_coordinates, 1);
+	
+	// Only the collinear node at the outer border is removed.
+	auto const part = derived->getPart(0);
+	QCOMPARE(part->getObject(0)->asPath()->getCoordinateCount(), left_count - 1);
+	QCOMPARE(part->getObject(1)->asPath()->getCoordinateCount(), right_count);
+	QCOMPARE(MapTopology(*part).sharedNodeCount(), shared_nodes);
+}
+
+
+void MapGeneralizerTest::sampleMapTest()
+{
+	Map map;
+	QVERIFY(map.loadFrom(map_path, nullptr, nullptr, false, false));
+	auto const num_objects = map.getNumObjects();
+	QVERIFY(num_objects > 0);
+	
+	MapGeneralizer::Options options;
+	options.scale_denominator = map.getScaleDenominator() * 3 / 2;
+	options.min_point_distance = 0.3;
+	options.partition_size = 20;
+	options.default_rule.min_area = 0.2;
+	options.default_rule.min_length = 0.3;
+	options.default_rule.simplification_tolerance = 0.05;
+	options.default_rule.displaceable = true;
+	MapGeneralizer generalizer(map, options);
+	
+	auto derived = generalizer.generalize();
+	QVERIFY(derived);
+	QCOMPARE(map.getNumObjects(), num_objects);
+	
+	const auto& report = generalizer.report();
+	QCOMPARE(report.input_objects, num_objects);
+	QCOMPARE(report.output_objects, derived->getNumObjects());
+	QVERIFY(report.partition_cells > 1);
+	QCOMPARE(report.output_objects, report.input_objects - report.removed_areas - report.removed_lines
+	                                - report.aggregated_objects + report.aggregates);
+	QCOMPARE(derived->getNumSymbols(), map.getNumSymbols());
+	QCOMPARE(derived->getNumParts(), map.getNumParts());
+	
+	for (int p = 0; p < derived->getNumParts(); ++p)
+	{
+		auto const part = derived->getPart(std::size_t(p));
+		for (int i = 0; i < part->getNumObjects(); ++i)
+			QVERIFY(part->getObject(i)->validate());
+	}
+	
+	// The results are deterministic.
+	auto const first_report = report;
+	QVERIFY(generalizer.generalize());
+	QCOMPARE(generalizer.report().output_objects, first_report.output_objects);
+	QCOMPARE(generalizer.report().removed_coordinates, first_report.removed_coordinates);
+	QCOMPARE(generalizer.report().displaced_points, first_report.displaced_points);
+}
+
+
+
+QTEST_MAIN(MapGeneralizerTest)
@@ -0,0 +1,61 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_MAP_GENERALIZER_T_H
+#define OPENORIENTEERING_MAP_GENERALIZER_T_H
+
+#include <QObject>
+#include <QString>
+
+
+/**
+ * @test Tests the derivation of generalized maps.
+ */
+class MapGeneralizerTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	
+	/** Tests that a map without rules is copied and rescaled, but not changed. */
+	void copyTest();
+	
+	/** Tests the removal of small areas and short lines. */
+	void minimumSizeTest();
+	
+	/** Tests the merging of nearby areas, before the removal of small areas. */
+	void aggregationTest();
+	
+	/** Tests the displacement of conflicting point objects. */
+	void displacementTest();
+	
+	/** Tests the simplification of lines, keeping curves and avoiding intersections. */
+	void simplificationTest();
+	
+	/** Tests that simplification keeps the nodes shared by adjacent areas. */
+	void topologyTest();
+	
+	/** Tests the consistency of the results for a complete sample map. */
+	void sampleMapTest();
+	
+private:
+	QString map_path;
+};
+
+#endif
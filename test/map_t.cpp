@@ -21,7 +21,9 @@
 
 #include <QtTest>
 #include <QBuffer>
+#include <QImage>
 #include <QMessageBox>
+#include <QPainter>
 #include <QTextStream>
 
 #include "test_config.h"
@@ -30,9 +32,15 @@
 #include "core/map.h"
 #include "core/map_color.h"
 #include "core/map_printer.h" // IWYU pragma: keep
+#include "core/map_part.h"
 #include "core/map_view.h"
+#include "core/selection_statistics.h"
+#include "core/objects/object.h"
+#include "core/objects/object_memory_budget.h"
 #include "core/objects/symbol_rule_set.h"
+#include "core/renderables/renderable.h"
 #include "core/symbols/symbol.h"
+#include "core/symbols/combined_symbol.h"
 #include "core/symbols/point_symbol.h"
 
 using namespace OpenOrienteering;
@@ -223,6 +231,160 @@ void MapTest::importTest()
 	QCOMPARE(symbol_map.size(), imported_map.getNumSymbols());
 }
 
+void MapTest::importDuplicatesTest()
+{
+	auto const path = examples_dir.absoluteFilePath(QStringLiteral("complete map.omap"));
+	Map map;
+	QVERIFY(map.loadFrom(path, nullptr, nullptr, false, false));
+	Map imported_map;
+	QVERIFY(imported_map.loadFrom(path, nullptr, nullptr, false, false));
+	
+	for (int i = 0; i < map.getNumSymbols(); ++i)
+	{
+		QVERIFY(map.getSymbol(i)->equals(imported_map.getSymbol(i)));
+		QCOMPARE(map.getSymbol(i)->structuralHash(), imported_map.getSymbol(i)->structuralHash());
+	}
+	for (int i = 0; i < map.getNumColors(); ++i)
+	{
+		QCOMPARE(map.getColor(i)->structuralHash(), imported_map.getColor(i)->structuralHash());
+	}
+	
+	// Merging: All symbols and colors are already present.
+	auto const num_symbols = map.getNumSymbols();
+	auto const num_colors = map.getNumColors();
+	auto symbol_map = map.importMap(imported_map, Map::SymbolImport);
+	QCOMPARE(map.getNumSymbols(), num_symbols);
+	QCOMPARE(map.getNumColors(), num_colors);
+	QCOMPARE(symbol_map.size(), num_symbols);
+	for (auto it = symbol_map.constBegin(); it != symbol_map.constEnd(); ++it)
+	{
+		QCOMPARE(map.findSymbolIndex(it.value()), imported_map.findSymbolIndex(it.key()));
+	}
+	
+	// Not merging: The parts of new combined symbols refer to new symbols.
+	symbol_map = map.importMap(imported_map, Map::SymbolImport, nullptr, -1, false);
+	QCOMPARE(map.getNumSymbols(), 2 * num_symbols);
+	QCOMPARE(map.getNumColors(), num_colors);
+	for (int i = num_symbols; i < map.getNumSymbols(); ++i)
+	{
+		auto symbol = map.getSymbol(i);
+		if (symbol->getType() != Symbol::Combined)
+			continue;
+		
+		auto combined = static_cast<const CombinedSymbol*>(symbol);
+		for (int j = 0; j < combined->getNumParts(); ++j)
+		{
+			auto part = combined->getPart(j);
+			if (part && !combined->isPartPrivate(j))
+				QVERIFY(map.findSymbolIndex(part) >= num_symbols);
+		}
+	}
+}
+
+
+
+void MapTest::selectionStatisticsTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), nullptr, &view, false, false));
+	
+	auto part = map.getCurrentPart();
+	QVERIFY(part->getNumObjects() > 10);
+	
+	const auto& statistics = map.selectionStatistics();
+	QCOMPARE(statistics.size(), 0);
+	QVERIFY(!statistics.uniformSymbol());
+	
+	// Select all objects
+	for (int i = 0; i < part->getNumObjects(); ++i)
+		map.addObjectToSelection(part->getObject(i), false);
+	QCOMPARE(statistics.size(), map.getNumSelectedObjects());
+	
+	auto num_objects = 0;
+	for (auto count : statistics.symbolCounts())
+		num_objects += count;
+	QCOMPARE(num_objects, map.getNumSelectedObjects());
+	
+	// Deselect every other object, and compare with a fresh recount
+	for (int i = 0; i < part->getNumObjects(); i += 2)
+		map.removeObjectFromSelection(part->getObject(i), false);
+	
+	SelectionStatistics expected;
+	for (const auto object : map.selectedObjects())
+		expected.add(object);
+	QCOMPARE(statistics.size(), expected.size());
+	QCOMPARE(statistics.symbolCounts(), expected.symbolCounts());
+	for (auto feature : { SelectionStatistics::Path, SelectionStatistics::Line, SelectionStatistics::Area,
+	                      SelectionStatistics::AreaWithHoles, SelectionStatistics::RotatablePattern, SelectionStatistics::RotatablePoint })
+	{
+		QCOMPARE(statistics.count(feature), expected.count(feature));
+	}
+	QVERIFY(qAbs(statistics.totalLength() - expected.totalLength()) < 0.001);
+	QVERIFY(qAbs(statistics.totalArea() - expected.totalArea()) < 0.001);
+	
+	// Single object
+	map.clearObjectSelection(false);
+	QCOMPARE(statistics.size(), 0);
+	QCOMPARE(statistics.totalLength(), 0.0);
+	map.addObjectToSelection(part->getObject(0), false);
+	QCOMPARE(statistics.uniformSymbol(), part->getObject(0)->getSymbol());
+}
+
+
+
+void MapTest::objectMemoryBudgetTest()
+{
+	Map map;
+	MapView view{ &map };
+	QVERIFY(map.loadFrom(examples_dir.absoluteFilePath(QStringLiteral("complete map.omap")), nullptr, &view, false, false));
+	map.updateObjects();
+	
+	auto part = map.getCurrentPart();
+	auto const extent = map.calculateExtent(true);
+	auto const visible_area = QRectF(extent.topLeft(), extent.size() / 20);
+	
+	ObjectMemoryBudget budget(map);
+	// The periodic check is only enabled for maps shown in map widgets.
+	QVERIFY(!budget.isActive());
+	budget.setBudget(0);
+	QCOMPARE(budget.enforce({ visible_area }), 0);
+	
+	// A tiny budget evicts all objects which are far from the visible area.
+	budget.setBudget(1);
+	auto const num_evicted = budget.enforce({ visible_area });
+	QVERIFY(num_evicted > 0);
+	auto count = 0;
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		const auto* object = part->getObject(i);
+		if (object->hasEvictedRenderables())
+		{
+			++count;
+			QVERIFY(!object->getExtent().intersects(visible_area));
+			QCOMPARE(object->renderables().renderableCount(), std::size_t(0));
+		}
+	}
+	QCOMPARE(count, num_evicted);
+	
+	// Nothing is left to evict, and nothing changes.
+	auto const revision = map.objectsRevision();
+	QCOMPARE(budget.enforce({ visible_area }), 0);
+	QCOMPARE(map.objectsRevision(), revision);
+	
+	// Drawing restores the renderables in the drawn area.
+	QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+	QPainter painter(&image);
+	auto const everything = extent.adjusted(-1000, -1000, 1000, 1000);
+	RenderConfig config = { map, everything, 1.0, RenderConfig::Screen, 1.0 };
+	map.draw(&painter, config);
+	painter.end();
+	for (int i = 0; i < part->getNumObjects(); ++i)
+	{
+		QVERIFY(!part->getObject(i)->hasEvictedRenderables());
+	}
+}
+
 
 
 void MapTest::crtFileTest()
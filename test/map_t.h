@@ -48,6 +48,15 @@ private slots:
 	void importTest_data();
 	void importTest();
 	
+	/** Tests the merging of duplicate symbols and colors during import. */
+	void importDuplicatesTest();
+	
+	/** Tests the incremental maintenance of selection statistics. */
+	void selectionStatisticsTest();
+	
+	/** Tests the eviction and lazy restoration of renderables. */
+	void objectMemoryBudgetTest();
+	
 	/** Basic tests for symbol set replacements. */
 	void crtFileTest();
 	
@@ -0,0 +1,187 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_topology_t.h"
+
+#include <algorithm>
+
+#include <QtTest>
+
+#include "test_helpers.h"
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/map_topology.h"
+#include "core/objects/object.h"
+
+using namespace OpenOrienteering;
+using namespace OpenOrienteering::TestHelpers;
+
+
+
+void MapTopologyTest::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
+void MapTopologyTest::sharedEdgesTest()
+{
+	Map map;
+	auto left   = makeSquare(map, Map::getUndefinedLine(), 0, 0, 10);
+	auto right  = makeSquare(map, Map::getUndefinedLine(), 10, 0, 10);
+	auto remote = makeSquare(map, Map::getUndefinedLine(), 100, 0, 10);
+	
+	MapTopology topology(*map.getCurrentPart());
+	QVERIFY(topology.contains(left));
+	QVERIFY(topology.contains(right));
+	QVERIFY(topology.contains(remote));
+	
+	QCOMPARE(int(topology.incidences(MapCoord(10, 0)).size()), 2);
+	QCOMPARE(int(topology.incidences(MapCoord(10, 10)).size()), 2);
+	QCOMPARE(int(topology.incidences(MapCoord(0, 0)).size()), 1);
+	QCOMPARE(int(topology.incidences(MapCoord(5, 5)).size()), 0);
+	QCOMPARE(int(topology.sharedNodeCount()), 2);
+	QCOMPARE(int(topology.duplicateCoordinateCount()), 2);
+	
+	auto left_edges = topology.sharedEdges(left);
+	QCOMPARE(int(left_edges.size()), 1);
+	QCOMPARE(left_edges.front().neighbour, static_cast<const PathObject*>(right));
+	QCOMPARE(int(left_edges.front().first_index), 1);
+	QCOMPARE(int(left_edges.front().last_index), 2);
+	
+	// The shared edge includes the closing segment of the right square.
+	auto right_edges = topology.sharedEdges(right);
+	QCOMPARE(int(right_edges.size()), 1);
+	QCOMPARE(right_edges.front().neighbour, static_cast<const PathObject*>(left));
+	QCOMPARE(int(right_edges.front().first_index), 3);
+	QCOMPARE(int(right_edges.front().last_index), 4);
+	
+	QVERIFY(topology.sharedEdges(remote).empty());
+	
+	// Touching in a single node is not a shared edge.
+	auto diagonal = makeSquare(map, Map::getUndefinedLine(), 20, 10, 10);
+	topology.addObject(diagonal);
+	QCOMPARE(int(topology.incidences(MapCoord(20, 10)).size()), 2);
+	QVERIFY(topology.sharedEdges(diagonal).empty());
+	QCOMPARE(int(topology.sharedEdges(right).size()), 1);
+}
+
+
+void MapTopologyTest::moveNodeTest()
+{
+	Map map;
+	auto left  = makeSquare(map, Map::getUndefinedLine(), 0, 0, 10);
+	auto right = makeSquare(map, Map::getUndefinedLine(), 10, 0, 10);
+	MapTopology topology(*map.getCurrentPart());
+	
+	auto modified = topology.moveNode(MapCoord(10, 0), MapCoord(12, -1));
+	QCOMPARE(int(modified.size()), 2);
+	QVERIFY(std::find(begin(modified), end(modified), left) != end(modified));
+	QVERIFY(std::find(begin(modified), end(modified), right) != end(modified));
+	
+	const PathObject* const_left = left;
+	const PathObject* const_right = right;
+	QCOMPARE(const_left->getCoordinate(1), MapCoord(12, -1));
+	QCOMPARE(const_right->getCoordinate(0), MapCoord(12, -1));
+	// The closing point follows the first point.
+	QCOMPARE(const_right->getCoordinate(4), MapCoord(12.0, -1.0, MapCoord::ClosePoint));
+	QVERIFY(left->isOutputDirty());
+	QVERIFY(right->isOutputDirty());
+	
+	QVERIFY(topology.incidences(MapCoord(10, 0)).empty());
+	QCOMPARE(int(topology.incidences(MapCoord(12, -1)).size()), 2);
+	QCOMPARE(int(topology.sharedEdges(left).size()), 1);
+	
+	// A fresh index finds the same topology.
+	MapTopology fresh_topology(*map.getCurrentPart());
+	QCOMPARE(int(fresh_topology.incidences(MapCoord(12, -1)).size()), 2);
+	QCOMPARE(fresh_topology.sharedNodeCount(), topology.sharedNodeCount());
+	
+	// Moving onto another node merges the nodes.
+	modified = topology.moveNode(MapCoord(12, -1), MapCoord(10, 10));
+	QCOMPARE(int(modified.size()), 2);
+	QCOMPARE(int(topology.incidences(MapCoord(10, 10)).size()), 4);
+	
+	// Moving an unknown position has no effect.
+	QVERIFY(topology.moveNode(MapCoord(50, 50), MapCoord(60, 60)).empty());
+}
+
+
+void MapTopologyTest::updateTest()
+{
+	Map map;
+	auto left  = makeSquare(map, Map::getUndefinedLine(), 0, 0, 10);
+	auto right = makeSquare(map, Map::getUndefinedLine(), 10, 0, 10);
+	
+	// Restricted to an area
+	MapTopology topology(*map.getCurrentPart(), QRectF(-5, -5, 10, 10));
+	QVERIFY(topology.contains(left));
+	QVERIFY(!topology.contains(right));
+	QCOMPARE(int(topology.sharedNodeCount()), 0);
+	
+	topology.addObject(right);
+	QCOMPARE(int(topology.sharedNodeCount()), 2);
+	
+	// Change the right square outside of the index
+	right->setCoordinate(3, MapCoord(11, 10));
+	topology.updateObject(right);
+	QCOMPARE(int(topology.incidences(MapCoord(10, 10)).size()), 1);
+	QCOMPARE(int(topology.sharedNodeCount()), 1);
+	QVERIFY(topology.sharedEdges(left).empty());
+	
+	topology.removeObject(right);
+	QVERIFY(!topology.contains(right));
+	QCOMPARE(int(topology.incidences(MapCoord(10, 0)).size()), 1);
+	QCOMPARE(int(topology.sharedNodeCount()), 0);
+	
+	topology.removeObject(left);
+	QVERIFY(topology.incidences(MapCoord(0, 0)).empty());
+}
+
+
+void MapTopologyTest::nearMissTest()
+{
+	Map map;
+	makeSquare(map, Map::getUndefinedLine(), 0, 0, 10);
+	auto right = makeSquare(map, Map::getUndefinedLine(), 10, 0, 10);
+	// Not exactly snapped
+	right->setCoordinate(3, MapCoord::fromNative(10010, 10000));
+	
+	MapTopology topology(*map.getCurrentPart());
+	QCOMPARE(int(topology.sharedNodeCount()), 1);
+	
+	auto near_misses = topology.findNearMisses(50);
+	QCOMPARE(int(near_misses.size()), 1);
+	auto const& near_miss = near_misses.front();
+	QVERIFY(near_miss.first.object != near_miss.second.object);
+	
+	QVERIFY(topology.findNearMisses(5).empty());
+	QVERIFY(topology.findNearMisses(0).empty());
+	
+	// Identical positions are not reported.
+	right->setCoordinate(3, MapCoord(10, 10));
+	topology.updateObject(right);
+	QVERIFY(topology.findNearMisses(50).empty());
+}
+
+
+QTEST_MAIN(MapTopologyTest)
@@ -0,0 +1,131 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_validator_benchmark_t.h"
+
+#include <cmath>
+
+#include <QtTest>
+#include <QString>
+
+#include "test_helpers.h"
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_validator.h"
+#include "core/objects/object.h"
+#include "core/symbols/area_symbol.h"
+#include "core/symbols/line_symbol.h"
+#include "core/symbols/point_symbol.h"
+
+using namespace OpenOrienteering;
+using namespace OpenOrienteering::TestHelpers;
+
+
+namespace
+{
+
+/**
+ * Fills the map with a grid of areas, lines and points, in cells of 5 mm.
+ * 
+ * Some of the objects violate the rules which are set up in validate().
+ */
+void fillMap(Map& map, int num_objects)
+{
+	auto area = addSymbol<AreaSymbol>(map, 401);
+	auto line = addSymbol<LineSymbol>(map, 501);
+	auto point = addSymbol<PointSymbol>(map, 601);
+	
+	auto const columns = int(std::ceil(std::sqrt(num_objects)));
+	for (int i = 0; i < num_objects; ++i)
+	{
+		auto const x = 5.0 * (i % columns);
+		auto const y = 5.0 * (i / columns);
+		switch (i % 3)
+		{
+		case 0:
+			if (i % 27 == 0)
+				makeRectangle(map, area, x + 1, y + 1, 0.5, 0.5);  // too small
+			else
+				makeRectangle(map, area, x, y, 4.9, 4.9);          // 0.1 mm gap to adjacent areas
+			break;
+		case 1:
+			if (i % 29 == 1)
+				makePath(map, line, { MapCoord(x, y), MapCoord(x + 0.5, y) });  // too short
+			else
+				makePath(map, line, { MapCoord(x, y), MapCoord(x + 2, y + 2), MapCoord(x + 4, y), MapCoord(x + 4, y + 4) });
+			break;
+		default:
+			makePoint(map, point, x + 2.5, y + 2.5);
+			if (i % 31 == 2)
+				makePoint(map, point, x + 2.8, y + 2.5);  // too close
+			break;
+		}
+	}
+}
+
+}  // namespace
+
+
+
+void MapValidatorBenchmark::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
+void MapValidatorBenchmark::validate_data()
+{
+	QTest::addColumn<int>("num_objects");
+	QTest::newRow("50k objects") << 50000;
+	QTest::newRow("500k objects") << 500000;
+}
+
+void MapValidatorBenchmark::validate()
+{
+	QFETCH(int, num_objects);
+	
+	Map map;
+	fillMap(map, num_objects);
+	QVERIFY(map.getNumObjects() >= num_objects);
+	
+	MapValidator::Options options;
+	options.default_rule.min_area = 1.0;
+	options.default_rule.min_length = 2.0;
+	options.default_rule.min_gap = 0.15;
+	options.default_rule.min_point_distance = 0.5;
+	options.default_rule.check_overlap = true;
+	MapValidator validator(map, options);
+	
+	// The first run updates the objects.
+	QVERIFY2(validator.validate(), qPrintable(validator.errorString()));
+	QVERIFY(!validator.issues().empty());
+	auto const num_issues = validator.issues().size();
+	
+	QBENCHMARK
+	{
+		validator.validate();
+	}
+	QCOMPARE(validator.issues().size(), num_issues);
+}
+
+
+
+QTEST_MAIN(MapValidatorBenchmark)
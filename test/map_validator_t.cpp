@@ -0,0 +1,299 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "map_validator_t.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <QtTest>
+#include <QRectF>
+#include <QString>
+
+#include "test_helpers.h"
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/map_validator.h"
+#include "core/objects/object.h"
+#include "core/symbols/area_symbol.h"
+#include "core/symbols/line_symbol.h"
+#include "core/symbols/point_symbol.h"
+#include "core/symbols/symbol.h"
+
+using namespace OpenOrienteering;
+using namespace OpenOrienteering::TestHelpers;
+
+
+namespace
+{
+
+/** Returns the issues of the given type. */
+std::vector<MapValidator::Issue> issuesOf(const MapValidator& validator, MapValidator::IssueType type)
+{
+	std::vector<MapValidator::Issue> issues;
+	for (const auto& issue : validator.issues())
+	{
+		if (issue.type == type)
+			issues.push_back(issue);
+	}
+	return issues;
+}
+
+bool isPair(const MapValidator::Issue& issue, const Object* a, const Object* b)
+{
+	return (issue.object == a && issue.other == b) || (issue.object == b && issue.other == a);
+}
+
+}  // namespace
+
+
+
+void MapValidatorTest::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
+void MapValidatorTest::minimumSizeTest()
+{
+	Map map;
+	auto area = addSymbol<AreaSymbol>(map, 401);
+	auto line = addSymbol<LineSymbol>(map, 501);
+	auto other_area = addSymbol<AreaSymbol>(map, 402);
+	auto helper_area = addSymbol<AreaSymbol>(map, 403);
+	helper_area->setIsHelperSymbol(true);
+	
+	auto small_area = makeRectangle(map, area, 0, 0, 0.5, 0.5);
+	makeRectangle(map, area, 10, 0, 2, 2);
+	makeRectangle(map, other_area, 20, 0, 0.5, 0.5);
+	makeRectangle(map, helper_area, 30, 0, 0.5, 0.5);
+	auto short_line = makePath(map, line, { MapCoord(0, 10), MapCoord(1, 10) });
+	makePath(map, line, { MapCoord(0, 20), MapCoord(2, 20), MapCoord(2, 21) });
+	
+	MapValidator::Options options;
+	MapValidator validator(map, options);
+	MapValidator::SymbolRule rule;
+	rule.min_area = 1.0;
+	rule.min_length = 2.5;
+	validator.setRule(area, rule);
+	validator.setRule(line, rule);
+	validator.setRule(helper_area, rule);
+	QCOMPARE(validator.rule(area).min_area, 1.0);
+	QCOMPARE(validator.rule(other_area).min_area, 0.0);
+	
+	QVERIFY2(validator.validate(), qPrintable(validator.errorString()));
+	QCOMPARE(int(validator.issues().size()), 2);
+	
+	// Ordered from top to bottom
+	const auto& area_issue = validator.issues()[0];
+	QCOMPARE(area_issue.type, MapValidator::AreaTooSmall);
+	QVERIFY(area_issue.object == small_area);
+	QVERIFY(!area_issue.other);
+	QCOMPARE(area_issue.part, 0);
+	QVERIFY(qAbs(area_issue.value - 0.25) < 0.001);
+	QCOMPARE(area_issue.limit, 1.0);
+	QCOMPARE(area_issue.fix, MapValidator::DeleteObject);
+	QVERIFY(area_issue.extent.contains(QPointF(0.25, 0.25)));
+	QVERIFY(!MapValidator::description(area_issue).isEmpty());
+	
+	const auto& line_issue = validator.issues()[1];
+	QCOMPARE(line_issue.type, MapValidator::LineTooShort);
+	QVERIFY(line_issue.object == short_line);
+	QVERIFY(qAbs(line_issue.value - 1.0) < 0.001);
+	QCOMPARE(line_issue.fix, MapValidator::DeleteObject);
+}
+
+
+void MapValidatorTest::gapTest()
+{
+	Map map;
+	auto area = addSymbol<AreaSymbol>(map, 401);
+	auto line = addSymbol<LineSymbol>(map, 501);
+	auto other_area = addSymbol<AreaSymbol>(map, 402);
+	
+	auto area_a = makeRectangle(map, area, 0, 0, 2, 2);
+	auto area_b = makeRectangle(map, area, 2.2, 0, 2, 2);
+	makeRectangle(map, area, 5, 0, 2, 2);   // 0.8 mm from area_b
+	makeRectangle(map, area, 7, 0, 2, 2);   // adjacent
+	makeRectangle(map, other_area, 0, 2.1, 2, 2);
+	
+	auto line_a = makePath(map, line, { MapCoord(0, 10), MapCoord(5, 10) });
+	auto line_b = makePath(map, line, { MapCoord(0, 10.3), MapCoord(5, 10.3) });
+	makePath(map, line, { MapCoord(0, 20), MapCoord(5, 20) });
+	makePath(map, line, { MapCoord(5, 20), MapCoord(5, 25) });   // junction
+	makePath(map, line, { MapCoord(2, 19), MapCoord(2, 21) });   // crossing
+	
+	MapValidator::Options options;
+	MapValidator validator(map, options);
+	MapValidator::SymbolRule area_rule;
+	area_rule.min_gap = 0.3;
+	validator.setRule(area, area_rule);
+	MapValidator::SymbolRule line_rule;
+	line_rule.min_gap = 0.5;
+	validator.setRule(line, line_rule);
+	
+	QVERIFY2(validator.validate(), qPrintable(validator.errorString()));
+	auto const gaps = issuesOf(validator, MapValidator::GapTooSmall);
+	QCOMPARE(int(validator.issues().size()), 2);
+	QCOMPARE(int(gaps.size()), 2);
+	
+	QVERIFY(isPair(gaps[0], area_a, area_b));
+	QVERIFY(qAbs(gaps[0].value - 0.2) < 0.001);
+	QCOMPARE(gaps[0].limit, 0.3);
+	QCOMPARE(gaps[0].fix, MapValidator::MergeObjects);
+	QVERIFY(qAbs(gaps[0].position.x() - 2.1) < 0.001);
+	
+	QVERIFY(isPair(gaps[1], line_a, line_b));
+	QVERIFY(qAbs(gaps[1].value - 0.3) < 0.001);
+	QCOMPARE(gaps[1].fix, MapValidator::NoFix);
+}
+
+
+void MapValidatorTest::overlapTest()
+{
+	Map map;
+	auto area = addSymbol<AreaSymbol>(map, 401);
+	
+	auto area_a = makeRectangle(map, area, 0, 0, 2, 2);
+	auto area_b = makeRectangle(map, area, 1, 1, 2, 2);
+	auto outer = makeRectangle(map, area, 10, 0, 10, 10);
+	auto inner = makeRectangle(map, area, 12, 2, 1, 1);
+	makeRectangle(map, area, 30, 0, 2, 2);
+	makeRectangle(map, area, 32, 0, 2, 2);   // adjacent
+	
+	MapValidator::Options options;
+	MapValidator validator(map, options);
+	MapValidator::SymbolRule rule;
+	rule.check_overlap = true;
+	rule.min_gap = 0.5;
+	validator.setRule(area, rule);
+	
+	QVERIFY2(validator.validate(), qPrintable(validator.errorString()));
+	auto const overlaps = issuesOf(validator, MapValidator::Overlap);
+	QCOMPARE(int(validator.issues().size()), 2);
+	QCOMPARE(int(overlaps.size()), 2);
+	
+	QVERIFY(isPair(overlaps[0], area_a, area_b));
+	QCOMPARE(overlaps[0].fix, MapValidator::MergeObjects);
+	
+	QVERIFY(isPair(overlaps[1], inner, outer));
+	QVERIFY(overlaps[1].object == inner);
+	QVERIFY(overlaps[1].extent.contains(QRectF(10.5, 0.5, 9, 9)));
+	
+	// Without the overlap check, the contained area is not reported,
+	// and the crossing areas are not a gap.
+	rule.check_overlap = false;
+	validator.setRule(area, rule);
+	QVERIFY(validator.validate());
+	QVERIFY(validator.issues().empty());
+}
+
+
+void MapValidatorTest::pointDistanceTest()
+{
+	Map map;
+	map.addPart(new MapPart(QStringLiteral("second"), &map), 1);
+	auto point = addSymbol<PointSymbol>(map, 101);
+	auto other_point = addSymbol<PointSymbol>(map, 102);
+	
+	auto point_a = makePoint(map, point, 0, 0);
+	auto point_b = makePoint(map, point, 0.5, 0);
+	auto point_c = makePoint(map, other_point, 10, 0);
+	auto point_d = makePoint(map, point, 10, 0.8);
+	makePoint(map, point, 20, 0);
+	makePoint(map, point, 22, 0);
+	makePoint(map, other_point, 30, 0);
+	makePoint(map, other_point, 30.1, 0);
+	makePoint(map, point, 20, 0.5, 1);   // other part
+	
+	MapValidator::Options options;
+	MapValidator validator(map, options);
+	MapValidator::SymbolRule rule;
+	rule.min_point_distance = 1.0;
+	validator.setRule(point, rule);
+	
+	QVERIFY2(validator.validate(), qPrintable(validator.errorString()));
+	auto const& issues = validator.issues();
+	QCOMPARE(int(issues.size()), 2);
+	
+	QCOMPARE(issues[0].type, MapValidator::PointsTooClose);
+	QVERIFY(isPair(issues[0], point_a, point_b));
+	QVERIFY(qAbs(issues[0].value - 0.5) < 0.001);
+	QCOMPARE(issues[0].limit, 1.0);
+	QCOMPARE(issues[0].fix, MapValidator::MoveObject);
+	auto const moved = issues[0].object->asPoint()->getCoordF() + issues[0].fix_offset;
+	auto const fixed = moved.distanceTo(issues[0].other->asPoint()->getCoordF());
+	QVERIFY(qAbs(fixed - 1.0) < 0.001);
+	
+	QCOMPARE(issues[1].type, MapValidator::PointsTooClose);
+	QVERIFY(isPair(issues[1], point_c, point_d));
+	QVERIFY(qAbs(issues[1].value - 0.8) < 0.001);
+}
+
+
+void MapValidatorTest::tilesTest()
+{
+	// A grid of points which are too close to their horizontal
+	// and vertical neighbours, but not to the diagonal ones.
+	Map map;
+	auto point = addSymbol<PointSymbol>(map, 101);
+	auto const n = 20;
+	for (int y = 0; y < n; ++y)
+	{
+		for (int x = 0; x < n; ++x)
+			makePoint(map, point, 0.8 * x, 0.8 * y);
+	}
+	
+	MapValidator::SymbolRule rule;
+	rule.min_point_distance = 1.0;
+	
+	for (auto tile_size : { 1000.0, 1.0, 0.3 })
+	{
+		MapValidator::Options options;
+		options.tile_size = tile_size;
+		MapValidator validator(map, options);
+		validator.setRule(point, rule);
+		QVERIFY2(validator.validate(), qPrintable(validator.errorString()));
+		QCOMPARE(int(validator.issues().size()), 2 * n * (n - 1));
+		
+		auto previous_y = validator.issues().front().position.y();
+		for (const auto& issue : validator.issues())
+		{
+			QVERIFY(issue.position.y() >= previous_y);
+			previous_y = issue.position.y();
+		}
+	}
+}
+
+
+void MapValidatorTest::invalidOptionsTest()
+{
+	Map map;
+	MapValidator::Options options;
+	options.tile_size = 0;
+	MapValidator validator(map, options);
+	QVERIFY(!validator.validate());
+	QVERIFY(!validator.errorString().isEmpty());
+}
+
+
+QTEST_MAIN(MapValidatorTest)
@@ -0,0 +1,55 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_MAP_VALIDATOR_T_H
+#define OPENORIENTEERING_MAP_VALIDATOR_T_H
+
+#include <QObject>
+
+
+/**
+ * @test Tests the validation of maps against per-symbol rules.
+ */
+class MapValidatorTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	
+	/** Tests that small areas and short lines are reported. */
+	void minimumSizeTest();
+	
+	/** Tests that gaps between objects of the same symbol are reported. */
+	void gapTest();
+	
+	/** Tests that overlapping areas are reported once per pair. */
+	void overlapTest();
+	
+	/** Tests that crowded point objects are reported, with a displacement. */
+	void pointDistanceTest();
+	
+	/** Tests that the results do not depend on the tiles. */
+	void tilesTest();
+	
+	/** Tests that invalid options are rejected. */
+	void invalidOptionsTest();
+};
+
+#endif
@@ -0,0 +1,209 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "object_pick_buffer_t.h"
+
+#include <vector>
+
+#include <QtTest>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QTransform>
+
+#include "test_helpers.h"
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_color.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/symbols/area_symbol.h"
+#include "core/symbols/line_symbol.h"
+#include "gui/map/object_pick_buffer.h"
+
+using namespace OpenOrienteering;
+using namespace OpenOrienteering::TestHelpers;
+
+
+namespace
+{
+
+/** 10 pixels per millimeter */
+const auto transform = QTransform::fromScale(10, 10);
+
+const auto size = QSize(200, 200);
+
+/**
+ * Sets up a map with a small area, which is covered by a big area, and a
+ * horizontal line across the big area. The line has the topmost color.
+ */
+void setupMap(Map& map, std::vector<Object*>& objects)
+{
+	auto line_color = new MapColor(QStringLiteral("line"), 0);
+	map.addColor(line_color, 0);
+	auto area_color = new MapColor(QStringLiteral("area"), 1);
+	map.addColor(area_color, 1);
+	
+	auto area_symbol = new AreaSymbol();
+	area_symbol->setColor(area_color);
+	map.addSymbol(area_symbol, 0);
+	auto line_symbol = new LineSymbol();
+	line_symbol->setColor(line_color);
+	line_symbol->setLineWidth(0.5);
+	map.addSymbol(line_symbol, 1);
+	
+	objects.push_back(makeRectangle(map, area_symbol, 4, 4, 2, 2));
+	objects.push_back(makeRectangle(map, area_symbol, 2, 2, 16, 16));
+	objects.push_back(makePath(map, line_symbol, { MapCoord(0, 10), MapCoord(20, 10) }));
+}
+
+}  // namespace
+
+
+
+void ObjectPickBufferTest::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
+void ObjectPickBufferTest::candidatesTest()
+{
+	Map map;
+	std::vector<Object*> objects;
+	setupMap(map, objects);
+	auto const& part = *map.getCurrentPart();
+	
+	ObjectPickBuffer buffer;
+	QVERIFY(buffer.isNull());
+	buffer.update(map, size, transform, 1.0);
+	QVERIFY(!buffer.isNull());
+	QVERIFY(!buffer.isDirty());
+	
+	std::vector<Object*> candidates;
+	QVERIFY(buffer.findCandidates(part, QPoint(150, 150), 3, candidates));
+	QCOMPARE(candidates, std::vector<Object*>({ objects[1] }));
+	
+	// The line is drawn on top of the big area.
+	candidates.clear();
+	QVERIFY(buffer.findCandidates(part, QPoint(150, 104), 3, candidates));
+	QCOMPARE(candidates, std::vector<Object*>({ objects[1], objects[2] }));
+	
+	candidates.clear();
+	QVERIFY(buffer.findCandidates(part, QPoint(150, 110), 3, candidates));
+	QCOMPARE(candidates, std::vector<Object*>({ objects[1] }));
+	
+	// The small area is covered by the big area.
+	candidates.clear();
+	QVERIFY(buffer.findCandidates(part, QPoint(50, 50), 3, candidates));
+	QCOMPARE(candidates, std::vector<Object*>({ objects[1] }));
+	
+	candidates.clear();
+	QVERIFY(buffer.findCandidates(part, QPoint(5, 190), 3, candidates));
+	QVERIFY(candidates.empty());
+	
+	QVERIFY(!buffer.findCandidates(part, QPoint(-5, 100), 3, candidates));
+	QVERIFY(!buffer.findCandidates(part, QPoint(100, 200), 3, candidates));
+	QVERIFY(candidates.empty());
+}
+
+
+void ObjectPickBufferTest::dirtyTest()
+{
+	Map map;
+	std::vector<Object*> objects;
+	setupMap(map, objects);
+	auto const& part = *map.getCurrentPart();
+	
+	ObjectPickBuffer buffer;
+	std::vector<Object*> candidates;
+	QVERIFY(!buffer.findCandidates(part, QPoint(150, 150), 3, candidates));
+	
+	buffer.update(map, size, transform, 1.0);
+	QVERIFY(buffer.findCandidates(part, QPoint(150, 150), 3, candidates));
+	QCOMPARE(candidates.size(), std::size_t(1));
+	
+	buffer.markDirty(QRect(0, 0, 10, 10));
+	QVERIFY(buffer.isDirty());
+	candidates.clear();
+	QVERIFY(!buffer.findCandidates(part, QPoint(150, 150), 3, candidates));
+	
+	buffer.update(map, size, transform, 1.0);
+	QVERIFY(!buffer.isDirty());
+	QVERIFY(buffer.findCandidates(part, QPoint(150, 150), 3, candidates));
+	
+	MapPart other_part(QStringLiteral("other"), &map);
+	candidates.clear();
+	QVERIFY(!buffer.findCandidates(other_part, QPoint(150, 150), 3, candidates));
+	
+	buffer.release();
+	QVERIFY(buffer.isNull());
+	QVERIFY(!buffer.findCandidates(part, QPoint(150, 150), 3, candidates));
+	QVERIFY(candidates.empty());
+}
+
+
+void ObjectPickBufferTest::staleTest()
+{
+	Map map;
+	std::vector<Object*> objects;
+	setupMap(map, objects);
+	auto const& part = *map.getCurrentPart();
+	
+	ObjectPickBuffer buffer;
+	buffer.update(map, size, transform, 1.0);
+	
+	// Removing the first object shifts the IDs of the other objects.
+	auto const deleted_rect = transform.mapRect(objects[0]->getExtent()).toAlignedRect();
+	map.deleteObject(objects[0], false);
+	std::vector<Object*> candidates;
+	QVERIFY(!buffer.findCandidates(part, QPoint(150, 150), 3, candidates));
+	QVERIFY(candidates.empty());
+	
+	// Outside of the objects, there is nothing to resolve.
+	QVERIFY(buffer.findCandidates(part, QPoint(5, 190), 3, candidates));
+	QVERIFY(candidates.empty());
+	
+	// Only the deleted object's extent is marked dirty, but the shifted IDs
+	// require redrawing the whole buffer.
+	buffer.markDirty(deleted_rect);
+	buffer.update(map, size, transform, 1.0);
+	QVERIFY(buffer.findCandidates(part, QPoint(150, 104), 3, candidates));
+	QCOMPARE(candidates, std::vector<Object*>({ objects[1], objects[2] }));
+	
+	candidates.clear();
+	QVERIFY(buffer.findCandidates(part, QPoint(150, 150), 3, candidates));
+	QCOMPARE(candidates, std::vector<Object*>({ objects[1] }));
+	
+	// Inserting an object outside of the other objects also shifts IDs.
+	auto const inserted = new PathObject(objects[1]->getSymbol(), { MapCoord(0, 0), MapCoord(1, 0), MapCoord(1, 1) });
+	inserted->closeAllParts();
+	map.getCurrentPart()->addObject(inserted, 0);
+	buffer.markDirty(transform.mapRect(inserted->getExtent()).toAlignedRect());
+	buffer.update(map, size, transform, 1.0);
+	candidates.clear();
+	QVERIFY(buffer.findCandidates(part, QPoint(150, 104), 3, candidates));
+	QCOMPARE(candidates, std::vector<Object*>({ objects[1], objects[2] }));
+}
+
+
+QTEST_MAIN(ObjectPickBufferTest)
@@ -0,0 +1,46 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_OBJECT_PICK_BUFFER_T_H
+#define OPENORIENTEERING_OBJECT_PICK_BUFFER_T_H
+
+#include <QObject>
+
+
+/**
+ * @test Tests the object ID raster used for picking objects in a map widget.
+ */
+class ObjectPickBufferTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	
+	/** Tests that the visible objects near a position are found, in part order. */
+	void candidatesTest();
+	
+	/** Tests that the buffer is not used while it is dirty or drawn for another part. */
+	void dirtyTest();
+	
+	/** Tests that IDs are detected as stale after objects were removed. */
+	void staleTest();
+};
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "pdf_text_t.h"
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QByteArray>
+#include <QFile>
+#include <QRectF>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_color.h"
+#include "core/map_coord.h"
+#include "core/map_printer.h"
+#include "core/objects/text_object.h"
+#include "core/symbols/text_symbol.h"
+
+#if defined(QT_PRINTSUPPORT_LIB)
+#  include <QPrinter>
+#  include <advanced_pdf_printer.h>
+#endif
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+/**
+ * Returns the contents of all streams in the PDF data.
+ * 
+ * Compressed streams are inflated. Other streams are returned as is.
+ */
+QByteArray streamContents(const QByteArray& pdf)
+{
+	static const auto stream_keyword = QByteArray("stream\n");
+	static const auto endstream_keyword = QByteArray("endstream");
+	
+	QByteArray contents;
+	auto pos = 0;
+	for (;;)
+	{
+		auto start = pdf.indexOf(stream_keyword, pos);
+		if (start < 0)
+			break;
+		start += stream_keyword.size();
+		auto end = pdf.indexOf(endstream_keyword, start);
+		if (end < 0)
+			break;
+		pos = end + endstream_keyword.size();
+		
+		// qUncompress expects the size of the uncompressed data in front
+		// of the zlib data. It grows its buffer when this size is too small.
+		auto data = pdf.mid(start, end - start);
+		auto expected_size = quint32(4 * data.size());
+		auto header = QByteArray(4, '\0');
+		header[0] = char(expected_size >> 24);
+		header[1] = char(expected_size >> 16);
+		header[2] = char(expected_size >> 8);
+		header[3] = char(expected_size);
+		auto inflated = qUncompress(header + data);
+		contents.append(inflated.isEmpty() ? data : inflated);
+		contents.append('\n');
+	}
+	return contents;
+}
+
+}  // namespace
+
+
+
+void PdfTextTest::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
+void PdfTextTest::textAsOutlinesTest_data()
+{
+	QTest::addColumn<bool>("text_as_outlines");
+	QTest::newRow("text objects") << false;
+	QTest::newRow("text as outlines") << true;
+}
+
+void PdfTextTest::textAsOutlinesTest()
+{
+#if !defined(QT_PRINTSUPPORT_LIB)
+	QSKIP("The advanced PDF engine is not available.");
+#else
+	QFETCH(bool, text_as_outlines);
+	
+	Map map;
+	auto color = new MapColor(QStringLiteral("black"), 0);
+	color->setCmyk(MapColorCmyk(0.0f, 0.0f, 0.0f, 1.0f));
+	map.addColor(color, 0);
+	
+	auto text_symbol = new TextSymbol();
+	text_symbol->setColor(color);
+	map.addSymbol(text_symbol, 0);
+	
+	auto text_object = new TextObject(text_symbol);
+	text_object->setAnchorPosition(MapCoord(10.0, 10.0));
+	text_object->setText(QStringLiteral("Mapper"));
+	map.addObject(text_object);
+	map.updateObjects();
+	
+	MapPrinter map_printer(map, nullptr);
+	map_printer.setMode(MapPrinterOptions::Vector);
+	map_printer.setPrintArea(text_object->getExtent().adjusted(-5.0, -5.0, 5.0, 5.0));
+	map_printer.setTextAsOutlines(text_as_outlines);
+	
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	auto const path = dir.path() + QLatin1String("/text.pdf");
+	{
+		AdvancedPdfPrinter printer(QPrinter::HighResolution);
+		printer.setOutputFileName(path);
+		QVERIFY(map_printer.printMap(&printer));
+	}
+	
+	QFile file(path);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	auto const data = file.readAll();
+	auto const contents = streamContents(data);
+	
+	// A text object is a BT ... ET block with a Tj operator,
+	// and the font subset is embedded as a TrueType font file.
+	auto const has_text_object = contents.contains("BT\n") && contents.contains(" Tj\n");
+	auto const has_embedded_font = data.contains("/FontFile2 ");
+	if (text_as_outlines)
+	{
+		QVERIFY(!has_text_object);
+		QVERIFY(!has_embedded_font);
+	}
+	else
+	{
+		QVERIFY(has_text_object);
+		QVERIFY(has_embedded_font);
+	}
+#endif
+}
+
+
+QTEST_MAIN(PdfTextTest)
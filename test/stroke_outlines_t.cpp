@@ -0,0 +1,184 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stroke_outlines_t.h"
+
+#include <cmath>
+
+#include <QtGlobal>
+#include <QtTest>
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QRectF>
+
+#include "core/map.h"
+#include "core/map_color.h"
+#include "core/map_coord.h"
+#include "core/objects/object.h"
+#include "core/renderables/renderable.h"
+#include "core/symbols/line_symbol.h"
+
+
+namespace OpenOrienteering {
+
+namespace {
+
+/** The size of the test image in pixels. */
+constexpr int image_size = 1024;
+
+/** Draws the map's center region into the image. */
+void drawMap(Map& map, QImage& image, qreal scaling, RenderConfig::Options options)
+{
+	image.fill(Qt::white);
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.translate(image_size / 2.0, image_size / 2.0);
+	painter.scale(scaling, scaling);
+	auto const half_size = image_size / 2.0 / scaling;
+	auto const bounding_box = QRectF(-half_size, -half_size, 2 * half_size, 2 * half_size);
+	RenderConfig config = { map, bounding_box, scaling, options, 1.0 };
+	map.draw(&painter, config);
+}
+
+}  // namespace
+
+
+
+void StrokeOutlinesTest::initTestCase()
+{
+	// Initializes the static symbols, e.g. Map::getUndefinedLine().
+	Map map;
+	Q_UNUSED(map)
+}
+
+
+void StrokeOutlinesTest::common_data()
+{
+	QTest::addColumn<qreal>("scaling");
+	QTest::newRow("scaling = 4") << qreal(4);
+	QTest::newRow("scaling = 20") << qreal(20);
+	QTest::newRow("scaling = 100") << qreal(100);
+}
+
+
+void StrokeOutlinesTest::fillMap(Map& map)
+{
+	auto color = new MapColor(QStringLiteral("black"), 0);
+	map.addColor(color, 0);
+	
+	auto symbol = new LineSymbol();
+	symbol->setColor(color);
+	symbol->setLineWidth(1.5);
+	symbol->setJoinStyle(LineSymbol::RoundJoin);
+	symbol->setCapStyle(LineSymbol::RoundCap);
+	map.addSymbol(symbol, 0);
+	
+	// Wavy lines with curves, resembling roads and rivers
+	for (int line = 0; line < 400; ++line)
+	{
+		MapCoordVector coords;
+		auto const offset_x = qint32((line % 20) * 10000 - 100000);
+		auto const offset_y = qint32((line / 20) * 10000 - 100000);
+		for (int i = 0; i < 40; ++i)
+		{
+			auto const x = offset_x + i * 1000;
+			auto const y = offset_y + qint32(std::lround(3000 * std::sin((i + line) / 3.0)));
+			coords.push_back(MapCoord::fromNative(x, y));
+			if (i % 6 == 0 && i + 3 < 40)
+				coords.back().setCurveStart(true);
+		}
+		map.addObject(new PathObject(symbol, coords));
+	}
+}
+
+
+void StrokeOutlinesTest::sameResult_data()
+{
+	common_data();
+}
+
+void StrokeOutlinesTest::sameResult()
+{
+	QFETCH(qreal, scaling);
+	
+	Map map;
+	fillMap(map);
+	
+	QImage stroked(image_size, image_size, QImage::Format_ARGB32_Premultiplied);
+	drawMap(map, stroked, scaling, RenderConfig::Screen);
+	QImage filled(image_size, image_size, QImage::Format_ARGB32_Premultiplied);
+	drawMap(map, filled, scaling, RenderConfig::Screen | RenderConfig::StrokeOutlines);
+	
+	// Antialiased edges may differ slightly.
+	auto painted = 0;
+	auto different = 0;
+	for (int y = 0; y < image_size; ++y)
+	{
+		auto const* stroked_line = reinterpret_cast<const QRgb*>(stroked.constScanLine(y));
+		auto const* filled_line  = reinterpret_cast<const QRgb*>(filled.constScanLine(y));
+		for (int x = 0; x < image_size; ++x)
+		{
+			if (qGray(stroked_line[x]) < 128)
+				++painted;
+			if (qAbs(qGray(stroked_line[x]) - qGray(filled_line[x])) > 64)
+				++different;
+		}
+	}
+	QVERIFY(painted > 0);
+	QVERIFY2(different <= painted / 100, qPrintable(QString::number(different)));
+}
+
+
+void StrokeOutlinesTest::render_data()
+{
+	QTest::addColumn<qreal>("scaling");
+	QTest::addColumn<bool>("outlines");
+	for (auto scaling : { 4, 20, 100 })
+	{
+		QTest::newRow(qPrintable(QString::fromLatin1("scaling = %1, stroked").arg(scaling))) << qreal(scaling) << false;
+		QTest::newRow(qPrintable(QString::fromLatin1("scaling = %1, outlines").arg(scaling))) << qreal(scaling) << true;
+	}
+}
+
+void StrokeOutlinesTest::render()
+{
+	QFETCH(qreal, scaling);
+	QFETCH(bool, outlines);
+	
+	Map map;
+	fillMap(map);
+	
+	auto options = RenderConfig::Options(RenderConfig::Screen);
+	if (outlines)
+		options |= RenderConfig::StrokeOutlines;
+	
+	QImage image(image_size, image_size, QImage::Format_ARGB32_Premultiplied);
+	// The first drawing updates the objects and fills the cache.
+	drawMap(map, image, scaling, options);
+	QBENCHMARK
+	{
+		drawMap(map, image, scaling, options);
+	}
+}
+
+
+}  // namespace OpenOrienteering
+
+QTEST_MAIN(OpenOrienteering::StrokeOutlinesTest)
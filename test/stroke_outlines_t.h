@@ -0,0 +1,61 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_STROKE_OUTLINES_T_H
+#define OPENORIENTEERING_STROKE_OUTLINES_T_H
+
+#include <QObject>
+
+
+namespace OpenOrienteering {
+
+class Map;
+
+
+/**
+ * @test Benchmarks drawing wide lines as stroked paths and as cached
+ *       filled outlines (RenderConfig::StrokeOutlines).
+ */
+class StrokeOutlinesTest : public QObject
+{
+Q_OBJECT
+	
+private slots:
+	/** Initialization. */
+	void initTestCase();
+	
+	/** Verifies that both modes produce nearly the same image. */
+	void sameResult();
+	void sameResult_data();
+	
+	/** Measures the redrawing of a map with many wide lines. */
+	void render();
+	void render_data();
+	
+private:
+	void common_data();
+	
+	/** Fills the map with wide curved lines with round joins. */
+	static void fillMap(Map& map);
+};
+
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -0,0 +1,497 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "template_point_cloud_t.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <QtEndian>
+#include <QtTest>
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QLineF>
+#include <QPainter>
+#include <QPointF>
+#include <QRectF>
+#include <QSignalSpy>
+#include <QString>
+#include <QStringList>
+
+#include "global.h"
+#include "core/georeferencing.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "templates/las_reader.h"
+#include "templates/template.h"
+#include "templates/template_point_cloud.h"
+#include "util/background_task.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+/// The number of point records in the synthetic point clouds
+constexpr int num_points = 40 * 40 + 20 * 40 + 1;
+
+
+template <class T>
+void putLE(QByteArray& data, int pos, T value)
+{
+	qToLittleEndian(value, reinterpret_cast<uchar*>(data.data() + pos));
+}
+
+void putDouble(QByteArray& data, int pos, double value)
+{
+	quint64 bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	putLE(data, pos, bits);
+}
+
+
+/**
+ * Writes a synthetic LAS file covering 40 x 40 cells of 1 m, starting at (1000, 2000).
+ * 
+ * Each cell has a ground point at 100 m + 0.1 m per column. The western half
+ * has an additional vegetation point 3 m above ground. There is one noise
+ * point 10 m above ground in the eastern half. A non-zero epsg code is
+ * written to a GeoTIFF key directory record.
+ */
+QString writeLas(const QTemporaryDir& dir, const QString& name, int minor_version, int format, bool with_noise = true, int epsg = 0)
+{
+	auto const extended_format = format >= 6;
+	auto const header_size = minor_version >= 4 ? 375 : 227;
+	auto const record_length = extended_format ? 30 : 28;
+	auto const count = with_noise ? num_points : num_points - 1;
+	
+	QByteArray header(header_size, 0);
+	header.replace(0, 4, "LASF");
+	header[24] = 1;
+	header[25] = char(minor_version);
+	putLE(header, 94, quint16(header_size));
+	putLE(header, 96, quint32(header_size));
+	if (epsg)
+	{
+		// Key directory header, and the ProjectedCSTypeGeoKey
+		const quint16 keys[] = { 1, 1, 0, 1, 3072, 0, 1, quint16(epsg) };
+		QByteArray vlr(54 + int(sizeof(keys)), 0);
+		vlr.replace(2, 15, "LASF_Projection");
+		putLE(vlr, 18, quint16(34735));
+		putLE(vlr, 20, quint16(sizeof(keys)));
+		for (int i = 0; i < 8; ++i)
+			putLE(vlr, 54 + 2 * i, keys[i]);
+		header.append(vlr);
+		putLE(header, 96, quint32(header.size()));
+		putLE(header, 100, quint32(1));
+	}
+	header[104] = char(format);
+	putLE(header, 105, quint16(record_length));
+	putLE(header, 107, quint32(extended_format ? 0 : count));
+	for (int i = 0; i < 3; ++i)
+	{
+		putDouble(header, 131 + 8 * i, 0.01);
+		putDouble(header, 155 + 8 * i, 0.0);
+	}
+	putDouble(header, 179, 1039.5);
+	putDouble(header, 187, 1000.5);
+	putDouble(header, 195, 2039.5);
+	putDouble(header, 203, 2000.5);
+	putDouble(header, 211, 113.0);
+	putDouble(header, 219, 100.0);
+	if (minor_version >= 4)
+		putLE(header, 247, quint64(count));
+	
+	QByteArray records;
+	auto addPoint = [&](double x, double y, double z, quint16 intensity, int classification, int number, int returns) {
+		QByteArray record(record_length, 0);
+		putLE(record, 0, qint32(std::lround(x * 100)));
+		putLE(record, 4, qint32(std::lround(y * 100)));
+		putLE(record, 8, qint32(std::lround(z * 100)));
+		putLE(record, 12, intensity);
+		if (extended_format)
+		{
+			record[14] = char(number | (returns << 4));
+			record[16] = char(classification);
+		}
+		else
+		{
+			record[14] = char(number | (returns << 3));
+			record[15] = char(classification);
+		}
+		records.append(record);
+	};
+	for (int row = 0; row < 40; ++row)
+	{
+		for (int col = 0; col < 40; ++col)
+		{
+			auto const x = 1000.5 + col;
+			auto const y = 2039.5 - row;
+			auto const ground = 100 + 0.1 * col;
+			addPoint(x, y, ground, 100, LasPoint::Ground, 1, 1);
+			if (col < 20)
+				addPoint(x, y, ground + 3, 300, LasPoint::HighVegetation, 1, 2);
+		}
+	}
+	if (with_noise)
+		addPoint(1030.5, 2034.5, 113, 1000, LasPoint::Noise, 1, 1);
+	
+	auto const path = dir.path() + QLatin1Char('/') + name;
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly)
+	    || file.write(header) != header.size()
+	    || file.write(records) != records.size())
+		return {};
+	return path;
+}
+
+
+PointCloudTiles::Options testOptions()
+{
+	PointCloudTiles::Options options;
+	options.tile_cells = 16;
+	options.chunk_size = 100;
+	options.buffer_budget = 1000;
+	return options;
+}
+
+
+QImage drawTemplate(const Template& temp)
+{
+	auto const bbox = temp.calculateTemplateBoundingBox();
+	QImage image(96, 96, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	QPainter painter(&image);
+	painter.scale(image.width() / bbox.width(), image.height() / bbox.height());
+	painter.translate(-bbox.topLeft());
+	temp.drawTemplate(&painter, bbox, 1, false, 1);
+	painter.end();
+	return image;
+}
+
+
+}  // namespace
+
+
+
+void TemplatePointCloudTest::initTestCase()
+{
+	doStaticInitializations();
+	QVERIFY(temp_dir.isValid());
+}
+
+
+void TemplatePointCloudTest::readerTest_data()
+{
+	QTest::addColumn<int>("minor_version");
+	QTest::addColumn<int>("format");
+	
+	QTest::newRow("LAS 1.2, format 1") << 2 << 1;
+	QTest::newRow("LAS 1.4, format 6") << 4 << 6;
+}
+
+void TemplatePointCloudTest::readerTest()
+{
+	QFETCH(int, minor_version);
+	QFETCH(int, format);
+	
+	auto const path = writeLas(temp_dir, QString::fromLatin1("reader-%1.las").arg(format), minor_version, format);
+	QVERIFY(!path.isEmpty());
+	
+	LasReader reader(path);
+	QVERIFY2(reader.open(), qPrintable(reader.errorString()));
+	QCOMPARE(reader.version(), 10 + minor_version);
+	QCOMPARE(reader.pointFormat(), format);
+	QCOMPARE(reader.pointCount(), quint64(num_points));
+	QCOMPARE(reader.minX(), 1000.5);
+	QCOMPARE(reader.maxX(), 1039.5);
+	QCOMPARE(reader.minY(), 2000.5);
+	QCOMPARE(reader.maxY(), 2039.5);
+	QCOMPARE(reader.epsgCode(), 0);
+	
+	std::vector<LasPoint> points;
+	QVERIFY(reader.read(points, 1000));
+	QCOMPARE(int(points.size()), 1000);
+	QCOMPARE(points[0].x, 1000.5);
+	QCOMPARE(points[0].y, 2039.5);
+	QCOMPARE(points[0].z, 100.0);
+	QCOMPARE(int(points[0].classification), int(LasPoint::Ground));
+	QCOMPARE(int(points[0].intensity), 100);
+	QCOMPARE(int(points[0].return_number), 1);
+	QCOMPARE(int(points[0].number_of_returns), 1);
+	QCOMPARE(points[1].z, 103.0);
+	QCOMPARE(int(points[1].classification), int(LasPoint::HighVegetation));
+	QCOMPARE(int(points[1].intensity), 300);
+	QCOMPARE(int(points[1].number_of_returns), 2);
+	
+	QVERIFY(reader.read(points, 1000));
+	QCOMPARE(int(points.size()), 1000);
+	QVERIFY(reader.read(points, 1000));
+	QCOMPARE(int(points.size()), num_points - 2000);
+	QCOMPARE(int(points.back().classification), int(LasPoint::Noise));
+	QVERIFY(reader.read(points, 1000));
+	QVERIFY(points.empty());
+}
+
+
+void TemplatePointCloudTest::tilesTest()
+{
+	auto const path = writeLas(temp_dir, QString::fromLatin1("tiles.las"), 2, 1);
+	QVERIFY(!path.isEmpty());
+	
+	auto const cache_path = PointCloudTiles::defaultCachePath(path);
+	PointCloudTiles tiles(path, cache_path, testOptions());
+	QVERIFY2(tiles.open(), qPrintable(tiles.errorString()));
+	QVERIFY(tiles.wasBuilt());
+	QCOMPARE(tiles.origin(), QPointF(1000, 2040));
+	QCOMPARE(tiles.tilesX(), 3);
+	QCOMPARE(tiles.tilesY(), 3);
+	QCOMPARE(tiles.numBands(), 3);
+	QCOMPARE(tiles.minGround(), 100.0f);
+	QVERIFY(std::abs(tiles.maxGround() - 103.9f) < 0.001f);
+	QCOMPARE(tiles.maxIntensity(), 200.0f);
+	
+	// The temporary point files are removed.
+	QVERIFY(QDir(cache_path).entryList({ QString::fromLatin1("*.points") }, QDir::Files).isEmpty());
+	
+	PointCloudTiles::Tile tile;
+	QVERIFY(!tiles.loadTile(3, 0, tile));
+	for (int tile_y = 0; tile_y < 3; ++tile_y)
+	{
+		for (int tile_x = 0; tile_x < 3; ++tile_x)
+		{
+			QVERIFY(tiles.hasTile(tile_x, tile_y));
+			QVERIFY(tiles.loadTile(tile_x, tile_y, tile));
+			QCOMPARE(int(tile.ground.size()), 16 * 16);
+			QCOMPARE(int(tile.density.size()), 3);
+			for (int row = 0; row < 16; ++row)
+			{
+				for (int col = 0; col < 16; ++col)
+				{
+					auto const i = std::size_t(row * 16 + col);
+					auto const map_col = tile_x * 16 + col;
+					auto const map_row = tile_y * 16 + row;
+					if (map_col >= 40 || map_row >= 40)
+					{
+						QVERIFY(std::isnan(tile.ground[i]));
+						QVERIFY(std::isnan(tile.intensity[i]));
+						QCOMPARE(tile.density[1][i], 0.0f);
+						continue;
+					}
+					
+					QVERIFY(std::abs(tile.ground[i] - float(100 + 0.1 * map_col)) < 0.001f);
+					QCOMPARE(tile.intensity[i], map_col < 20 ? 200.0f : 100.0f);
+					QCOMPARE(tile.density[0][i], 0.0f);
+					QCOMPARE(tile.density[1][i], map_col < 20 ? 0.5f : 0.0f);
+					QCOMPARE(tile.density[2][i], 0.0f);  // noise is ignored
+				}
+			}
+		}
+	}
+}
+
+
+void TemplatePointCloudTest::cacheTest()
+{
+	auto path = writeLas(temp_dir, QString::fromLatin1("cache.las"), 4, 6);
+	QVERIFY(!path.isEmpty());
+	auto const cache_path = PointCloudTiles::defaultCachePath(path);
+	auto options = testOptions();
+	{
+		PointCloudTiles tiles(path, cache_path, options);
+		QVERIFY(tiles.open());
+		QVERIFY(tiles.wasBuilt());
+	}
+	{
+		PointCloudTiles tiles(path, cache_path, options);
+		QVERIFY(tiles.open());
+		QVERIFY(!tiles.wasBuilt());
+		QCOMPARE(tiles.tilesX(), 3);
+		QCOMPARE(tiles.maxIntensity(), 200.0f);
+		PointCloudTiles::Tile tile;
+		QVERIFY(tiles.loadTile(0, 0, tile));
+		QCOMPARE(tile.density[1][0], 0.5f);
+	}
+	
+	// Different options
+	options.cell_size = 2;
+	{
+		PointCloudTiles tiles(path, cache_path, options);
+		QVERIFY(tiles.open());
+		QVERIFY(tiles.wasBuilt());
+		QCOMPARE(tiles.tilesX(), 2);
+		QVERIFY(QDir(cache_path).entryList({ QString::fromLatin1("*.tile") }, QDir::Files).size() == 4);
+	}
+	
+	// Modified source
+	QCOMPARE(writeLas(temp_dir, QString::fromLatin1("cache.las"), 4, 6, false), path);
+	{
+		PointCloudTiles tiles(path, cache_path, options);
+		QVERIFY(tiles.open());
+		QVERIFY(tiles.wasBuilt());
+	}
+}
+
+
+void TemplatePointCloudTest::templateTest()
+{
+	auto const path = writeLas(temp_dir, QString::fromLatin1("template.las"), 2, 1);
+	QVERIFY(!path.isEmpty());
+	
+	Map map;
+	auto temp = Template::templateForFile(path, &map);
+	QVERIFY(temp);
+	QCOMPARE(temp->getTemplateType(), "TemplatePointCloud");
+	
+	auto point_cloud = static_cast<TemplatePointCloud*>(temp.get());
+	QVERIFY2(point_cloud->loadTemplateFile(false), qPrintable(point_cloud->errorString()));
+	QCOMPARE(point_cloud->getTemplateState(), Template::Loaded);
+	QVERIFY(point_cloud->tiles());
+	QCOMPARE(point_cloud->getTemplateExtent(), QRectF(0, 0, 48, 48));
+	
+	const auto& georef = map.getGeoreferencing();
+	QVERIFY(QLineF(point_cloud->templateToMap(QPointF(0, 0)), georef.toMapCoordF(QPointF(1000, 2040))).length() < 0.001);
+	QVERIFY(QLineF(point_cloud->templateToMap(QPointF(48, 48)), georef.toMapCoordF(QPointF(1048, 1992))).length() < 0.001);
+	
+	// Ground height: all cells with points are opaque.
+	auto image = drawTemplate(*point_cloud);
+	QCOMPARE(qAlpha(image.pixel(10, 10)), 255);
+	QCOMPARE(qAlpha(image.pixel(70, 70)), 255);
+	QCOMPARE(qAlpha(image.pixel(90, 90)), 0);
+	QVERIFY(qGray(image.pixel(10, 10)) < qGray(image.pixel(70, 10)));
+	
+	// Vegetation density: only the western half is covered.
+	point_cloud->setProduct(TemplatePointCloud::VegetationDensity, 1);
+	QCOMPARE(point_cloud->product(), TemplatePointCloud::VegetationDensity);
+	QCOMPARE(point_cloud->band(), 1);
+	image = drawTemplate(*point_cloud);
+	QVERIFY(qAlpha(image.pixel(10, 10)) > 100);
+	QVERIFY(qAlpha(image.pixel(10, 10)) < 150);
+	QCOMPARE(qAlpha(image.pixel(60, 10)), 0);
+	
+	point_cloud->unloadTemplateFile();
+	QVERIFY(!point_cloud->tiles());
+}
+
+
+void TemplatePointCloudTest::taskTest()
+{
+	auto const path = writeLas(temp_dir, QString::fromLatin1("task.las"), 2, 1);
+	QVERIFY(!path.isEmpty());
+	auto const cache_path = PointCloudTiles::defaultCachePath(path);
+	
+	// Stopping from the progress callback
+	{
+		PointCloudTiles tiles(path, cache_path, testOptions());
+		auto calls = 0;
+		QVERIFY(!tiles.open([&calls](int /*value*/) { return ++calls < 3; }));
+		QCOMPARE(calls, 3);
+	}
+	
+	{
+		PointCloudTiles tiles(path, cache_path, testOptions());
+		PointCloudTilesTask task(tiles);
+		QSignalSpy progress_spy(&task, &BackgroundTask::progressChanged);
+		QVERIFY(task.runSynchronously());
+		QCOMPARE(task.state(), BackgroundTask::Finished);
+		QVERIFY(tiles.wasBuilt());
+		QVERIFY(!progress_spy.isEmpty());
+		QVERIFY(progress_spy.last().at(0).toInt() >= 80);
+	}
+	
+	QVERIFY(QDir(cache_path).removeRecursively());
+	{
+		PointCloudTiles tiles(path, cache_path, testOptions());
+		PointCloudTilesTask task(tiles);
+		task.cancel();
+		QVERIFY(!task.runSynchronously());
+		QCOMPARE(task.state(), BackgroundTask::Canceled);
+	}
+}
+
+
+void TemplatePointCloudTest::crsTest()
+{
+	auto const path = writeLas(temp_dir, QString::fromLatin1("crs.las"), 2, 1, true, 25832);
+	QVERIFY(!path.isEmpty());
+	
+	LasReader reader(path);
+	QVERIFY2(reader.open(), qPrintable(reader.errorString()));
+	QCOMPARE(reader.epsgCode(), 25832);
+	QCOMPARE(reader.pointCount(), quint64(num_points));
+	
+	Map map;
+	TemplatePointCloud temp(path, &map);
+	QVERIFY2(temp.loadTemplateFile(false), qPrintable(temp.errorString()));
+	QVERIFY(!temp.crsWarning().isEmpty());  // local map
+	
+	Georeferencing georef;
+	georef.setProjectedCRS(QString::fromLatin1("EPSG"), QString::fromLatin1("+init=epsg:25832"), { QString::fromLatin1("25832") });
+	map.setGeoreferencing(georef);
+	QVERIFY(temp.crsWarning().isEmpty());
+	
+	georef.setProjectedCRS(QString::fromLatin1("UTM"), QString::fromLatin1("+proj=utm +zone=32 +datum=WGS84"), { QString::fromLatin1("32 N") });
+	map.setGeoreferencing(georef);
+	QVERIFY(temp.crsWarning().contains(QLatin1String("32632")));
+	
+	// No CRS in the file
+	TemplatePointCloud unknown_crs(writeLas(temp_dir, QString::fromLatin1("no-crs.las"), 2, 1), &map);
+	QVERIFY(unknown_crs.loadTemplateFile(false));
+	QVERIFY(unknown_crs.crsWarning().isEmpty());
+}
+
+
+void TemplatePointCloudTest::invalidFileTest()
+{
+	auto const path = temp_dir.path() + QLatin1String("/invalid.las");
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write("This is not a LAS file.");
+	}
+	
+	LasReader reader(path);
+	QVERIFY(!reader.open());
+	QVERIFY(!reader.errorString().isEmpty());
+	
+	Map map;
+	TemplatePointCloud temp(path, &map);
+	QVERIFY(!temp.loadTemplateFile(false));
+	QVERIFY(!temp.errorString().isEmpty());
+	QVERIFY(!temp.tiles());
+	
+	// Compressed (LAZ) point records
+	auto const laz_path = writeLas(temp_dir, QString::fromLatin1("compressed.las"), 2, 1);
+	{
+		QFile file(laz_path);
+		QVERIFY(file.open(QIODevice::ReadWrite));
+		QVERIFY(file.seek(104));
+		QCOMPARE(file.write("\x81", 1), qint64(1));
+	}
+	LasReader laz_reader(laz_path);
+	QVERIFY(!laz_reader.open());
+}
+
+
+
+QTEST_MAIN(TemplatePointCloudTest)
@@ -0,0 +1,77 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_TEMPLATE_POINT_CLOUD_T_H
+#define OPENORIENTEERING_TEMPLATE_POINT_CLOUD_T_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+
+/**
+ * @test Tests the LiDAR point cloud template with synthetic LAS files.
+ */
+class TemplatePointCloudTest : public QObject
+{
+Q_OBJECT
+	
+private slots:
+	void initTestCase();
+	
+	/**
+	 * Tests the header and the chunked point records of LAS 1.2 and 1.4 files.
+	 */
+	void readerTest_data();
+	void readerTest();
+	
+	/**
+	 * Tests the raster products, built with multiple chunks and flushes.
+	 */
+	void tilesTest();
+	
+	/**
+	 * Tests that a valid cache is reused, and an outdated cache is rebuilt.
+	 */
+	void cacheTest();
+	
+	/**
+	 * Tests loading, positioning and drawing the template.
+	 */
+	void templateTest();
+	
+	/**
+	 * Tests building the tiles in a background task, with progress and cancellation.
+	 */
+	void taskTest();
+	
+	/**
+	 * Tests reading the CRS of a LAS file, and the warning about a different map CRS.
+	 */
+	void crsTest();
+	
+	/**
+	 * Tests the error handling for invalid files.
+	 */
+	void invalidFileTest();
+	
+private:
+	QTemporaryDir temp_dir;
+};
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPENORIENTEERING_TEST_HELPERS_H
+#define OPENORIENTEERING_TEST_HELPERS_H
+
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/objects/object.h"
+#include "core/symbols/symbol.h"
+
+
+namespace OpenOrienteering {
+
+/**
+ * Test helpers for building maps in code.
+ *
+ * Objects are given in map coordinates (mm), and they are added to the
+ * given map part, or to the current part by default.
+ */
+namespace TestHelpers {
+
+/** Adds a new symbol of type T, with the given number, at the end of the symbol list. */
+template <class T>
+T* addSymbol(Map& map, int number)
+{
+	auto symbol = new T();
+	symbol->setNumberComponent(0, number);
+	map.addSymbol(symbol, map.getNumSymbols());
+	return symbol;
+}
+
+/** Adds a path object with the given coordinates. */
+inline PathObject* makePath(Map& map, const Symbol* symbol, const MapCoordVector& coords, bool closed = false, int part = -1)
+{
+	auto object = new PathObject(symbol, coords);
+	if (closed)
+		object->closeAllParts();
+	map.addObject(object, part);
+	return object;
+}
+
+/** Adds a closed rectangular path from (x, y) to (x + width, y + height). */
+inline PathObject* makeRectangle(Map& map, const Symbol* symbol, double x, double y, double width, double height)
+{
+	return makePath(map, symbol, { MapCoord(x, y), MapCoord(x + width, y), MapCoord(x + width, y + height), MapCoord(x, y + height) }, true);
+}
+
+/** Adds a closed square path from (x, y) to (x + size, y + size). */
+inline PathObject* makeSquare(Map& map, const Symbol* symbol, double x, double y, double size)
+{
+	return makeRectangle(map, symbol, x, y, size, size);
+}
+
+/** Adds a point object at (x, y). */
+inline PointObject* makePoint(Map& map, const Symbol* symbol, double x, double y, int part = -1)
+{
+	auto object = new PointObject(symbol);
+	object->setPosition(MapCoordF(x, y));
+	map.addObject(object, part);
+	return object;
+}
+
+}  // namespace TestHelpers
+
+}  // namespace OpenOrienteering
+
+#endif
@@ -30,6 +30,7 @@
 #include <QPoint>
 #include <QPointF>
 #include <QString>
+#include <QVariant>
 
 #include "core/map.h"
 #include "core/map_color.h"
@@ -37,6 +38,7 @@
 #include "core/objects/object.h"
 #include "core/symbols/line_symbol.h"
 #include "global.h"
+#include "settings.h"
 #include "gui/main_window.h"
 #include "gui/map/map_editor.h"
 #include "gui/map/map_widget.h"
@@ -206,6 +208,58 @@ void ToolsTest::editTool()
 }
 
 
+void ToolsTest::editToolSharedNodes()
+{
+	// Initialization
+	TestMap map;
+	PathObject* object = map.line_object;
+	auto const position = object->getCoordinate(0);
+	
+	// Three neighbours sharing the first node of the line object
+	auto add_neighbour = [&map, position](bool hidden, bool is_protected) {
+		auto symbol = map.line_symbol->duplicate();
+		symbol->setHidden(hidden);
+		symbol->setProtected(is_protected);
+		map.map->addSymbol(symbol, map.map->getNumSymbols());
+		auto neighbour = new PathObject(symbol);
+		neighbour->addCoordinate(position);
+		neighbour->addCoordinate(MapCoord(0, 20));
+		map.map->addObject(neighbour);
+		return neighbour;
+	};
+	auto regular_neighbour   = add_neighbour(false, false);
+	auto hidden_neighbour    = add_neighbour(true, false);
+	auto protected_neighbour = add_neighbour(false, true);
+	
+	auto& settings = Settings::getInstance();
+	auto const move_shared_nodes = settings.getSettingCached(Settings::EditTool_MoveSharedNodes);
+	settings.setSettingInCache(Settings::EditTool_MoveSharedNodes, true);
+	
+	TestMapEditor editor(map.map);
+	EditTool* tool = new EditPointTool(editor.editor, nullptr);
+	editor.editor->setTool(tool);
+	
+	MapWidget* map_widget = editor.map_widget;
+	QPointF drag_start_pos = map_widget->mapToViewport(position);
+	QPointF drag_end_pos = drag_start_pos + QPointF(0, -50);
+	
+	// Select the line object, and drag its first coordinate.
+	map.map->clearObjectSelection(false);
+	map.map->addObjectToSelection(object, true);
+	editor.simulateDrag(drag_start_pos, drag_end_pos);
+	
+	auto const new_position = object->getCoordinate(0);
+	QVERIFY(new_position != position);
+	QCOMPARE(regular_neighbour->getCoordinate(0), new_position);
+	QCOMPARE(hidden_neighbour->getCoordinate(0), position);
+	QCOMPARE(protected_neighbour->getCoordinate(0), position);
+	
+	// Cleanup
+	editor.editor->setTool(nullptr);
+	settings.setSettingInCache(Settings::EditTool_MoveSharedNodes, move_shared_nodes);
+}
+
+
 /*
  * We select a non-standard QPA because we don't need a real GUI window.
  * 
@@ -34,6 +34,9 @@ private slots:
 	void initTestCase();
 	
 	void editTool();
+	
+	/** Tests that shared nodes of hidden or protected objects are not moved. */
+	void editToolSharedNodes();
 };
 
 #endif
@@ -0,0 +1,193 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transform_grid_t.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <QtTest>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+#include "core/georeferencing.h"
+#include "core/latlon.h"
+#include "core/map_coord.h"
+#include "core/transform_grid.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+double distance(const QPointF& a, const QPointF& b)
+{
+	return std::hypot(a.x() - b.x(), a.y() - b.y());
+}
+
+}  // namespace
+
+
+
+void TransformGridTest::affineTest()
+{
+	auto const transform = [](const QPointF& source, QPointF& target) {
+		target = QPointF(2 * source.x() - source.y() + 5, source.x() + 3 * source.y());
+		return true;
+	};
+	
+	TransformGrid grid(transform, QRectF(-10, -10, 20, 20), 0.001);
+	QCOMPARE(grid.cellCount(), std::size_t(1));
+	QCOMPARE(grid.sampleCount(), std::size_t(9));
+	
+	for (auto const& source : { QPointF(0, 0), QPointF(-10, 10), QPointF(3.3, -7.1) })
+	{
+		QVERIFY(grid.isInterpolated(source));
+		QPointF expected;
+		transform(source, expected);
+		QVERIFY(distance(grid.map(source), expected) < 1e-9);
+	}
+}
+
+
+void TransformGridTest::errorBoundTest_data()
+{
+	QTest::addColumn<QString>("spec");
+	QTest::addColumn<double>("latitude");
+	QTest::addColumn<double>("longitude");
+	QTest::addColumn<double>("size");       // degrees
+	QTest::addColumn<double>("max_error");  // mm
+	
+	auto const utm32 = QStringLiteral("+proj=utm +zone=32 +datum=WGS84");
+	auto const gk3 = QStringLiteral("+proj=tmerc +lat_0=0 +lon_0=9 +k=1.000000 +x_0=3500000 +y_0=0 +ellps=bessel +datum=potsdam +units=m +no_defs");
+	auto const mercator = QStringLiteral("+proj=merc +datum=WGS84 +units=m +no_defs");
+	auto const lambert = QStringLiteral("+proj=lcc +lat_1=49 +lat_2=44 +lat_0=46.5 +lon_0=3 +x_0=700000 +y_0=6600000 +ellps=GRS80 +units=m +no_defs");
+	auto const polar = QStringLiteral("+proj=stere +lat_0=90 +lat_ts=70 +lon_0=-45 +k=1 +x_0=0 +y_0=0 +datum=WGS84 +units=m +no_defs");
+	
+	QTest::newRow("UTM 32, 1 mm")         << utm32 << 50.0 << 8.0 << 0.5 << 1.0;
+	QTest::newRow("UTM 32, 0.001 mm")     << utm32 << 50.0 << 8.0 << 0.05 << 0.001;
+	QTest::newRow("UTM 32, zone border")  << utm32 << 60.0 << 12.5 << 1.0 << 0.01;
+	QTest::newRow("Gauss-Krueger, 1 mm")  << gk3 << 48.0 << 9.5 << 0.5 << 1.0;
+	QTest::newRow("Mercator, 0.01 mm")    << mercator << 65.0 << 20.0 << 1.0 << 0.01;
+	QTest::newRow("Lambert, 0.01 mm")     << lambert << 46.0 << 5.0 << 0.5 << 0.01;
+	QTest::newRow("Polar stereographic")  << polar << 80.0 << -40.0 << 2.0 << 0.01;
+}
+
+void TransformGridTest::errorBoundTest()
+{
+	QFETCH(QString, spec);
+	QFETCH(double, latitude);
+	QFETCH(double, longitude);
+	QFETCH(double, size);
+	QFETCH(double, max_error);
+	
+	Georeferencing georef;
+	georef.setScaleDenominator(10000);
+	QVERIFY2(georef.setProjectedCRS(spec, spec), georef.getErrorText().toLatin1());
+	georef.setGeographicRefPoint(LatLon(latitude, longitude));
+	
+	auto const transform = [&georef](const QPointF& source, QPointF& target) {
+		bool ok;
+		target = georef.toMapCoordF(LatLon(source.y(), source.x()), &ok);
+		return ok;
+	};
+	
+	auto const extent = QRectF(longitude - size / 2, latitude - size / 2, size, size);
+	TransformGrid grid(transform, extent, max_error);
+	QVERIFY(grid.cellCount() > 0);
+	
+	// Test points which are not aligned with the grid
+	constexpr int steps = 97;
+	auto interpolated = 0;
+	auto max_deviation = 0.0;
+	for (int i = 0; i <= steps; ++i)
+	{
+		for (int j = 0; j <= steps; ++j)
+		{
+			auto const source = QPointF(extent.left() + extent.width() * i / steps,
+			                            extent.top() + extent.height() * j / steps);
+			QPointF expected;
+			QVERIFY(transform(source, expected));
+			bool ok = false;
+			auto const actual = grid.map(source, &ok);
+			QVERIFY(ok);
+			max_deviation = std::max(max_deviation, distance(actual, expected));
+			if (grid.isInterpolated(source))
+				++interpolated;
+		}
+	}
+	if (max_deviation > max_error)
+		QCOMPARE(max_deviation, max_error);
+	
+	// The grid must pay off for this number of points.
+	QVERIFY(grid.sampleCount() < std::size_t((steps + 1) * (steps + 1)));
+	QCOMPARE(interpolated, (steps + 1) * (steps + 1));
+}
+
+
+void TransformGridTest::fallbackTest()
+{
+	// Fails for negative x, and is not linear.
+	auto const transform = [](const QPointF& source, QPointF& target) {
+		target = QPointF(source.x() * source.x(), source.y());
+		return source.x() >= 0;
+	};
+	
+	TransformGrid grid(transform, QRectF(-1, 0, 5, 5), 0.01);
+	QVERIFY(grid.cellCount() > 1);
+	
+	bool ok = true;
+	QPointF expected;
+	
+	// Points where the transformation fails are not interpolated.
+	auto source = QPointF(-0.5, 2);
+	QVERIFY(!grid.isInterpolated(source));
+	grid.map(source, &ok);
+	QVERIFY(!ok);
+	
+	// Points outside the extent are transformed exactly.
+	source = QPointF(10, 10);
+	QVERIFY(!grid.isInterpolated(source));
+	transform(source, expected);
+	QCOMPARE(grid.map(source, &ok), expected);
+	QVERIFY(ok);
+	
+	// Points in the extent are interpolated within the error bound.
+	source = QPointF(3.14159, 2.71828);
+	QVERIFY(grid.isInterpolated(source));
+	transform(source, expected);
+	QVERIFY(distance(grid.map(source, &ok), expected) <= 0.01);
+	QVERIFY(ok);
+	
+	// A degenerated extent results in exact transformations only.
+	TransformGrid empty_grid(transform, QRectF(1, 1, 0, 5), 0.01);
+	QCOMPARE(empty_grid.cellCount(), std::size_t(0));
+	QCOMPARE(empty_grid.sampleCount(), std::size_t(0));
+	source = QPointF(1, 2);
+	transform(source, expected);
+	QCOMPARE(empty_grid.map(source, &ok), expected);
+	QVERIFY(ok);
+}
+
+
+
+QTEST_GUILESS_MAIN(TransformGridTest)
@@ -0,0 +1,44 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_TRANSFORM_GRID_T_H
+#define OPENORIENTEERING_TRANSFORM_GRID_T_H
+
+#include <QObject>
+
+
+/**
+ * @test Tests the interpolation of transformations on adaptive grids.
+ */
+class TransformGridTest : public QObject
+{
+Q_OBJECT
+private slots:
+	/** Tests that an affine transformation needs no subdivision. */
+	void affineTest();
+	
+	/** Tests the error bound for geographic to map coordinates in several CRS. */
+	void errorBoundTest();
+	void errorBoundTest_data();
+	
+	/** Tests the fallback to the exact transformation. */
+	void fallbackTest();
+};
+
+#endif
@@ -0,0 +1,568 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vector_tile_export_t.h"
+
+#include <cmath>
+#include <vector>
+
+#include <QtTest>
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointF>
+#include <QRectF>
+#include <QSignalSpy>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "global.h"
+#include "core/crs_template.h"
+#include "core/georeferencing.h"
+#include "core/latlon.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/objects/object.h"
+#include "core/symbols/area_symbol.h"
+#include "fileformats/vector_tile_export.h"
+#include "util/background_task.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+/** A decoded feature. */
+struct DecodedFeature
+{
+	quint64 id = 0;
+	int type = 0;
+	std::vector<quint32> tags;
+	std::vector<std::vector<QPointF>> parts;
+};
+
+/** A decoded layer. */
+struct DecodedLayer
+{
+	QString name;
+	quint32 extent = 4096;
+	quint32 version = 1;
+	QStringList keys;
+	QStringList values;
+	std::vector<DecodedFeature> features;
+};
+
+
+quint64 readVarint(const QByteArray& data, int& pos)
+{
+	quint64 result = 0;
+	for (int shift = 0; pos < data.size(); shift += 7)
+	{
+		auto const byte = quint8(data[pos++]);
+		result |= quint64(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			break;
+	}
+	return result;
+}
+
+QByteArray readBytes(const QByteArray& data, int& pos)
+{
+	auto const length = int(readVarint(data, pos));
+	auto const result = data.mid(pos, length);
+	pos += length;
+	return result;
+}
+
+std::vector<quint32> readPacked(const QByteArray& data, int& pos)
+{
+	auto const bytes = readBytes(data, pos);
+	std::vector<quint32> result;
+	for (int i = 0; i < bytes.size(); )
+		result.push_back(quint32(readVarint(bytes, i)));
+	return result;
+}
+
+void skipField(const QByteArray& data, int& pos, int wire_type)
+{
+	switch (wire_type)
+	{
+	case 0:
+		readVarint(data, pos);
+		break;
+	case 1:
+		pos += 8;
+		break;
+	case 2:
+		readBytes(data, pos);
+		break;
+	case 5:
+		pos += 4;
+		break;
+	default:
+		QFAIL("Unexpected wire type");
+	}
+}
+
+qint32 unzigzag(quint32 value)
+{
+	return qint32(value >> 1) ^ -qint32(value & 1);
+}
+
+/**
+ * Decodes the geometry commands. Closed rings repeat their first point.
+ */
+std::vector<std::vector<QPointF>> decodeGeometry(const std::vector<quint32>& commands)
+{
+	std::vector<std::vector<QPointF>> parts;
+	qint32 x = 0, y = 0;
+	for (std::size_t i = 0; i < commands.size(); )
+	{
+		auto const id = commands[i] & 0x7;
+		auto const count = commands[i] >> 3;
+		++i;
+		if (id == 7)
+		{
+			if (!parts.empty() && !parts.back().empty())
+				parts.back().push_back(parts.back().front());
+			continue;
+		}
+		for (quint32 j = 0; j < count && i + 1 < commands.size(); ++j, i += 2)
+		{
+			x += unzigzag(commands[i]);
+			y += unzigzag(commands[i+1]);
+			if (id == 1)
+				parts.emplace_back();
+			parts.back().push_back(QPointF(x, y));
+		}
+	}
+	return parts;
+}
+
+DecodedFeature decodeFeature(const QByteArray& data)
+{
+	DecodedFeature feature;
+	for (int pos = 0; pos < data.size(); )
+	{
+		auto const key = readVarint(data, pos);
+		switch (key >> 3)
+		{
+		case 1:
+			feature.id = readVarint(data, pos);
+			break;
+		case 2:
+			feature.tags = readPacked(data, pos);
+			break;
+		case 3:
+			feature.type = int(readVarint(data, pos));
+			break;
+		case 4:
+			feature.parts = decodeGeometry(readPacked(data, pos));
+			break;
+		default:
+			skipField(data, pos, int(key & 0x7));
+		}
+	}
+	return feature;
+}
+
+DecodedLayer decodeLayer(const QByteArray& data)
+{
+	DecodedLayer layer;
+	for (int pos = 0; pos < data.size(); )
+	{
+		auto const key = readVarint(data, pos);
+		switch (key >> 3)
+		{
+		case 1:
+			layer.name = QString::fromUtf8(readBytes(data, pos));
+			break;
+		case 2:
+			layer.features.push_back(decodeFeature(readBytes(data, pos)));
+			break;
+		case 3:
+			layer.keys.append(QString::fromUtf8(readBytes(data, pos)));
+			break;
+		case 4:
+			{
+				auto const value = readBytes(data, pos);
+				int value_pos = 0;
+				readVarint(value, value_pos);  // string_value
+				layer.values.append(QString::fromUtf8(readBytes(value, value_pos)));
+			}
+			break;
+		case 5:
+			layer.extent = quint32(readVarint(data, pos));
+			break;
+		case 15:
+			layer.version = quint32(readVarint(data, pos));
+			break;
+		default:
+			skipField(data, pos, int(key & 0x7));
+		}
+	}
+	return layer;
+}
+
+/**
+ * Decodes a tile which is expected to have exactly one layer.
+ */
+DecodedLayer decodeTile(const QByteArray& data)
+{
+	std::vector<DecodedLayer> layers;
+	for (int pos = 0; pos < data.size(); )
+	{
+		auto const key = readVarint(data, pos);
+		if (key >> 3 == 3)
+			layers.push_back(decodeLayer(readBytes(data, pos)));
+		else
+			skipField(data, pos, int(key & 0x7));
+	}
+	return layers.size() == 1 ? layers.front() : DecodedLayer{};
+}
+
+
+/** Returns the area of a ring, positive for clockwise rings in tile coordinates. */
+qreal signedArea(const std::vector<QPointF>& ring)
+{
+	auto area = qreal(0);
+	for (std::size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+		area += ring[j].x() * ring[i].y() - ring[i].x() * ring[j].y();
+	return area / 2;
+}
+
+
+/** Sets up a map with Web Mercator georeferencing. */
+void setupGeoreferencing(Map& map)
+{
+	Georeferencing georef;
+	georef.setScaleDenominator(10000);
+	georef.setProjectedCRS(QString::fromLatin1("EPSG:3857"), CRSTemplateRegistry().find(QString::fromLatin1("EPSG"))->specificationTemplate().arg(QString::fromLatin1("3857")), { QString::fromLatin1("3857") });
+	georef.setProjectedRefPoint({ 1000000.0, 6000000.0 }, false);
+	map.setScaleDenominator(10000);
+	map.setGeoreferencing(georef);
+}
+
+/** Returns the expected position of a map coordinate in tile units. */
+QPointF tileCoords(const Map& map, const MapCoordF& coord, const VectorTileExport::TileId& tile, quint32 extent)
+{
+	auto const lat_lon = map.getGeoreferencing().toGeographicCoords(coord);
+	auto const world = VectorTileExport::worldCoords(lat_lon.latitude(), lat_lon.longitude());
+	auto const scale = qreal(extent) * (1 << tile.zoom);
+	return { world.x() * scale - qreal(tile.x) * extent, world.y() * scale - qreal(tile.y) * extent };
+}
+
+}  // namespace
+
+
+
+void VectorTileExportTest::initTestCase()
+{
+	doStaticInitializations();
+}
+
+
+void VectorTileExportTest::worldCoordsTest()
+{
+	auto const center = VectorTileExport::worldCoords(0.0, 0.0);
+	QCOMPARE(center.x(), 0.5);
+	QCOMPARE(center.y(), 0.5);
+	
+	auto const north_west = VectorTileExport::worldCoords(85.0511287798, -180.0);
+	QVERIFY(std::abs(north_west.x()) < 1e-9);
+	QVERIFY(std::abs(north_west.y()) < 1e-9);
+	
+	auto const south_east = VectorTileExport::worldCoords(-85.0511287798, 180.0);
+	QVERIFY(std::abs(south_east.x() - 1.0) < 1e-9);
+	QVERIFY(std::abs(south_east.y() - 1.0) < 1e-9);
+}
+
+
+void VectorTileExportTest::encodeTileTest()
+{
+	Map map;
+	setupGeoreferencing(map);
+	QVERIFY(!map.getGeoreferencing().isLocal());
+	
+	auto area_symbol = new AreaSymbol();
+	map.addSymbol(area_symbol, 0);
+	
+	auto corners = MapCoordVector { MapCoord(0, 0), MapCoord(20, 0), MapCoord(20, 20), MapCoord(0, 20) };
+	auto area = new PathObject(area_symbol, corners);
+	area->closeAllParts();
+	map.addObject(area);
+	
+	auto line = new PathObject(Map::getUndefinedLine(), { MapCoord(-10, 30), MapCoord(30, 30) });
+	map.addObject(line);
+	
+	auto point = new PointObject(Map::getUndefinedPoint());
+	point->setPosition(MapCoord(10, 50));
+	map.addObject(point);
+	
+	VectorTileExport::Options options;
+	options.min_zoom = 16;
+	options.max_zoom = 16;
+	VectorTileExport exporter(map, options);
+	QVERIFY(exporter.prepare());
+	QVERIFY(exporter.warnings().empty());
+	
+	auto const tiles = exporter.tiles(16);
+	QVERIFY(!tiles.empty());
+	QVERIFY(exporter.tiles(15).empty());
+	
+	auto const extent = qreal(options.extent);
+	auto const buffered_tile = QRectF(-options.buffer, -options.buffer, extent + 2 * options.buffer, extent + 2 * options.buffer);
+	auto const limits = buffered_tile.adjusted(-1, -1, 1, 1);
+	
+	int found[4] = {};
+	for (const auto& tile : tiles)
+	{
+		auto const data = exporter.encodeTile(tile);
+		if (data.isEmpty())
+			continue;
+		
+		auto const layer = decodeTile(data);
+		QCOMPARE(layer.name, QString::fromLatin1("map"));
+		QCOMPARE(layer.extent, options.extent);
+		QCOMPARE(layer.version, 2u);
+		QVERIFY(layer.keys.contains(QString::fromLatin1("symbol")));
+		
+		for (const auto& feature : layer.features)
+		{
+			QVERIFY(feature.type >= 1 && feature.type <= 3);
+			QVERIFY(feature.id >= 1 && feature.id <= 3);
+			QVERIFY(!feature.parts.empty());
+			QCOMPARE(feature.tags.size() % 2, std::size_t(0));
+			for (std::size_t i = 0; i < feature.tags.size(); i += 2)
+			{
+				QVERIFY(int(feature.tags[i]) < layer.keys.size());
+				QVERIFY(int(feature.tags[i+1]) < layer.values.size());
+			}
+			++found[feature.type];
+			
+			QRectF bounds;
+			for (const auto& part : feature.parts)
+			{
+				for (const auto& pos : part)
+				{
+					QVERIFY(limits.contains(pos));
+					bounds |= QRectF(pos, QSizeF(0.0001, 0.0001));
+				}
+			}
+			
+			switch (feature.type)
+			{
+			case 1:
+				{
+					QCOMPARE(feature.parts.size(), std::size_t(1));
+					auto const expected = tileCoords(map, MapCoordF(point->getCoord()), tile, options.extent);
+					auto const actual = feature.parts.front().front();
+					QVERIFY(std::abs(actual.x() - expected.x()) <= 1);
+					QVERIFY(std::abs(actual.y() - expected.y()) <= 1);
+				}
+				break;
+			case 2:
+				for (const auto& part : feature.parts)
+					QVERIFY(part.size() >= 2);
+				break;
+			case 3:
+				{
+					QRectF expected;
+					for (const auto& corner : corners)
+					{
+						auto const pos = tileCoords(map, MapCoordF(corner), tile, options.extent);
+						expected |= QRectF(pos, QSizeF(0.0001, 0.0001));
+					}
+					expected &= buffered_tile;
+					QVERIFY(std::abs(bounds.left() - expected.left()) <= 1);
+					QVERIFY(std::abs(bounds.top() - expected.top()) <= 1);
+					QVERIFY(std::abs(bounds.right() - expected.right()) <= 1);
+					QVERIFY(std::abs(bounds.bottom() - expected.bottom()) <= 1);
+					for (const auto& ring : feature.parts)
+					{
+						QVERIFY(ring.size() >= 4);
+						QVERIFY(signedArea(ring) > 0);
+					}
+				}
+				break;
+			}
+		}
+	}
+	QVERIFY(found[1] >= 1);
+	QVERIFY(found[2] >= 1);
+	QVERIFY(found[3] >= 1);
+}
+
+
+void VectorTileExportTest::levelOfDetailTest()
+{
+	Map map;
+	setupGeoreferencing(map);
+	
+	// A zigzag line of 400 vertices, 5 m apart, with an amplitude of 3 m.
+	MapCoordVector coords;
+	for (int i = 0; i < 400; ++i)
+		coords.push_back(MapCoord(0.5 * i, (i % 2) ? 0.3 : 0.0));
+	map.addObject(new PathObject(Map::getUndefinedLine(), coords));
+	
+	VectorTileExport::Options options;
+	options.min_zoom = 10;
+	options.max_zoom = 16;
+	VectorTileExport exporter(map, options);
+	QVERIFY(exporter.prepare());
+	
+	auto countVertices = [&exporter](int zoom) {
+		auto count = std::size_t(0);
+		for (const auto& tile : exporter.tiles(zoom))
+		{
+			for (const auto& feature : decodeTile(exporter.encodeTile(tile)).features)
+			{
+				for (const auto& part : feature.parts)
+					count += part.size();
+			}
+		}
+		return count;
+	};
+	auto const high_detail = countVertices(16);
+	auto const low_detail = countVertices(10);
+	QVERIFY(high_detail >= 400);
+	QVERIFY(low_detail >= 2);
+	QVERIFY(low_detail * 10 < high_detail);
+}
+
+
+void VectorTileExportTest::exportToDirectoryTest()
+{
+	Map map;
+	setupGeoreferencing(map);
+	auto point = new PointObject(Map::getUndefinedPoint());
+	point->setPosition(MapCoord(10, 10));
+	map.addObject(point);
+	map.addObject(new PathObject(Map::getUndefinedLine(), { MapCoord(0, 0), MapCoord(100, 0) }));
+	
+	QTemporaryDir temp_dir;
+	QVERIFY(temp_dir.isValid());
+	
+	VectorTileExport::Options options;
+	options.min_zoom = 14;
+	options.max_zoom = 15;
+	VectorTileExport exporter(map, options);
+	QVERIFY2(exporter.exportToDirectory(temp_dir.path()), qPrintable(exporter.errorString()));
+	
+	QDir dir(temp_dir.path());
+	auto num_files = 0;
+	for (auto zoom = options.min_zoom; zoom <= options.max_zoom; ++zoom)
+	{
+		for (const auto& tile : exporter.tiles(zoom))
+		{
+			auto const path = QString::fromLatin1("%1/%2/%3.mvt").arg(tile.zoom).arg(tile.x).arg(tile.y);
+			auto const data = exporter.encodeTile(tile);
+			QCOMPARE(dir.exists(path), !data.isEmpty());
+			if (data.isEmpty())
+				continue;
+			
+			QFile file(dir.filePath(path));
+			QVERIFY(file.open(QIODevice::ReadOnly));
+			QCOMPARE(file.readAll(), data);
+			++num_files;
+		}
+	}
+	QVERIFY(num_files >= 2);
+	
+	QFile metadata_file(dir.filePath(QString::fromLatin1("metadata.json")));
+	QVERIFY(metadata_file.open(QIODevice::ReadOnly));
+	auto const metadata = QJsonDocument::fromJson(metadata_file.readAll()).object();
+	QCOMPARE(metadata.value(QString::fromLatin1("format")).toString(), QString::fromLatin1("pbf"));
+	QCOMPARE(metadata.value(QString::fromLatin1("minzoom")).toInt(), 14);
+	QCOMPARE(metadata.value(QString::fromLatin1("maxzoom")).toInt(), 15);
+	
+	auto const bounds = metadata.value(QString::fromLatin1("bounds")).toArray();
+	QCOMPARE(bounds.size(), 4);
+	QVERIFY(bounds.at(0).toDouble() < bounds.at(2).toDouble());
+	QVERIFY(bounds.at(1).toDouble() < bounds.at(3).toDouble());
+	
+	auto const layers = metadata.value(QString::fromLatin1("vector_layers")).toArray();
+	QCOMPARE(layers.size(), 1);
+	QCOMPARE(layers.at(0).toObject().value(QString::fromLatin1("id")).toString(), QString::fromLatin1("map"));
+}
+
+
+void VectorTileExportTest::exportTaskTest()
+{
+	Map map;
+	setupGeoreferencing(map);
+	map.addObject(new PathObject(Map::getUndefinedLine(), { MapCoord(0, 0), MapCoord(100, 0) }));
+	
+	VectorTileExport::Options options;
+	options.min_zoom = 14;
+	options.max_zoom = 15;
+	
+	{
+		QTemporaryDir temp_dir;
+		QVERIFY(temp_dir.isValid());
+		VectorTileExportTask task(map, options, temp_dir.path());
+		QSignalSpy progress_spy(&task, &BackgroundTask::progressChanged);
+		task.start();
+		QVERIFY(task.waitForFinished());
+		QCOMPARE(task.state(), BackgroundTask::Finished);
+		QVERIFY(QFile::exists(QDir(temp_dir.path()).filePath(QString::fromLatin1("metadata.json"))));
+		QVERIFY(progress_spy.count() > 0);
+	}
+	
+	{
+		QTemporaryDir temp_dir;
+		QVERIFY(temp_dir.isValid());
+		VectorTileExportTask task(map, options, temp_dir.path());
+		task.cancel();
+		QVERIFY(!task.runSynchronously());
+		QCOMPARE(task.state(), BackgroundTask::Canceled);
+		QVERIFY(!QFile::exists(QDir(temp_dir.path()).filePath(QString::fromLatin1("metadata.json"))));
+	}
+	
+	{
+		Map local_map;
+		QTemporaryDir temp_dir;
+		QVERIFY(temp_dir.isValid());
+		VectorTileExportTask task(local_map, options, temp_dir.path());
+		QVERIFY(!task.runSynchronously());
+		QCOMPARE(task.state(), BackgroundTask::Failed);
+		QVERIFY(!task.errorString().isEmpty());
+	}
+}
+
+
+void VectorTileExportTest::localGeoreferencingTest()
+{
+	Map map;
+	map.addObject(new PathObject(Map::getUndefinedLine(), { MapCoord(0, 0), MapCoord(100, 0) }));
+	QVERIFY(map.getGeoreferencing().isLocal());
+	
+	VectorTileExport exporter(map, VectorTileExport::defaultOptions(map));
+	QVERIFY(!exporter.prepare());
+	QVERIFY(!exporter.errorString().isEmpty());
+}
+
+
+
+QTEST_MAIN(VectorTileExportTest)
@@ -0,0 +1,67 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_VECTOR_TILE_EXPORT_T_H
+#define OPENORIENTEERING_VECTOR_TILE_EXPORT_T_H
+
+#include <QObject>
+
+
+/**
+ * @test Tests the Mapbox Vector Tile export.
+ */
+class VectorTileExportTest : public QObject
+{
+Q_OBJECT
+	
+private slots:
+	void initTestCase();
+	
+	/**
+	 * Tests the conversion to normalized Web Mercator coordinates.
+	 */
+	void worldCoordsTest();
+	
+	/**
+	 * Tests the encoding of the layer, the features and their geometry.
+	 */
+	void encodeTileTest();
+	
+	/**
+	 * Tests that lower zoom levels carry less vertices.
+	 */
+	void levelOfDetailTest();
+	
+	/**
+	 * Tests the files written for the tile pyramid.
+	 */
+	void exportToDirectoryTest();
+	
+	/**
+	 * Tests the background task, including progress and cancellation.
+	 */
+	void exportTaskTest();
+	
+	/**
+	 * Tests that maps without georeferencing are rejected.
+	 */
+	void localGeoreferencingTest();
+};
+
+#endif
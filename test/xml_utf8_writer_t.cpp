@@ -0,0 +1,204 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "xml_utf8_writer_t.h"
+
+#include <QtTest>
+#include <QBuffer>
+#include <QByteArray>
+#include <QScopedValueRollback>
+#include <QString>
+#include <QXmlStreamWriter>
+
+#include "test_config.h"
+
+#include "global.h"
+#include "core/map.h"
+#include "core/map_coord.h"
+#include "core/map_part.h"
+#include "core/objects/object.h"
+#include "core/objects/text_object.h"
+#include "core/symbols/text_symbol.h"
+#include "fileformats/xml_file_format.h"
+#include "util/xml_utf8_writer.h"
+
+using namespace OpenOrienteering;
+
+
+namespace
+{
+
+static const auto test_files = {
+  "data:test_map.omap",
+  "data:issue-513-coords-outside-printable.omap",
+  "examples:complete map.omap",
+  "examples:forest sample.omap",
+};
+
+}  // namespace
+
+
+void XmlUtf8WriterTest::initTestCase()
+{
+	doStaticInitializations();
+	
+	static const auto prefix = QString::fromLatin1("data");
+	QDir::addSearchPath(prefix, QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(prefix));
+	static const auto examples = QString::fromLatin1("examples");
+	QDir::addSearchPath(examples, QDir(QString::fromUtf8(MAPPER_TEST_SOURCE_DIR)).absoluteFilePath(QStringLiteral("../examples")));
+	
+	for (auto raw_path : test_files)
+	{
+		auto path = QString::fromUtf8(raw_path);
+		QVERIFY(QFileInfo::exists(path));
+	}
+}
+
+
+void XmlUtf8WriterTest::escaping_data()
+{
+	QTest::addColumn<QString>("text");
+	QTest::newRow("empty") << QString();
+	QTest::newRow("plain") << QStringLiteral("Plain text");
+	QTest::newRow("markup") << QStringLiteral("<a href=\"x\">&amp;</a>");
+	QTest::newRow("whitespace") << QStringLiteral("line\nbreak\r\n\ttab  space");
+	QTest::newRow("latin1") << QString::fromUtf8("Gr\xc3\xbc\xc3\x9f" "e");
+	QTest::newRow("bmp") << QString::fromUtf8("\xe6\x9d\xb1\xe4\xba\xac \xe2\x82\xac");
+	QTest::newRow("surrogates") << QString::fromUtf8("\xf0\x9f\x8c\xb2 & \xf0\x9f\x8f\x83");
+}
+
+void XmlUtf8WriterTest::escaping()
+{
+	QFETCH(QString, text);
+	
+	QBuffer expected;
+	expected.open(QIODevice::WriteOnly);
+	{
+		QXmlStreamWriter xml(&expected);
+		xml.writeStartElement(QLatin1String("t"));
+		xml.writeAttribute(QLatin1String("k"), text);
+		xml.writeCharacters(text);
+		xml.writeEndElement();
+		xml.writeStartElement(QLatin1String("empty"));
+		xml.writeAttribute(QLatin1String("k"), text);
+		xml.writeEndElement();
+		xml.writeTextElement(QLatin1String("text"), text);
+	}
+	
+	QBuffer actual;
+	actual.open(QIODevice::WriteOnly);
+	{
+		XmlUtf8Writer writer(&actual);
+		writer.writeStartElement(QLatin1String("t"));
+		writer.writeAttribute(QLatin1String("k"), text);
+		writer.writeCharacters(text);
+		writer.writeEndElement();
+		writer.writeStartElement(QLatin1String("empty"));
+		writer.writeAttribute(QLatin1String("k"), text);
+		writer.writeEndElement();
+		writer.writeTextElement(QLatin1String("text"), text);
+		writer.flush();
+	}
+	
+	QCOMPARE(actual.data(), expected.data());
+}
+
+
+void XmlUtf8WriterTest::mapParts_data()
+{
+	QTest::addColumn<QString>("map_filename");
+	for (auto raw_path : test_files)
+	{
+		QTest::newRow(raw_path) << QString::fromUtf8(raw_path);
+	}
+}
+
+void XmlUtf8WriterTest::mapParts()
+{
+	QFETCH(QString, map_filename);
+	Map map;
+	QVERIFY(map.loadFrom(map_filename, nullptr, nullptr, false, false));
+	
+	// The dense coordinate format
+	QScopedValueRollback<int> version(XMLFileFormat::active_version, XMLFileFormat::current_version);
+	
+	for (int i = 0; i < map.getNumParts(); ++i)
+	{
+		auto const* part = map.getPart(std::size_t(i));
+		
+		QBuffer expected;
+		expected.open(QIODevice::WriteOnly);
+		{
+			QXmlStreamWriter xml(&expected);
+			part->save(xml);
+		}
+		
+		QBuffer actual;
+		actual.open(QIODevice::WriteOnly);
+		{
+			XmlUtf8Writer writer(&actual);
+			part->save(writer);
+			writer.flush();
+		}
+		
+		QVERIFY(actual.size() > 0);
+		QCOMPARE(actual.data(), expected.data());
+	}
+}
+
+
+void XmlUtf8WriterTest::roundTrip()
+{
+	Map map;
+	QVERIFY(map.loadFrom(QStringLiteral("data:test_map.omap"), nullptr, nullptr, false, false));
+	
+	auto symbol = new TextSymbol();
+	map.addSymbol(symbol, map.getNumSymbols());
+	auto text_object = new TextObject(symbol);
+	text_object->setAnchorPosition(MapCoord::fromNative(1000, -2000));
+	text_object->setText(QString::fromUtf8("<\"T\xc3\xa4st\" & \xf0\x9f\x8c\xb2>\n\ttext"));
+	text_object->setTag(QStringLiteral("name"), QString::fromUtf8("\xe2\x82\xac <&> \"\n\""));
+	text_object->setTag(QString::fromUtf8("k\xc3\xa9y \""), QStringLiteral("  "));
+	map.addObject(text_object);
+	map.getPart(0)->setName(QString::fromUtf8("Part <\xc3\xa4> & \"1\""));
+	
+	QBuffer buffer;
+	QVERIFY(map.exportToIODevice(&buffer));
+	
+	Map loaded_map;
+	buffer.open(QIODevice::ReadOnly);
+	QVERIFY(loaded_map.importFromIODevice(&buffer));
+	
+	QCOMPARE(loaded_map.getNumParts(), map.getNumParts());
+	QCOMPARE(loaded_map.getPart(0)->getName(), map.getPart(0)->getName());
+	QCOMPARE(loaded_map.getNumObjects(), map.getNumObjects());
+	for (int i = 0; i < map.getNumParts(); ++i)
+	{
+		auto const* part = map.getPart(std::size_t(i));
+		auto const* loaded_part = loaded_map.getPart(std::size_t(i));
+		QCOMPARE(loaded_part->getNumObjects(), part->getNumObjects());
+		for (int j = 0; j < part->getNumObjects(); ++j)
+		{
+			QVERIFY(loaded_part->getObject(j)->equals(part->getObject(j), false));
+		}
+	}
+}
+
+
+QTEST_MAIN(XmlUtf8WriterTest)
@@ -0,0 +1,48 @@
+/*
+ *    Copyright 2018 Kai Pastor
+ *
+ *    This file is part of OpenOrienteering.
+ *
+ *    OpenOrienteering is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    OpenOrienteering is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with OpenOrienteering.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENORIENTEERING_XML_UTF8_WRITER_T_H
+#define OPENORIENTEERING_XML_UTF8_WRITER_T_H
+
+#include <QObject>
+
+
+/**
+ * @test Tests that XmlUtf8Writer produces the same output as QXmlStreamWriter,
+ *       and that this output is read correctly by the XML file importer.
+ */
+class XmlUtf8WriterTest : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	
+	/** Compares the output for strings which need escaping. */
+	void escaping();
+	void escaping_data();
+	
+	/** Compares the output for map parts. */
+	void mapParts();
+	void mapParts_data();
+	
+	/** Saves and loads a map with challenging text and tags. */
+	void roundTrip();
+};
+
+#endif